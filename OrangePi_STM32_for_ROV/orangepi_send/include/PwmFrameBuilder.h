@@ -53,6 +53,12 @@ public:
     /// 固定的帧头（SOF）
     static constexpr std::uint16_t kSof = 0xAA55;
 
+    /// 紧凑帧 v2 的帧头（只承载 PWM，见 protocol_v1.md 4.1c）
+    static constexpr std::uint16_t kSofV2 = 0xAA5A;
+
+    /// HB_ACK status 位：设备支持紧凑帧 v2
+    static constexpr std::uint16_t kDevStatusProtoV2 = 0x0008;
+
     /// PWM 通道与取值范围（控制语义层）
     static constexpr std::size_t  kPwmChannelCount = 8;
     static constexpr std::uint16_t kPwmMaxValue    = 10000; // 映射 [-1..+1]→[-5000..+5000] + 5000
@@ -104,6 +110,37 @@ public:
     static std::vector<std::uint8_t>
     buildHeartbeatFrameV1(std::uint16_t seq, std::uint32_t ticks_ms);
 
+    // ========================= 构帧（紧凑帧 v2） =========================
+
+    /**
+     * @brief 构建 PWM 指令帧（v2）：SOF 0xAA5A | TYPE<<5|LEN | SEQ8 | TICK16 | 8 路位打包 | CRC16
+     * @param pwm_values 8 通道，每通道 0..10000（将被裁剪）
+     * @param seq        序列号（只发低 8 位；须与 v1 心跳共用同一计数器，设备据心跳展开）
+     * @param ticks_ms   本地毫秒时间戳（只发低 16 位）
+     * @param bits       每通道位数：12（码值=值×2/5，20 字节）或 14（无损，22 字节）
+     * @throws std::invalid_argument bits 不是 12 / 14
+     */
+    static std::vector<std::uint8_t>
+    buildPwmCmdFrameV2(const std::array<std::uint16_t, kPwmChannelCount>& pwm_values,
+                       std::uint16_t seq,
+                       std::uint32_t ticks_ms,
+                       int bits = 12);
+
+    // ========================= COBS 分帧（可选） =========================
+
+    /**
+     * @brief 将一帧（v1 / v2）包装为 0x00 + COBS + 0x00（固件 CFG_PROTO_COBS_ENABLE=1 时使用）
+     * @param frame 原始帧
+     * @return 线上字节（首尾各一个 0x00，开销 n/254 + 3 字节）
+     */
+    static std::vector<std::uint8_t> wrapCobs(const std::vector<std::uint8_t>& frame);
+
+    /**
+     * @brief 解码一段 COBS 数据（调用方已按 0x00 切分，不含分隔符）
+     * @return 原始帧；格式错误或为空时为 std::nullopt
+     */
+    static std::optional<std::vector<std::uint8_t>> unwrapCobs(std::string_view chunk);
+
     // ========================= 解析（v1） =========================
 
     /**
@@ -124,6 +161,12 @@ public:
      */
     static std::optional<std::string_view> parseStatusV1(std::string_view frame);
 
+    /**
+     * @brief 取 HB_ACK 负载中的 status 位（LEN>=16 时存在）
+     * @return status（含 kDevStatusProtoV2 即可切换为 v2 PWM 帧）；非 HB_ACK 或旧固件无此字段时为 std::nullopt
+     */
+    static std::optional<std::uint16_t> heartbeatAckStatusV1(std::string_view frame);
+
     // ========================= 轻量工具 =========================
 
     /// @return 8 通道个数（编译期常量）
@@ -52,14 +52,51 @@ public:
     /// 可选：绑定本地地址与端口（在 initialize 前调用）
     void setLocalBind(const std::string& local_ip, uint16_t local_port);
 
-    /// 可选：设置接收/发送缓冲大小（字节）
-    void setSocketBuffers(int rcvbuf_bytes, int sndbuf_bytes);
+    /// setSocketBuffers 的取值：按观测峰值取推荐值（见 recommendSocketBuffers）
+    static constexpr int kRecommendedBuffer = -1;
+
+    /**
+     * @brief 可选：设置接收/发送缓冲大小（字节，setsockopt 参数，内核生效值为其 2 倍）
+     * @param rcvbuf_bytes 0=不修改；kRecommendedBuffer=按观测峰值推荐
+     * @param sndbuf_bytes 同上
+     * 初始化前调用时在 initialize 中生效；已初始化时立即生效。
+     * @return false=setsockopt 失败（见 getLastError）
+     */
+    bool setSocketBuffers(int rcvbuf_bytes, int sndbuf_bytes);
+
+    /// 内核 socket 队列遥测（字节按内核记账，含 skb 开销，可与 SO_RCVBUF/SO_SNDBUF 生效值直接比较）
+    struct QueueStats {
+        uint64_t rx_overflow = 0;  ///< 接收缓冲满被内核丢弃的数据报（SO_RXQ_OVFL）
+        uint32_t rxq_bytes   = 0;  ///< 最近一次采样的接收队列占用
+        uint32_t rxq_peak    = 0;
+        uint32_t txq_bytes   = 0;  ///< 最近一次采样的发送队列占用（SIOCOUTQ）
+        uint32_t txq_peak    = 0;
+        int      rcvbuf      = 0;  ///< 当前 SO_RCVBUF 生效值（getsockopt）
+        int      sndbuf      = 0;  ///< 当前 SO_SNDBUF 生效值
+    };
+
+    /// 采样收发队列占用并更新峰值（receiveFrom 收包前自动调用；只发不收的循环请每周期调用一次）
+    void sampleQueues();
+
+    /// 读取队列遥测
+    const QueueStats& getQueueStats() const { return qstats_; }
+
+    /**
+     * @brief 按观测峰值推荐缓冲大小（setsockopt 参数）
+     *
+     * 生效值取峰值的 2 倍余量（内核将参数翻倍，故参数 = 峰值），4 KiB 取整、不低于 4 KiB；
+     * 出现过接收溢出时峰值已被缓冲封顶，接收侧至少推荐当前生效值（翻倍）。
+     * 推荐值可能小于系统默认：发送缓冲越小，拥塞时在内核里排队的过期指令越少。
+     * 观测窗口应覆盖最忙的工况。
+     */
+    void recommendSocketBuffers(int& rcvbuf_bytes, int& sndbuf_bytes) const;
 
     /// 可选：切换是否非阻塞（默认初始化后即为非阻塞）
     bool setNonBlocking(bool nb);
 
 private:
     bool applySocketOptions(int timeout_ms);
+    bool applyBufferSizes();
     bool bindLocalIfNeeded();
 
 private:
@@ -79,6 +116,10 @@ private:
     // 可选缓冲设置（<=0 表示不修改）
     int rcvbuf_bytes_;
     int sndbuf_bytes_;
+
+    // 队列遥测
+    QueueStats qstats_;
+    uint32_t   ovfl_last_;  ///< 上次读到的 SO_RXQ_OVFL 累计值
 };
 
 #endif // UDPSENDER_H
@@ -6,7 +6,7 @@
 /**
  * @file      libpwm_host.h
  * @brief     上位机（香橙派）控制 STM32 PWM 的最小可复用 C 接口
- * @version   1.1.0
+ * @version   1.3.0
  *
  * 设计目标：
  *  - 作为“底层驱动库”供 C/C++ 直接链接，Python 可通过 ctypes/cffi 调用
@@ -38,12 +38,13 @@ extern "C" {
 #endif
 
 /** 库语义版本（供运行时查询） */
-#define PWM_HOST_SEMVER "1.1.0"
+#define PWM_HOST_SEMVER "1.4.0"
 
 /** 协议固定参数（与 STM32 端保持一致） */
 enum {
     PWM_HOST_PROTO_VER   = 0x01,   /**< protocol_v1 版本号 */
     PWM_HOST_MSG_PWM     = 0x01,   /**< PWM 指令消息 ID */
+    PWM_HOST_MSG_PWM_AT  = 0x02,   /**< 定时应用的 PWM 指令（DUE u32 + 8×u16，见 pwm_host_set_schedule） */
     PWM_HOST_MSG_HB      = 0x10,   /**< 心跳（Host -> STM32） */
     PWM_HOST_MSG_HB_ACK  = 0x11,   /**< 心跳 ACK（STM32 -> Host） */
     PWM_HOST_SOF_BE      = 0xAA55, /**< 帧头（大端） */
@@ -92,13 +93,20 @@ PWMH_API const char* pwm_host_strerror(pwmh_result_t rc);
  *  - send_hz:        50
  *  - socket_sndbuf:  不修改
  *  - nonblock_send:  0（阻塞发送）
+ *
+ * 发送邮箱（nonblock_send=1）：
+ *  - 发送缓冲已满（EAGAIN/ENOBUFS）时帧不丢弃也不计错误，发送接口照常返回 PWMH_OK；
+ *  - PWM 只保留最新一条待发指令（旧的被覆盖，计 tx_mbox_replaced），心跳与急停帧另有优先槽；
+ *  - pwm_host_poll() / pwm_host_sleep_ms() 等待 fd 可写后按“急停 → 心跳 → PWM”顺序冲刷，
+ *    冲刷时以最新值重新组帧，拥塞链路上不会排起过期推力指令；
+ *  - 阻塞模式（0）下缓冲满会让控制线程卡在 sendto 上，链路与视频共用时建议使用 1。
  */
 typedef struct {
     const char* stm32_ip;       /**< 目标 STM32 IP（默认 "192.168.2.16"） */
     uint16_t    stm32_port;     /**< 目标端口（默认 8000） */
     int         send_hz;        /**< 建议发送频率（默认 50） */
     int         socket_sndbuf;  /**< socket 发送缓冲（字节），0=不修改 */
-    int         nonblock_send;  /**< 非零则使用非阻塞 sendto（默认 0 阻塞） */
+    int         nonblock_send;  /**< 非零则使用非阻塞 sendto + 发送邮箱（默认 0 阻塞），见下方说明 */
 } pwm_host_config_t;
 
 /**
@@ -115,8 +123,38 @@ typedef struct {
     uint64_t rx_hb_ack;     /**< 收到心跳 ACK 计数 */
     uint64_t tx_err;        /**< 发送错误计数（系统调用失败等） */
     uint64_t rx_err;        /**< 接收/解析错误计数（CRC/长度等） */
+    uint64_t tx_pwm_dup;    /**< 冗余副本发送计数（见 pwm_host_set_redundancy） */
+    /* 以下来自设备 HB_ACK 负载（固件 CFG_HB_ACK_STATS_ENABLE），设备未上报时为 0 */
+    uint32_t dev_rx_unique; /**< 设备去重后收到的 PWM 帧数（心跳不计） */
+    uint32_t dev_rx_dup;    /**< 设备丢弃的重复副本数 */
+    uint32_t dev_seq_gaps;  /**< 设备推断的 SEQ 缺口（所有副本都丢失的帧） */
+    uint64_t link_switches; /**< 主备链路切换次数（见 pwm_host_enable_failover） */
+    uint64_t tx_pwm_coalesced; /**< 速率控制下未发出即被新指令覆盖的 PWM 指令数 */
+    uint64_t tx_pwm_keepalive; /**< 速率控制下因空闲而重发影子值的保活帧数（计入 tx_pwm） */
+    uint64_t tx_backpressure;  /**< 非阻塞发送遇到 EAGAIN/ENOBUFS 的次数（帧进入邮箱，不计 tx_err） */
+    uint64_t tx_mbox_replaced; /**< 邮箱中尚未发出即被新指令覆盖的 PWM 指令数 */
+    uint64_t tx_deadline_miss; /**< PWM 帧间隔超过 标称周期 + 容差 的次数（见 pwm_host_txmon_configure） */
+    uint64_t tx_catchup_burst; /**< 超期后出现的追赶突发（连续短间隔帧）次数 */
+    int32_t  dev_phase_lag_us; /**< 设备 PWM 指令到达 → 输出生效的平均等待（μs，见固件 Phase_pwm），-1=未上报 */
+    uint16_t dev_status;       /**< 设备状态位（PWM_HOST_DEV_STATUS_*），随 HB_ACK 更新 */
+    uint64_t tx_pwm_merged;    /**< 批量 / 延迟模式下并入同一帧的 setter 调用数（每帧计 调用数-1） */
+    uint64_t tx_pwm_v2;        /**< 以紧凑帧 v2 发出的 PWM 帧数（计入 tx_pwm，见 pwm_host_set_proto） */
+    /* 以下为本机内核 socket 队列遥测（UDP 模式，每次 pwm_host_poll 采样；注入传输下为 0）。
+     * 字节数按内核记账（含 skb 开销），可直接与 SO_RCVBUF / SO_SNDBUF 比较；
+     * 队列深度持续非零是主机侧时延堆积最早的信号 */
+    uint64_t rx_overflow;      /**< 接收缓冲满被内核丢弃的数据报数（SO_RXQ_OVFL）；HB_ACK 缺失而此值不变 = 丢在线路上 */
+    uint32_t rxq_bytes;        /**< 最近一次采样的接收队列占用（收包前，主备链路之和） */
+    uint32_t rxq_peak;         /**< 接收队列占用峰值 */
+    uint32_t txq_bytes;        /**< 最近一次采样的发送队列占用（SIOCOUTQ，主备链路之和） */
+    uint32_t txq_peak;         /**< 发送队列占用峰值 */
 } pwm_host_stats_t;
 
+/** 设备状态位（HB_ACK 负载 LEN>=16 时上报，见 protocol_v1.md 4.2） */
+#define PWM_HOST_DEV_STATUS_PHASE_ALIGN  0x0001u  /**< 固件启用 PWM 周期相位对齐 */
+#define PWM_HOST_DEV_STATUS_PHASE_LOCKED 0x0002u  /**< 相位对齐已锁定 */
+#define PWM_HOST_DEV_STATUS_WARMING      0x0004u  /**< 设备上电暖机中：应答心跳但输出保持中位、不应用 PWM */
+#define PWM_HOST_DEV_STATUS_PROTO_V2     0x0008u  /**< 固件支持紧凑帧 v2（见 pwm_host_set_proto） */
+
 /* ----------------------------- 基础生命周期 ----------------------------- */
 
 /**
@@ -172,10 +210,62 @@ PWMH_API pwmh_result_t pwm_host_set_all_pct(const float pct[PWM_HOST_CH_NUM]);
  * @param pct 百分比或 -1
  * @return PWMH_OK / 错误码
  *
- * 注意：本函数内部会先读取当前影子缓存的 8 路值，替换 ch，再整体下发一次。
+ * 注意：本函数内部会先读取当前影子缓存的 8 路值，替换 ch，再整体下发一次；
+ *       连续设置多路时请放在 pwm_host_begin() / pwm_host_commit() 之间，合并为一帧。
  */
 PWMH_API pwmh_result_t pwm_host_set_ch_pct(int ch, float pct);
 
+/**
+ * @brief 设置单通道协议值（0..10000，超出裁剪），行为同 pwm_host_set_ch_pct
+ * @param ch 1..8
+ */
+PWMH_API pwmh_result_t pwm_host_set_ch_u16(int ch, uint16_t v);
+
+/* ----------------------------- 批量更新与延迟模式 ----------------------------- */
+
+/**
+ * 逐通道 setter 每次都会发一整帧：连续设置 4 个推进器即 4 帧、4 个 SEQ，
+ * 设备依次应用 3 个中间状态（阶梯）。批量更新把多次 setter 合并为一条原子指令：
+ *
+ *    pwm_host_begin();
+ *    pwm_host_set_ch_pct(1, 8.5f);
+ *    pwm_host_set_ch_pct(2, 8.5f);
+ *    pwm_host_set_ch_pct(3, 6.5f);
+ *    pwm_host_set_ch_pct(4, 6.5f);
+ *    pwm_host_commit();                  // 一帧 PWM，设备一次性应用
+ *
+ *  - begin 之后所有 setter（set_ch_* / set_all_*）只修改暂存值，未涉及的通道保持当前输出；
+ *  - begin / commit 可嵌套，最外层 commit 才发出；期间冗余副本、速率控制保活、邮箱重发
+ *    仍使用上一帧的影子值，半成品状态不会被发出；
+ *  - pwm_host_rollback() 丢弃所有未发出的暂存修改；
+ *  - 延迟模式（pwm_host_set_deferred(1)）：setter 与 commit 都只更新暂存值，
+ *    由下一次 pwm_host_poll() / pwm_host_sleep_ms() / 任意库内发送前的服务点整帧发出，
+ *    一个控制周期内任意多次 setter 只产生一帧；有未提交的 begin 时等待 commit；
+ *  - pwm_host_flush() 立即发出暂存值（急停路径使用，不等待 commit）；
+ *  - 合并掉的 setter 调用计入 pwm_host_stats_t.tx_pwm_merged。
+ */
+
+/**
+ * @brief 开始批量更新（可嵌套）
+ * @return PWMH_OK / PWMH_ENOTINIT
+ */
+PWMH_API pwmh_result_t pwm_host_begin(void);
+
+/**
+ * @brief 结束批量更新；最外层且有修改时整帧发出（延迟模式下留待下一次服务）
+ * @return PWMH_OK / PWMH_ENOTINIT / PWMH_EINVAL（没有对应的 begin）/ 发送错误码
+ */
+PWMH_API pwmh_result_t pwm_host_commit(void);
+
+/** 放弃批量：清空嵌套层数与未发出的暂存修改 */
+PWMH_API void pwm_host_rollback(void);
+
+/**
+ * @brief 开启 / 关闭延迟模式（关闭时若有已提交的暂存值立即发出）
+ * @return PWMH_OK / PWMH_ENOTINIT / 发送错误码
+ */
+PWMH_API pwmh_result_t pwm_host_set_deferred(int on);
+
 /* ----------------------------- 心跳与轮询 ----------------------------- */
 
 /**
@@ -186,7 +276,7 @@ PWMH_API pwmh_result_t pwm_host_send_heartbeat(void);
 
 /**
  * @brief 轮询收包/处理（解析 HB_ACK / 统计 / RTT 计算）
- * @param timeout_ms 轮询超时（毫秒）。0=非阻塞，>0=阻塞等待至多 timeout_ms。
+ * @param timeout_ms 轮询超时（毫秒）。0=非阻塞，>0=阻塞等待至多 timeout_ms，<0=无限等待。
  * @return
  *   - >= 0 : 本次处理的帧数
  *   - <  0 : 发生错误，对应 -PWMH_xxx（例如返回 -PWMH_ESYS）
@@ -204,6 +294,366 @@ PWMH_API double pwm_host_last_rtt_ms(void);
  */
 PWMH_API void pwm_host_get_stats(pwm_host_stats_t* out);
 
+/* ----------------------------- 冗余发送（掩盖突发丢包） ----------------------------- */
+
+/** 每帧最多发送的份数（含原帧） */
+#define PWM_HOST_REDUNDANCY_MAX 3
+
+/**
+ * @brief 设置 PWM 帧冗余发送
+ * @param copies     每帧发送份数（1=关闭冗余，最大 PWM_HOST_REDUNDANCY_MAX）
+ * @param spacing_ms 副本间隔（ms）；0=背靠背立即发送
+ * @return PWMH_OK / PWMH_EINVAL
+ *
+ * 说明：
+ *  - 副本与原帧字节完全相同（同 SEQ），固件按 SEQ 去重，只应用最先到达的一份；
+ *  - spacing_ms>0 时副本延后发送，由 pwm_host_poll() / pwm_host_sleep_ms() 负责按时补发，
+ *    控制循环无需改动；新 PWM 帧会取代尚未发出的旧副本；
+ *  - 间隔应小于控制周期，且大于链路突发丢包的典型时长（滑环附近约数 ms）。
+ */
+PWMH_API pwmh_result_t pwm_host_set_redundancy(int copies, int spacing_ms);
+
+/**
+ * @brief 残余丢包率（冗余后仍未到达设备的帧比例）
+ * @return 0..1；设备未上报链路统计（旧固件或尚未收到 HB_ACK）时返回 -1
+ *
+ * 计算：dev_seq_gaps / (dev_rx_unique + dev_seq_gaps)，基于最近一次 HB_ACK。
+ */
+PWMH_API double pwm_host_residual_loss(void);
+
+/* ----------------------------- 双链路热备（主备切换） ----------------------------- */
+
+/** 链路编号 */
+enum {
+    PWM_HOST_LINK_PRIMARY   = 0,   /**< 主链路（pwm_host_init 的 stm32_ip/port） */
+    PWM_HOST_LINK_SECONDARY = 1,   /**< 备链路 */
+    PWM_HOST_LINK_NUM       = 2
+};
+
+/**
+ * @brief 热备配置
+ *
+ * 默认值（pwm_host_failover_default_config）：
+ *  - probe_ms: 20，lapse_ms: 60，failback_acks: 5，duplicate_on_both: 0
+ */
+typedef struct {
+    const char* secondary_ip;      /**< 备链路目标 IP（必填） */
+    uint16_t    secondary_port;    /**< 备链路目标端口（0=与主链路相同） */
+    const char* secondary_bind_ip; /**< 备链路本地源地址（NULL=由路由决定，用于指定第二块网卡） */
+    int         probe_ms;          /**< 每条链路的探测心跳间隔（ms） */
+    int         lapse_ms;          /**< 链路失效判定：超过该时间无探测 ACK（须 > probe_ms，且远小于固件 300ms 失联保护） */
+    int         failback_acks;     /**< 主链路连续 N 次探测成功后切回主链路 */
+    int         duplicate_on_both; /**< 非零：PWM 帧同时走两条链路（同 SEQ，固件去重），切换零间隙 */
+} pwm_host_failover_config_t;
+
+/** 单条链路的统计（快照） */
+typedef struct {
+    int      up;          /**< lapse_ms 内收到过该链路的探测 ACK */
+    double   rtt_ms;      /**< 最近一次探测 RTT（ms），无则 <0 */
+    double   loss;        /**< 最近 32 次已判定探测的丢失比例（0..1），无则 <0 */
+    uint32_t ack_age_ms;  /**< 距最近一次探测 ACK 的时间（ms），从未收到为 UINT32_MAX */
+    uint64_t probes_tx;   /**< 已发送探测数 */
+    uint64_t acks_rx;     /**< 已收到探测 ACK 数 */
+} pwm_host_link_stats_t;
+
+/** 填充默认热备配置（secondary_ip 需调用方填写） */
+PWMH_API void pwm_host_failover_default_config(pwm_host_failover_config_t* cfg);
+
+/**
+ * @brief 启用双链路热备（须在 pwm_host_init 之后；注入传输模式不支持）
+ * @return PWMH_OK / PWMH_ENOTINIT / PWMH_EINVAL / PWMH_ESYS
+ *
+ * 行为：
+ *  - 库每 probe_ms 在两条链路上各发一帧探测心跳（心跳 SEQ 空间），按 SEQ 匹配 HB_ACK，
+ *    得到每条链路的 RTT / 丢包率 / 存活状态；
+ *  - 当前链路超过 lapse_ms 无 ACK 而另一条存活时立即切换，此后的 PWM / 心跳帧都走新链路；
+ *    每次发送前都会先评估，切换在一个控制周期内生效；当前链路 sendto 失败时也会立即切换重发；
+ *  - 探测由 pwm_host_poll() / pwm_host_sleep_ms() / 发送接口顺带完成，控制循环无需改动；
+ *  - 心跳（含探测）与 PWM 各用一套 SEQ，备链路上丢失的探测不计入设备的 dev_seq_gaps。
+ */
+PWMH_API pwmh_result_t pwm_host_enable_failover(const pwm_host_failover_config_t* cfg);
+
+/** 关闭热备并释放备链路 socket（pwm_host_close / pwm_host_init 会自动调用） */
+PWMH_API void pwm_host_disable_failover(void);
+
+/** 当前承载 PWM 的链路（PWM_HOST_LINK_PRIMARY / PWM_HOST_LINK_SECONDARY） */
+PWMH_API int pwm_host_active_link(void);
+
+/**
+ * @brief 获取单条链路统计
+ * @param link PWM_HOST_LINK_PRIMARY / PWM_HOST_LINK_SECONDARY
+ * @return PWMH_OK / PWMH_EINVAL / PWMH_ENOTINIT（未启用热备）
+ */
+PWMH_API pwmh_result_t pwm_host_get_link_stats(int link, pwm_host_link_stats_t* out);
+
+/* ----------------------------- 快速链路恢复 ----------------------------- */
+
+/** 恢复状态 */
+typedef enum {
+    PWM_HOST_REC_NORMAL  = 0,  /**< 链路正常 */
+    PWM_HOST_REC_PROBING = 1,  /**< 已判定失联：库自动发快速心跳探测 */
+    PWM_HOST_REC_RAMP    = 2   /**< 已恢复：输出由中位渐变回目标 */
+} pwm_host_rec_state_t;
+
+/**
+ * @brief 快速恢复配置
+ *
+ * 默认值（pwm_host_recovery_default_config）：
+ *  - keepalive_ms 100，ack_timeout_ms 200，probe_ms 20，hold_ms 300，ramp_ms 1000，icmp 1
+ */
+typedef struct {
+    uint32_t keepalive_ms;   /**< 距最近 ACK 超过该时间且没有待应答心跳时，库补发一帧心跳（0 = 只靠调用方心跳） */
+    uint32_t ack_timeout_ms; /**< 心跳发出后该时间内没有任何 HB_ACK 即判定失联 */
+    uint32_t probe_ms;       /**< 失联期间的快速心跳间隔 */
+    uint32_t hold_ms;        /**< 距最近 ACK 超过该时间后 PWM 改发中位（取固件 CFG_FAILSAFE_TIMEOUT_MS：此时设备已回中） */
+    uint32_t ramp_ms;        /**< 恢复后 中位 → 目标 的渐变时间（0 = 直接恢复目标） */
+    int      icmp;           /**< 非零：收发报 ECONNREFUSED / EHOSTUNREACH / ENETUNREACH 等（ICMP 不可达、无路由）立即判定失联 */
+} pwm_host_recovery_config_t;
+
+/** 恢复统计（快照，时间均为 ms） */
+typedef struct {
+    pwm_host_rec_state_t state;
+    uint64_t losses;          /**< 判定失联次数 */
+    uint64_t losses_unreach;  /**< 其中由不可达错误触发的次数（其余为 ACK 超时） */
+    uint64_t recoveries;      /**< 恢复次数（失联后收到首个 HB_ACK） */
+    uint64_t ramps;           /**< 恢复后执行了中位渐变的次数（其余为短暂中断，直接恢复） */
+    uint64_t probes;          /**< 快速心跳数（计入 tx_hb） */
+    uint64_t keepalives;      /**< keepalive_ms 补发的心跳数（计入 tx_hb） */
+    uint64_t dev_resets;      /**< 检测到设备重启的次数（HB_ACK 中设备 tick 回退） */
+    uint64_t unreach_errors;  /**< 收发时遇到的不可达错误数 */
+    double   last_detect_ms;  /**< 最近一次：最后一个 ACK → 判定失联 */
+    double   last_ttr_ms;     /**< 最近一次恢复耗时（time-to-recover）：判定失联 → 首个 ACK */
+    double   last_outage_ms;  /**< 最近一次中断时长：最后一个 ACK → 首个 ACK */
+    double   last_ramp_ms;    /**< 最近一次：首个 ACK → 输出回到目标 */
+    double   max_ttr_ms;
+} pwm_host_recovery_t;
+
+/** 填充默认恢复配置 */
+PWMH_API void pwm_host_recovery_default_config(pwm_host_recovery_config_t* cfg);
+
+/**
+ * @brief 启用快速链路恢复（STM32 复位 / 网桥重连后尽快恢复控制）
+ * @param cfg 可为 NULL（默认配置）
+ * @return PWMH_OK / PWMH_EINVAL
+ *
+ * 状态机（收到第一个 HB_ACK 后才开始判定）：
+ *  - NORMAL / RAMP → PROBING：最早一个未应答心跳超过 ack_timeout_ms，或收发报不可达错误（icmp 非零，
+ *    UDP socket 开启 IP_RECVERR 以收到 ICMP）；检测延迟不超过 keepalive_ms + ack_timeout_ms
+ *    （keepalive_ms 为 0 时为 调用方心跳间隔 + ack_timeout_ms），不可达错误即时；
+ *  - PROBING：库每 probe_ms 自动发一帧心跳（不再等 1 Hz 心跳），PWM 帧退回 v1（带完整 SEQ16）；
+ *    距最近 ACK 超过 hold_ms 后 PWM 改发中位，调用方的设定值记为目标；
+ *  - 首个 HB_ACK 到达即恢复并重新同步：设备以随后的 v1 PWM 帧重建去重基准，主机丢弃失联前的冗余副本，
+ *    设备重启（ACK 中 tick 回退）时清空时钟偏移样本，v2 待 ACK 状态位重新协商；
+ *    已回中或设备重启过 → RAMP，否则（短暂中断）直接回到 NORMAL；
+ *  - RAMP：输出 = 中位 + (目标 - 中位) × 进度，ramp_ms 内按 send_hz 由库补发，完成后回到 NORMAL；
+ *    新目标随时生效，向中位方向的变化（含急停）不受渐变限制。
+ *  - 配置在 pwm_host_init 之间保留，状态与统计随会话重置。
+ */
+PWMH_API pwmh_result_t pwm_host_enable_recovery(const pwm_host_recovery_config_t* cfg);
+
+/** 关闭快速恢复（处于 PROBING / RAMP 时立即恢复发送目标值） */
+PWMH_API void pwm_host_disable_recovery(void);
+
+/** 读取恢复状态与统计（含 time-to-recover） */
+PWMH_API void pwm_host_recovery_get(pwm_host_recovery_t* out);
+
+/* ----------------------------- 自适应发送速率 ----------------------------- */
+
+/**
+ * @brief 速率控制配置
+ *
+ * 默认值（pwm_host_rate_default_config）：
+ *  - floor_hz 10，ceil_hz 100，start_hz 50，failsafe_ms 300
+ *  - rtt_factor 2.0，rtt_margin_ms 5，loss_hi 0.02，active_units_per_s 1000
+ */
+typedef struct {
+    double   floor_hz;           /**< 帧率下限（实际下限取 max(floor_hz, 3000/failsafe_ms)） */
+    double   ceil_hz;            /**< 帧率上限（控制循环调用频率应不低于此值） */
+    double   start_hz;           /**< 初始帧率 */
+    uint32_t failsafe_ms;        /**< 设备失联超时（固件 CFG_FAILSAFE_TIMEOUT_MS），据此保证保活帧率 */
+    double   rtt_factor;         /**< RTT 超过 基线×rtt_factor + rtt_margin_ms 视为排队 */
+    double   rtt_margin_ms;
+    double   loss_hi;            /**< 设备侧残余丢包率超过该值视为拥塞（需固件上报 HB_ACK 统计） */
+    double   active_units_per_s; /**< 指令变化速度（协议值/秒）超过该值才提速 */
+} pwm_host_rate_config_t;
+
+/** 填充默认速率控制配置 */
+PWMH_API void pwm_host_rate_default_config(pwm_host_rate_config_t* cfg);
+
+/**
+ * @brief 启用自适应发送速率
+ * @param cfg 可为 NULL（默认配置）
+ * @return PWMH_OK / PWMH_EINVAL
+ *
+ * 行为：
+ *  - 启用后 pwm_host_set_all_u16 / _pct / set_ch_pct 只在“距上一帧 ≥ 1/当前帧率”时立即发送，
+ *    否则仅更新影子值，由 pwm_host_poll() / pwm_host_sleep_ms() 到期发出最新值（中间指令被覆盖）；
+ *  - 每 100ms 评估一次：RTT 抬升、发送错误或设备侧丢包 → 乘性退避；链路健康且指令快速变化 → 加性提速；
+ *    指令平稳 → 缓慢回落到下限；
+ *  - 任何情况下都不低于保活帧率：调用方长时间不下发时，库按下限重发影子值；
+ *  - 配置在 pwm_host_init 之间保留，速率随会话重置为 start_hz。
+ */
+PWMH_API pwmh_result_t pwm_host_enable_rate_control(const pwm_host_rate_config_t* cfg);
+
+/** 关闭速率控制（先发出待发指令），恢复“每次调用即发送” */
+PWMH_API void pwm_host_disable_rate_control(void);
+
+/** 当前 PWM 帧率（Hz）；未启用速率控制时返回配置的 send_hz */
+PWMH_API double pwm_host_rate_hz(void);
+
+/**
+ * @brief 立即发出被速率控制暂缓 / 滞留在邮箱中的最新指令（无待发指令时直接返回 PWMH_OK）
+ * @note  用于急停等不能等待下一个发送时刻的场景；若发送缓冲仍满，该指令升入优先槽，先于心跳冲刷
+ */
+PWMH_API pwmh_result_t pwm_host_flush(void);
+
+/* ----------------------------- 定时应用（设备侧抖动缓冲） ----------------------------- */
+
+/** pwm_host_set_schedule 允许的最大缓冲延迟（须小于固件 CFG_SCHED_MAX_LEAD_MS） */
+#define PWM_HOST_SCHED_MAX_DELAY_MS 250
+
+/**
+ * @brief 启用 / 关闭定时应用
+ * @param delay_ms 0=关闭（发 MSG_PWM，到达即应用）；1..PWM_HOST_SCHED_MAX_DELAY_MS=缓冲延迟
+ * @return PWMH_OK / PWMH_EINVAL
+ *
+ * 行为：
+ *  - 库在每次 HB_ACK 时以 offset = dev_ticks - (t_send + t_recv)/2 估计设备时钟偏移，
+ *    取最近 8 个样本中 RTT 最小者（排队最少、偏移误差最小）；
+ *  - 启用且已有偏移样本时，PWM 帧改为 MSG_PWM_AT，DUE = 主机发送时刻 + 偏移 + delay_ms（设备 tick），
+ *    设备排队后由 1ms 定时中断到点应用，网络与桥接抖动在 delay_ms 内被吸收；
+ *  - 尚无样本（刚初始化、心跳未回）时仍发 MSG_PWM；
+ *  - delay_ms 应覆盖单程延迟 + 抖动，迟到超过固件 CFG_SCHED_LATE_DROP_MS 的指令会被丢弃；
+ *  - 设置在 pwm_host_init 之间保留，偏移样本随会话重置。
+ */
+PWMH_API pwmh_result_t pwm_host_set_schedule(int delay_ms);
+
+/**
+ * @brief 当前设备时钟偏移估计
+ * @param offset_ms 可为 NULL；设备 tick - 主机 tick（ms，按 32 位回绕解释）
+ * @param rtt_ms    可为 NULL；该样本的 RTT（ms）
+ * @return PWMH_OK / PWMH_ENOTINIT（尚无 HB_ACK 样本）
+ */
+PWMH_API pwmh_result_t pwm_host_clock_offset(int32_t* offset_ms, double* rtt_ms);
+
+/* ----------------------------- 紧凑帧 v2（PWM 帧压缩） ----------------------------- */
+
+/** PWM 帧格式 */
+enum {
+    PWM_HOST_PROTO_AUTO = 0,   /**< 协商：设备 HB_ACK 声明支持时发 v2，否则 v1（默认） */
+    PWM_HOST_PROTO_V1   = 1,   /**< 始终 v1 */
+    PWM_HOST_PROTO_V2   = 2    /**< 始终 v2，不等待协商（台架 / 已知固件；不支持的设备会丢弃全部 PWM） */
+};
+
+/** 协商结果的有效期：超过该时间未收到 HB_ACK 即回退 v1，直到下一个声明支持的应答 */
+#define PWM_HOST_PROTO_V2_HOLD_MS 1000
+
+/**
+ * @brief 选择 PWM 帧格式与 v2 通道分辨率
+ * @param mode PWM_HOST_PROTO_AUTO / _V1 / _V2
+ * @param bits 12 或 14（v2 每通道位数；0 = 12）
+ * @return PWMH_OK / PWMH_EINVAL
+ *
+ * 紧凑帧 v2（格式见 protocol_v1.md 4.1c）：
+ *  - SOF 0xAA 0x5A + TYPE|LEN 一字节 + SEQ 低 8 位 + TICK 低 16 位 + 8 路位打包 + CRC，
+ *    12 位 20 字节 / 14 位 22 字节（v1 为 30 字节），定时应用再加 2 字节 DUE16；
+ *  - 12 位码值 = 协议值 × 2/5（步长 2.5 ≈ 0.0125% 占空，中位与两端精确）；14 位无损；
+ *  - 只压缩 PWM 帧（设备以最近的合法 PWM SEQ 就近展开 SEQ8）；心跳仍是 v1（独立 SEQ，上报统计），
+ *    协商也借助心跳：AUTO 模式下 HB_ACK status 带 PWM_HOST_DEV_STATUS_PROTO_V2 时切换，
+ *    不带该位（旧固件）或 PWM_HOST_PROTO_V2_HOLD_MS 内没有应答时回退 v1；
+ *  - 冗余副本、邮箱、速率控制与批量更新对两种格式透明；
+ *  - 设置在 pwm_host_init 之间保留，协商结果随会话重置。
+ */
+PWMH_API pwmh_result_t pwm_host_set_proto(int mode, int bits);
+
+/**
+ * @brief 下一帧 PWM 将使用的格式
+ * @return 1（v1）或 2（v2）
+ */
+PWMH_API int pwm_host_proto_active(void);
+
+/* ----------------------------- COBS 分帧 ----------------------------- */
+
+/** 线上分帧方式 */
+enum {
+    PWM_HOST_FRAMING_RAW  = 0,   /**< 原始帧（设备按 SOF 搜索，默认） */
+    PWM_HOST_FRAMING_COBS = 1    /**< 0x00 + COBS(帧) + 0x00（固件 CFG_PROTO_COBS_ENABLE，见 pwm_cobs.h） */
+};
+
+/**
+ * @brief 选择分帧方式（须与固件 CFG_PROTO_COBS_ENABLE 一致，不做协商）
+ * @return PWMH_OK / PWMH_EINVAL
+ *
+ * COBS 分帧下，设备按 0x00 切分串口字节流，每段解码后恰好一帧：
+ * 负载中出现 0xAA 0x55 不会造成假帧头，损坏后从下一个 0x00 起立即恢复，
+ * 每段最多一次 CRC。每帧多 3 字节（COBS 1 + 首尾分隔符 2）。
+ * 收到的数据报同样按 0x00 切分解码；解码失败计入 rx_err。
+ * 设置在 pwm_host_init 之间保留。
+ */
+PWMH_API pwmh_result_t pwm_host_set_framing(int framing);
+
+/* ----------------------------- 发送节拍监测 ----------------------------- */
+
+/** 间隔直方图桶数（最后一桶为溢出桶） */
+#define PWM_HOST_TXMON_BINS 64
+
+/**
+ * @brief 发送节拍监测配置
+ *
+ * 每发出一帧 PWM（不含冗余副本），记录与上一帧的实际间隔：
+ *  - 标称周期为 1/send_hz，启用速率控制时为 1/当前帧率（保活帧为 1/下限帧率）；
+ *  - 间隔 > 周期 + tolerance_ms 计为 deadline miss；
+ *  - 间隔 < 周期 × burst_ratio 计为追赶帧（控制环超期后补发），一串连续追赶帧计一次追赶突发；
+ *  - 每 window 帧统计一次 miss 比例，≥ alert_miss_rate 时进入告警并回调 on_alert(1, ...)，
+ *    降到一半以下时解除并回调 on_alert(0, ...)。
+ */
+typedef struct {
+    double   tolerance_ms;     /**< 超期容差（默认 5ms） */
+    double   burst_ratio;      /**< 追赶帧判定比例（默认 0.5） */
+    uint32_t bin_us;           /**< 直方图桶宽（微秒，默认 1000） */
+    uint32_t window;           /**< 告警统计窗口（帧数，默认 50） */
+    double   alert_miss_rate;  /**< 告警阈值（默认 0.1；0=不告警） */
+    /** 告警进入 / 解除回调（在发送路径中调用，回调内不可再调用本库发送接口）；可为 NULL */
+    void   (*on_alert)(int active, double miss_rate, void* user);
+    void*    user;
+} pwm_host_txmon_config_t;
+
+/** 发送节拍统计快照 */
+typedef struct {
+    uint64_t frames;                        /**< 已记录的间隔数 */
+    uint32_t hist[PWM_HOST_TXMON_BINS];     /**< 间隔直方图：hist[i] 覆盖 [i, i+1) × bin_us */
+    uint32_t bin_us;
+    double   period_ms;                     /**< 最近一帧的标称周期 */
+    double   mean_ms;
+    double   stddev_ms;
+    double   min_ms;
+    double   max_ms;
+    double   p50_ms;                        /**< 由直方图估计（桶上沿；落在溢出桶时取 max_ms） */
+    double   p99_ms;
+    uint64_t deadline_miss;
+    uint64_t catchup_frames;
+    uint64_t catchup_burst;
+    uint64_t alerts;                        /**< 进入告警的次数 */
+    int      alert_active;
+} pwm_host_txmon_t;
+
+/** 填充默认监测配置 */
+PWMH_API void pwm_host_txmon_default_config(pwm_host_txmon_config_t* cfg);
+
+/**
+ * @brief 设置监测参数（监测始终开启，此处只调整判定与告警）
+ * @param cfg 可为 NULL（恢复默认）
+ * @return PWMH_OK / PWMH_EINVAL
+ * @note  配置在 pwm_host_init 之间保留；修改 bin_us 会清空直方图
+ */
+PWMH_API pwmh_result_t pwm_host_txmon_configure(const pwm_host_txmon_config_t* cfg);
+
+/** 获取节拍统计快照 */
+PWMH_API void pwm_host_txmon_get(pwm_host_txmon_t* out);
+
+/** 清空节拍统计（例如切换控制阶段时） */
+PWMH_API void pwm_host_txmon_reset(void);
+
 /* ----------------------------- 阻塞式渐变（简易） ----------------------------- */
 
 /**
@@ -218,15 +668,78 @@ PWMH_API void pwm_host_get_stats(pwm_host_stats_t* out);
  * 说明：
  *  - 内部以固定步长插值 + 周期发送，直到完成；
  *  - 其他 7 路保持当前值不变；
- *  - 若需非阻塞 / 多路同时渐变，建议上移到“daemon 服务层”统一调度。
+ *  - 若需非阻塞 / 多路同时渐变，建议经 pwm_daemon（pwmd_client.h）提交目标，由其限斜率 step 统一调度。
  */
 PWMH_API pwmh_result_t pwm_host_ramp_pct(int ch, float start_pct, float end_pct, float seconds, int hz);
 
+/* ----------------------------- 时钟与传输注入（仿真 / 回归） ----------------------------- */
+
+/**
+ * @brief 可注入的单调时钟
+ *
+ * 库内所有计时（帧 TICKS、RTT、阻塞渐变的 sleep）以及 pwm_control 的阻塞接口都经由该时钟；
+ * 换成虚拟时钟后，sleep 只推进时间而不真正等待，控制序列可以远快于实时地跑完。
+ */
+typedef struct {
+    uint64_t (*now_ns)(void* user);               /**< 当前时间（纳秒，单调） */
+    void     (*sleep_ns)(void* user, uint64_t ns); /**< 睡眠 ns 纳秒 */
+    void*    user;                                 /**< 回调私有参数 */
+} pwm_host_clock_t;
+
+/**
+ * @brief 设置时钟；clk 为 NULL（或回调不全）时恢复为系统 CLOCK_MONOTONIC
+ */
+PWMH_API void pwm_host_set_clock(const pwm_host_clock_t* clk);
+
+/**
+ * @brief 切换到内置虚拟时钟，初始时间为 start_ns
+ * @note  建议 start_ns 非 0（RTT 匹配以“发送时刻非 0”作为有效标志）
+ */
+PWMH_API void pwm_host_use_virtual_clock(uint64_t start_ns);
+
+/**
+ * @brief 推进内置虚拟时钟（仅在 pwm_host_use_virtual_clock 之后有意义）
+ */
+PWMH_API void pwm_host_vclock_advance_ns(uint64_t ns);
+
+/** 当前时钟读数（纳秒） */
+PWMH_API uint64_t pwm_host_now_ns(void);
+
+/** 当前时钟读数（毫秒，32 位回绕，与帧 TICKS 一致） */
+PWMH_API uint32_t pwm_host_ticks_ms(void);
+
+/** 按当前时钟睡眠（虚拟时钟下立即返回并推进时间） */
+PWMH_API void pwm_host_sleep_ms(double ms);
+
+/**
+ * @brief 可注入的数据报传输（替代 UDP socket）
+ *
+ * - send：发送一整帧，返回已发送字节数，<0 表示失败；
+ * - recv：取一个数据报，timeout_ms 语义同 pwm_host_poll；
+ *         返回字节数（>0）、0（无数据/超时）或 <0（失败）。
+ */
+typedef struct {
+    int   (*send)(void* user, const uint8_t* buf, uint16_t len);
+    int   (*recv)(void* user, uint8_t* buf, uint16_t cap, int timeout_ms);
+    void* user;
+} pwm_host_transport_t;
+
+/**
+ * @brief 使用注入传输初始化（不创建 socket）
+ * @param cfg 可为 NULL；仅使用 send_hz，IP/端口/socket 选项被忽略
+ * @param tp  send/recv 均不可为 NULL
+ * @return PWMH_OK / PWMH_EINVAL
+ *
+ * 用法见 pwm_host_sim.h（进程内 STM32 仿真端点）。pwm_host_close() 会解除注入。
+ */
+PWMH_API pwmh_result_t pwm_host_init_transport(const pwm_host_config_t* cfg,
+                                               const pwm_host_transport_t* tp);
+
 /* ----------------------------- 线程安全性说明 ----------------------------- */
 /*
  * - 本库内部维护一个 UDP socket 与“上次下发的 8 路影子值”，默认实现非线程安全；
  * - 若需要多线程调用，请在外部加互斥锁，或在 .c 实现中加入 pthread_mutex 保护；
- * - 建议：进程内统一通过单线程调度发送，或改用“pwm-daemon 服务层”。
+ * - 建议：进程内统一通过单线程调度发送；多进程共用链路时改用 pwm_daemon 服务层（见 pwmd_client.h）。
  */
 
 #ifdef __cplusplus
@@ -18,6 +18,16 @@ void protocol_pack_init(void);
 bool protocol_pack_pwm(const uint16_t pwm8[8],
                        uint8_t* out_buf, uint16_t out_cap, uint16_t* out_len);
 
+/* 组帧：8路PWM，紧凑帧 v2（SOF 0xAA 0x5A，bits=12 或 14 位打包，20/22 字节；
+ * 仅在设备 HB_ACK 状态位声明支持 v2 后使用，格式见 protocol_v1.md 4.1c） */
+bool protocol_pack_pwm_v2(const uint16_t pwm8[8], int bits,
+                          uint8_t* out_buf, uint16_t out_cap, uint16_t* out_len);
+
+/* COBS 分帧：frame 编码为 0x00 + COBS + 0x00（CFG_PROTO_COBS_ENABLE 固件使用，
+ * 线上最长 n + n/254 + 3 字节；格式见 protocol_v1.md 4.1d） */
+bool protocol_pack_cobs(const uint8_t* frame, uint16_t n,
+                        uint8_t* out_buf, uint16_t out_cap, uint16_t* out_len);
+
 /* 组帧：心跳 */
 bool protocol_pack_heartbeat(uint8_t* out_buf, uint16_t out_cap, uint16_t* out_len);
 
@@ -14,6 +14,20 @@ struct ProtocolV1Packer {
         buf.resize(n);
         return buf;
     }
+    static std::vector<uint8_t> packPWMv2(const std::array<uint16_t,8>& pwm, int bits = 12){
+        std::vector<uint8_t> buf(24); // 6 + 14 + 2 = 22
+        uint16_t n = 0;
+        protocol_pack_pwm_v2(pwm.data(), bits, buf.data(), (uint16_t)buf.size(), &n);
+        buf.resize(n);
+        return buf;
+    }
+    static std::vector<uint8_t> packCobs(const std::vector<uint8_t>& frame){
+        std::vector<uint8_t> buf(frame.size() + frame.size() / 254 + 3);
+        uint16_t n = 0;
+        protocol_pack_cobs(frame.data(), (uint16_t)frame.size(), buf.data(), (uint16_t)buf.size(), &n);
+        buf.resize(n);
+        return buf;
+    }
     static std::vector<uint8_t> packHeartbeat(){
         std::vector<uint8_t> buf(16); // 14 + 0 + 2 = 16
         uint16_t n = 0;
@@ -0,0 +1,92 @@
+#ifndef PWM_COBS_H
+#define PWM_COBS_H
+
+/**
+ * @file    pwm_cobs.h
+ * @brief   COBS 分帧（与固件 cobs.c / CFG_PROTO_COBS_ENABLE 一致），主机侧各编码器共用
+ *
+ * 线上格式：0x00 + COBS(原始 v1/v2 帧) + 0x00
+ *  - COBS 编码后不含 0x00，接收端按 0x00 切分即得帧边界，每段解码后恰好一帧，
+ *    不再逐字节搜 SOF、试算 CRC，损坏后的重同步代价与负载内容无关；
+ *  - 开销：帧 < 254 字节时 COBS +1 字节，加首尾分隔符共 +3 字节；
+ *  - 帧首的 0x00 把线路上残留的半帧 / 噪声截断在上一段，新帧不受其影响。
+ *
+ * 纯头文件（static inline），C / C++ 均可直接包含。
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** n 字节帧 COBS 编码后的最大长度（不含分隔符） */
+#define PWM_COBS_MAX_ENCODED(n) ((n) + ((n) / 254u) + 1u)
+
+/** n 字节帧加首尾分隔符后的线上最大长度 */
+#define PWM_COBS_WIRE_MAX(n)    (PWM_COBS_MAX_ENCODED(n) + 2u)
+
+/**
+ * @brief COBS 编码（不含分隔符）
+ * @param out 容量 >= PWM_COBS_MAX_ENCODED(n)，不可与 in 重叠
+ * @return 编码长度
+ */
+static inline uint16_t pwm_cobs_encode(const uint8_t* in, uint16_t n, uint8_t* out)
+{
+    uint16_t code_pos = 0;
+    uint16_t o        = 1;
+    uint8_t  code     = 1;
+    for (uint16_t i = 0; i < n; ++i) {
+        if (in[i] != 0) {
+            out[o++] = in[i];
+            ++code;
+        }
+        if (in[i] == 0 || code == 0xFF) {
+            out[code_pos] = code;
+            code_pos      = o++;
+            code          = 1;
+        }
+    }
+    out[code_pos] = code;
+    return o;
+}
+
+/**
+ * @brief COBS 解码（可原地：out == in）
+ * @param in 一段不含 0x00 的编码数据
+ * @return 解码长度；格式错误返回 0
+ */
+static inline uint16_t pwm_cobs_decode(const uint8_t* in, uint16_t n, uint8_t* out)
+{
+    uint16_t i = 0;
+    uint16_t o = 0;
+    while (i < n) {
+        const uint8_t code = in[i++];
+        if (code == 0 || (uint32_t)i + code - 1u > n) return 0;
+        for (uint8_t k = 1; k < code; ++k) {
+            if (in[i] == 0) return 0;
+            out[o++] = in[i++];
+        }
+        if (code != 0xFF && i < n) out[o++] = 0;
+    }
+    return o;
+}
+
+/**
+ * @brief 整帧加 COBS 与首尾分隔符
+ * @param out 容量 >= PWM_COBS_WIRE_MAX(n)，不可与 frame 重叠
+ * @return 线上长度
+ */
+static inline uint16_t pwm_cobs_wrap(const uint8_t* frame, uint16_t n, uint8_t* out)
+{
+    out[0] = 0;
+    const uint16_t e = pwm_cobs_encode(frame, n, out + 1);
+    out[1u + e] = 0;
+    return (uint16_t)(e + 2u);
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PWM_COBS_H */
@@ -136,6 +136,7 @@ typedef enum {
 #define PWM_CTRL_ERR_NOT_INIT     -1  /**< 未调用 pwm_ctrl_init */
 #define PWM_CTRL_ERR_INVALID_ARG  -2  /**< 参数非法（通道号/指针等） */
 #define PWM_CTRL_ERR_INTERNAL     -3  /**< 内部错误（如 libpwm_host 发送失败） */
+#define PWM_CTRL_ERR_ESTOP        -4  /**< 急停已锁存，目标设定被拒绝 */
 
 /* ====================================================================== */
 /*                         配置结构体                                     */
@@ -326,16 +327,78 @@ int pwm_ctrl_step(void);
 int pwm_ctrl_hold_pct_blocking(int ch, float pct, float seconds);
 
 /**
- * @brief 紧急归中位：在指定时间内，将所有通道平滑拉回 7.5%
+ * @brief 紧急归中位（阻塞式）：在指定时间内，将所有通道平滑拉回 7.5%
  *
  * @param seconds 归中总时间（秒），<=0 表示“尽快”（仍受 max_step_pct 限制）
  *
  * 典型用法：
- *   - ROV 停机 / 上岸前；
- *   - 检测到通讯异常 / 传感器失效时。
+ *   - ROV 停机 / 上岸前（退出程序时）。
+ *
+ * @return PWM_CTRL_OK：急停已解除、目标为中位；
+ *         PWM_CTRL_ERR_ESTOP：未能在估算步数内归中，急停锁存保持；
+ *         其他负值：step 失败（锁存保持）
+ *
+ * 注意：内部以软急停 + 循环 step 实现；
+ *       运行中的控制循环请改用非阻塞的 pwm_ctrl_estop_engage()。
  */
 int pwm_ctrl_emergency_stop(float seconds);
 
+/* ====================================================================== */
+/*                         非阻塞急停（锁存）                             */
+/* ====================================================================== */
+
+/**
+ * @brief 急停模式
+ */
+typedef enum {
+    PWM_CTRL_ESTOP_NONE = 0,  /**< 未急停 */
+
+    /**
+     * 软急停：由正常的 pwm_ctrl_step() 推进，全部通道同时（忽略 AB 分组）
+     * 向中位渐变，在 seconds 内完成（不慢于 max_step_pct）。
+     */
+    PWM_CTRL_ESTOP_SOFT = 1,
+
+    /**
+     * 硬急停：engage 时立即下发一帧全中位，之后每次 step 重复下发中位帧。
+     */
+    PWM_CTRL_ESTOP_HARD = 2,
+} pwm_ctrl_estop_mode_t;
+
+/**
+ * @brief 急停状态
+ */
+typedef struct {
+    pwm_ctrl_estop_mode_t mode;      /**< 当前模式（NONE 表示未锁存） */
+    int      complete;               /**< 1 = 全部通道已到中位 */
+    uint64_t steps_since_engage;     /**< engage 后已执行的 step 数 */
+    float    max_dev_pct;            /**< 当前距中位的最大偏差（%） */
+} pwm_ctrl_estop_status_t;
+
+/**
+ * @brief 锁存急停（非阻塞，立即返回）
+ *
+ * @param mode    SOFT / HARD
+ * @param seconds SOFT 模式的归中时间（秒），<=0 表示按 max_step_pct 尽快归中；HARD 忽略
+ *
+ * 说明：
+ *  - 急停优先于一切目标：锁存期间 pwm_ctrl_set_* 返回 PWM_CTRL_ERR_ESTOP；
+ *  - 调用方应照常运行控制循环（step / 心跳 / poll），急停不会占用调用线程；
+ *  - 已处于 SOFT 时可升级为 HARD；已处于 HARD 时再次 SOFT 不会降级。
+ */
+int pwm_ctrl_estop_engage(pwm_ctrl_estop_mode_t mode, float seconds);
+
+/**
+ * @brief 解除急停锁存：目标统一置为中位，需由上层重新下达指令
+ * @return PWM_CTRL_OK；未完成归中时返回 PWM_CTRL_ERR_ESTOP（锁存保持）
+ */
+int pwm_ctrl_estop_release(void);
+
+/**
+ * @brief 查询急停状态（out 不可为 NULL）
+ */
+int pwm_ctrl_estop_get_status(pwm_ctrl_estop_status_t* out);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
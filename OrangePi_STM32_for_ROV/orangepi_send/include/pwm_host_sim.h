@@ -0,0 +1,98 @@
+#ifndef PWM_HOST_SIM_H
+#define PWM_HOST_SIM_H
+
+/**
+ * @file    pwm_host_sim.h
+ * @brief   进程内 STM32 仿真端点（虚拟时钟 + 注入传输）
+ *
+ * 用途：
+ *  - 不依赖网络与硬件，在虚拟时间下回放完整控制序列（渐变 / 急停 / RTT / 失联保护）；
+ *  - 仿真端按 protocol_v1 解析帧（SOF/VER/LEN/CRC），与固件相同按 SEQ 去重，
+ *    同时解析紧凑帧 v2（SEQ8 按最近的 SEQ 展开）并在 HB_ACK 状态位声明支持（v1_only 模拟旧固件），
+ *    主机使用 COBS 分帧（pwm_host_set_framing）时自动识别，HB_ACK 以相同分帧回复，
+ *    对 PWM 帧更新 8 路输出，对 HB 帧在 2×latency_ms 后回 HB_ACK（携带链路统计负载），
+ *    PWM_AT 帧不做排队，忽略 DUE 到达即应用（设备时钟与主机时钟相同，偏移估计为 0），
+ *    并按 failsafe_ms 模拟失联回中；
+ *  - pwm_host_sim_outage() 模拟桥接断电 / 板卡复位：中断期间双向不通，复位后 SEQ 基准与 tick 从零开始；
+ *  - 所有 sleep 只推进虚拟时钟，几十秒的序列通常在毫秒级内完成。
+ *
+ * 用法：
+ *
+ *    pwm_host_sim_config_t sc;
+ *    pwm_host_sim_default_config(&sc);
+ *    sc.latency_ms = 5;
+ *    pwm_host_sim_open(&sc, NULL);        // 切换虚拟时钟 + 注入传输
+ *    pwm_ctrl_init(NULL);
+ *    ...                                  // 与实机完全相同的调用
+ *    pwm_host_sim_state_t st;
+ *    pwm_host_sim_get_state(&st);         // 检查设备侧输出 / 失联次数
+ *    pwm_host_sim_close();                // 恢复系统时钟并关闭
+ *
+ * 线程安全：与 libpwm_host 相同，单线程使用。
+ */
+
+#include "libpwm_host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t latency_ms;     /**< 单向链路延迟（ms），HB→HB_ACK 往返为 2 倍（默认 2） */
+    uint32_t failsafe_ms;    /**< 设备侧失联超时（ms），与固件 CFG_FAILSAFE_TIMEOUT_MS 对应（默认 300） */
+    uint32_t drop_every_n;   /**< 主机→设备方向每 N 帧丢 1 帧（0=不丢） */
+    int      v1_only;        /**< 非零则模拟旧固件：不认紧凑帧 v2，HB_ACK 不带 PROTO_V2 状态位（默认 0） */
+    uint64_t start_ns;       /**< 虚拟时钟起点（0 则取 1s） */
+} pwm_host_sim_config_t;
+
+typedef struct {
+    uint16_t duty[PWM_HOST_CH_NUM];  /**< 设备当前输出（协议值 0..10000） */
+    uint16_t last_seq;               /**< 最近一个合法 PWM 帧的 SEQ（心跳另有独立 SEQ 空间） */
+    uint64_t rx_frames;              /**< 合法帧数（含重复副本） */
+    uint64_t rx_pwm;                 /**< PWM 帧数（含 PWM_AT） */
+    uint64_t rx_hb;                  /**< HB 帧数 */
+    uint64_t rx_v2;                  /**< 紧凑帧 v2 数（计入 rx_frames / rx_pwm） */
+    uint64_t tx_hb_ack;              /**< 已投递给主机的 HB_ACK 数 */
+    uint64_t bad_frames;             /**< 解析失败（SOF/VER/LEN/CRC） */
+    uint64_t rx_dup;                 /**< 同 SEQ 重复副本（已丢弃） */
+    uint64_t rx_stale;               /**< 乱序旧帧（已丢弃） */
+    uint64_t seq_gaps;               /**< SEQ 缺口：所有副本均丢失的帧 */
+    uint64_t dropped;                /**< 按 drop_every_n 丢弃的帧 */
+    uint64_t failsafe_trips;         /**< 进入失联保护的次数 */
+    int      failsafe_active;        /**< 当前是否处于失联保护（输出已回中） */
+    uint32_t max_gap_ms;             /**< 相邻合法帧的最大间隔（ms） */
+    uint32_t phase_lag_us;           /**< 立即 PWM 到达 → 下一个 20ms PWM 周期边界的平均等待（EMA，不模拟锁相） */
+    uint64_t outage_drops;           /**< 中断期间丢弃的帧（pwm_host_sim_outage） */
+    uint64_t resets;                 /**< 模拟的设备复位次数 */
+} pwm_host_sim_state_t;
+
+/** 填充默认仿真参数 */
+PWMH_API void pwm_host_sim_default_config(pwm_host_sim_config_t* cfg);
+
+/**
+ * @brief 切换到虚拟时钟并以仿真端点初始化 libpwm_host
+ * @param cfg      可为 NULL（默认参数）
+ * @param host_cfg 可为 NULL；透传给 pwm_host_init_transport
+ */
+PWMH_API pwmh_result_t pwm_host_sim_open(const pwm_host_sim_config_t* cfg,
+                                         const pwm_host_config_t* host_cfg);
+
+/** 关闭 libpwm_host 并恢复系统时钟 */
+PWMH_API void pwm_host_sim_close(void);
+
+/**
+ * @brief 从当前虚拟时刻起模拟链路中断 down_ms
+ *
+ * 中断期间主机发出的帧全部丢弃，在途 HB_ACK 作废；
+ * reset 非零时同时模拟 STM32 复位：输出回中、SEQ 去重基准清除，恢复后 HB_ACK 的 TICKS 从 0 重新计数。
+ */
+PWMH_API void pwm_host_sim_outage(uint32_t down_ms, int reset);
+
+/** 获取设备侧状态快照（会先按当前虚拟时间评估失联保护） */
+PWMH_API void pwm_host_sim_get_state(pwm_host_sim_state_t* out);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PWM_HOST_SIM_H */
@@ -0,0 +1,176 @@
+#ifndef PWM_PLAYER_H
+#define PWM_PLAYER_H
+
+/**
+ * @file    pwm_player.h
+ * @brief   轨迹 / 任务回放：mmap 读取预计算设定值文件，按绝对截止时间经 pwm_control 下发
+ *
+ * 用途：
+ *  - 取代硬编码的测试序列（如 pwm_control_program 中逐段 run_for_seconds），
+ *    离线生成设定值文件后由本模块按时间回放；
+ *  - 文件为紧凑二进制（见 pwm_player_file_hdr_t / pwm_player_rec_t），两种记录：
+ *      · PCT8    ：t + 8 路目标占空比（%，负值 = 中位）；
+ *      · WRENCH6 ：t + 6 自由度力/力矩（Fx Fy Fz Mx My Mz），经配置的推力分配矩阵换算为 8 路占空比；
+ *  - 打开时只校验文件头与长度（O(1)），不解析记录；回放时顺序推进游标，页面按需换入，
+ *    数小时的巡检任务也能立即开始；
+ *  - 时间基准：start 时刻 t0 + 记录时间，控制周期按绝对截止时间推进（超期不追赶、不累积漂移）；
+ *  - 记录标志：LERP 到下一记录线性插值（否则保持到下一记录），ABORT 到达即急停；
+ *    tag 非零的记录可作为跳转点：pwm_player_seek_tag() 在回放中跳转，
+ *    从当前输出经 blend_s 秒线性过渡到新位置的轨迹；
+ *  - 中止：pwm_player_abort() / ABORT 记录 / 外部已锁存急停 / HB_ACK 超时（可选）
+ *    → pwm_ctrl_estop_engage() 锁存急停，回放结束于 PWM_PLAYER_ABORTED。
+ *
+ * 用法（阻塞回放，内部驱动 step / 心跳 / 收包）：
+ *
+ *    pwm_host_init(&host_cfg);
+ *    pwm_ctrl_init(&ctrl_cfg);
+ *    pwm_player_t* p;
+ *    pwm_player_open("survey.pwmt", NULL, &p);
+ *    pwm_player_run(p, 100, &g_stop);            // 100ms 心跳；g_stop 置位即中止
+ *    pwm_player_close(p);
+ *
+ * 嵌入已有控制循环时改用 pwm_player_start() + 每周期 pwm_player_tick()（只设定目标，step 由调用者执行）。
+ *
+ * 文件字节序为小端（与 OrangePi / x86 主机一致），可用 tools 中的 pwm_mission 由文本脚本生成。
+ *
+ * 线程安全：与 libpwm_host 相同，单线程使用。
+ */
+
+#include "libpwm_host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWM_PLAYER_MAGIC    0x544D5750u   /**< "PWMT"（小端） */
+#define PWM_PLAYER_VERSION  1u
+
+/** 记录类型 */
+typedef enum {
+    PWM_PLAYER_KIND_PCT8    = 1,   /**< v[0..7] = CH1..CH8 目标占空比（%） */
+    PWM_PLAYER_KIND_WRENCH6 = 2    /**< v[0..5] = Fx Fy Fz Mx My Mz（单位由分配矩阵决定），v[6..7] 未用 */
+} pwm_player_kind_t;
+
+/** 记录标志 */
+#define PWM_PLAYER_REC_LERP   0x0001u  /**< 到下一记录之间线性插值 */
+#define PWM_PLAYER_REC_ABORT  0x0002u  /**< 到达即中止并急停（任务内的安全终止点） */
+
+/** 文件头（32 字节） */
+typedef struct {
+    uint32_t magic;        /**< PWM_PLAYER_MAGIC */
+    uint16_t version;      /**< PWM_PLAYER_VERSION */
+    uint16_t kind;         /**< pwm_player_kind_t */
+    uint32_t rec_size;     /**< 单条记录字节数（sizeof(pwm_player_rec_t)，留作扩展） */
+    uint32_t reserved;
+    uint64_t count;        /**< 记录条数 */
+    uint64_t duration_ns;  /**< 最后一条记录的时间 */
+} pwm_player_file_hdr_t;
+
+/** 记录（48 字节），t_ns 单调不减 */
+typedef struct {
+    uint64_t t_ns;         /**< 相对任务开始的时间 */
+    uint16_t flags;        /**< PWM_PLAYER_REC_* */
+    uint16_t tag;          /**< 跳转标签，0 = 无 */
+    uint32_t reserved;
+    float    v[PWM_HOST_CH_NUM];
+} pwm_player_rec_t;
+
+/** 回放状态 */
+typedef enum {
+    PWM_PLAYER_IDLE    = 0,  /**< 已打开，未开始 */
+    PWM_PLAYER_RUNNING = 1,
+    PWM_PLAYER_DONE    = 2,  /**< 播放到最后一条记录（末条目标保持） */
+    PWM_PLAYER_ABORTED = 3   /**< 已中止并锁存急停 */
+} pwm_player_status_t;
+
+/** 回放配置 */
+typedef struct {
+    double   ctrl_hz;           /**< pwm_player_run 的控制频率（默认 50） */
+    uint8_t  mask;              /**< 回放驱动的通道（默认 0xFF；未选中的通道保持原目标） */
+    float    blend_in_s;        /**< 开始时从当前输出过渡到首条记录的时间（默认 0 = 直接交给限斜率） */
+    int      abort_hard;        /**< 中止方式：非零 HARD（立即中位），0 SOFT（默认） */
+    float    abort_s;           /**< SOFT 中止归中时间（默认 1.0） */
+    uint32_t abort_on_ack_ms;   /**< pwm_player_run 中超过该时间未收到 HB_ACK 即中止（0 = 不检查） */
+    /**
+     * WRENCH6 推力分配：u = alloc · w，u 为 8 个推进器的归一化指令（-1..1）。
+     * 任一 |u| > 1 时整体等比缩放（保持力的方向），再映射为 中位 ± u × 半量程。
+     * WRENCH6 文件要求矩阵非全零。
+     */
+    float    alloc[PWM_HOST_CH_NUM][6];
+    float    min_pct;           /**< 映射范围（默认 5 / 7.5 / 10，与 pwm_control 一致） */
+    float    mid_pct;
+    float    max_pct;
+} pwm_player_config_t;
+
+/** 文件 / 回放信息 */
+typedef struct {
+    pwm_player_kind_t   kind;
+    uint64_t            count;         /**< 记录条数 */
+    uint64_t            duration_ns;
+    pwm_player_status_t status;
+    uint64_t            t_ns;          /**< 当前回放时间（相对 t0） */
+    uint64_t            index;         /**< 当前记录下标 */
+    uint64_t            ticks;         /**< 已执行的 tick 数 */
+    uint64_t            late_ticks;    /**< run 中超过截止时间的周期数 */
+    uint64_t            saturated;     /**< WRENCH6 分配饱和（被等比缩放）的 tick 数 */
+    const char*         abort_reason;  /**< 中止原因（静态字符串），未中止为 NULL */
+} pwm_player_info_t;
+
+typedef struct pwm_player pwm_player_t;
+
+/** 填充默认配置（alloc 全零） */
+PWMH_API void pwm_player_default_config(pwm_player_config_t* cfg);
+
+/**
+ * @brief 打开并映射设定值文件（只校验文件头与长度，不解析记录）
+ * @param cfg 可为 NULL（默认配置；WRENCH6 文件此时返回 PWMH_EINVAL）
+ * @return PWMH_OK / PWMH_EINVAL（格式不符、长度不足、WRENCH6 缺分配矩阵）/ PWMH_ESYS（open / mmap 失败）
+ */
+PWMH_API pwmh_result_t pwm_player_open(const char* path, const pwm_player_config_t* cfg,
+                                       pwm_player_t** out);
+
+/** 解除映射并释放；p 可为 NULL。不改变 pwm_control 状态 */
+PWMH_API void pwm_player_close(pwm_player_t* p);
+
+/**
+ * @brief 以 t0_ns（pwm_host_now_ns() 时基）为任务零点开始回放
+ * @param t0_ns 0 = 当前时刻
+ * @return PWMH_OK / PWMH_EINVAL / PWMH_EBUSY（pwm_control 急停锁存中）
+ */
+PWMH_API pwmh_result_t pwm_player_start(pwm_player_t* p, uint64_t t0_ns);
+
+/**
+ * @brief 按当前时刻推进游标并设定目标（pwm_ctrl_set_targets_mask），不执行 step
+ * @return 当前状态（RUNNING / DONE / ABORTED）
+ */
+PWMH_API pwm_player_status_t pwm_player_tick(pwm_player_t* p);
+
+/**
+ * @brief 阻塞回放到结束：按绝对截止时间循环 tick + pwm_ctrl_step + 心跳 + 收包
+ * @param hb_ms 心跳间隔（ms，<=0 取 100）
+ * @param stop  可为 NULL；外部置非零即中止（急停）
+ * @return 最终状态（DONE / ABORTED）
+ */
+PWMH_API pwm_player_status_t pwm_player_run(pwm_player_t* p, int hb_ms, volatile int* stop);
+
+/**
+ * @brief 跳转到第一条 tag 匹配的记录（从当前游标向后查找，找不到再从头查找）
+ * @param blend_s 从当前输出过渡到新轨迹的时间（<=0 直接交给限斜率）
+ * @return PWMH_OK / PWMH_EINVAL（无此标签）/ PWMH_ENOTINIT（未在回放中）
+ */
+PWMH_API pwmh_result_t pwm_player_seek_tag(pwm_player_t* p, uint16_t tag, float blend_s);
+
+/**
+ * @brief 中止回放并锁存急停（cfg.abort_hard / abort_s）
+ * @param reason 静态字符串（记录在 info.abort_reason），可为 NULL
+ */
+PWMH_API void pwm_player_abort(pwm_player_t* p, const char* reason);
+
+/** 读取文件与回放信息 */
+PWMH_API void pwm_player_get_info(const pwm_player_t* p, pwm_player_info_t* out);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PWM_PLAYER_H */
@@ -0,0 +1,142 @@
+#ifndef PWMD_CLIENT_H
+#define PWMD_CLIENT_H
+
+/**
+ * @file    pwmd_client.h
+ * @brief   pwm-daemon 服务层客户端接口（多进程共用一条链路）
+ *
+ * 架构：
+ *  - pwm_daemon 是链路的唯一持有者：UDP socket、SEQ、pwm_control 限斜率 step、心跳与失联策略都在守护进程内；
+ *  - 客户端（驾驶界面 / 自动驾驶 / Python 脚本）经 Unix socket 注册一次（名称 + 优先级），
+ *    之后只通过共享内存交互：
+ *      · 每个客户端一条单生产者单消费者无锁环，提交目标 / 急停 / 保活指令，不做系统调用；
+ *      · 守护进程每个控制周期发布一份 seqlock 状态快照（输出、控制权、链路、急停），客户端无锁读取；
+ *  - 仲裁：租约内（最近 lease_ms 内有提交）的客户端中优先级最高者持有控制权，同级时保持现持有者；
+ *    持有者停止提交（进程卡死 / 退出）后控制权自动交给下一个，没有任何客户端时目标回中位；
+ *    交接由 pwm_control 限斜率平滑过渡；
+ *  - 急停任意客户端都可锁存，只有优先级不低于锁存者的客户端可以解除；解除后所有客户端需重新提交目标；
+ *  - Unix socket 仅用于注册 / 调整优先级；连接断开即释放槽位（进程崩溃也会被回收）。
+ *
+ * 用法：
+ *
+ *    pwmd_client_t* c;
+ *    pwmd_connect(NULL, "autopilot", 10, &c);      // 默认 socket PWMD_DEFAULT_SOCK
+ *    float pct[8] = { 8.0f, 8.0f, -1, -1, -1, -1, -1, -1 };
+ *    while (running) {
+ *        pwmd_set_targets_pct(c, 0xFF, pct);        // 每个周期提交，同时续租
+ *        pwmd_state_t st;
+ *        pwmd_get_state(c, &st);                    // st.owner == pwmd_slot(c) 表示本客户端在控制
+ *        ...
+ *    }
+ *    pwmd_disconnect(c);
+ *
+ * 线程安全：同一 pwmd_client_t 的提交接口只能由一个线程调用（单生产者）；pwmd_get_state 可任意线程调用。
+ */
+
+#include "libpwm_host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWMD_DEFAULT_SOCK  "/tmp/pwmd.sock"   /**< 默认控制 socket 路径 */
+#define PWMD_DEFAULT_SHM   "/pwmd"            /**< 默认共享内存名（shm_open） */
+#define PWMD_MAX_CLIENTS   8                  /**< 同时注册的客户端上限 */
+#define PWMD_NAME_MAX      24                 /**< 客户端名称长度上限（含结尾 0） */
+#define PWMD_PRIO_MIN      0
+#define PWMD_PRIO_MAX      100
+
+typedef struct pwmd_client pwmd_client_t;
+
+/** 单个客户端槽位（快照内） */
+typedef struct {
+    int      in_use;                 /**< 槽位已注册 */
+    int      priority;               /**< 优先级（越大越优先） */
+    int      live;                   /**< 租约有效（最近 lease_ms 内有提交） */
+    uint32_t pid;                    /**< 注册进程 PID */
+    uint64_t cmds;                   /**< 守护进程已取出的指令数 */
+    char     name[PWMD_NAME_MAX];
+} pwmd_client_info_t;
+
+/** 守护进程状态快照（每个控制周期发布一次） */
+typedef struct {
+    uint64_t update;                         /**< 快照序号（每周期 +1，可用于判断守护进程是否存活） */
+    uint64_t t_ns;                           /**< 发布时刻（CLOCK_MONOTONIC，纳秒） */
+    double   ctrl_hz;                        /**< 控制频率 */
+    float    current_pct[PWM_HOST_CH_NUM];   /**< 已下发占空比 */
+    float    target_pct[PWM_HOST_CH_NUM];    /**< 当前生效目标 */
+    int      owner;                          /**< 持有控制权的槽位，-1 = 无（目标中位） */
+    int      estop_mode;                     /**< pwm_ctrl_estop_mode_t */
+    int      estop_complete;                 /**< 已全部回到中位 */
+    int      estop_slot;                     /**< 锁存急停的槽位，-1 = 无（或锁存者已断开，急停仍可能锁存） */
+    double   rtt_ms;                         /**< 最近心跳 RTT，无则 <0 */
+    uint32_t hb_ack_age_ms;                  /**< 距最近一次 HB_ACK（ms），从未收到为 UINT32_MAX */
+    uint16_t dev_status;                     /**< 设备状态位（PWM_HOST_DEV_STATUS_*） */
+    int32_t  dev_phase_lag_us;
+    uint64_t tx_pwm;
+    uint64_t tx_hb;
+    uint64_t rx_hb_ack;
+    uint64_t tx_err;
+    uint32_t cmd_latency_us_max;             /**< 客户端提交 → 守护进程取出的最大延迟（μs，最近 1s） */
+    pwmd_client_info_t clients[PWMD_MAX_CLIENTS];
+} pwmd_state_t;
+
+/**
+ * @brief 连接守护进程并注册
+ * @param sock_path 控制 socket（NULL = PWMD_DEFAULT_SOCK）
+ * @param name      客户端名称（显示 / 日志用，超长截断）
+ * @param priority  PWMD_PRIO_MIN..PWMD_PRIO_MAX
+ * @param out       成功时返回句柄
+ * @return PWMH_OK / PWMH_EINVAL / PWMH_ESYS（连接或映射失败）/ PWMH_EBUSY（槽位已满）
+ */
+PWMH_API pwmh_result_t pwmd_connect(const char* sock_path, const char* name, int priority,
+                                    pwmd_client_t** out);
+
+/** 注销并释放句柄（关闭控制连接，守护进程回收槽位）；c 可为 NULL */
+PWMH_API void pwmd_disconnect(pwmd_client_t* c);
+
+/** 本客户端的槽位号（与 pwmd_state_t.owner / clients[] 对应） */
+PWMH_API int pwmd_slot(const pwmd_client_t* c);
+
+/**
+ * @brief 调整优先级（经控制 socket，非实时路径）；只能调低，不能高于 pwmd_connect 时的值
+ * @return PWMH_OK / PWMH_EINVAL（越界或试图调高）/ PWMH_ESYS
+ */
+PWMH_API pwmh_result_t pwmd_set_priority(pwmd_client_t* c, int priority);
+
+/**
+ * @brief 提交目标占空比（写共享内存环，不阻塞、无系统调用），同时续租
+ * @param mask bit0→CH1 ... bit7→CH8，未选中的通道保持本客户端上次的目标
+ * @param pct  8 路百分比，负值表示中位
+ * @return PWMH_OK / PWMH_EINVAL / PWMH_EBUSY（环满，守护进程未及时取出；计 dropped）
+ */
+PWMH_API pwmh_result_t pwmd_set_targets_pct(pwmd_client_t* c, uint8_t mask,
+                                            const float pct[PWM_HOST_CH_NUM]);
+
+/** 仅续租（保持控制权而不改变目标） */
+PWMH_API pwmh_result_t pwmd_keepalive(pwmd_client_t* c);
+
+/**
+ * @brief 锁存急停
+ * @param hard    非零 = HARD（立即中位），0 = SOFT（seconds 内渐变回中位）
+ * @param seconds SOFT 归中时间，<=0 按 max_step 尽快
+ */
+PWMH_API pwmh_result_t pwmd_estop(pwmd_client_t* c, int hard, float seconds);
+
+/** 请求解除急停（优先级低于锁存者、或尚未归中完成时守护进程忽略，可查看快照重试） */
+PWMH_API pwmh_result_t pwmd_estop_release(pwmd_client_t* c);
+
+/**
+ * @brief 读取状态快照（seqlock，无锁；写入冲突时自动重读）
+ * @return PWMH_OK / PWMH_EINVAL / PWMH_EBUSY（守护进程持续写入，重试次数用尽）
+ */
+PWMH_API pwmh_result_t pwmd_get_state(const pwmd_client_t* c, pwmd_state_t* out);
+
+/** 本客户端因环满被拒绝的提交数 */
+PWMH_API uint64_t pwmd_dropped(const pwmd_client_t* c);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PWMD_CLIENT_H */
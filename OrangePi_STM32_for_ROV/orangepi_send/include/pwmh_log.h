@@ -0,0 +1,102 @@
+#ifndef PWMH_LOG_H
+#define PWMH_LOG_H
+
+/**
+ * @file    pwmh_log.h
+ * @brief   异步结构化日志：控制环只写二进制记录，后台线程格式化输出
+ *
+ * 设计：
+ *  - 热路径（pwmh_log_emit）只做三件事：读时钟、按格式串把参数取进定长记录、无锁入环；
+ *    不格式化、不加锁、不做系统调用。环满时丢弃并计数，绝不阻塞；
+ *  - 格式串即“格式 ID”：必须是字符串字面量（记录只保存指针）。参数按 printf 转换说明取值，
+ *    支持整数 / 浮点 / 字符 / 指针 / 字符串，不支持 '*' 宽度与 %n；
+ *    %s 参数会被复制进记录（合计最多 PWMH_LOG_STR_CAP 字节，超出截断），可以传临时字符串；
+ *  - 后台线程每 flush_ms 取尽环、格式化并批量 write 到 fd（默认 stderr）。
+ *    终端慢 / SSH 卡顿只会让环变满（dropped 增长），不会拉长控制周期；
+ *  - 多生产者安全（任意线程可写），后台线程为唯一消费者；
+ *  - 未启动（或已停止）时退化为同步写 stderr，便于启动前后的少量日志。
+ *
+ * 用法：
+ *
+ *    pwmh_log_start(NULL);
+ *    PWMH_LOGI("[STAT] tx_pwm=%llu rtt=%.2f ms", (unsigned long long)st.tx_pwm, rtt);
+ *    ...
+ *    pwmh_log_stop();   // 取尽剩余记录后返回
+ *
+ * 线程约束：start / stop 与写日志的线程之间需由调用方保证先后（停止后不再有并发写入）。
+ */
+
+#include "libpwm_host.h"
+
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PWMH_LOG_PRINTF(fmt_idx, arg_idx) __attribute__((format(printf, fmt_idx, arg_idx)))
+#else
+#define PWMH_LOG_PRINTF(fmt_idx, arg_idx)
+#endif
+
+#define PWMH_LOG_MAX_ARGS 12   /**< 每条记录最多参数个数（超出部分不输出，计 truncated） */
+#define PWMH_LOG_STR_CAP  48   /**< 每条记录内 %s 参数的复制空间（字节，含结尾 0） */
+
+typedef enum {
+    PWMH_LOG_DEBUG = 0,
+    PWMH_LOG_INFO,
+    PWMH_LOG_WARN,
+    PWMH_LOG_ERROR
+} pwmh_log_level_t;
+
+typedef struct {
+    unsigned ring_records;   /**< 环容量（记录数，向上取 2 的幂，默认 1024） */
+    int      fd;             /**< 输出 fd（默认 2 = stderr） */
+    int      min_level;      /**< 低于该级别的记录在热路径直接丢弃（默认 PWMH_LOG_INFO） */
+    int      flush_ms;       /**< 后台线程空闲时的轮询间隔（默认 5ms） */
+    int      json;           /**< 非零输出 JSON Lines：{"t":秒,"lvl":..,"msg":..,"args":[..]} */
+} pwmh_log_config_t;
+
+typedef struct {
+    uint64_t written;        /**< 已输出的记录数 */
+    uint64_t dropped;        /**< 环满丢弃的记录数 */
+    uint64_t truncated;      /**< 参数或字符串被截断的记录数 */
+} pwmh_log_stats_t;
+
+/** 填充默认配置 */
+PWMH_API void pwmh_log_default_config(pwmh_log_config_t* cfg);
+
+/**
+ * @brief 分配环并启动后台输出线程
+ * @param cfg 可为 NULL（默认配置）
+ * @return PWMH_OK / PWMH_EINVAL / PWMH_EBUSY（已在运行）/ PWMH_ESYS（内存或线程创建失败）
+ */
+PWMH_API pwmh_result_t pwmh_log_start(const pwmh_log_config_t* cfg);
+
+/** 停止后台线程（先输出环中剩余记录）；未启动时无操作 */
+PWMH_API void pwmh_log_stop(void);
+
+/**
+ * @brief 写一条日志（热路径，非阻塞）
+ * @param level 级别
+ * @param fmt   printf 格式串，必须是字符串字面量
+ */
+PWMH_API void pwmh_log_emit(pwmh_log_level_t level, const char* fmt, ...) PWMH_LOG_PRINTF(2, 3);
+
+/** va_list 版本 */
+PWMH_API void pwmh_log_emitv(pwmh_log_level_t level, const char* fmt, va_list ap) PWMH_LOG_PRINTF(2, 0);
+
+/** 统计快照 */
+PWMH_API void pwmh_log_get_stats(pwmh_log_stats_t* out);
+
+#define PWMH_LOGD(...) pwmh_log_emit(PWMH_LOG_DEBUG, __VA_ARGS__)
+#define PWMH_LOGI(...) pwmh_log_emit(PWMH_LOG_INFO, __VA_ARGS__)
+#define PWMH_LOGW(...) pwmh_log_emit(PWMH_LOG_WARN, __VA_ARGS__)
+#define PWMH_LOGE(...) pwmh_log_emit(PWMH_LOG_ERROR, __VA_ARGS__)
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PWMH_LOG_H */
@@ -0,0 +1,56 @@
+#ifndef PWMH_TRACE_H
+#define PWMH_TRACE_H
+
+/**
+ * @file    pwmh_trace.h
+ * @brief   上位机控制链路的 USDT（SystemTap SDT）静态探针
+ *
+ * 用途：
+ *  - 在现场（实船）用 bpftrace / perf / SystemTap 按“阶段”拆分指令延迟，
+ *    无需重新编译加 printf，也不改变控制环时序；
+ *  - 探针 provider 统一为 "pwm_host"，脚本见 tools/bpftrace/。
+ *
+ * 开销：
+ *  - 启用（定义 PWMH_ENABLE_USDT，且系统提供 <sys/sdt.h>）时，每个探针只是一条 nop，
+ *    参数仅在 .note.stapsdt 中描述位置，未挂载追踪器时不做任何额外工作；
+ *  - 未启用时宏展开为空语句，参数不会被求值（sizeof 不求值，仅用于消除未使用告警）。
+ *
+ * 探针列表（参数均为整数）：
+ *  - target_set      (ch, pct_x100)          pwm_control：设定目标（ch=0 表示按掩码批量设定，第二参为掩码）
+ *  - step_computed   (step_count, mask)      pwm_control：一次 step 计算完成（即将下发）
+ *  - estop_engage    (mode, seconds_x1000)   pwm_control：急停锁存 / 解除（mode=0 表示解除）
+ *  - frame_encoded   (msg_id, seq, len)      libpwm_host：组帧完成
+ *  - sendto_ret      (msg_id, seq, ret, err) libpwm_host：sendto 返回（ret<0 时 err=errno）
+ *  - datagram_rx     (len, msg_id)           libpwm_host：收到一个 UDP 数据报
+ *  - ack_matched     (seq, rtt_ms)           libpwm_host：HB_ACK 与最近一次心跳匹配
+ *  - link_switch     (from, to, ack_age_ms)  libpwm_host：热备主备切换（ack_age_ms 为原链路最近 ACK 距今）
+ *  - rate_change     (hz_x10, reason)        libpwm_host：自适应帧率变化（0=退避 1=提速 2=回落 3=重置）
+ *  - tx_interval     (interval_us, period_us, verdict) libpwm_host：相邻 PWM 帧实际间隔（0=准时 1=超期 2=追赶）
+ *  - link_recovery   (state, ms)             libpwm_host：快速恢复状态变化（1=判定失联，ms 为距最近 ACK；
+ *                                            2/0=恢复进入 RAMP / NORMAL，ms 为恢复耗时；RAMP 结束时为 0，ms 为渐变耗时）
+ *  - udp_sendto_ret  (data, size, ret)       UdpSender：sendto 返回（data 为帧首地址，可读 SEQ）
+ *  - udp_datagram_rx (data, len)             UdpSender：收到一个 UDP 数据报
+ */
+
+#ifdef PWMH_ENABLE_USDT
+#include <sys/sdt.h>
+
+#define PWMH_TRACE1(name, a1)                 DTRACE_PROBE1(pwm_host, name, a1)
+#define PWMH_TRACE2(name, a1, a2)             DTRACE_PROBE2(pwm_host, name, a1, a2)
+#define PWMH_TRACE3(name, a1, a2, a3)         DTRACE_PROBE3(pwm_host, name, a1, a2, a3)
+#define PWMH_TRACE4(name, a1, a2, a3, a4)     DTRACE_PROBE4(pwm_host, name, a1, a2, a3, a4)
+
+#else
+
+#define PWMH_TRACE1(name, a1) \
+    do { (void)sizeof(a1); } while (0)
+#define PWMH_TRACE2(name, a1, a2) \
+    do { (void)sizeof(a1); (void)sizeof(a2); } while (0)
+#define PWMH_TRACE3(name, a1, a2, a3) \
+    do { (void)sizeof(a1); (void)sizeof(a2); (void)sizeof(a3); } while (0)
+#define PWMH_TRACE4(name, a1, a2, a3, a4) \
+    do { (void)sizeof(a1); (void)sizeof(a2); (void)sizeof(a3); (void)sizeof(a4); } while (0)
+
+#endif /* PWMH_ENABLE_USDT */
+
+#endif /* PWMH_TRACE_H */
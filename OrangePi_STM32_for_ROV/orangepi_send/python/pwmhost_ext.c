@@ -0,0 +1,516 @@
+/**
+ * @file    pwmhost_ext.c
+ * @brief   libpwm_host 的 CPython 扩展模块（模块名 pwmhost）
+ *
+ * 与 ctypes 逐通道调用相比：
+ *  - 批量接口直接接收 buffer protocol 对象（bytes/array/numpy），一次调用下发 N 帧；
+ *  - 后台控制线程在 C 中运行 step + 心跳 + 收包，全程不持有 GIL；
+ *  - 统计/状态以 memoryview 形式暴露（零拷贝，直接映射模块内静态缓冲）。
+ *
+ * Python 侧示例：
+ *
+ *    import numpy as np, pwmhost
+ *    pwmhost.init("192.168.2.16", 8000, 100)
+ *    pwmhost.start(ctrl_hz=100.0, hb_hz=1, max_step_pct=0.2)
+ *    pwmhost.set_targets(np.full(8, 7.5, dtype=np.float32))
+ *    traj = np.linspace(7.5, 8.5, 500, dtype=np.float32)[:, None].repeat(8, axis=1)
+ *    pwmhost.play(traj)                 # 每个控制 tick 消费一行
+ *    st = np.frombuffer(pwmhost.stats(), dtype=np.uint64)   # 实时视图
+ *    pwmhost.stop(); pwmhost.close()
+ *
+ * 线程模型：
+ *  - libpwm_host / pwm_control 为单实例、非线程安全；后台线程运行期间，
+ *    直接发送类接口（send_u16 / send_batch）返回 RuntimeError（EBUSY）；
+ *  - send_batch 释放 GIL 期间置 s_busy，其余 Python 线程调用任何会触及库的接口
+ *    同样返回 EBUSY（s_busy 只在持有 GIL 时读写）；
+ *  - Python 线程与后台线程之间只通过 s_mu 保护的“待应用目标/轨迹”交换数据。
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+#include "libpwm_host.h"
+#include "pwm_control.h"
+
+/* ============================ 内部状态 ============================ */
+
+enum {
+    STAT_TX_PWM = 0,
+    STAT_TX_HB,
+    STAT_RX_HB_ACK,
+    STAT_TX_ERR,
+    STAT_RX_ERR,
+    STAT_TICKS,      /* 后台线程已执行的控制 tick 数 */
+    STAT_TRAJ_LEFT,  /* 轨迹队列剩余行数 */
+    STAT_NUM
+};
+
+/* 零拷贝导出的缓冲（memoryview 直接指向这里） */
+static uint64_t   s_stats_buf[STAT_NUM];
+static float      s_state_buf[2 * PWM_HOST_CH_NUM];   /* [0..7]=current, [8..15]=target */
+static Py_ssize_t s_stats_shape[1] = { STAT_NUM };
+static Py_ssize_t s_state_shape[2] = { 2, PWM_HOST_CH_NUM };
+static Py_ssize_t s_stats_strides[1] = { sizeof(uint64_t) };
+static Py_ssize_t s_state_strides[2] = { PWM_HOST_CH_NUM * sizeof(float), sizeof(float) };
+
+static int             s_inited = 0;
+static pthread_t       s_thr;
+static int             s_thr_running = 0;
+static int             s_busy = 0;      /* send_batch 正在无 GIL 发送（持 GIL 访问） */
+static atomic_int      s_thr_stop;
+static pthread_mutex_t s_mu = PTHREAD_MUTEX_INITIALIZER;
+
+/* 由 s_mu 保护 */
+static float   s_pending_target[PWM_HOST_CH_NUM];
+static int     s_pending_dirty = 0;
+static float*  s_traj      = NULL;   /* rows × 8，C 连续 */
+static size_t  s_traj_rows = 0;
+static size_t  s_traj_pos  = 0;
+
+/* 线程参数 */
+static double s_ctrl_hz = 50.0;
+static int    s_hb_hz   = 1;
+
+/* ============================ 工具函数 ============================ */
+
+static uint64_t mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* 以绝对时刻睡眠（不累积漂移） */
+static void sleep_until_ns(uint64_t deadline_ns)
+{
+    struct timespec ts;
+    ts.tv_sec  = (time_t)(deadline_ns / 1000000000ull);
+    ts.tv_nsec = (long)(deadline_ns % 1000000000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+static void refresh_stats(void)
+{
+    pwm_host_stats_t st;
+    pwm_host_get_stats(&st);
+    s_stats_buf[STAT_TX_PWM]    = st.tx_pwm;
+    s_stats_buf[STAT_TX_HB]     = st.tx_hb;
+    s_stats_buf[STAT_RX_HB_ACK] = st.rx_hb_ack;
+    s_stats_buf[STAT_TX_ERR]    = st.tx_err;
+    s_stats_buf[STAT_RX_ERR]    = st.rx_err;
+}
+
+static void refresh_state(void)
+{
+    pwm_ctrl_state_t cs;
+    pwm_ctrl_get_state(&cs);
+    memcpy(&s_state_buf[0],               cs.current_pct, sizeof(cs.current_pct));
+    memcpy(&s_state_buf[PWM_HOST_CH_NUM], cs.target_pct,  sizeof(cs.target_pct));
+}
+
+static PyObject* raise_rc(pwmh_result_t rc)
+{
+    if (rc == PWMH_ESYS) {
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    PyErr_Format(PyExc_RuntimeError, "libpwm_host: %s", pwm_host_strerror(rc));
+    return NULL;
+}
+
+/**
+ * @brief 取得 rows × 8 的 C 连续缓冲（允许一维长度为 8 的整数倍）
+ * @param fmt_ok 期望的 struct 格式字符（'H' 或 'f'）
+ */
+static int get_rows_buffer(PyObject* obj, Py_buffer* view, char fmt_ok, size_t* rows)
+{
+    if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+        return -1;
+    }
+    const char* fmt = view->format ? view->format : "B";
+    if (fmt[0] == '<' || fmt[0] == '=' || fmt[0] == '@') ++fmt;
+    if (fmt[0] != fmt_ok || fmt[1] != '\0') {
+        PyErr_Format(PyExc_TypeError, "expected buffer of format '%c' (got '%s')",
+                     fmt_ok, view->format ? view->format : "B");
+        PyBuffer_Release(view);
+        return -1;
+    }
+    const Py_ssize_t n = view->len / view->itemsize;
+    if (n <= 0 || (n % PWM_HOST_CH_NUM) != 0) {
+        PyErr_SetString(PyExc_ValueError, "buffer length must be a positive multiple of 8");
+        PyBuffer_Release(view);
+        return -1;
+    }
+    *rows = (size_t)(n / PWM_HOST_CH_NUM);
+    return 0;
+}
+
+static int check_idle(void)
+{
+    if (!s_inited) {
+        raise_rc(PWMH_ENOTINIT);
+        return -1;
+    }
+    if (s_thr_running || s_busy) {
+        raise_rc(PWMH_EBUSY);
+        return -1;
+    }
+    return 0;
+}
+
+/* ============================ 后台控制线程 ============================ */
+
+static void* ctrl_thread_main(void* arg)
+{
+    (void)arg;
+
+    const uint64_t period_ns = (uint64_t)(1e9 / s_ctrl_hz);
+    const uint64_t hb_ns     = (s_hb_hz > 0) ? (uint64_t)(1e9 / s_hb_hz) : (uint64_t)0;
+
+    uint64_t t_next    = mono_ns();
+    uint64_t t_next_hb = t_next;
+
+    while (!atomic_load(&s_thr_stop)) {
+        /* 1) 取走 Python 侧提交的目标 / 轨迹行（只在锁内拷贝） */
+        float row[PWM_HOST_CH_NUM];
+        int   have_row = 0;
+        pthread_mutex_lock(&s_mu);
+        if (s_traj && s_traj_pos < s_traj_rows) {
+            memcpy(row, s_traj + s_traj_pos * PWM_HOST_CH_NUM, sizeof(row));
+            ++s_traj_pos;
+            have_row = 1;
+        } else if (s_pending_dirty) {
+            memcpy(row, s_pending_target, sizeof(row));
+            s_pending_dirty = 0;
+            have_row = 1;
+        }
+        s_stats_buf[STAT_TRAJ_LEFT] = (s_traj && s_traj_pos < s_traj_rows)
+                                    ? (uint64_t)(s_traj_rows - s_traj_pos) : 0u;
+        pthread_mutex_unlock(&s_mu);
+
+        if (have_row) {
+            (void)pwm_ctrl_set_targets_mask(PWM_CH_MASK_ALL, row);
+        }
+
+        /* 2) 控制步 + 心跳 + 收包 */
+        (void)pwm_ctrl_step();
+
+        const uint64_t now = mono_ns();
+        if (hb_ns && now >= t_next_hb) {
+            t_next_hb += hb_ns;
+            (void)pwm_host_send_heartbeat();
+        }
+        (void)pwm_host_poll(0);
+
+        /* 3) 更新零拷贝视图 */
+        refresh_stats();
+        refresh_state();
+        ++s_stats_buf[STAT_TICKS];
+
+        /* 4) 绝对时刻调度；严重超期则重新对齐，避免追赶突发 */
+        t_next += period_ns;
+        if (mono_ns() > t_next + 4 * period_ns) {
+            t_next = mono_ns();
+        }
+        sleep_until_ns(t_next);
+    }
+    return NULL;
+}
+
+/* ============================ 模块函数 ============================ */
+
+static PyObject* py_init(PyObject* self, PyObject* args, PyObject* kw)
+{
+    (void)self;
+    static char* kwlist[] = { "ip", "port", "send_hz", "nonblock", NULL };
+    const char* ip = NULL;
+    int port = 0, send_hz = 0, nonblock = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kw, "|ziip", kwlist, &ip, &port, &send_hz, &nonblock)) {
+        return NULL;
+    }
+    if (s_thr_running || s_busy) return raise_rc(PWMH_EBUSY);
+    if (port < 0 || port > 65535) {
+        PyErr_SetString(PyExc_ValueError, "port out of range");
+        return NULL;
+    }
+
+    pwm_host_config_t cfg;
+    pwm_host_default_config(&cfg);
+    if (ip)       cfg.stm32_ip   = ip;
+    if (port)     cfg.stm32_port = (uint16_t)port;
+    if (send_hz)  cfg.send_hz    = send_hz;
+    cfg.nonblock_send = nonblock;
+
+    pwmh_result_t rc = pwm_host_init(&cfg);
+    if (rc != PWMH_OK) return raise_rc(rc);
+    s_inited = 1;
+    memset(s_stats_buf, 0, sizeof(s_stats_buf));
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_stop(PyObject* self, PyObject* noargs);
+
+static PyObject* py_close(PyObject* self, PyObject* noargs)
+{
+    PyObject* r = py_stop(self, noargs);
+    if (!r) return NULL;
+    Py_DECREF(r);
+    pwm_host_close();
+    s_inited = 0;
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_send_u16(PyObject* self, PyObject* obj)
+{
+    (void)self;
+    if (check_idle() < 0) return NULL;
+
+    Py_buffer view;
+    size_t rows = 0;
+    if (get_rows_buffer(obj, &view, 'H', &rows) < 0) return NULL;
+    if (rows != 1) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "send_u16 expects exactly 8 values");
+        return NULL;
+    }
+    pwmh_result_t rc = pwm_host_set_all_u16((const uint16_t*)view.buf);
+    PyBuffer_Release(&view);
+    if (rc != PWMH_OK) return raise_rc(rc);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_send_batch(PyObject* self, PyObject* args)
+{
+    (void)self;
+    PyObject* obj = NULL;
+    double hz = 0.0;
+    if (!PyArg_ParseTuple(args, "O|d", &obj, &hz)) return NULL;
+    if (check_idle() < 0) return NULL;
+
+    Py_buffer view;
+    size_t rows = 0;
+    if (get_rows_buffer(obj, &view, 'H', &rows) < 0) return NULL;
+
+    const uint16_t* base = (const uint16_t*)view.buf;
+    const uint64_t  period_ns = (hz > 0.0) ? (uint64_t)(1e9 / hz) : 0u;
+    size_t          sent = 0;
+    pwmh_result_t   rc   = PWMH_OK;
+
+    s_busy = 1;
+    Py_BEGIN_ALLOW_THREADS
+    uint64_t t_next = mono_ns();
+    for (size_t i = 0; i < rows; ++i) {
+        rc = pwm_host_set_all_u16(base + i * PWM_HOST_CH_NUM);
+        if (rc != PWMH_OK) break;
+        ++sent;
+        (void)pwm_host_poll(0);
+        if (period_ns && i + 1 < rows) {
+            t_next += period_ns;
+            sleep_until_ns(t_next);
+        }
+    }
+    Py_END_ALLOW_THREADS
+    s_busy = 0;
+
+    PyBuffer_Release(&view);
+    if (rc != PWMH_OK && sent == 0) return raise_rc(rc);
+    return PyLong_FromSize_t(sent);
+}
+
+static PyObject* py_start(PyObject* self, PyObject* args, PyObject* kw)
+{
+    (void)self;
+    static char* kwlist[] = { "ctrl_hz", "hb_hz", "max_step_pct", "group_all", NULL };
+    double ctrl_hz = 50.0, max_step = 0.2;
+    int hb_hz = 1, group_all = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kw, "|didp", kwlist,
+                                     &ctrl_hz, &hb_hz, &max_step, &group_all)) {
+        return NULL;
+    }
+    if (check_idle() < 0) return NULL;
+    if (ctrl_hz <= 0.0 || ctrl_hz > 1000.0) {
+        PyErr_SetString(PyExc_ValueError, "ctrl_hz must be in (0, 1000]");
+        return NULL;
+    }
+
+    pwm_ctrl_config_t cc;
+    memset(&cc, 0, sizeof(cc));
+    cc.ctrl_hz      = (float)ctrl_hz;
+    cc.max_step_pct = (float)max_step;
+    cc.enable_reverse_protection = 1;
+    cc.group_mode   = group_all ? PWM_CTRL_GROUP_MODE_ALL : PWM_CTRL_GROUP_MODE_AB_ALTERNATE;
+    if (pwm_ctrl_init(&cc) != PWM_CTRL_OK) return raise_rc(PWMH_EINTERNAL);
+
+    s_ctrl_hz = ctrl_hz;
+    s_hb_hz   = hb_hz;
+    pthread_mutex_lock(&s_mu);
+    s_pending_dirty = 0;
+    pthread_mutex_unlock(&s_mu);
+    refresh_state();
+
+    atomic_store(&s_thr_stop, 0);
+    if (pthread_create(&s_thr, NULL, ctrl_thread_main, NULL) != 0) {
+        pwm_ctrl_deinit();
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    s_thr_running = 1;
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_stop(PyObject* self, PyObject* noargs)
+{
+    (void)self;
+    (void)noargs;
+    if (s_busy) return raise_rc(PWMH_EBUSY);
+    if (!s_thr_running) Py_RETURN_NONE;
+
+    atomic_store(&s_thr_stop, 1);
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(s_thr, NULL);
+    Py_END_ALLOW_THREADS
+    s_thr_running = 0;
+
+    pthread_mutex_lock(&s_mu);
+    PyMem_RawFree(s_traj);
+    s_traj = NULL;
+    s_traj_rows = s_traj_pos = 0;
+    pthread_mutex_unlock(&s_mu);
+
+    pwm_ctrl_deinit();
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_set_targets(PyObject* self, PyObject* obj)
+{
+    (void)self;
+    if (!s_thr_running) return raise_rc(PWMH_ENOTINIT);
+
+    Py_buffer view;
+    size_t rows = 0;
+    if (get_rows_buffer(obj, &view, 'f', &rows) < 0) return NULL;
+    if (rows != 1) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "set_targets expects exactly 8 float32 values");
+        return NULL;
+    }
+    pthread_mutex_lock(&s_mu);
+    memcpy(s_pending_target, view.buf, sizeof(s_pending_target));
+    s_pending_dirty = 1;
+    s_traj_pos      = s_traj_rows;   /* 以最新指令为准：中止未播完的轨迹 */
+    pthread_mutex_unlock(&s_mu);
+    PyBuffer_Release(&view);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_play(PyObject* self, PyObject* obj)
+{
+    (void)self;
+    if (!s_thr_running) return raise_rc(PWMH_ENOTINIT);
+
+    Py_buffer view;
+    size_t rows = 0;
+    if (get_rows_buffer(obj, &view, 'f', &rows) < 0) return NULL;
+
+    /* 拷贝一份交给后台线程（调用方随后可自由修改/释放原数组） */
+    float* copy = (float*)PyMem_RawMalloc((size_t)view.len);
+    if (!copy) {
+        PyBuffer_Release(&view);
+        return PyErr_NoMemory();
+    }
+    memcpy(copy, view.buf, (size_t)view.len);
+    PyBuffer_Release(&view);
+
+    pthread_mutex_lock(&s_mu);
+    float* old = s_traj;
+    s_traj      = copy;
+    s_traj_rows = rows;
+    s_traj_pos  = 0;
+    s_pending_dirty = 0;
+    pthread_mutex_unlock(&s_mu);
+    PyMem_RawFree(old);
+    return PyLong_FromSize_t(rows);
+}
+
+static PyObject* make_view(void* buf, Py_ssize_t len, Py_ssize_t itemsize, const char* fmt,
+                           int ndim, Py_ssize_t* shape, Py_ssize_t* strides)
+{
+    Py_buffer info;
+    memset(&info, 0, sizeof(info));
+    info.buf      = buf;
+    info.len      = len;
+    info.itemsize = itemsize;
+    info.readonly = 1;
+    info.ndim     = ndim;
+    info.format   = (char*)fmt;
+    info.shape    = shape;
+    info.strides  = strides;
+    return PyMemoryView_FromBuffer(&info);
+}
+
+static PyObject* py_stats(PyObject* self, PyObject* noargs)
+{
+    (void)self;
+    (void)noargs;
+    if (!s_thr_running && !s_busy && s_inited) refresh_stats();
+    return make_view(s_stats_buf, (Py_ssize_t)sizeof(s_stats_buf), sizeof(uint64_t), "Q",
+                     1, s_stats_shape, s_stats_strides);
+}
+
+static PyObject* py_state(PyObject* self, PyObject* noargs)
+{
+    (void)self;
+    (void)noargs;
+    return make_view(s_state_buf, (Py_ssize_t)sizeof(s_state_buf), sizeof(float), "f",
+                     2, s_state_shape, s_state_strides);
+}
+
+static PyObject* py_last_rtt_ms(PyObject* self, PyObject* noargs)
+{
+    (void)self;
+    (void)noargs;
+    return PyFloat_FromDouble(pwm_host_last_rtt_ms());
+}
+
+static PyObject* py_version(PyObject* self, PyObject* noargs)
+{
+    (void)self;
+    (void)noargs;
+    return PyUnicode_FromString(pwm_host_version());
+}
+
+static PyMethodDef s_methods[] = {
+    { "init",        (PyCFunction)(void (*)(void))py_init, METH_VARARGS | METH_KEYWORDS,
+      "init(ip=None, port=0, send_hz=0, nonblock=False): pwm_host_init" },
+    { "close",       py_close,        METH_NOARGS, "stop the control thread and close the socket" },
+    { "send_u16",    py_send_u16,     METH_O,      "send one frame from 8 uint16 values (0..10000)" },
+    { "send_batch",  py_send_batch,   METH_VARARGS,
+      "send_batch(buf, hz=0) -> frames sent; buf is N x 8 uint16, GIL released while sending" },
+    { "start",       (PyCFunction)(void (*)(void))py_start, METH_VARARGS | METH_KEYWORDS,
+      "start(ctrl_hz=50, hb_hz=1, max_step_pct=0.2, group_all=False): run pwm_control in a C thread" },
+    { "stop",        py_stop,         METH_NOARGS, "stop the control thread" },
+    { "set_targets", py_set_targets,  METH_O,      "set 8 float32 target percentages (applied next tick)" },
+    { "play",        py_play,         METH_O,      "queue N x 8 float32 targets, one row per control tick" },
+    { "stats",       py_stats,        METH_NOARGS,
+      "read-only memoryview (uint64): tx_pwm, tx_hb, rx_hb_ack, tx_err, rx_err, ticks, traj_left" },
+    { "state",       py_state,        METH_NOARGS, "read-only memoryview (float32, 2 x 8): current, target" },
+    { "last_rtt_ms", py_last_rtt_ms,  METH_NOARGS, "last heartbeat RTT in ms (negative if none)" },
+    { "version",     py_version,      METH_NOARGS, "libpwm_host version string" },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef s_module = {
+    PyModuleDef_HEAD_INIT, "pwmhost",
+    "High-throughput bindings for libpwm_host / pwm_control", -1, s_methods,
+    NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_pwmhost(void)
+{
+    return PyModule_Create(&s_module);
+}
@@ -1,4 +1,5 @@
 #include "PwmFrameBuilder.h"
+#include "pwm_cobs.h"
 #include <algorithm>
 #include <cstring>
 #include <stdexcept>
@@ -112,6 +113,46 @@ PwmFrameBuilder::buildHeartbeatFrameV1(uint16_t seq, uint32_t ticks_ms) {
     return buf;
 }
 
+// ========================= v2 构帧 =========================
+vector<uint8_t>
+PwmFrameBuilder::buildPwmCmdFrameV2(const array<uint16_t, kPwmChannelCount>& pwm_values,
+                                    uint16_t seq,
+                                    uint32_t ticks_ms,
+                                    int bits) {
+    if (bits != 12 && bits != 14) {
+        throw std::invalid_argument("v2 channel bits must be 12 or 14");
+    }
+
+    // SOF(2)+TL(1)+SEQ8(1)+TICK16(2)+payload(bits)+CRC(2)
+    const size_t len = static_cast<size_t>(bits);  // 8 路 × bits 位 = bits 字节
+    vector<uint8_t> buf;
+    buf.reserve(6 + len + 2);
+
+    appendU16BE(buf, kSofV2);
+    const size_t tl_offset = buf.size();
+    buf.push_back(static_cast<uint8_t>(((bits == 14) ? 1u : 0u) << 5 | len));  // TYPE PWM12=0 / PWM14=1
+    buf.push_back(static_cast<uint8_t>(seq & 0xFF));
+    appendU16BE(buf, static_cast<uint16_t>(ticks_ms & 0xFFFF));
+
+    // PAYLOAD：MSB 优先位打包；12 位码值 = 值×2/5（四舍五入，0..4000）
+    uint32_t acc = 0;
+    int nacc = 0;
+    for (size_t i = 0; i < kPwmChannelCount; ++i) {
+        uint32_t v = clampPwm(pwm_values[i]);
+        if (bits == 12) v = (v * 2u + 2u) / 5u;
+        acc = (acc << bits) | v;
+        nacc += bits;
+        while (nacc >= 8) {
+            nacc -= 8;
+            buf.push_back(static_cast<uint8_t>(acc >> nacc));
+        }
+    }
+
+    const uint16_t crc = proto::Crc16Ccitt::compute(&buf[tl_offset], buf.size() - tl_offset);
+    appendU16BE(buf, crc);
+    return buf;
+}
+
 // ========================= v1 解析 =========================
 bool PwmFrameBuilder::looksLikeV1Frame(string_view frame) {
     if (!hasMinHeaderV1(frame)) return false;
@@ -186,6 +227,39 @@ PwmFrameBuilder::parseStatusV1(string_view frame) {
     return std::string_view(payload_ptr, len);
 }
 
+std::optional<uint16_t>
+PwmFrameBuilder::heartbeatAckStatusV1(string_view frame) {
+    uint16_t seq = 0;
+    uint32_t ticks = 0;
+    if (!parseHeartbeatAckV1(frame, seq, ticks)) return std::nullopt;
+
+    const auto* p = reinterpret_cast<const uint8_t*>(frame.data());
+    if (readU16BE(p + 10) < 16) return std::nullopt;
+    return readU16BE(p + 12 + 14);  // rx_unique / rx_dup / seq_gaps / phase_lag 之后
+}
+
+// ========================= COBS 分帧 =========================
+
+vector<uint8_t> PwmFrameBuilder::wrapCobs(const vector<uint8_t>& frame) {
+    if (frame.size() > 0xFFFFu - 0x200u) {
+        throw std::invalid_argument("COBS frame too long");
+    }
+    const auto n = static_cast<uint16_t>(frame.size());
+    vector<uint8_t> out(PWM_COBS_WIRE_MAX(n));
+    out.resize(pwm_cobs_wrap(frame.data(), n, out.data()));
+    return out;
+}
+
+std::optional<vector<uint8_t>> PwmFrameBuilder::unwrapCobs(string_view chunk) {
+    if (chunk.empty() || chunk.size() > 0xFFFFu) return std::nullopt;
+    vector<uint8_t> out(chunk.size());
+    const uint16_t n = pwm_cobs_decode(reinterpret_cast<const uint8_t*>(chunk.data()),
+                                       static_cast<uint16_t>(chunk.size()), out.data());
+    if (n == 0) return std::nullopt;
+    out.resize(n);
+    return out;
+}
+
 // ========================= v0 兼容（可选） =========================
 #ifdef PWM_PROTO_ENABLE_V0_COMPAT
 
@@ -1,6 +1,10 @@
 #include "UdpSender.h"
+#include "pwmh_trace.h"
+#include "pwmh_sockq.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <cstring>
 #include <sstream>
 
@@ -28,7 +32,8 @@ UdpSender::UdpSender()
       peer_(nullptr),
       local_port_(0),
       rcvbuf_bytes_(0),
-      sndbuf_bytes_(0) {}
+      sndbuf_bytes_(0),
+      ovfl_last_(0) {}
 
 UdpSender::~UdpSender() {
     close();
@@ -44,9 +49,47 @@ void UdpSender::setLocalBind(const std::string& local_ip, uint16_t local_port) {
     local_port_ = local_port;
 }
 
-void UdpSender::setSocketBuffers(int rcvbuf_bytes, int sndbuf_bytes) {
+bool UdpSender::setSocketBuffers(int rcvbuf_bytes, int sndbuf_bytes) {
+    if (rcvbuf_bytes == kRecommendedBuffer || sndbuf_bytes == kRecommendedBuffer) {
+        int rcv = 0, snd = 0;
+        recommendSocketBuffers(rcv, snd);
+        if (rcvbuf_bytes == kRecommendedBuffer) rcvbuf_bytes = rcv;
+        if (sndbuf_bytes == kRecommendedBuffer) sndbuf_bytes = snd;
+    }
     rcvbuf_bytes_ = rcvbuf_bytes;
     sndbuf_bytes_ = sndbuf_bytes;
+    if (sockfd_ < 0) return true;   // 未初始化：在 initialize 中生效
+    return applyBufferSizes();
+}
+
+void UdpSender::sampleQueues() {
+    if (sockfd_ < 0) return;
+    qstats_.rxq_bytes = pwmh_sockq_rx_bytes(sockfd_);
+    qstats_.txq_bytes = pwmh_sockq_tx_bytes(sockfd_);
+    qstats_.rxq_peak  = std::max(qstats_.rxq_peak, qstats_.rxq_bytes);
+    qstats_.txq_peak  = std::max(qstats_.txq_peak, qstats_.txq_bytes);
+
+    socklen_t len = sizeof(qstats_.rcvbuf);
+    ::getsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &qstats_.rcvbuf, &len);
+    len = sizeof(qstats_.sndbuf);
+    ::getsockopt(sockfd_, SOL_SOCKET, SO_SNDBUF, &qstats_.sndbuf, &len);
+}
+
+void UdpSender::recommendSocketBuffers(int& rcvbuf_bytes, int& sndbuf_bytes) const {
+    // 尚未采样：无依据，保持不修改
+    if (qstats_.rcvbuf <= 0) {
+        rcvbuf_bytes = 0;
+        sndbuf_bytes = 0;
+        return;
+    }
+    auto roundUp = [](uint64_t v) -> int {
+        v = std::max<uint64_t>((v + 4095u) & ~uint64_t(4095u), 4096u);
+        return static_cast<int>(std::min<uint64_t>(v, INT_MAX / 2));
+    };
+    uint64_t rx = qstats_.rxq_peak;
+    if (qstats_.rx_overflow > 0) rx = std::max<uint64_t>(rx, static_cast<uint64_t>(qstats_.rcvbuf));
+    rcvbuf_bytes = roundUp(rx);
+    sndbuf_bytes = roundUp(qstats_.txq_peak);
 }
 
 bool UdpSender::setNonBlocking(bool nb) {
@@ -71,6 +114,8 @@ bool UdpSender::initialize(const std::string& target_ip, uint16_t target_port, i
 
     target_ip_   = target_ip;
     target_port_ = target_port;
+    qstats_      = QueueStats{};
+    ovfl_last_   = 0;
 
     // 1) 创建 socket
     sockfd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
@@ -121,18 +166,10 @@ bool UdpSender::applySocketOptions(int timeout_ms) {
     }
 
     // RCVBUF/SNDBUF（可选）
-    if (rcvbuf_bytes_ > 0) {
-        if (::setsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf_bytes_, sizeof(rcvbuf_bytes_)) < 0) {
-            last_error_ = errnoStr("setsockopt(SO_RCVBUF) failed");
-            return false;
-        }
-    }
-    if (sndbuf_bytes_ > 0) {
-        if (::setsockopt(sockfd_, SOL_SOCKET, SO_SNDBUF, &sndbuf_bytes_, sizeof(sndbuf_bytes_)) < 0) {
-            last_error_ = errnoStr("setsockopt(SO_SNDBUF) failed");
-            return false;
-        }
-    }
+    if (!applyBufferSizes()) return false;
+
+    // 接收溢出计数（可选，旧内核不支持时溢出计数恒为 0）
+    pwmh_sockq_enable(sockfd_);
 
     // 设置非阻塞（推荐）
     if (!setNonBlocking(true)) {
@@ -153,6 +190,22 @@ bool UdpSender::applySocketOptions(int timeout_ms) {
     return true;
 }
 
+bool UdpSender::applyBufferSizes() {
+    if (rcvbuf_bytes_ > 0) {
+        if (::setsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf_bytes_, sizeof(rcvbuf_bytes_)) < 0) {
+            last_error_ = errnoStr("setsockopt(SO_RCVBUF) failed");
+            return false;
+        }
+    }
+    if (sndbuf_bytes_ > 0) {
+        if (::setsockopt(sockfd_, SOL_SOCKET, SO_SNDBUF, &sndbuf_bytes_, sizeof(sndbuf_bytes_)) < 0) {
+            last_error_ = errnoStr("setsockopt(SO_SNDBUF) failed");
+            return false;
+        }
+    }
+    return true;
+}
+
 bool UdpSender::bindLocalIfNeeded() {
     if (local_ip_.empty() && local_port_ == 0) return true;
 
@@ -195,6 +248,7 @@ bool UdpSender::sendRawData(const void* data, size_t data_size) {
 
     ssize_t n = ::sendto(sockfd_, data, data_size, 0,
                          reinterpret_cast<sockaddr*>(peer_), sizeof(*peer_));
+    PWMH_TRACE3(udp_sendto_ret, data, data_size, n);
     if (n < 0) {
         last_error_ = errnoStr("sendto failed");
         return false;
@@ -232,6 +286,9 @@ bool UdpSender::receiveFrom(std::vector<uint8_t>& buffer, std::string& src_ip, u
         return false;
     }
 
+    // 收包前采样内核队列（积压即时延堆积）
+    sampleQueues();
+
     // poll 短超时轮询
     struct pollfd pfd{};
     pfd.fd = sockfd_;
@@ -254,10 +311,17 @@ bool UdpSender::receiveFrom(std::vector<uint8_t>& buffer, std::string& src_ip, u
 
     // 尝试接收
     sockaddr_in from{};
-    socklen_t from_len = sizeof(from);
     std::vector<uint8_t> tmp(2048); // 常见 UDP MTU 足够；现场可调整
-    ssize_t n = ::recvfrom(sockfd_, tmp.data(), tmp.size(), 0,
-                           reinterpret_cast<sockaddr*>(&from), &from_len);
+    pwmh_sockq_cmsg_t ctl;
+    iovec  iov{tmp.data(), tmp.size()};
+    msghdr msg{};
+    msg.msg_name       = &from;
+    msg.msg_namelen    = sizeof(from);
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = ctl.buf;
+    msg.msg_controllen = sizeof(ctl.buf);
+    ssize_t n = ::recvmsg(sockfd_, &msg, 0);
     if (n < 0) {
         if (errno == EWOULDBLOCK || errno == EAGAIN) {
             last_error_.clear();
@@ -267,6 +331,8 @@ bool UdpSender::receiveFrom(std::vector<uint8_t>& buffer, std::string& src_ip, u
         return false;
     }
 
+    qstats_.rx_overflow += pwmh_sockq_take_drops(&msg, &ovfl_last_);
+    PWMH_TRACE2(udp_datagram_rx, tmp.data(), n);
     tmp.resize(static_cast<size_t>(n));
     buffer.swap(tmp);
 
@@ -1,13 +1,18 @@
 #include "libpwm_host.h"
+#include "pwm_cobs.h"
+#include "pwmh_trace.h"
+#include "pwmh_sockq.h"
 
 #include <string.h>
 #include <stdio.h>
+#include <math.h>
 #include <time.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <sys/select.h>
 #include <errno.h>
+#include <stdint.h>
 
 /* ============================ 内部常量/宏 ============================ */
 
@@ -18,6 +23,7 @@
 /* protocol_v1 信息（与 STM32 侧一致） */
 enum {
     MSG_PWM    = PWM_HOST_MSG_PWM,
+    MSG_PWM_AT = PWM_HOST_MSG_PWM_AT,  /* 0x02 定时应用 */
     MSG_HB     = PWM_HOST_MSG_HB,      /* 0x10 心跳 */
     MSG_HB_ACK = PWM_HOST_MSG_HB_ACK   /* 0x11 心跳应答 */
 };
@@ -33,10 +39,22 @@ enum {
 /* CRC 长度 */
 #define V1_CRC_LEN 2
 
-/* 最大负载（PWM payload = 16 字节（8×u16）） */
-#define V1_MAX_PAYLOAD 16
+/* 最大负载（PWM_AT payload = 20 字节（DUE u32 + 8×u16）） */
+#define V1_MAX_PAYLOAD 20
 #define V1_MAX_FRAME   (V1_HEADER_TOTAL_LEN + V1_MAX_PAYLOAD + V1_CRC_LEN)
 
+/* 紧凑帧 v2（SOF=0xAA 0x5A，只承载 PWM）：TL(1)=TYPE<<5|LEN，SEQ8(1)，TICK16(2)，位打包负载，CRC 覆盖 TL..PAYLOAD */
+#define V2_SOF_B1       0x5A
+#define V2_HEADER_LEN   6       /* SOF(2)+TL(1)+SEQ8(1)+TICK16(2) */
+#define V2_Q12_MAX      4000u   /* 12 位码值满量程（协议值 × 2/5） */
+
+enum {
+    V2_PWM12    = 0,   /* 8×12 位，LEN=12 */
+    V2_PWM14    = 1,   /* 8×14 位，LEN=14 */
+    V2_PWM12_AT = 2,   /* DUE16 + 8×12 位，LEN=14 */
+    V2_PWM14_AT = 3    /* DUE16 + 8×14 位，LEN=16 */
+};
+
 /* 接收缓存（足够放下完整帧） */
 #define RX_BUF_SIZE 256
 
@@ -44,8 +62,18 @@ enum {
 
 static int                s_sock   = -1;
 static struct sockaddr_in s_addr;
-static uint16_t           s_seq    = 0;
+static uint32_t           s_ovfl_last = 0;  /* s_sock 上次读到的 SO_RXQ_OVFL 累计值 */
+static uint16_t           s_seq    = 0;     /* PWM / PWM_AT / v2 共用 */
+static uint16_t           s_hb_seq = 0;     /* 心跳（含链路探测）独立计数，丢失不计入设备 seq_gaps */
 static uint16_t           s_shadow[PWM_HOST_CH_NUM];  /* 当前影子值（0..10000） */
+
+/* 批量更新（begin/commit）与延迟模式：setter 只改暂存值，提交 / 下一次服务时整帧发出 */
+static uint16_t           s_stage[PWM_HOST_CH_NUM];
+static int                s_stage_valid = 0;   /* 暂存值已从影子值复制 */
+static int                s_stage_dirty = 0;   /* 有未发出的修改 */
+static uint32_t           s_stage_calls = 0;   /* 本次暂存累计的 setter 调用数 */
+static int                s_txn_depth   = 0;
+static int                s_deferred    = 0;
 static int                s_send_hz       = 50;
 static int                s_nonblock_send = 0;
 
@@ -56,39 +84,211 @@ static double             s_last_rtt_ms = -1.0;
 /* 记录最近一次发送心跳时的 seq→ticks（用于 RTT 计算） */
 static uint16_t           s_last_hb_seq        = 0;
 static uint32_t           s_last_hb_send_ticks = 0;
+static uint64_t           s_last_hb_send_ns    = 0;   /* 同一时刻的 ns 读数（时钟偏移估计用） */
+
+/* 注入的传输层（send 为 NULL 表示使用 UDP socket） */
+static pwm_host_transport_t s_tp;
+
+/* 冗余发送：待补发的副本（与最近一帧 PWM 字节相同） */
+static int                s_red_copies     = 1;
+static int                s_red_spacing_ms = 0;
+static uint8_t            s_dup_frame[V1_MAX_FRAME];
+static uint16_t           s_dup_len        = 0;
+static int                s_dup_left       = 0;   /* 剩余待发副本数 */
+static uint64_t           s_dup_due_ns     = 0;   /* 下一份副本的发送时刻 */
+
+/* 双链路热备：[0] 主链路（复用 s_sock/s_addr），[1] 备链路 */
+#define LINK_PROBE_RING 32   /* 每条链路保留的探测记录数（丢包率窗口） */
+
+typedef struct {
+    uint16_t seq;
+    int      acked;
+    uint64_t sent_ns;        /* 0 = 空槽 */
+} link_probe_t;
+
+typedef struct {
+    int                sock;
+    struct sockaddr_in addr;
+    link_probe_t       ring[LINK_PROBE_RING];
+    unsigned           ring_pos;
+    uint64_t           next_probe_ns;
+    uint64_t           last_ack_ns;    /* 0 = 从未收到 */
+    uint32_t           consec_acks;    /* 连续成功的探测数（超时即清零） */
+    double             rtt_ms;
+    uint64_t           probes_tx;
+    uint64_t           acks_rx;
+    uint32_t           ovfl_last;      /* 上次读到的 SO_RXQ_OVFL 累计值 */
+} host_link_t;
+
+static int                        s_fo_enabled = 0;
+static pwm_host_failover_config_t s_fo_cfg;
+static host_link_t                s_links[PWM_HOST_LINK_NUM];
+static int                        s_active_link = PWM_HOST_LINK_PRIMARY;
+
+/* 快速链路恢复（配置跨 pwm_host_init 保留，状态与统计随会话重置） */
+#define REC_RESET_SLACK_MS  250   /* 设备 tick 比外推值小超过该值即判定设备重启（容忍 ACK 乱序 / 抖动） */
+
+static int                        s_rec_enabled = 0;
+static pwm_host_recovery_config_t s_rec_cfg;
+static pwm_host_recovery_t        s_rec;                          /* 状态与统计 */
+static uint16_t                   s_rec_target[PWM_HOST_CH_NUM];  /* 调用方设定的目标（PROBING / RAMP 下不同于输出） */
+static uint64_t                   s_rec_last_ack_ns = 0;  /* 最近一次 HB_ACK（0 = 尚未收到，不判定失联） */
+static uint64_t                   s_rec_hb_wait_ns  = 0;  /* 最早一个未应答心跳的发出时刻（0 = 无） */
+static uint64_t                   s_rec_lost_ns     = 0;  /* 判定失联时刻 */
+static uint64_t                   s_rec_back_ns     = 0;  /* 恢复（首个 ACK）时刻 */
+static uint64_t                   s_rec_probe_ns    = 0;  /* 下一次快速心跳 */
+static uint64_t                   s_rec_tx_ns       = 0;  /* 库最近一次按恢复状态下发 */
+static uint32_t                   s_rec_dev_ticks   = 0;  /* 最近 ACK 中的设备 tick */
+static int                        s_rec_held        = 0;  /* PROBING 下已改发中位 */
+static int                        s_rec_resend      = 0;  /* 待按恢复状态重发一帧 */
+
+/* 自适应发送速率（配置跨 pwm_host_init 保留，动态状态随会话重置） */
+#define RATE_ADJUST_NS   100000000ull   /* 速率评估间隔 100ms */
+#define RATE_HOLD_NS     500000000ull   /* 退避后暂停加速 500ms */
+#define RATE_MINRTT_NS   10000000000ull /* RTT 基线窗口 10s */
+
+static int                    s_rate_enabled = 0;
+static pwm_host_rate_config_t s_rate_cfg;
+static double                 s_rate_hz         = 0.0;  /* 当前帧率 */
+static double                 s_rate_floor_hz   = 0.0;  /* max(floor_hz, 保活下限) */
+static uint64_t               s_rate_last_tx_ns = 0;    /* 最近一次 PWM 帧发出时刻 */
+static int                    s_rate_pending    = 0;    /* 影子值有尚未发出的新指令 */
+static uint64_t               s_rate_eval_ns    = 0;    /* 下一次速率评估时刻 */
+static uint64_t               s_rate_hold_ns    = 0;    /* 该时刻之前不加速 */
+static int                    s_rate_congested  = 0;    /* 本评估周期内出现拥塞信号 */
+static uint64_t               s_rate_tx_err     = 0;    /* 上次评估时的 tx_err */
+static double                 s_rate_min_rtt    = -1.0; /* RTT 基线（窗口内最小值） */
+static uint64_t               s_rate_min_rtt_ns = 0;    /* 基线建立时刻 */
+static double                 s_rate_activity   = 0.0;  /* 指令变化速度 EWMA（协议值/秒） */
+static uint16_t               s_rate_prev_cmd[PWM_HOST_CH_NUM];
+static uint64_t               s_rate_prev_cmd_ns = 0;
+
+/* 发送邮箱（非阻塞发送遇到 EAGAIN 时暂存，fd 可写时冲刷）：
+ * 普通槽只记“影子值待发”，冲刷时以最新影子值重新组帧（新 SEQ/TICKS），旧指令自然被覆盖；
+ * 优先槽（急停 PWM、心跳）先于普通槽冲刷 */
+static int                    s_mbox_pwm    = 0;
+static int                    s_mbox_urgent = 0;
+static int                    s_mbox_hb     = 0;
+static int                    s_in_service  = 0;   /* service_all 防重入（冲刷时会再次进入发送路径） */
+
+/* 定时应用：设备时钟偏移样本（每个 HB_ACK 一个），取 RTT 最小者 */
+#define CLK_SAMPLES 8
+
+typedef struct {
+    int32_t offset_ms;       /* 设备 tick - 主机 tick */
+    double  rtt_ms;
+} clk_sample_t;
+
+static int                    s_sched_delay_ms = 0;   /* 0 = 关闭 */
+
+/* 紧凑帧 v2：模式与分辨率跨 pwm_host_init 保留，协商结果随会话重置 */
+static int                    s_proto_mode   = PWM_HOST_PROTO_AUTO;
+static int                    s_proto_bits   = 12;
+static int                    s_v2_peer      = 0;   /* 最近的 HB_ACK 声明支持 v2 */
+static int                    s_framing      = PWM_HOST_FRAMING_RAW;   /* 跨 pwm_host_init 保留 */
+static uint64_t               s_v2_ack_ns    = 0;   /* 该应答的到达时刻 */
+static clk_sample_t           s_clk_ring[CLK_SAMPLES];
+static unsigned               s_clk_count = 0;
+static unsigned               s_clk_pos   = 0;
+
+/* 发送节拍监测（配置跨 pwm_host_init 保留，统计随会话重置） */
+static pwm_host_txmon_config_t s_txmon_cfg = {
+    .tolerance_ms = 5.0, .burst_ratio = 0.5, .bin_us = 1000u, .window = 50u,
+    .alert_miss_rate = 0.1, .on_alert = NULL, .user = NULL
+};
+static pwm_host_txmon_t       s_txmon;
+static double                 s_txmon_m2        = 0.0;  /* Welford 二阶矩 */
+static uint64_t               s_txmon_last_ns   = 0;    /* 上一帧 PWM 发出时刻 */
+static int                    s_txmon_keepalive = 0;    /* 当前帧为速率控制保活帧 */
+static int                    s_txmon_in_burst  = 0;
+static uint32_t               s_txmon_win_n     = 0;
+static uint32_t               s_txmon_win_miss  = 0;
 
 /* ============================ 工具函数 ============================ */
 
 static inline uint16_t be16(uint16_t v) { return htons(v); }
 static inline uint32_t be32(uint32_t v) { return htonl(v); }
 
-static uint32_t ticks_ms(void)
+/* ============================ 时钟（可注入） ============================ */
+
+static uint64_t sys_now_ns(void* user)
 {
+    UNUSED(user);
 #if defined(CLOCK_MONOTONIC)
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (uint32_t)(ts.tv_sec * 1000u + ts.tv_nsec / 1000000u);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
 #else
     /* 退化实现：精度差一些，但足够做 RTT 粗略估计 */
-    return (uint32_t)time(NULL) * 1000u;
+    return (uint64_t)time(NULL) * 1000000000ull;
 #endif
 }
 
 /* 睡眠：处理 EINTR，保证尽量睡满 */
-static void sleep_ms(double ms)
+static void sys_sleep_ns(void* user, uint64_t ns)
 {
-    if (ms <= 0.0) return;
-
+    UNUSED(user);
     struct timespec req, rem;
-    req.tv_sec  = (time_t)(ms / 1000.0);
-    req.tv_nsec = (long)((ms - (double)req.tv_sec * 1000.0) * 1e6);
-    if (req.tv_nsec < 0) req.tv_nsec = 0;
+    req.tv_sec  = (time_t)(ns / 1000000000ull);
+    req.tv_nsec = (long)(ns % 1000000000ull);
 
     while (nanosleep(&req, &rem) != 0 && errno == EINTR) {
         req = rem;
     }
 }
 
+/* 内置虚拟时钟：sleep 只推进计数，不真正等待 */
+static uint64_t s_vclock_ns = 0;
+
+static uint64_t vclock_now_ns(void* user)
+{
+    UNUSED(user);
+    return s_vclock_ns;
+}
+
+static void vclock_sleep_ns(void* user, uint64_t ns)
+{
+    UNUSED(user);
+    s_vclock_ns += ns;
+}
+
+static pwm_host_clock_t s_clock = { sys_now_ns, sys_sleep_ns, NULL };
+
+static uint32_t ticks_ms(void)
+{
+    return (uint32_t)(s_clock.now_ns(s_clock.user) / 1000000ull);
+}
+
+static void     service_dup(void);
+static void     service_rate(void);
+static void     service_mbox(void);
+static uint64_t next_service_ns(void);
+static void     service_all(void);
+static void     wait_ns(uint64_t ns);
+
+/* 睡眠期间顺带按时补发冗余副本 / 发送链路探测 */
+static void sleep_ms(double ms)
+{
+    if (ms <= 0.0) return;
+    const uint64_t end = s_clock.now_ns(s_clock.user) + (uint64_t)(ms * 1e6);
+
+    uint64_t due;
+    while ((due = next_service_ns()) < end) {
+        const uint64_t now = s_clock.now_ns(s_clock.user);
+        if (due > now) wait_ns(due - now);
+        service_all();
+    }
+
+    const uint64_t now = s_clock.now_ns(s_clock.user);
+    if (end > now) wait_ns(end - now);
+}
+
+/* 已初始化（UDP socket 或注入传输） */
+static int host_is_open(void)
+{
+    return (s_sock >= 0) || (s_tp.send != NULL);
+}
+
 /* CRC16-CCITT(False): poly=0x1021, init=0xFFFF, no-reflect, xorout=0x0000 */
 static uint16_t crc16_ccitt_false(const uint8_t* data, uint16_t len)
 {
@@ -122,7 +322,8 @@ static pwmh_result_t v1_pack(uint8_t msg_id,
     *p++ = (uint8_t)PWM_HOST_PROTO_VER;
     *p++ = (uint8_t)msg_id;
 
-    uint16_t seq_be = be16(++s_seq);
+    const uint16_t seq    = (msg_id == MSG_HB) ? ++s_hb_seq : ++s_seq;
+    const uint16_t seq_be = be16(seq);
     memcpy(p, &seq_be, 2); p += 2;
 
     uint32_t t_be = be32(ticks_ms());
@@ -143,289 +344,1515 @@ static pwmh_result_t v1_pack(uint8_t msg_id,
     memcpy(p, &crc_be, 2); p += 2;
 
     *out_len = (uint16_t)(p - out);
+    PWMH_TRACE3(frame_encoded, msg_id, seq, *out_len);
     return PWMH_OK;
 }
 
-static pwmh_result_t v1_send_frame(uint8_t msg_id,
-                                   const uint8_t* payload, uint16_t payload_len)
+/* 8 路 MSB 优先位打包：bits=12 时码值 = 协议值 × 2/5（四舍五入，0..4000），bits=14 时即协议值；返回字节数 */
+static uint16_t v2_pack_channels(const uint16_t v[PWM_HOST_CH_NUM], int bits, uint8_t* out)
 {
-    if (s_sock < 0) return PWMH_ENOTINIT;
+    uint32_t acc  = 0;
+    int      nacc = 0;
+    uint8_t* p    = out;
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+        uint32_t q = (v[i] > PWM_HOST_VAL_MAX) ? (uint32_t)PWM_HOST_VAL_MAX : v[i];
+        if (bits == 12) q = (q * 2u + 2u) / 5u;
+        acc   = (acc << bits) | q;
+        nacc += bits;
+        while (nacc >= 8) {
+            nacc -= 8;
+            *p++ = (uint8_t)(acc >> nacc);
+        }
+    }
+    return (uint16_t)(p - out);
+}
 
-    uint8_t buf[V1_MAX_FRAME];
-    uint16_t n = 0;
-    pwmh_result_t r = v1_pack(msg_id, payload, payload_len, buf, sizeof(buf), &n);
-    if (r != PWMH_OK) return r;
+/* 以紧凑帧 v2 组帧；SEQ 与 v1 PWM 共用同一计数器，只发低 8 位（设备以最近的合法 SEQ 就近展开） */
+static pwmh_result_t v2_pack(uint8_t type,
+                             const uint8_t* payload, uint16_t payload_len,
+                             uint8_t* out, uint16_t out_cap, uint16_t* out_len)
+{
+    if (!out || !out_len || payload_len > 0x1F) return PWMH_EINVAL;
+    const uint16_t need = (uint16_t)(V2_HEADER_LEN + payload_len + V1_CRC_LEN);
+    if (out_cap < need) return PWMH_EINVAL;
 
-    int flags = s_nonblock_send ? MSG_DONTWAIT : 0;
+    uint8_t* p = out;
+    *p++ = (uint8_t)(PWM_HOST_SOF_BE >> 8);
+    *p++ = (uint8_t)V2_SOF_B1;
+    *p++ = (uint8_t)((type << 5) | payload_len);
+    *p++ = (uint8_t)(++s_seq);
 
-    ssize_t sent;
-    do {
-        sent = sendto(s_sock, buf, n, flags, (struct sockaddr*)&s_addr, sizeof(s_addr));
-    } while (sent < 0 && errno == EINTR);
+    const uint16_t t_be = be16((uint16_t)ticks_ms());
+    memcpy(p, &t_be, 2); p += 2;
 
-    if (sent < 0 || (size_t)sent != n) {
-        ++s_stats.tx_err;
-        return PWMH_ESYS;
+    if (payload_len && payload) {
+        memcpy(p, payload, payload_len);
+        p += payload_len;
     }
+
+    const uint16_t crc_be = be16(crc16_ccitt_false(out + 2, (uint16_t)(V2_HEADER_LEN - 2 + payload_len)));
+    memcpy(p, &crc_be, 2); p += 2;
+
+    *out_len = (uint16_t)(p - out);
+    PWMH_TRACE3(frame_encoded, MSG_PWM, s_seq, *out_len);
     return PWMH_OK;
 }
 
-/* 解析 HB_ACK（最小校验：SOF/VER/MSG/CRC；LEN 允许为 0） */
-static int v1_try_parse_hb_ack(const uint8_t* buf, int len, uint16_t* out_seq, uint32_t* out_ticks)
+/* 本帧 PWM 是否使用 v2（AUTO：协商有效且未过期） */
+static int proto_use_v2(void)
 {
-    if (!buf || len < (V1_HEADER_TOTAL_LEN + V1_CRC_LEN)) return 0;
-
-    /* SOF */
-    if (buf[0] != (uint8_t)(PWM_HOST_SOF_BE >> 8) ||
-        buf[1] != (uint8_t)(PWM_HOST_SOF_BE & 0xFF)) {
+    if (s_proto_mode == PWM_HOST_PROTO_V2) return 1;
+    if (s_proto_mode == PWM_HOST_PROTO_V1 || !s_v2_peer) return 0;
+    if (s_clock.now_ns(s_clock.user) - s_v2_ack_ns > (uint64_t)PWM_HOST_PROTO_V2_HOLD_MS * 1000000u) {
+        s_v2_peer = 0;   /* 长时间无应答：回退 v1，等待重新协商 */
         return 0;
     }
-
-    const uint8_t* p = buf + 2;
-    uint8_t ver = p[0];
-    uint8_t msg = p[1];
-    if (ver != PWM_HOST_PROTO_VER || msg != MSG_HB_ACK) return 0;
-
-    uint16_t seq_be;   memcpy(&seq_be,   p + 2, 2);
-    uint32_t ticks_be; memcpy(&ticks_be, p + 4, 4);
-    uint16_t len_be;   memcpy(&len_be,   p + 8, 2);
-
-    uint16_t payload_len = ntohs(len_be);
-    const int frame_len  = V1_HEADER_TOTAL_LEN + payload_len + V1_CRC_LEN;
-    if (len < frame_len) return 0;
-
-    /* CRC 检验（覆盖 VER..LEN(+PAYLOAD)） */
-    uint16_t crc_rx_be; memcpy(&crc_rx_be, buf + (frame_len - 2), 2);
-    uint16_t crc_rx   = ntohs(crc_rx_be);
-    uint16_t crc_calc = crc16_ccitt_false(buf + 2, (uint16_t)(V1_FIXED_HEADER_LEN + payload_len));
-    if (crc_rx != crc_calc) return 0;
-
-    if (out_seq)   *out_seq   = ntohs(seq_be);
-    if (out_ticks) *out_ticks = ntohl(ticks_be);
-    return frame_len; /* consumed bytes */
+    return 1;
 }
 
-/* ============================ 错误字符串 ============================ */
+static void rec_on_unreach(void);
 
-PWMH_API const char* pwm_host_strerror(pwmh_result_t rc)
+static ssize_t sock_send(int sock, const struct sockaddr_in* addr, const uint8_t* buf, uint16_t n)
 {
-    switch (rc) {
-    case PWMH_OK:        return "OK";
-    case PWMH_EINVAL:    return "EINVAL";
-    case PWMH_ENOTINIT:  return "ENOTINIT";
-    case PWMH_ESYS:      return "ESYS";
-    case PWMH_EBUSY:     return "EBUSY";
-    case PWMH_EINTERNAL: return "EINTERNAL";
-    default:             return "UNKNOWN";
+    ssize_t sent;
+    int flags = s_nonblock_send ? MSG_DONTWAIT : 0;
+    do {
+        sent = sendto(sock, buf, n, flags, (const struct sockaddr*)addr, sizeof(*addr));
+    } while (sent < 0 && errno == EINTR);
+    if (sent < 0 && pwmh_sockq_is_unreach(errno)) {
+        /* 不可达（ICMP 经 IP_RECVERR 报告时错误队列里还留有一份，一并取走） */
+        const int err = errno;
+        rec_on_unreach();
+        (void)pwmh_sockq_drain_errors(sock);
+        errno = err;
     }
+    return sent;
 }
 
-/* ============================ 默认配置 ============================ */
+static int  link_up(int link, uint64_t now);
+static void switch_link(int to, uint64_t now);
 
-PWMH_API void pwm_host_default_config(pwm_host_config_t* cfg)
+/* 热备模式下的发送：走当前链路（或两条都走）；当前链路发送失败且另一条可用时立即切换重发 */
+static ssize_t link_send(const uint8_t* buf, uint16_t n)
 {
-    if (!cfg) return;
-    cfg->stm32_ip      = "192.168.2.16";
-    cfg->stm32_port    = 8000;
-    cfg->send_hz       = 50;
-    cfg->socket_sndbuf = 0;
-    cfg->nonblock_send = 0;
-}
+    if (s_fo_cfg.duplicate_on_both) {
+        const ssize_t a = sock_send(s_links[0].sock, &s_links[0].addr, buf, n);
+        const ssize_t b = sock_send(s_links[1].sock, &s_links[1].addr, buf, n);
+        return (a == (ssize_t)n) ? a : b;
+    }
 
-/* ============================ 映射工具实现 ============================ */
+    host_link_t* l = &s_links[s_active_link];
+    ssize_t sent = sock_send(l->sock, &l->addr, buf, n);
+    if (sent != (ssize_t)n && !(sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+        const int      other = 1 - s_active_link;
+        const uint64_t now   = s_clock.now_ns(s_clock.user);
+        if (link_up(other, now)) {
+            switch_link(other, now);
+            l    = &s_links[other];
+            sent = sock_send(l->sock, &l->addr, buf, n);
+        }
+    }
+    return sent;
+}
 
-PWMH_API uint16_t pwm_host_percent_to_u16(float pct)
+/* 按当前分帧方式取得线上字节：COBS 时编码进 wire（容量 PWM_COBS_WIRE_MAX(V1_MAX_FRAME)），否则原样 */
+static uint16_t to_wire(const uint8_t* buf, uint16_t n, uint8_t* wire, const uint8_t** out)
 {
-    if (pct < PWM_HOST_PCT_MIN) pct = PWM_HOST_PCT_MIN;
-    if (pct > PWM_HOST_PCT_MAX) pct = PWM_HOST_PCT_MAX;
-    /* 5.0% → 0, 10.0% → 10000 */
-    float norm = (pct - PWM_HOST_PCT_MIN) / (PWM_HOST_PCT_MAX - PWM_HOST_PCT_MIN); /* 0..1 */
-    int v = (int)(norm * (float)PWM_HOST_VAL_MAX + 0.5f);
-    if (v < PWM_HOST_VAL_MIN) v = PWM_HOST_VAL_MIN;
-    if (v > PWM_HOST_VAL_MAX) v = PWM_HOST_VAL_MAX;
-    return (uint16_t)v;
+    if (s_framing != PWM_HOST_FRAMING_COBS) {
+        *out = buf;
+        return n;
+    }
+    *out = wire;
+    return pwm_cobs_wrap(buf, n, wire);
 }
 
-PWMH_API float pwm_host_u16_to_percent(uint16_t v)
+/* 发送一整帧（UDP / 双链路 / 注入传输）；COBS 分帧时整帧发出返回 n */
+static ssize_t raw_send(const uint8_t* buf, uint16_t n)
 {
-    if (v > PWM_HOST_VAL_MAX) v = PWM_HOST_VAL_MAX;
-    /* 0 → 5.0%, 10000 → 10.0% */
-    float pct = PWM_HOST_PCT_MIN
-              + (PWM_HOST_PCT_MAX - PWM_HOST_PCT_MIN) * ((float)v / (float)PWM_HOST_VAL_MAX);
-    return pct;
-}
+    uint8_t        wire[PWM_COBS_WIRE_MAX(V1_MAX_FRAME)];
+    const uint8_t* out = NULL;
+    const uint16_t len = to_wire(buf, n, wire, &out);
 
-/* ============================ 生命周期 ============================ */
+    ssize_t sent;
+    if (s_tp.send) {
+        sent = s_tp.send(s_tp.user, out, len);
+    } else if (s_fo_enabled) {
+        sent = link_send(out, len);
+    } else {
+        sent = sock_send(s_sock, &s_addr, out, len);
+    }
+    if (sent == (ssize_t)len) sent = (ssize_t)n;
+    PWMH_TRACE4(sendto_ret, (buf[1] == V2_SOF_B1) ? MSG_PWM : buf[3],
+                (buf[1] == V2_SOF_B1) ? s_seq : (uint16_t)((buf[4] << 8) | buf[5]),
+                sent, (sent < 0) ? errno : 0);
+    return sent;
+}
 
-PWMH_API pwmh_result_t pwm_host_init(const pwm_host_config_t* cfg)
+/* 发出已组好的一帧；PWM 帧登记冗余副本 */
+static pwmh_result_t send_packed(const uint8_t* buf, uint16_t n, int is_pwm)
 {
-    if (s_sock >= 0) {
-        close(s_sock);
-        s_sock = -1;
+    ssize_t sent = raw_send(buf, n);
+    if (sent < 0 && !s_tp.send && s_nonblock_send &&
+        (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS)) {
+        /* 发送缓冲已满：不算错误，由调用方放入邮箱 */
+        ++s_stats.tx_backpressure;
+        return PWMH_EBUSY;
+    }
+    if (sent < 0 || (size_t)sent != n) {
+        ++s_stats.tx_err;
+        return PWMH_ESYS;
     }
 
-    pwm_host_config_t local_cfg;
-    if (cfg == NULL) {
-        pwm_host_default_config(&local_cfg);
-        cfg = &local_cfg;
+    /* PWM 帧：登记冗余副本（新帧取代尚未发出的旧副本） */
+    if (is_pwm && s_red_copies > 1) {
+        memcpy(s_dup_frame, buf, n);
+        s_dup_len    = n;
+        s_dup_left   = s_red_copies - 1;
+        s_dup_due_ns = s_clock.now_ns(s_clock.user)
+                     + (uint64_t)(unsigned)s_red_spacing_ms * 1000000u;
+        if (s_red_spacing_ms == 0) service_dup();
     }
+    return PWMH_OK;
+}
 
-    const char* ip   = (cfg->stm32_ip   != NULL) ? cfg->stm32_ip   : "192.168.2.16";
-    uint16_t    port = (cfg->stm32_port != 0   ) ? cfg->stm32_port : 8000;
-    s_send_hz         = (cfg->send_hz   > 0   ) ? cfg->send_hz     : 50;
-    s_nonblock_send   = (cfg->nonblock_send != 0) ? 1 : 0;
+/* 组帧（v1: msg_id / v2: 紧凑帧类型）并立即发出，不做库内服务；调用方须已先 service_all */
+static pwmh_result_t pack_send(int v2, uint8_t id,
+                               const uint8_t* payload, uint16_t payload_len)
+{
+    uint8_t buf[V1_MAX_FRAME];
+    uint16_t n = 0;
+    pwmh_result_t r = v2 ? v2_pack(id, payload, payload_len, buf, sizeof(buf), &n)
+                         : v1_pack(id, payload, payload_len, buf, sizeof(buf), &n);
+    if (r != PWMH_OK) return r;
+    return send_packed(buf, n, v2 || id == MSG_PWM || id == MSG_PWM_AT);
+}
 
-    s_sock = socket(AF_INET, SOCK_DGRAM, 0);
-    if (s_sock < 0) return PWMH_ESYS;
+static pwmh_result_t v1_send_frame(uint8_t msg_id,
+                                   const uint8_t* payload, uint16_t payload_len)
+{
+    if (!host_is_open()) return PWMH_ENOTINIT;
 
-    memset(&s_addr, 0, sizeof(s_addr));
-    s_addr.sin_family = AF_INET;
-    s_addr.sin_port   = htons(port);
-    if (inet_pton(AF_INET, ip, &s_addr.sin_addr) != 1) {
-        close(s_sock); s_sock = -1;
-        return PWMH_EINVAL;
-    }
+    /* 发送前先评估链路：主链路心跳中断后，本帧即走备链路 */
+    service_all();
+    return pack_send(0, msg_id, payload, payload_len);
+}
 
-    if (cfg->socket_sndbuf > 0) {
-        int sndbuf = cfg->socket_sndbuf;
-        (void)setsockopt(s_sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
-    }
 
-    /* 影子值设为中位 */
-    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
-        s_shadow[i] = PWM_HOST_VAL_MID;
+/* 补发到期的冗余副本 */
+static void service_dup(void)
+{
+    while (s_dup_left > 0 && host_is_open()) {
+        const uint64_t now = s_clock.now_ns(s_clock.user);
+        if (now < s_dup_due_ns) return;
+
+        ssize_t sent = raw_send(s_dup_frame, s_dup_len);
+        --s_dup_left;
+        s_dup_due_ns += (uint64_t)(unsigned)s_red_spacing_ms * 1000000u;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            s_dup_left = 0;   /* 缓冲已满：副本不进邮箱，放弃本帧剩余副本 */
+        } else if (sent < 0 || (size_t)sent != s_dup_len) {
+            ++s_stats.tx_err;
+        } else {
+            ++s_stats.tx_pwm_dup;
+        }
     }
-    s_seq = 0;
+}
 
-    /* 重置统计与 RTT */
-    memset(&s_stats, 0, sizeof(s_stats));
-    s_last_rtt_ms        = -1.0;
-    s_last_hb_seq        = 0;
-    s_last_hb_send_ticks = 0;
+/* ============================ 自适应发送速率 ============================ */
 
-    return PWMH_OK;
+static void rate_set(double hz, int reason)
+{
+    if (hz < s_rate_floor_hz) hz = s_rate_floor_hz;
+    if (hz > s_rate_cfg.ceil_hz) hz = s_rate_cfg.ceil_hz;
+    if (hz != s_rate_hz) {
+        PWMH_TRACE2(rate_change, (int)(hz * 10.0), reason);
+        s_rate_hz = hz;
+    }
 }
 
-PWMH_API void pwm_host_close(void)
+/* RTT 样本：高于基线 rtt_factor 倍 + rtt_margin_ms 视为排队（拥塞） */
+static void rate_on_rtt(double rtt_ms, uint64_t now)
 {
-    if (s_sock >= 0) {
-        close(s_sock);
-        s_sock = -1;
+    if (!s_rate_enabled) return;
+    if (s_rate_min_rtt < 0.0 || rtt_ms < s_rate_min_rtt || now - s_rate_min_rtt_ns > RATE_MINRTT_NS) {
+        s_rate_min_rtt    = rtt_ms;
+        s_rate_min_rtt_ns = now;
+    }
+    if (rtt_ms > s_rate_min_rtt * s_rate_cfg.rtt_factor + s_rate_cfg.rtt_margin_ms) {
+        s_rate_congested = 1;
     }
 }
 
-PWMH_API const char* pwm_host_version(void)
+/* 设备统计：两次 HB_ACK 之间的残余丢包率超过 loss_hi 视为拥塞 */
+static void rate_on_dev_stats(uint32_t unique, uint32_t gaps)
 {
-    return PWM_HOST_SEMVER;
+    if (!s_rate_enabled) return;
+    /* 计数回退即设备重启（rec_on_ack 稍后才判定）：差值无意义，本次样本只作为新基准 */
+    if (unique < s_stats.dev_rx_unique || gaps < s_stats.dev_seq_gaps) return;
+    const uint64_t du = unique - s_stats.dev_rx_unique;
+    const uint64_t dg = gaps   - s_stats.dev_seq_gaps;
+    if (du + dg > 0 && (double)dg / (double)(du + dg) > s_rate_cfg.loss_hi) {
+        s_rate_congested = 1;
+    }
 }
 
-/* ============================ 发送接口 ============================ */
+/* 指令变化速度：相邻两次指令的最大通道差 / 时间间隔，做 EWMA */
+static void rate_on_command(const uint16_t v[PWM_HOST_CH_NUM], uint64_t now)
+{
+    if (s_rate_prev_cmd_ns != 0 && now > s_rate_prev_cmd_ns) {
+        int dmax = 0;
+        for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+            int d = (int)v[i] - (int)s_rate_prev_cmd[i];
+            if (d < 0) d = -d;
+            if (d > dmax) dmax = d;
+        }
+        const double speed = (double)dmax * 1e9 / (double)(now - s_rate_prev_cmd_ns);
+        s_rate_activity += 0.2 * (speed - s_rate_activity);
+    }
+    memcpy(s_rate_prev_cmd, v, sizeof(s_rate_prev_cmd));
+    s_rate_prev_cmd_ns = now;
+}
 
-PWMH_API pwmh_result_t pwm_host_set_all_u16(const uint16_t v[PWM_HOST_CH_NUM])
+/*
+ * 每 100ms 评估一次（AIMD）：
+ *  - 拥塞（RTT 抬升 / 发送错误 / 设备侧丢包）→ 乘性退避 ×0.75，并在 500ms 内不加速；
+ *  - 链路健康且指令快速变化 → 加性提升 (ceil-floor)/10；
+ *  - 链路健康但指令平稳 → 缓慢回落 (ceil-floor)/40。
+ */
+static void rate_evaluate(uint64_t now)
 {
-    if (s_sock < 0) return PWMH_ENOTINIT;
-    if (!v) return PWMH_EINVAL;
+    if (s_stats.tx_err != s_rate_tx_err) {
+        s_rate_tx_err    = s_stats.tx_err;
+        s_rate_congested = 1;
+    }
 
-    /* clamp & 覆盖影子 */
-    uint16_t payload16[PWM_HOST_CH_NUM];
-    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
-        uint16_t vi = v[i];
-        if (vi > PWM_HOST_VAL_MAX) vi = PWM_HOST_VAL_MAX;
-        payload16[i] = vi;
-        s_shadow[i]  = vi;
+    const double span = s_rate_cfg.ceil_hz - s_rate_floor_hz;
+    if (s_rate_congested) {
+        rate_set(s_rate_hz * 0.75, 0);
+        s_rate_hold_ns = now + RATE_HOLD_NS;
+    } else if (now >= s_rate_hold_ns) {
+        if (s_rate_activity >= s_rate_cfg.active_units_per_s) rate_set(s_rate_hz + span / 10.0, 1);
+        else                                                  rate_set(s_rate_hz - span / 40.0, 2);
     }
+    s_rate_congested = 0;
+    s_rate_eval_ns   = now + RATE_ADJUST_NS;
+}
 
-    /* payload 大端打包 */
-    uint8_t payload[V1_MAX_PAYLOAD];
-    uint8_t* p = payload;
-    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
-        uint16_t be = be16(payload16[i]);
-        memcpy(p, &be, 2);
-        p += 2;
+/* 时钟偏移样本：设备在 HB 往返的中点附近打 TICKS，offset = dev_ticks - (t_send + t_recv)/2 */
+static void clk_on_ack(uint32_t dev_ticks, uint64_t now)
+{
+    if (s_last_hb_send_ns == 0 || now < s_last_hb_send_ns) return;
+    const uint32_t mid_ms = (uint32_t)((s_last_hb_send_ns + (now - s_last_hb_send_ns) / 2u) / 1000000ull);
+
+    clk_sample_t* c = &s_clk_ring[s_clk_pos];
+    c->offset_ms = (int32_t)(dev_ticks - mid_ms);
+    c->rtt_ms    = (double)(now - s_last_hb_send_ns) / 1e6;
+    s_clk_pos    = (s_clk_pos + 1u) % CLK_SAMPLES;
+    if (s_clk_count < CLK_SAMPLES) ++s_clk_count;
+}
+
+/* RTT 最小的样本排队最少，中点假设误差最小；无样本返回 NULL */
+static const clk_sample_t* clk_best(void)
+{
+    const clk_sample_t* best = NULL;
+    for (unsigned i = 0; i < s_clk_count; ++i) {
+        if (!best || s_clk_ring[i].rtt_ms < best->rtt_ms) best = &s_clk_ring[i];
     }
+    return best;
+}
 
-    pwmh_result_t rc = v1_send_frame(MSG_PWM, payload, sizeof(payload));
-    if (rc == PWMH_OK) ++s_stats.tx_pwm;
-    else               ++s_stats.tx_err;
-    return rc;
+/* ---------------------------- 发送节拍监测 ---------------------------- */
+
+static void txmon_clear(void)
+{
+    const uint32_t bin_us = s_txmon_cfg.bin_us;
+    memset(&s_txmon, 0, sizeof(s_txmon));
+    s_txmon.bin_us    = bin_us;
+    s_txmon_m2        = 0.0;
+    s_txmon_last_ns   = 0;
+    s_txmon_in_burst  = 0;
+    s_txmon_win_n     = 0;
+    s_txmon_win_miss  = 0;
 }
 
-PWMH_API pwmh_result_t pwm_host_set_all_pct(const float pct[PWM_HOST_CH_NUM])
+/* 当前帧的标称周期（ms） */
+static double txmon_period_ms(void)
 {
-    if (s_sock < 0) return PWMH_ENOTINIT;
-    if (!pct) return PWMH_EINVAL;
+    if (s_rate_enabled) return 1000.0 / (s_txmon_keepalive ? s_rate_floor_hz : s_rate_hz);
+    return 1000.0 / (double)s_send_hz;
+}
 
-    uint16_t vv[PWM_HOST_CH_NUM];
-    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
-        float pi = pct[i];
-        if (pi < 0.0f) pi = PWM_HOST_PCT_MID;  /* 负值视为中位 */
-        vv[i] = pwm_host_percent_to_u16(pi);
+/* 每发出一帧 PWM 调用一次：记录间隔、判定超期 / 追赶、按窗口评估告警 */
+static void txmon_on_tx(uint64_t now)
+{
+    const uint64_t last = s_txmon_last_ns;
+    s_txmon_last_ns = now;
+    if (last == 0 || now < last) return;
+
+    pwm_host_txmon_t* m = &s_txmon;
+    const double period = txmon_period_ms();
+    const double iv     = (double)(now - last) / 1e6;
+
+    /* 直方图 + Welford 均值 / 方差 */
+    uint64_t bin = (now - last) / 1000u / s_txmon_cfg.bin_us;
+    if (bin >= PWM_HOST_TXMON_BINS) bin = PWM_HOST_TXMON_BINS - 1;
+    ++m->hist[bin];
+    ++m->frames;
+    const double delta = iv - m->mean_ms;
+    m->mean_ms += delta / (double)m->frames;
+    s_txmon_m2 += delta * (iv - m->mean_ms);
+    if (m->frames == 1 || iv < m->min_ms) m->min_ms = iv;
+    if (iv > m->max_ms) m->max_ms = iv;
+    m->period_ms = period;
+
+    int verdict = 0;
+    if (iv > period + s_txmon_cfg.tolerance_ms) {
+        verdict = 1;
+        ++m->deadline_miss;
+        ++s_stats.tx_deadline_miss;
+        ++s_txmon_win_miss;
+        s_txmon_in_burst = 0;
+    } else if (iv < period * s_txmon_cfg.burst_ratio) {
+        verdict = 2;
+        ++m->catchup_frames;
+        if (!s_txmon_in_burst) {
+            ++m->catchup_burst;
+            ++s_stats.tx_catchup_burst;
+            s_txmon_in_burst = 1;
+        }
+    } else {
+        s_txmon_in_burst = 0;
+    }
+    PWMH_TRACE3(tx_interval, (long long)(now - last) / 1000, (long long)(period * 1000.0), verdict);
+
+    /* 窗口告警（带迟滞：进入 ≥ 阈值，解除 < 阈值/2） */
+    if (s_txmon_cfg.window == 0 || ++s_txmon_win_n < s_txmon_cfg.window) return;
+    const double rate = (double)s_txmon_win_miss / (double)s_txmon_win_n;
+    s_txmon_win_n    = 0;
+    s_txmon_win_miss = 0;
+    if (s_txmon_cfg.alert_miss_rate <= 0.0) return;
+    if (!m->alert_active && rate >= s_txmon_cfg.alert_miss_rate) {
+        m->alert_active = 1;
+        ++m->alerts;
+        if (s_txmon_cfg.on_alert) s_txmon_cfg.on_alert(1, rate, s_txmon_cfg.user);
+    } else if (m->alert_active && rate < s_txmon_cfg.alert_miss_rate / 2.0) {
+        m->alert_active = 0;
+        if (s_txmon_cfg.on_alert) s_txmon_cfg.on_alert(0, rate, s_txmon_cfg.user);
     }
-    return pwm_host_set_all_u16(vv);
 }
 
-PWMH_API pwmh_result_t pwm_host_set_ch_pct(int ch, float pct)
+static pwmh_result_t send_shadow(void);
+
+/* 到期的待发指令按当前速率发出；空闲超过保活周期则重发影子值 */
+static void service_rate(void)
 {
-    if (s_sock < 0) return PWMH_ENOTINIT;
-    if (ch < 1 || ch > PWM_HOST_CH_NUM) return PWMH_EINVAL;
+    if (!s_rate_enabled || !host_is_open() || s_rate_last_tx_ns == 0) return;
+    const uint64_t now = s_clock.now_ns(s_clock.user);
 
-    uint16_t vv[PWM_HOST_CH_NUM];
-    /* 从影子复制当前值 */
-    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
-        vv[i] = s_shadow[i];
-    }
+    if (now >= s_rate_eval_ns) rate_evaluate(now);
 
-    float p = (pct < 0.0f) ? PWM_HOST_PCT_MID : pct;
-    vv[ch - 1] = pwm_host_percent_to_u16(p);
-    return pwm_host_set_all_u16(vv);
+    if (s_rate_pending) {
+        if (now - s_rate_last_tx_ns >= (uint64_t)(1e9 / s_rate_hz)) (void)send_shadow();
+    } else if (now - s_rate_last_tx_ns >= (uint64_t)(1e9 / s_rate_floor_hz)) {
+        s_txmon_keepalive = 1;
+        if (send_shadow() == PWMH_OK) ++s_stats.tx_pwm_keepalive;
+        s_txmon_keepalive = 0;
+    }
 }
 
-/* ============================ 心跳与轮询 ============================ */
+/* ============================ 双链路热备 ============================ */
 
-PWMH_API pwmh_result_t pwm_host_send_heartbeat(void)
+/* 链路在 lapse_ms 内收到过探测 ACK */
+static int link_up(int link, uint64_t now)
 {
-    if (s_sock < 0) return PWMH_ENOTINIT;
+    const host_link_t* l = &s_links[link];
+    return l->last_ack_ns != 0 &&
+           now - l->last_ack_ns <= (uint64_t)(unsigned)s_fo_cfg.lapse_ms * 1000000u;
+}
 
-    /* 先“窥视”一下将要使用的 seq：v1_pack 会 ++s_seq */
-    uint16_t next_seq = (uint16_t)(s_seq + 1);
-    uint32_t now_ms   = ticks_ms();
+static void switch_link(int to, uint64_t now)
+{
+    const uint64_t last = s_links[s_active_link].last_ack_ns;
+    const uint32_t age  = last ? (uint32_t)((now - last) / 1000000ull) : UINT32_MAX;
+    PWMH_TRACE3(link_switch, s_active_link, to, age);
+    s_active_link = to;
+    ++s_stats.link_switches;
+}
 
+/* 向指定链路发一帧探测心跳（心跳 SEQ 空间，与 PWM 分开；只走该链路） */
+static void link_probe(int link, uint64_t now)
+{
+    host_link_t* l = &s_links[link];
+    uint8_t  buf[V1_MAX_FRAME];
+    uint16_t n = 0;
+    if (v1_pack(MSG_HB, NULL, 0, buf, sizeof(buf), &n) != PWMH_OK) return;
+
+    link_probe_t* pr = &l->ring[l->ring_pos];
+    l->ring_pos = (l->ring_pos + 1u) % LINK_PROBE_RING;
+    pr->seq     = s_hb_seq;
+    pr->acked   = 0;
+    pr->sent_ns = now;
+    ++l->probes_tx;
+
+    /* 只走该链路，不经 raw_send 的链路选择；分帧方式与其他帧一致 */
+    uint8_t        wire[PWM_COBS_WIRE_MAX(V1_MAX_FRAME)];
+    const uint8_t* out = NULL;
+    const uint16_t len = to_wire(buf, n, wire, &out);
+    ssize_t sent = sock_send(l->sock, &l->addr, out, len);
+    PWMH_TRACE4(sendto_ret, MSG_HB, s_hb_seq, sent, (sent < 0) ? errno : 0);
+    if (sent != (ssize_t)len) ++s_stats.tx_err;
+}
+
+/* HB_ACK 归属：按 SEQ 匹配各链路的探测记录（ACK 从哪个 socket 回来不重要） */
+static int link_on_ack(uint16_t seq, uint64_t now)
+{
+    for (int k = 0; k < PWM_HOST_LINK_NUM; ++k) {
+        host_link_t* l = &s_links[k];
+        for (unsigned i = 0; i < LINK_PROBE_RING; ++i) {
+            link_probe_t* pr = &l->ring[i];
+            if (pr->sent_ns == 0 || pr->seq != seq || pr->acked) continue;
+            pr->acked      = 1;
+            l->rtt_ms      = (double)(now - pr->sent_ns) / 1e6;
+            rate_on_rtt(l->rtt_ms, now);
+            l->last_ack_ns = now;
+            ++l->consec_acks;
+            ++l->acks_rx;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * 切换策略：
+ *  - 当前为主链路且主链路失效、备链路可用 → 切到备链路；
+ *  - 当前为备链路：备链路失效而主链路可用，或主链路已连续 failback_acks 次探测成功 → 切回主链路。
+ */
+static void service_links(void)
+{
+    if (!s_fo_enabled || s_sock < 0) return;
+    const uint64_t now   = s_clock.now_ns(s_clock.user);
+    const uint64_t lapse = (uint64_t)(unsigned)s_fo_cfg.lapse_ms * 1000000u;
+
+    for (int k = 0; k < PWM_HOST_LINK_NUM; ++k) {
+        host_link_t* l = &s_links[k];
+        /* 有探测超时未应答 → 连续成功计数清零 */
+        for (unsigned i = 0; i < LINK_PROBE_RING; ++i) {
+            const link_probe_t* pr = &l->ring[i];
+            if (pr->sent_ns != 0 && !pr->acked && now - pr->sent_ns > lapse &&
+                pr->sent_ns > l->last_ack_ns) {
+                l->consec_acks = 0;
+                break;
+            }
+        }
+        if (now >= l->next_probe_ns) {
+            link_probe(k, now);
+            l->next_probe_ns = now + (uint64_t)(unsigned)s_fo_cfg.probe_ms * 1000000u;
+        }
+    }
+
+    const int up0 = link_up(PWM_HOST_LINK_PRIMARY, now);
+    const int up1 = link_up(PWM_HOST_LINK_SECONDARY, now);
+    if (s_active_link == PWM_HOST_LINK_PRIMARY) {
+        if (!up0 && up1) switch_link(PWM_HOST_LINK_SECONDARY, now);
+    } else if (up0 && (!up1 ||
+               s_links[PWM_HOST_LINK_PRIMARY].consec_acks >= (uint32_t)s_fo_cfg.failback_acks)) {
+        switch_link(PWM_HOST_LINK_PRIMARY, now);
+    }
+}
+
+/* ============================ 快速链路恢复 ============================ */
+
+static pwmh_result_t send_hb(void);
+static pwmh_result_t apply_all_u16(const uint16_t v[PWM_HOST_CH_NUM]);
+
+static uint64_t ms_to_ns(uint32_t ms) { return (uint64_t)ms * 1000000ull; }
+
+static int rec_active(void)
+{
+    return s_rec_enabled && s_rec.state != PWM_HOST_REC_NORMAL;
+}
+
+/* 调用方设定的目标值（恢复期间影子值是实际输出，不是目标） */
+static const uint16_t* commanded(void)
+{
+    return rec_active() ? s_rec_target : s_shadow;
+}
+
+/* 目标 → 本帧输出：PROBING 已回中则发中位，RAMP 按进度从中位插值 */
+static void rec_output(uint16_t out[PWM_HOST_CH_NUM], uint64_t now)
+{
+    double k = 1.0;
+    if (s_rec.state == PWM_HOST_REC_PROBING) {
+        k = s_rec_held ? 0.0 : 1.0;
+    } else if (s_rec.state == PWM_HOST_REC_RAMP) {
+        k = (double)(now - s_rec_back_ns) / (double)ms_to_ns(s_rec_cfg.ramp_ms);
+        if (k > 1.0) k = 1.0;
+    }
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+        const double d = (double)s_rec_target[i] - (double)PWM_HOST_VAL_MID;
+        out[i] = (uint16_t)((double)PWM_HOST_VAL_MID + d * k + 0.5);
+    }
+}
+
+/* 判定失联：进入 PROBING，本次服务即发出第一帧快速心跳 */
+static void rec_lost(uint64_t now, int unreach)
+{
+    if (!s_rec_enabled || s_rec_last_ack_ns == 0 || s_rec.state == PWM_HOST_REC_PROBING) return;
+    if (s_rec.state == PWM_HOST_REC_NORMAL) memcpy(s_rec_target, s_shadow, sizeof(s_rec_target));
+
+    s_rec.state          = PWM_HOST_REC_PROBING;
+    s_rec.last_detect_ms = (double)(now - s_rec_last_ack_ns) / 1e6;
+    ++s_rec.losses;
+    if (unreach) ++s_rec.losses_unreach;
+    s_rec_lost_ns  = now;
+    s_rec_probe_ns = now;
+    s_rec_held     = 0;
+
+    /* 为重新同步做准备：探测心跳与此后的 PWM 走 v1（完整 SEQ16），失联前的冗余副本作废 */
+    s_v2_peer  = 0;
+    s_dup_left = 0;
+    PWMH_TRACE2(link_recovery, s_rec.state, (uint32_t)s_rec.last_detect_ms);
+}
+
+/* 收发遇到不可达错误 */
+static void rec_on_unreach(void)
+{
+    if (!s_rec_enabled) return;
+    ++s_rec.unreach_errors;
+    if (s_rec_cfg.icmp) rec_lost(s_clock.now_ns(s_clock.user), 1);
+}
+
+/* 任一 HB_ACK：清除应答超时；PROBING 下即为恢复，重新同步后进入 RAMP / NORMAL */
+static void rec_on_ack(uint32_t dev_ticks, uint64_t now)
+{
+    if (!s_rec_enabled) return;
+
+    /* 设备重启：tick 明显小于按主机时间外推的值；设备时钟重新计数，旧偏移样本作废 */
+    int reset = 0;
+    if (s_rec_last_ack_ns != 0) {
+        const uint32_t expect = s_rec_dev_ticks + (uint32_t)((now - s_rec_last_ack_ns) / 1000000ull);
+        if ((int32_t)(expect - dev_ticks) > REC_RESET_SLACK_MS) {
+            reset = 1;
+            ++s_rec.dev_resets;
+            s_clk_count = 0;
+            s_clk_pos   = 0;
+        }
+    }
+
+    const uint64_t last = s_rec_last_ack_ns;
+    s_rec_last_ack_ns = now;
+    s_rec_dev_ticks   = dev_ticks;
+    s_rec_hb_wait_ns  = 0;
+    if (s_rec.state != PWM_HOST_REC_PROBING) return;
+
+    s_rec.last_ttr_ms    = (double)(now - s_rec_lost_ns) / 1e6;
+    s_rec.last_outage_ms = (double)(now - last) / 1e6;
+    if (s_rec.last_ttr_ms > s_rec.max_ttr_ms) s_rec.max_ttr_ms = s_rec.last_ttr_ms;
+    ++s_rec.recoveries;
+    s_rec_back_ns = now;
+
+    /* 设备已回中或重启过：从中位渐变；短暂中断：设备仍在执行原指令，直接恢复 */
+    if ((s_rec_held || reset) && s_rec_cfg.ramp_ms > 0) {
+        s_rec.state = PWM_HOST_REC_RAMP;
+        ++s_rec.ramps;
+    } else {
+        s_rec.state        = PWM_HOST_REC_NORMAL;
+        s_rec.last_ramp_ms = 0.0;
+    }
+    s_rec_resend = 1;
+    PWMH_TRACE2(link_recovery, s_rec.state, (uint32_t)s_rec.last_ttr_ms);
+}
+
+/* 应答超时判定 / 快速心跳 / 回中 / 渐变补发 */
+static void service_recovery(void)
+{
+    if (!s_rec_enabled || !host_is_open()) return;
+    const uint64_t now = s_clock.now_ns(s_clock.user);
+
+    if (s_rec.state != PWM_HOST_REC_PROBING && s_rec_last_ack_ns != 0) {
+        if (s_rec_hb_wait_ns != 0) {
+            if (now - s_rec_hb_wait_ns >= ms_to_ns(s_rec_cfg.ack_timeout_ms)) rec_lost(now, 0);
+        } else if (s_rec_cfg.keepalive_ms && now - s_rec_last_ack_ns >= ms_to_ns(s_rec_cfg.keepalive_ms)) {
+            ++s_rec.keepalives;   /* 调用方心跳间隔较长时由库补发，失联检测不受其限制 */
+            (void)send_hb();
+        }
+    }
+
+    if (s_rec.state == PWM_HOST_REC_PROBING) {
+        if (!s_rec_held && now - s_rec_last_ack_ns >= ms_to_ns(s_rec_cfg.hold_ms)) {
+            s_rec_held   = 1;    /* 设备此时已失联回中：改发中位，目标留待恢复后渐变 */
+            s_rec_resend = 1;
+        }
+        if (now >= s_rec_probe_ns) {
+            s_rec_probe_ns = now + ms_to_ns(s_rec_cfg.probe_ms);
+            ++s_rec.probes;
+            (void)send_hb();
+        }
+    } else if (s_rec.state == PWM_HOST_REC_RAMP) {
+        if (now - s_rec_back_ns >= ms_to_ns(s_rec_cfg.ramp_ms)) {
+            s_rec.state        = PWM_HOST_REC_NORMAL;   /* 末帧即目标值 */
+            s_rec.last_ramp_ms = (double)(now - s_rec_back_ns) / 1e6;
+            s_rec_resend       = 1;
+            PWMH_TRACE2(link_recovery, s_rec.state, (uint32_t)s_rec.last_ramp_ms);
+        } else if (now - s_rec_tx_ns >= (uint64_t)(1e9 / s_send_hz)) {
+            s_rec_resend = 1;
+        }
+    }
+
+    if (s_rec_resend) {
+        uint16_t v[PWM_HOST_CH_NUM];
+        memcpy(v, s_rec_target, sizeof(v));
+        s_rec_resend = 0;
+        s_rec_tx_ns  = now;
+        (void)apply_all_u16(v);
+    }
+}
+
+/* 下一次恢复服务到期时刻；无则 UINT64_MAX */
+static uint64_t rec_next_ns(void)
+{
+    if (!s_rec_enabled) return UINT64_MAX;
+    if (s_rec_resend) return 0;
+
+    uint64_t t = UINT64_MAX;
+    if (s_rec.state == PWM_HOST_REC_PROBING) {
+        t = s_rec_probe_ns;
+        if (!s_rec_held && s_rec_last_ack_ns + ms_to_ns(s_rec_cfg.hold_ms) < t) {
+            t = s_rec_last_ack_ns + ms_to_ns(s_rec_cfg.hold_ms);
+        }
+        return t;
+    }
+    if (s_rec_last_ack_ns != 0) {
+        if (s_rec_hb_wait_ns != 0) {
+            t = s_rec_hb_wait_ns + ms_to_ns(s_rec_cfg.ack_timeout_ms);
+        } else if (s_rec_cfg.keepalive_ms) {
+            t = s_rec_last_ack_ns + ms_to_ns(s_rec_cfg.keepalive_ms);
+        }
+    }
+    if (s_rec.state == PWM_HOST_REC_RAMP) {
+        const uint64_t tx  = s_rec_tx_ns + (uint64_t)(1e9 / s_send_hz);
+        const uint64_t end = s_rec_back_ns + ms_to_ns(s_rec_cfg.ramp_ms);
+        if (tx < t)  t = tx;
+        if (end < t) t = end;
+    }
+    return t;
+}
+
+static pwmh_result_t stage_send(void);
+
+/* 延迟模式：没有未提交的批量时，把暂存值作为一帧发出 */
+static void service_deferred(void)
+{
+    if (s_deferred && s_txn_depth == 0 && s_stage_dirty && host_is_open()) (void)stage_send();
+}
+
+static void service_all(void)
+{
+    if (s_in_service) return;
+    s_in_service = 1;
+    service_deferred();
+    service_dup();
+    service_links();
+    service_recovery();
+    service_rate();
+    s_in_service = 0;
+}
+
+/* 下一次需要库内服务（冗余副本 / 链路探测）的时刻；无则 UINT64_MAX */
+static uint64_t next_service_ns(void)
+{
+    uint64_t t = UINT64_MAX;
+    if (!host_is_open()) return t;
+    if (s_deferred && s_txn_depth == 0 && s_stage_dirty) return 0;
+    if (s_dup_left > 0) t = s_dup_due_ns;
+    if (s_fo_enabled && s_sock >= 0) {
+        for (int k = 0; k < PWM_HOST_LINK_NUM; ++k) {
+            if (s_links[k].next_probe_ns < t) t = s_links[k].next_probe_ns;
+        }
+    }
+    if (s_rate_enabled && s_rate_last_tx_ns != 0) {
+        /* 待发指令按当前速率到期；否则按保活下限到期 */
+        const double   hz  = s_rate_pending ? s_rate_hz : s_rate_floor_hz;
+        const uint64_t due = s_rate_last_tx_ns + (uint64_t)(1e9 / hz);
+        if (due < t) t = due;
+        if (s_rate_eval_ns < t) t = s_rate_eval_ns;
+    }
+    const uint64_t rec = rec_next_ns();
+    if (rec < t) t = rec;
+    return t;
+}
+
+static int poll_socket_us(long long timeout_us);
+
+static int mbox_pending(void)
+{
+    return s_mbox_pwm || s_mbox_urgent || s_mbox_hb;
+}
+
+/*
+ * 等待 ns：热备模式或邮箱有待发帧时改为在 socket 上等待——
+ * 到达的探测 ACK 即时处理（RTT 不被睡眠拉长），fd 一旦可写就冲刷邮箱。
+ */
+static void wait_ns(uint64_t ns)
+{
+    if ((s_fo_enabled || mbox_pending()) && s_sock >= 0 && s_clock.now_ns == sys_now_ns) {
+        const uint64_t end = s_clock.now_ns(s_clock.user) + ns;
+        for (;;) {
+            const uint64_t now = s_clock.now_ns(s_clock.user);
+            if (now >= end) break;
+            (void)poll_socket_us((long long)((end - now) / 1000u));
+            service_mbox();
+        }
+        return;
+    }
+    s_clock.sleep_ns(s_clock.user, ns);
+}
+
+/* 解析 HB_ACK（最小校验：SOF/VER/MSG/CRC；LEN 允许为 0） */
+static int v1_try_parse_hb_ack(const uint8_t* buf, int len, uint16_t* out_seq, uint32_t* out_ticks,
+                               const uint8_t** out_payload, uint16_t* out_plen)
+{
+    if (!buf || len < (V1_HEADER_TOTAL_LEN + V1_CRC_LEN)) return 0;
+
+    /* SOF */
+    if (buf[0] != (uint8_t)(PWM_HOST_SOF_BE >> 8) ||
+        buf[1] != (uint8_t)(PWM_HOST_SOF_BE & 0xFF)) {
+        return 0;
+    }
+
+    const uint8_t* p = buf + 2;
+    uint8_t ver = p[0];
+    uint8_t msg = p[1];
+    if (ver != PWM_HOST_PROTO_VER || msg != MSG_HB_ACK) return 0;
+
+    uint16_t seq_be;   memcpy(&seq_be,   p + 2, 2);
+    uint32_t ticks_be; memcpy(&ticks_be, p + 4, 4);
+    uint16_t len_be;   memcpy(&len_be,   p + 8, 2);
+
+    uint16_t payload_len = ntohs(len_be);
+    const int frame_len  = V1_HEADER_TOTAL_LEN + payload_len + V1_CRC_LEN;
+    if (len < frame_len) return 0;
+
+    /* CRC 检验（覆盖 VER..LEN(+PAYLOAD)） */
+    uint16_t crc_rx_be; memcpy(&crc_rx_be, buf + (frame_len - 2), 2);
+    uint16_t crc_rx   = ntohs(crc_rx_be);
+    uint16_t crc_calc = crc16_ccitt_false(buf + 2, (uint16_t)(V1_FIXED_HEADER_LEN + payload_len));
+    if (crc_rx != crc_calc) return 0;
+
+    if (out_seq)     *out_seq     = ntohs(seq_be);
+    if (out_ticks)   *out_ticks   = ntohl(ticks_be);
+    if (out_payload) *out_payload = buf + V1_HEADER_TOTAL_LEN;
+    if (out_plen)    *out_plen    = payload_len;
+    return frame_len; /* consumed bytes */
+}
+
+/* ============================ 错误字符串 ============================ */
+
+PWMH_API const char* pwm_host_strerror(pwmh_result_t rc)
+{
+    switch (rc) {
+    case PWMH_OK:        return "OK";
+    case PWMH_EINVAL:    return "EINVAL";
+    case PWMH_ENOTINIT:  return "ENOTINIT";
+    case PWMH_ESYS:      return "ESYS";
+    case PWMH_EBUSY:     return "EBUSY";
+    case PWMH_EINTERNAL: return "EINTERNAL";
+    default:             return "UNKNOWN";
+    }
+}
+
+/* ============================ 默认配置 ============================ */
+
+PWMH_API void pwm_host_default_config(pwm_host_config_t* cfg)
+{
+    if (!cfg) return;
+    cfg->stm32_ip      = "192.168.2.16";
+    cfg->stm32_port    = 8000;
+    cfg->send_hz       = 50;
+    cfg->socket_sndbuf = 0;
+    cfg->nonblock_send = 0;
+}
+
+/* ============================ 映射工具实现 ============================ */
+
+PWMH_API uint16_t pwm_host_percent_to_u16(float pct)
+{
+    if (pct < PWM_HOST_PCT_MIN) pct = PWM_HOST_PCT_MIN;
+    if (pct > PWM_HOST_PCT_MAX) pct = PWM_HOST_PCT_MAX;
+    /* 5.0% → 0, 10.0% → 10000 */
+    float norm = (pct - PWM_HOST_PCT_MIN) / (PWM_HOST_PCT_MAX - PWM_HOST_PCT_MIN); /* 0..1 */
+    int v = (int)(norm * (float)PWM_HOST_VAL_MAX + 0.5f);
+    if (v < PWM_HOST_VAL_MIN) v = PWM_HOST_VAL_MIN;
+    if (v > PWM_HOST_VAL_MAX) v = PWM_HOST_VAL_MAX;
+    return (uint16_t)v;
+}
+
+PWMH_API float pwm_host_u16_to_percent(uint16_t v)
+{
+    if (v > PWM_HOST_VAL_MAX) v = PWM_HOST_VAL_MAX;
+    /* 0 → 5.0%, 10000 → 10.0% */
+    float pct = PWM_HOST_PCT_MIN
+              + (PWM_HOST_PCT_MAX - PWM_HOST_PCT_MIN) * ((float)v / (float)PWM_HOST_VAL_MAX);
+    return pct;
+}
+
+/* ============================ 生命周期 ============================ */
+
+/* 速率控制动态状态回到起始速率 */
+static void rate_reset(void)
+{
+    s_rate_pending     = 0;
+    s_rate_last_tx_ns  = 0;
+    s_rate_eval_ns     = 0;
+    s_rate_hold_ns     = 0;
+    s_rate_congested   = 0;
+    s_rate_tx_err      = 0;
+    s_rate_min_rtt     = -1.0;
+    s_rate_activity    = 0.0;
+    s_rate_prev_cmd_ns = 0;
+    if (s_rate_enabled) {
+        s_rate_hz = s_rate_floor_hz;
+        rate_set(s_rate_cfg.start_hz, 3);
+    }
+}
+
+/* 重置会话状态（影子值/SEQ/统计/RTT），socket 与注入传输共用 */
+static void reset_session(void)
+{
+    /* 影子值设为中位 */
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+        s_shadow[i] = PWM_HOST_VAL_MID;
+    }
+    s_seq    = 0;
+    s_hb_seq = 0;
+
+    /* 重置统计与 RTT */
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.dev_phase_lag_us = -1;
+    s_last_rtt_ms        = -1.0;
+    s_last_hb_seq        = 0;
+    s_last_hb_send_ticks = 0;
+    s_last_hb_send_ns    = 0;
+    s_clk_count          = 0;
+    s_clk_pos            = 0;
+
+    s_dup_left = 0;
+    rate_reset();
+    s_mbox_pwm = s_mbox_urgent = s_mbox_hb = 0;
+    s_stage_valid = s_stage_dirty = s_txn_depth = s_deferred = 0;
+    s_stage_calls = 0;
+    s_v2_peer     = 0;
+    s_v2_ack_ns   = 0;
+    txmon_clear();
+
+    memset(&s_rec, 0, sizeof(s_rec));
+    s_rec_last_ack_ns = 0;
+    s_rec_hb_wait_ns  = 0;
+    s_rec_tx_ns       = 0;
+    s_rec_held        = 0;
+    s_rec_resend      = 0;
+}
+
+PWMH_API pwmh_result_t pwm_host_init(const pwm_host_config_t* cfg)
+{
+    pwm_host_disable_failover();
+    if (s_sock >= 0) {
+        close(s_sock);
+        s_sock = -1;
+    }
+    memset(&s_tp, 0, sizeof(s_tp));
+
+    pwm_host_config_t local_cfg;
+    if (cfg == NULL) {
+        pwm_host_default_config(&local_cfg);
+        cfg = &local_cfg;
+    }
+
+    const char* ip   = (cfg->stm32_ip   != NULL) ? cfg->stm32_ip   : "192.168.2.16";
+    uint16_t    port = (cfg->stm32_port != 0   ) ? cfg->stm32_port : 8000;
+    s_send_hz         = (cfg->send_hz   > 0   ) ? cfg->send_hz     : 50;
+    s_nonblock_send   = (cfg->nonblock_send != 0) ? 1 : 0;
+
+    s_sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s_sock < 0) return PWMH_ESYS;
+    pwmh_sockq_enable(s_sock);
+    if (s_rec_enabled && s_rec_cfg.icmp) pwmh_sockq_enable_recverr(s_sock);
+    s_ovfl_last = 0;
+
+    memset(&s_addr, 0, sizeof(s_addr));
+    s_addr.sin_family = AF_INET;
+    s_addr.sin_port   = htons(port);
+    if (inet_pton(AF_INET, ip, &s_addr.sin_addr) != 1) {
+        close(s_sock); s_sock = -1;
+        return PWMH_EINVAL;
+    }
+
+    if (cfg->socket_sndbuf > 0) {
+        int sndbuf = cfg->socket_sndbuf;
+        (void)setsockopt(s_sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    }
+
+    reset_session();
+    return PWMH_OK;
+}
+
+PWMH_API pwmh_result_t pwm_host_init_transport(const pwm_host_config_t* cfg,
+                                               const pwm_host_transport_t* tp)
+{
+    if (!tp || !tp->send || !tp->recv) return PWMH_EINVAL;
+
+    pwm_host_close();
+
+    s_send_hz       = (cfg && cfg->send_hz > 0) ? cfg->send_hz : 50;
+    s_nonblock_send = 0;
+    s_tp            = *tp;
+
+    reset_session();
+    return PWMH_OK;
+}
+
+PWMH_API void pwm_host_close(void)
+{
+    pwm_host_disable_failover();
+    if (s_sock >= 0) {
+        close(s_sock);
+        s_sock = -1;
+    }
+    memset(&s_tp, 0, sizeof(s_tp));
+}
+
+/* ============================ 时钟注入 ============================ */
+
+PWMH_API void pwm_host_set_clock(const pwm_host_clock_t* clk)
+{
+    if (clk && clk->now_ns && clk->sleep_ns) {
+        s_clock = *clk;
+    } else {
+        s_clock.now_ns   = sys_now_ns;
+        s_clock.sleep_ns = sys_sleep_ns;
+        s_clock.user     = NULL;
+    }
+}
+
+PWMH_API void pwm_host_use_virtual_clock(uint64_t start_ns)
+{
+    s_vclock_ns      = start_ns;
+    s_clock.now_ns   = vclock_now_ns;
+    s_clock.sleep_ns = vclock_sleep_ns;
+    s_clock.user     = NULL;
+}
+
+PWMH_API void pwm_host_vclock_advance_ns(uint64_t ns)
+{
+    s_vclock_ns += ns;
+}
+
+PWMH_API uint64_t pwm_host_now_ns(void)
+{
+    return s_clock.now_ns(s_clock.user);
+}
+
+PWMH_API uint32_t pwm_host_ticks_ms(void)
+{
+    return ticks_ms();
+}
+
+PWMH_API void pwm_host_sleep_ms(double ms)
+{
+    sleep_ms(ms);
+}
+
+PWMH_API const char* pwm_host_version(void)
+{
+    return PWM_HOST_SEMVER;
+}
+
+/* ============================ 发送接口 ============================ */
+
+static int staging(void)
+{
+    return s_txn_depth > 0 || s_deferred;
+}
+
+/* 修改暂存值前：首次从影子值复制（未改动的通道保持当前输出） */
+static uint16_t* stage_begin_edit(void)
+{
+    if (!s_stage_valid) {
+        memcpy(s_stage, commanded(), sizeof(s_stage));
+        s_stage_valid = 1;
+    }
+    s_stage_dirty = 1;
+    ++s_stage_calls;
+    return s_stage;
+}
+
+static pwmh_result_t apply_all_u16(const uint16_t v[PWM_HOST_CH_NUM]);
+
+/* 暂存值整帧发出（走与立即下发相同的速率控制 / 邮箱路径） */
+static pwmh_result_t stage_send(void)
+{
+    if (s_stage_calls > 1) s_stats.tx_pwm_merged += s_stage_calls - 1u;
+    s_stage_dirty = 0;
+    s_stage_valid = 0;
+    s_stage_calls = 0;
+    return apply_all_u16(s_stage);
+}
+
+PWMH_API pwmh_result_t pwm_host_set_all_u16(const uint16_t v[PWM_HOST_CH_NUM])
+{
+    if (!host_is_open()) return PWMH_ENOTINIT;
+    if (!v) return PWMH_EINVAL;
+
+    if (staging()) {
+        uint16_t* st = stage_begin_edit();
+        for (int i = 0; i < PWM_HOST_CH_NUM; ++i) st[i] = (v[i] > PWM_HOST_VAL_MAX) ? PWM_HOST_VAL_MAX : v[i];
+        return PWMH_OK;
+    }
+    return apply_all_u16(v);
+}
+
+static pwmh_result_t apply_all_u16(const uint16_t v[PWM_HOST_CH_NUM])
+{
+    /* 快速恢复期间：v 记为目标，实际下发中位 / 渐变值 */
+    uint16_t rec_out[PWM_HOST_CH_NUM];
+    if (rec_active()) {
+        for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+            s_rec_target[i] = (v[i] > PWM_HOST_VAL_MAX) ? (uint16_t)PWM_HOST_VAL_MAX : v[i];
+        }
+        rec_output(rec_out, s_clock.now_ns(s_clock.user));
+        v = rec_out;
+    }
+
+    /* clamp & 覆盖影子 */
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+        uint16_t vi = v[i];
+        if (vi > PWM_HOST_VAL_MAX) vi = PWM_HOST_VAL_MAX;
+        s_shadow[i]  = vi;
+    }
+
+    /* 速率控制：未到发送时刻只更新影子值，到期由 poll/sleep 发出最新值（旧指令被覆盖） */
+    /* 先冲刷邮箱优先槽（急停 / 心跳），保证其不被新的 PWM 抢先；仍滞留的旧指令被本次覆盖 */
+    service_mbox();
+    if (s_mbox_pwm) ++s_stats.tx_mbox_replaced;
+
+    if (s_rate_enabled) {
+        const uint64_t now = s_clock.now_ns(s_clock.user);
+        rate_on_command(s_shadow, now);
+        if (s_rate_last_tx_ns != 0 && now - s_rate_last_tx_ns < (uint64_t)(1e9 / s_rate_hz)) {
+            if (s_rate_pending) ++s_stats.tx_pwm_coalesced;
+            s_rate_pending = 1;
+            service_all();
+            return PWMH_OK;
+        }
+    }
+    return send_shadow();
+}
+
+/* 以当前影子值立即发一帧 PWM */
+static pwmh_result_t send_shadow(void)
+{
+    if (!host_is_open()) return PWMH_ENOTINIT;
+
+    /* 本帧即最新影子值，取代邮箱中的旧指令（先于服务置位：服务内的速率控制不再重发影子值） */
+    s_mbox_pwm        = 0;
+    s_rate_pending    = 0;
+    s_rate_last_tx_ns = s_clock.now_ns(s_clock.user);
+
+    /* 先服务再组帧：服务可能先发出更新的帧（失联恢复补发 / 暂存值）、改写影子值或退回 v1（rec_lost），
+     * 按服务后的状态组帧，SEQ 顺序才与内容新旧一致；恢复补发已带出当前影子值则不再重复 */
+    const uint64_t tx_before = s_stats.tx_pwm;
+    service_all();
+    if (s_stats.tx_pwm != tx_before && !s_mbox_pwm) return PWMH_OK;
+
+    /* payload 大端打包；定时应用时前置设备 tick 目标时刻 DUE（v2 只带低 16 位） */
+    uint8_t payload[V1_MAX_PAYLOAD];
+    uint8_t* p = payload;
+    uint8_t msg_id = MSG_PWM;
+    const int v2 = proto_use_v2();
+    uint8_t v2_type = (s_proto_bits == 14) ? V2_PWM14 : V2_PWM12;
+    const clk_sample_t* clk = clk_best();
+    if (s_sched_delay_ms > 0 && clk) {
+        const uint32_t due = ticks_ms() + (uint32_t)clk->offset_ms + (uint32_t)s_sched_delay_ms;
+        if (v2) {
+            uint16_t due_be = be16((uint16_t)due);
+            memcpy(p, &due_be, 2);
+            p += 2;
+            v2_type = (uint8_t)(v2_type + V2_PWM12_AT);
+        } else {
+            uint32_t due_be = be32(due);
+            memcpy(p, &due_be, 4);
+            p += 4;
+        }
+        msg_id = MSG_PWM_AT;
+    }
+    if (v2) {
+        p += v2_pack_channels(s_shadow, s_proto_bits, p);
+    } else {
+        for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+            uint16_t be = be16(s_shadow[i]);
+            memcpy(p, &be, 2);
+            p += 2;
+        }
+    }
+
+    pwmh_result_t rc = pack_send(v2, v2 ? v2_type : msg_id, payload, (uint16_t)(p - payload));
+    if (rc == PWMH_EBUSY) {
+        /* 放入邮箱：只保留最新指令 */
+        s_mbox_pwm = 1;
+        return PWMH_OK;
+    }
+    if (rc == PWMH_OK) {
+        ++s_stats.tx_pwm;
+        if (v2) ++s_stats.tx_pwm_v2;
+        txmon_on_tx(s_clock.now_ns(s_clock.user));
+    } else {
+        ++s_stats.tx_err;
+    }
+    return rc;
+}
+
+PWMH_API pwmh_result_t pwm_host_flush(void)
+{
+    if (!host_is_open()) return PWMH_ENOTINIT;
+    /* 暂存值强制发出（急停等不等待 commit / 下一次服务） */
+    if (s_stage_dirty) {
+        pwmh_result_t rc = stage_send();
+        if (rc != PWMH_OK) return rc;
+    }
+    if (!s_rate_pending && !s_mbox_pwm) return PWMH_OK;
+
+    pwmh_result_t rc = send_shadow();
+    /* 仍发不出去：升级到优先槽，先于心跳冲刷 */
+    if (rc == PWMH_OK && s_mbox_pwm) s_mbox_urgent = 1;
+    return rc;
+}
+
+PWMH_API pwmh_result_t pwm_host_set_all_pct(const float pct[PWM_HOST_CH_NUM])
+{
+    if (!host_is_open()) return PWMH_ENOTINIT;
+    if (!pct) return PWMH_EINVAL;
+
+    uint16_t vv[PWM_HOST_CH_NUM];
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+        float pi = pct[i];
+        if (pi < 0.0f) pi = PWM_HOST_PCT_MID;  /* 负值视为中位 */
+        vv[i] = pwm_host_percent_to_u16(pi);
+    }
+    return pwm_host_set_all_u16(vv);
+}
+
+PWMH_API pwmh_result_t pwm_host_set_ch_u16(int ch, uint16_t v)
+{
+    if (!host_is_open()) return PWMH_ENOTINIT;
+    if (ch < 1 || ch > PWM_HOST_CH_NUM) return PWMH_EINVAL;
+    if (v > PWM_HOST_VAL_MAX) v = PWM_HOST_VAL_MAX;
+
+    if (staging()) {
+        stage_begin_edit()[ch - 1] = v;
+        return PWMH_OK;
+    }
+
+    uint16_t vv[PWM_HOST_CH_NUM];
+    /* 从当前目标复制（恢复期间影子值是中位 / 渐变输出） */
+    memcpy(vv, commanded(), sizeof(vv));
+    vv[ch - 1] = v;
+    return apply_all_u16(vv);
+}
+
+PWMH_API pwmh_result_t pwm_host_set_ch_pct(int ch, float pct)
+{
+    float p = (pct < 0.0f) ? PWM_HOST_PCT_MID : pct;
+    return pwm_host_set_ch_u16(ch, pwm_host_percent_to_u16(p));
+}
+
+/* ============================ 批量更新 / 延迟模式 ============================ */
+
+PWMH_API pwmh_result_t pwm_host_begin(void)
+{
+    if (!host_is_open()) return PWMH_ENOTINIT;
+    ++s_txn_depth;
+    return PWMH_OK;
+}
+
+PWMH_API pwmh_result_t pwm_host_commit(void)
+{
+    if (!host_is_open()) return PWMH_ENOTINIT;
+    if (s_txn_depth == 0) return PWMH_EINVAL;
+    if (--s_txn_depth > 0 || !s_stage_dirty) return PWMH_OK;
+    if (s_deferred) return PWMH_OK;   /* 由下一次 poll / sleep / flush 发出 */
+    return stage_send();
+}
+
+PWMH_API void pwm_host_rollback(void)
+{
+    s_txn_depth   = 0;
+    s_stage_valid = 0;
+    s_stage_dirty = 0;
+    s_stage_calls = 0;
+}
+
+PWMH_API pwmh_result_t pwm_host_set_deferred(int on)
+{
+    if (!host_is_open()) return PWMH_ENOTINIT;
+    s_deferred = on ? 1 : 0;
+    if (!s_deferred && s_txn_depth == 0 && s_stage_dirty) return stage_send();
+    return PWMH_OK;
+}
+
+/* ============================ 心跳与轮询 ============================ */
+
+static pwmh_result_t send_hb(void)
+{
+    uint32_t now_ms = ticks_ms();
+
+    /* v1_pack 是 v1_send_frame 中最后一次 ++s_hb_seq（之前可能先发了链路探测），成功后 s_hb_seq 即本帧 SEQ */
     pwmh_result_t rc = v1_send_frame(MSG_HB, NULL, 0);
+    if (rc == PWMH_EBUSY) {
+        s_mbox_hb = 1;   /* 优先槽：fd 可写后先于 PWM 发出（重新组帧，RTT 从实际发出时算起） */
+        return PWMH_OK;
+    }
+    s_mbox_hb = 0;
     if (rc == PWMH_OK) {
         ++s_stats.tx_hb;
-        s_last_hb_seq        = next_seq;
+        s_last_hb_seq        = s_hb_seq;
         s_last_hb_send_ticks = now_ms;
+        s_last_hb_send_ns    = s_clock.now_ns(s_clock.user);
+        if (s_rec_hb_wait_ns == 0) s_rec_hb_wait_ns = s_last_hb_send_ns;
     } else {
         ++s_stats.tx_err;
     }
     return rc;
 }
 
+/* 冲刷邮箱：优先槽（急停 PWM → 心跳）先，普通 PWM 槽后；任一帧仍被阻塞则停止，保持顺序 */
+static void service_mbox(void)
+{
+    if (!mbox_pending() || !host_is_open()) return;
+
+    if (s_mbox_urgent) {
+        s_mbox_urgent = 0;
+        if (send_shadow() != PWMH_OK || s_mbox_pwm) {
+            s_mbox_urgent = s_mbox_pwm;
+            return;
+        }
+    }
+    if (s_mbox_hb) {
+        if (send_hb() != PWMH_OK || s_mbox_hb) return;
+    }
+    if (s_mbox_pwm) (void)send_shadow();
+}
+
+PWMH_API pwmh_result_t pwm_host_send_heartbeat(void)
+{
+    if (!host_is_open()) return PWMH_ENOTINIT;
+    service_mbox();
+    return send_hb();
+}
+
+/* 处理一个收到的数据报；返回 1 表示计为一帧 */
+static int handle_datagram(const uint8_t* buf, int len)
+{
+    PWMH_TRACE2(datagram_rx, len, (len > 3) ? buf[3] : 0);
+
+    /* 尝试解析 HB_ACK */
+    uint16_t       seq_rx   = 0;
+    uint32_t       ticks_rx = 0;
+    const uint8_t* pl       = NULL;
+    uint16_t       plen     = 0;
+    int used = v1_try_parse_hb_ack(buf, len, &seq_rx, &ticks_rx, &pl, &plen);
+    if (used > 0) {
+        ++s_stats.rx_hb_ack;
+
+        /* 可选负载：设备链路统计 rx_unique / rx_dup / seq_gaps（各 u32 大端） */
+        if (plen >= 12) {
+            uint32_t v[3];
+            memcpy(v, pl, sizeof(v));
+            rate_on_dev_stats(ntohl(v[0]), ntohl(v[2]));
+            s_stats.dev_rx_unique = ntohl(v[0]);
+            s_stats.dev_rx_dup    = ntohl(v[1]);
+            s_stats.dev_seq_gaps  = ntohl(v[2]);
+        }
+        /* 扩展负载：相位滞后 μs（0xFFFF=设备尚无样本）/ 状态位（各 u16 大端） */
+        if (plen >= 16) {
+            const uint16_t lag = (uint16_t)((pl[12] << 8) | pl[13]);
+            s_stats.dev_phase_lag_us = (lag == 0xFFFFu) ? -1 : (int32_t)lag;
+            s_stats.dev_status       = (uint16_t)((pl[14] << 8) | pl[15]);
+        }
+
+        /* v2 协商：每个应答都重新确认（旧固件不上报状态位，即回退 v1） */
+        s_v2_peer = (plen >= 16 && (s_stats.dev_status & PWM_HOST_DEV_STATUS_PROTO_V2)) ? 1 : 0;
+        if (s_v2_peer) s_v2_ack_ns = s_clock.now_ns(s_clock.user);
+
+        /* 快速恢复：任一 ACK 都证明链路可用 */
+        rec_on_ack(ticks_rx, s_clock.now_ns(s_clock.user));
+
+        /* 热备探测的 ACK 归到对应链路 */
+        if (s_fo_enabled && link_on_ack(seq_rx, s_clock.now_ns(s_clock.user))) return 1;
+
+        /* 匹配最近一次心跳，给出 RTT（粗略，以 host 单调时钟为准） */
+        if (seq_rx == s_last_hb_seq && s_last_hb_send_ticks != 0) {
+            uint32_t now = ticks_ms();
+            double rtt = (double)(now - s_last_hb_send_ticks);
+            s_last_rtt_ms = rtt;
+            rate_on_rtt(rtt, s_clock.now_ns(s_clock.user));
+            clk_on_ack(ticks_rx, s_clock.now_ns(s_clock.user));
+            PWMH_TRACE2(ack_matched, seq_rx, now - s_last_hb_send_ticks);
+        }
+    }
+
+    /* 其他帧：暂不处理（后续可扩展 STATUS 等） */
+    return 1;
+}
+
+/* 处理收到的数据（COBS 分帧时按 0x00 切分、原地解码，逐帧处理）；返回帧数 */
+static int handle_rx(uint8_t* buf, int len)
+{
+    if (s_framing != PWM_HOST_FRAMING_COBS) return handle_datagram(buf, len);
+
+    int handled = 0;
+    int start   = 0;
+    for (int i = 0; i <= len; ++i) {
+        if (i < len && buf[i] != 0) continue;
+        if (i > start) {
+            const uint16_t m = pwm_cobs_decode(buf + start, (uint16_t)(i - start), buf + start);
+            if (m == 0) ++s_stats.rx_err;
+            else        handled += handle_datagram(buf + start, m);
+        }
+        start = i + 1;
+    }
+    return handled;
+}
+
+/* 采样内核收发队列占用（收包前，主备链路之和），更新峰值 */
+static void sample_queues(void)
+{
+    uint32_t rxq = pwmh_sockq_rx_bytes(s_sock);
+    uint32_t txq = pwmh_sockq_tx_bytes(s_sock);
+    if (s_fo_enabled && s_links[PWM_HOST_LINK_SECONDARY].sock >= 0) {
+        rxq += pwmh_sockq_rx_bytes(s_links[PWM_HOST_LINK_SECONDARY].sock);
+        txq += pwmh_sockq_tx_bytes(s_links[PWM_HOST_LINK_SECONDARY].sock);
+    }
+    s_stats.rxq_bytes = rxq;
+    s_stats.txq_bytes = txq;
+    if (rxq > s_stats.rxq_peak) s_stats.rxq_peak = rxq;
+    if (txq > s_stats.txq_peak) s_stats.txq_peak = txq;
+}
+
+/* 注入传输的轮询：首次按 timeout_ms 等待，之后非阻塞取尽 */
+static int poll_transport(int timeout_ms)
+{
+    int handled = 0;
+    for (;;) {
+        uint8_t buf[RX_BUF_SIZE];
+        int rcv = s_tp.recv(s_tp.user, buf, (uint16_t)sizeof(buf), handled ? 0 : timeout_ms);
+        if (rcv < 0) {
+            ++s_stats.rx_err;
+            return (handled > 0) ? handled : -PWMH_ESYS;
+        }
+        if (rcv == 0) break;
+        handled += handle_rx(buf, rcv);
+    }
+    return handled;
+}
+
 /**
  * @brief 轮询收包/处理
- * @param timeout_ms 0=非阻塞；>0=阻塞等待至多 timeout_ms
+ * @param timeout_ms 0=非阻塞；>0=阻塞等待至多 timeout_ms；<0=无限等待
  * @return
  *   - >= 0 : 本次处理的帧数
  *   - <  0 : 负的错误码（-PWMH_ENOTINIT, -PWMH_ESYS 等）
  */
 PWMH_API int pwm_host_poll(int timeout_ms)
 {
-    if (s_sock < 0) return -PWMH_ENOTINIT;
+    if (!host_is_open()) return -PWMH_ENOTINIT;
+
+    /* 邮箱 / 冗余副本 / 链路探测：先处理已到期的；等待时间不超过下一次到期时刻 */
+    service_mbox();
+    service_all();
+    const uint64_t due_ns = next_service_ns();
+    if (due_ns != UINT64_MAX && timeout_ms != 0) {
+        const uint64_t now  = s_clock.now_ns(s_clock.user);
+        const int      due  = (due_ns > now) ? (int)((due_ns - now) / 1000000ull) : 0;
+        if (timeout_ms < 0 || due < timeout_ms) timeout_ms = due;
+    }
+
+    if (!s_tp.recv) sample_queues();
+
+    int handled = s_tp.recv ? poll_transport(timeout_ms)
+                            : poll_socket_us((timeout_ms < 0) ? -1 : (long long)timeout_ms * 1000);
+    service_mbox();
+    service_all();
+    return handled;
+}
+
+/* 取尽一个 socket 的内核缓冲区（避免积压）；ovfl_last 为该 socket 的 SO_RXQ_OVFL 基准 */
+static int drain_socket(int sock, uint32_t* ovfl_last)
+{
+    int handled = 0;
+    for (;;) {
+        uint8_t            buf[RX_BUF_SIZE];
+        pwmh_sockq_cmsg_t  ctl;
+        struct iovec       iov = { buf, sizeof(buf) };
+        struct msghdr      msg;
+        ssize_t rcv;
+        do {
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov        = &iov;
+            msg.msg_iovlen     = 1;
+            msg.msg_control    = ctl.buf;
+            msg.msg_controllen = sizeof(ctl.buf);
+            rcv = recvmsg(sock, &msg, MSG_DONTWAIT);
+        } while (rcv < 0 && errno == EINTR);
+
+        if (rcv < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (pwmh_sockq_is_unreach(errno)) {
+                /* ICMP 不可达（IP_RECVERR）：不算接收错误，取走错误队列后继续 */
+                rec_on_unreach();
+                (void)pwmh_sockq_drain_errors(sock);
+                continue;
+            }
+            ++s_stats.rx_err;
+            return (handled > 0) ? handled : -PWMH_ESYS;
+        }
+        if (rcv == 0) break; /* UDP: 理论上少见，这里直接退出循环 */
+        s_stats.rx_overflow += pwmh_sockq_take_drops(&msg, ovfl_last);
+        handled += handle_rx(buf, (int)rcv);
+    }
+    return handled;
+}
+
+/* 主 socket（热备模式下连同备链路 socket）上等待并收包 */
+static int poll_socket_us(long long timeout_us)
+{
+    const int sock2 = s_fo_enabled ? s_links[PWM_HOST_LINK_SECONDARY].sock : -1;
 
-    fd_set rfds;
+    fd_set rfds, wfds;
     FD_ZERO(&rfds);
+    FD_ZERO(&wfds);
     FD_SET(s_sock, &rfds);
+    if (sock2 >= 0) FD_SET(sock2, &rfds);
+    const int maxfd = (sock2 > s_sock) ? sock2 : s_sock;
+
+    /* 邮箱有待发帧：fd 可写即返回，由调用方冲刷 */
+    const int want_write = mbox_pending();
+    if (want_write) {
+        FD_SET(s_sock, &wfds);
+        if (sock2 >= 0) FD_SET(sock2, &wfds);
+    }
 
+    /* timeout_us == 0 → 零超时（非阻塞）；< 0 → 无限等待 */
     struct timeval tv, *ptv = NULL;
-    if (timeout_ms > 0) {
-        tv.tv_sec  = timeout_ms / 1000;
-        tv.tv_usec = (timeout_ms % 1000) * 1000;
+    if (timeout_us >= 0) {
+        tv.tv_sec  = (time_t)(timeout_us / 1000000);
+        tv.tv_usec = (suseconds_t)(timeout_us % 1000000);
         ptv = &tv;
     }
 
     int nsel;
     do {
-        nsel = select(s_sock + 1, &rfds, NULL, NULL, ptv);
+        nsel = select(maxfd + 1, &rfds, want_write ? &wfds : NULL, NULL, ptv);
     } while (nsel < 0 && errno == EINTR);
 
     if (nsel < 0) {
@@ -434,45 +1861,329 @@ PWMH_API int pwm_host_poll(int timeout_ms)
     }
     if (nsel == 0) return 0; /* 超时，无数据 */
 
-    if (!FD_ISSET(s_sock, &rfds)) return 0;
-
-    /* 尽量消费掉内核缓冲区（避免积压） */
     int handled = 0;
-    for (;;) {
-        uint8_t buf[RX_BUF_SIZE];
-        ssize_t rcv;
-        do {
-            rcv = recvfrom(s_sock, buf, sizeof(buf), MSG_DONTWAIT, NULL, NULL);
-        } while (rcv < 0 && errno == EINTR);
+    if (FD_ISSET(s_sock, &rfds)) {
+        const int r = drain_socket(s_sock, &s_ovfl_last);
+        if (r < 0) return r;
+        handled += r;
+    }
+    if (sock2 >= 0 && FD_ISSET(sock2, &rfds)) {
+        const int r = drain_socket(sock2, &s_links[PWM_HOST_LINK_SECONDARY].ovfl_last);
+        if (r < 0) return (handled > 0) ? handled : r;
+        handled += r;
+    }
+    return handled;
+}
 
-        if (rcv < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
-            ++s_stats.rx_err;
-            return (handled > 0) ? handled : -PWMH_ESYS;
+PWMH_API pwmh_result_t pwm_host_set_redundancy(int copies, int spacing_ms)
+{
+    if (copies < 1 || copies > PWM_HOST_REDUNDANCY_MAX) return PWMH_EINVAL;
+    if (spacing_ms < 0) return PWMH_EINVAL;
+
+    s_red_copies     = copies;
+    s_red_spacing_ms = spacing_ms;
+    if (copies == 1) s_dup_left = 0;
+    return PWMH_OK;
+}
+
+PWMH_API double pwm_host_residual_loss(void)
+{
+    const uint64_t total = (uint64_t)s_stats.dev_rx_unique + s_stats.dev_seq_gaps;
+    if (total == 0) return -1.0;
+    return (double)s_stats.dev_seq_gaps / (double)total;
+}
+
+PWMH_API void pwm_host_failover_default_config(pwm_host_failover_config_t* cfg)
+{
+    if (!cfg) return;
+    cfg->secondary_ip      = NULL;
+    cfg->secondary_port    = 0;
+    cfg->secondary_bind_ip = NULL;
+    cfg->probe_ms          = 20;
+    cfg->lapse_ms          = 60;
+    cfg->failback_acks     = 5;
+    cfg->duplicate_on_both = 0;
+}
+
+PWMH_API pwmh_result_t pwm_host_enable_failover(const pwm_host_failover_config_t* cfg)
+{
+    if (s_sock < 0) return PWMH_ENOTINIT;   /* 仅 UDP 模式（注入传输只有一条链路） */
+    if (!cfg || !cfg->secondary_ip) return PWMH_EINVAL;
+    if (cfg->probe_ms <= 0 || cfg->lapse_ms <= cfg->probe_ms || cfg->failback_acks < 1) {
+        return PWMH_EINVAL;
+    }
+
+    pwm_host_disable_failover();
+
+    host_link_t* sec = &s_links[PWM_HOST_LINK_SECONDARY];
+    memset(&sec->addr, 0, sizeof(sec->addr));
+    sec->addr.sin_family = AF_INET;
+    sec->addr.sin_port   = cfg->secondary_port ? htons(cfg->secondary_port) : s_addr.sin_port;
+    if (inet_pton(AF_INET, cfg->secondary_ip, &sec->addr.sin_addr) != 1) return PWMH_EINVAL;
+
+    sec->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sec->sock < 0) return PWMH_ESYS;
+    pwmh_sockq_enable(sec->sock);
+    if (s_rec_enabled && s_rec_cfg.icmp) pwmh_sockq_enable_recverr(sec->sock);
+
+    if (cfg->secondary_bind_ip) {
+        struct sockaddr_in local;
+        memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        if (inet_pton(AF_INET, cfg->secondary_bind_ip, &local.sin_addr) != 1 ||
+            bind(sec->sock, (struct sockaddr*)&local, sizeof(local)) != 0) {
+            close(sec->sock);
+            sec->sock = -1;
+            return PWMH_ESYS;
         }
-        if (rcv == 0) break; /* UDP: 理论上少见，这里直接退出循环 */
+    }
 
-        /* 尝试解析 HB_ACK */
-        uint16_t seq_rx   = 0;
-        uint32_t ticks_rx = 0;
-        int used = v1_try_parse_hb_ack(buf, (int)rcv, &seq_rx, &ticks_rx);
-        if (used > 0) {
-            ++handled;
-            ++s_stats.rx_hb_ack;
-
-            /* 匹配最近一次心跳，给出 RTT（粗略，以 host 单调时钟为准） */
-            if (seq_rx == s_last_hb_seq && s_last_hb_send_ticks != 0) {
-                uint32_t now = ticks_ms();
-                double rtt = (double)(now - s_last_hb_send_ticks);
-                s_last_rtt_ms = rtt;
-            }
-            continue;
+    host_link_t* pri = &s_links[PWM_HOST_LINK_PRIMARY];
+    pri->sock = s_sock;
+    pri->addr = s_addr;
+
+    const uint64_t now = s_clock.now_ns(s_clock.user);
+    for (int k = 0; k < PWM_HOST_LINK_NUM; ++k) {
+        s_links[k].next_probe_ns = now;
+        s_links[k].rtt_ms        = -1.0;
+    }
+
+    s_fo_cfg      = *cfg;
+    s_active_link = PWM_HOST_LINK_PRIMARY;
+    s_fo_enabled  = 1;
+    return PWMH_OK;
+}
+
+PWMH_API void pwm_host_disable_failover(void)
+{
+    if (s_fo_enabled && s_links[PWM_HOST_LINK_SECONDARY].sock >= 0) {
+        close(s_links[PWM_HOST_LINK_SECONDARY].sock);
+    }
+    memset(s_links, 0, sizeof(s_links));
+    for (int k = 0; k < PWM_HOST_LINK_NUM; ++k) s_links[k].sock = -1;
+    s_fo_enabled  = 0;
+    s_active_link = PWM_HOST_LINK_PRIMARY;
+}
+
+PWMH_API int pwm_host_active_link(void)
+{
+    return s_active_link;
+}
+
+PWMH_API pwmh_result_t pwm_host_get_link_stats(int link, pwm_host_link_stats_t* out)
+{
+    if (!out || link < 0 || link >= PWM_HOST_LINK_NUM) return PWMH_EINVAL;
+    if (!s_fo_enabled) return PWMH_ENOTINIT;
+
+    const host_link_t* l   = &s_links[link];
+    const uint64_t     now = s_clock.now_ns(s_clock.user);
+    const uint64_t     lapse = (uint64_t)(unsigned)s_fo_cfg.lapse_ms * 1000000u;
+
+    unsigned decided = 0, lost = 0;
+    for (unsigned i = 0; i < LINK_PROBE_RING; ++i) {
+        const link_probe_t* pr = &l->ring[i];
+        if (pr->sent_ns == 0) continue;
+        if (pr->acked) {
+            ++decided;
+        } else if (now - pr->sent_ns > lapse) {
+            ++decided;
+            ++lost;
         }
+    }
+
+    out->up         = link_up(link, now);
+    out->rtt_ms     = l->rtt_ms;
+    out->loss       = decided ? (double)lost / (double)decided : -1.0;
+    out->ack_age_ms = l->last_ack_ns ? (uint32_t)((now - l->last_ack_ns) / 1000000ull) : UINT32_MAX;
+    out->probes_tx  = l->probes_tx;
+    out->acks_rx    = l->acks_rx;
+    return PWMH_OK;
+}
+
+PWMH_API void pwm_host_recovery_default_config(pwm_host_recovery_config_t* cfg)
+{
+    if (!cfg) return;
+    cfg->keepalive_ms   = 100;
+    cfg->ack_timeout_ms = 200;
+    cfg->probe_ms       = 20;
+    cfg->hold_ms        = 300;
+    cfg->ramp_ms        = 1000;
+    cfg->icmp           = 1;
+}
 
-        /* 其他帧：暂不处理（后续可扩展 STATUS 等） */
-        ++handled;
+PWMH_API pwmh_result_t pwm_host_enable_recovery(const pwm_host_recovery_config_t* cfg)
+{
+    pwm_host_recovery_config_t c;
+    pwm_host_recovery_default_config(&c);
+    if (cfg) c = *cfg;
+    if (c.ack_timeout_ms == 0 || c.probe_ms == 0) return PWMH_EINVAL;
+
+    s_rec_cfg     = c;
+    s_rec_enabled = 1;
+    if (c.icmp && s_sock >= 0) {
+        pwmh_sockq_enable_recverr(s_sock);
+        if (s_fo_enabled) pwmh_sockq_enable_recverr(s_links[PWM_HOST_LINK_SECONDARY].sock);
     }
-    return handled;
+    return PWMH_OK;
+}
+
+PWMH_API void pwm_host_disable_recovery(void)
+{
+    const int was_active = rec_active();
+    uint16_t  v[PWM_HOST_CH_NUM];
+    memcpy(v, s_rec_target, sizeof(v));
+
+    s_rec_enabled = 0;
+    s_rec.state   = PWM_HOST_REC_NORMAL;
+    s_rec_resend  = 0;
+    if (was_active && host_is_open()) (void)apply_all_u16(v);
+}
+
+PWMH_API void pwm_host_recovery_get(pwm_host_recovery_t* out)
+{
+    if (!out) return;
+    *out = s_rec;
+}
+
+PWMH_API void pwm_host_rate_default_config(pwm_host_rate_config_t* cfg)
+{
+    if (!cfg) return;
+    cfg->floor_hz           = 10.0;
+    cfg->ceil_hz            = 100.0;
+    cfg->start_hz           = 50.0;
+    cfg->failsafe_ms        = 300;
+    cfg->rtt_factor         = 2.0;
+    cfg->rtt_margin_ms      = 5.0;
+    cfg->loss_hi            = 0.02;
+    cfg->active_units_per_s = 1000.0;
+}
+
+PWMH_API pwmh_result_t pwm_host_enable_rate_control(const pwm_host_rate_config_t* cfg)
+{
+    pwm_host_rate_config_t c;
+    pwm_host_rate_default_config(&c);
+    if (cfg) c = *cfg;
+    if (c.floor_hz <= 0.0 || c.ceil_hz < c.floor_hz || c.failsafe_ms == 0 ||
+        c.rtt_factor < 1.0 || c.rtt_margin_ms < 0.0 || c.loss_hi < 0.0) {
+        return PWMH_EINVAL;
+    }
+
+    /* 保活下限：每个失联窗口内至少 3 帧，单帧丢失不会触发设备回中 */
+    const double keepalive_hz = 3000.0 / (double)c.failsafe_ms;
+    if (c.ceil_hz < keepalive_hz) return PWMH_EINVAL;
+
+    s_rate_cfg      = c;
+    s_rate_floor_hz = (c.floor_hz > keepalive_hz) ? c.floor_hz : keepalive_hz;
+    s_rate_enabled  = 1;
+    rate_reset();
+    return PWMH_OK;
+}
+
+PWMH_API void pwm_host_disable_rate_control(void)
+{
+    if (s_rate_pending && host_is_open()) (void)send_shadow();
+    s_rate_enabled = 0;
+    s_rate_pending = 0;
+}
+
+PWMH_API double pwm_host_rate_hz(void)
+{
+    return s_rate_enabled ? s_rate_hz : (double)s_send_hz;
+}
+
+PWMH_API pwmh_result_t pwm_host_set_schedule(int delay_ms)
+{
+    if (delay_ms < 0 || delay_ms > PWM_HOST_SCHED_MAX_DELAY_MS) return PWMH_EINVAL;
+    s_sched_delay_ms = delay_ms;
+    return PWMH_OK;
+}
+
+PWMH_API pwmh_result_t pwm_host_set_proto(int mode, int bits)
+{
+    if (mode < PWM_HOST_PROTO_AUTO || mode > PWM_HOST_PROTO_V2) return PWMH_EINVAL;
+    if (bits == 0) bits = 12;
+    if (bits != 12 && bits != 14) return PWMH_EINVAL;
+    s_proto_mode = mode;
+    s_proto_bits = bits;
+    return PWMH_OK;
+}
+
+PWMH_API int pwm_host_proto_active(void)
+{
+    return proto_use_v2() ? 2 : 1;
+}
+
+PWMH_API pwmh_result_t pwm_host_set_framing(int framing)
+{
+    if (framing != PWM_HOST_FRAMING_RAW && framing != PWM_HOST_FRAMING_COBS) return PWMH_EINVAL;
+    s_framing = framing;
+    return PWMH_OK;
+}
+
+PWMH_API pwmh_result_t pwm_host_clock_offset(int32_t* offset_ms, double* rtt_ms)
+{
+    const clk_sample_t* clk = clk_best();
+    if (!clk) return PWMH_ENOTINIT;
+    if (offset_ms) *offset_ms = clk->offset_ms;
+    if (rtt_ms)    *rtt_ms    = clk->rtt_ms;
+    return PWMH_OK;
+}
+
+PWMH_API void pwm_host_txmon_default_config(pwm_host_txmon_config_t* cfg)
+{
+    if (!cfg) return;
+    cfg->tolerance_ms    = 5.0;
+    cfg->burst_ratio     = 0.5;
+    cfg->bin_us          = 1000u;
+    cfg->window          = 50u;
+    cfg->alert_miss_rate = 0.1;
+    cfg->on_alert        = NULL;
+    cfg->user            = NULL;
+}
+
+PWMH_API pwmh_result_t pwm_host_txmon_configure(const pwm_host_txmon_config_t* cfg)
+{
+    pwm_host_txmon_config_t c;
+    pwm_host_txmon_default_config(&c);
+    if (cfg) c = *cfg;
+    if (c.tolerance_ms < 0.0 || c.burst_ratio < 0.0 || c.burst_ratio >= 1.0 ||
+        c.bin_us == 0 || c.alert_miss_rate < 0.0 || c.alert_miss_rate > 1.0) {
+        return PWMH_EINVAL;
+    }
+    const int rebin = (c.bin_us != s_txmon_cfg.bin_us);
+    s_txmon_cfg = c;
+    if (rebin) txmon_clear();
+    return PWMH_OK;
+}
+
+/* 直方图分位数：取累计达到 q 的桶上沿，落在溢出桶时取最大值 */
+static double txmon_quantile(const pwm_host_txmon_t* m, double q)
+{
+    if (m->frames == 0) return 0.0;
+    const double target = q * (double)m->frames;
+    uint64_t     acc    = 0;
+    for (int i = 0; i < PWM_HOST_TXMON_BINS - 1; ++i) {
+        acc += m->hist[i];
+        if ((double)acc >= target) {
+            const double edge = (double)(i + 1) * (double)m->bin_us / 1000.0;
+            return (edge < m->max_ms) ? edge : m->max_ms;
+        }
+    }
+    return m->max_ms;
+}
+
+PWMH_API void pwm_host_txmon_get(pwm_host_txmon_t* out)
+{
+    if (!out) return;
+    *out = s_txmon;
+    out->stddev_ms = (s_txmon.frames > 1) ? sqrt(s_txmon_m2 / (double)(s_txmon.frames - 1)) : 0.0;
+    out->p50_ms    = txmon_quantile(&s_txmon, 0.50);
+    out->p99_ms    = txmon_quantile(&s_txmon, 0.99);
+}
+
+PWMH_API void pwm_host_txmon_reset(void)
+{
+    txmon_clear();
 }
 
 PWMH_API double pwm_host_last_rtt_ms(void)
@@ -490,7 +2201,7 @@ PWMH_API void pwm_host_get_stats(pwm_host_stats_t* out)
 
 PWMH_API pwmh_result_t pwm_host_ramp_pct(int ch, float start_pct, float end_pct, float seconds, int hz)
 {
-    if (s_sock < 0) return PWMH_ENOTINIT;
+    if (!host_is_open()) return PWMH_ENOTINIT;
     if (ch < 1 || ch > PWM_HOST_CH_NUM) return PWMH_EINVAL;
     if (seconds <= 0.0f) return PWMH_EINVAL;
     if (hz <= 0) hz = (s_send_hz > 0) ? s_send_hz : 50;
@@ -500,11 +2211,9 @@ PWMH_API pwmh_result_t pwm_host_ramp_pct(int ch, float start_pct, float end_pct,
     if (steps < 1) steps = 1;
     const double period_ms = 1000.0 / (double)hz;
 
-    /* 基于影子生成初值 */
+    /* 其余通道保持调用方的目标值（恢复期间影子值是中位 / 渐变中的实际输出） */
     uint16_t base[PWM_HOST_CH_NUM];
-    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
-        base[i] = s_shadow[i];
-    }
+    memcpy(base, commanded(), sizeof(base));
 
     const uint16_t start_v = pwm_host_percent_to_u16(start_pct);
     const uint16_t end_v   = pwm_host_percent_to_u16(end_pct);
@@ -2,7 +2,6 @@
 #include <chrono>
 #include <csignal>
 #include <cstdint>
-#include <iomanip>
 #include <iostream>
 #include <thread>
 #include <unordered_map>
@@ -11,6 +10,7 @@
 
 #include "UdpSender.h"
 #include "protocol_pack.hpp" // 我们的上位机轻量打包封装
+#include "pwmh_log.h"        // 异步日志（需链接 libpwm_host）
 
 namespace
 {
@@ -121,6 +121,13 @@ int main(int argc, char **argv)
     Stats stats;
     protocol_pack_init(); // 重置 packer 的本地序列号（从 0 开始）
 
+    // 主循环内的输出走异步日志，终端卡顿不影响发送节拍
+    std::cout << std::flush;
+    pwmh_log_config_t log_cfg{};
+    pwmh_log_default_config(&log_cfg);
+    log_cfg.fd = 1;
+    (void)pwmh_log_start(&log_cfg);
+
     // ====== 4) 主循环：固定频率发送 PWM + 低频心跳；短超时接收 ======
     while (g_running.load())
     {
@@ -134,7 +141,7 @@ int main(int argc, char **argv)
             auto frame = ProtocolV1Packer::packPWM(pwm);
             if (frame.empty() || !udp.sendHexData(frame))
             {
-                std::cerr << "[WARN] send PWM failed\n";
+                PWMH_LOGW("send PWM failed");
             }
             else
             {
@@ -159,7 +166,7 @@ int main(int argc, char **argv)
 
             if (frame.empty() || !udp.sendHexData(frame))
             {
-                std::cerr << "[WARN] send HB failed\n";
+                PWMH_LOGW("send HB failed");
             }
             else
             {
@@ -184,13 +191,12 @@ int main(int argc, char **argv)
                         std::chrono::duration<double, std::milli>(Clock::now() - it->second).count();
                     stats.add_rtt(rtt_ms);
                     hb_send_times.erase(it);
-                    std::cout << "[HB_ACK] seq=" << seq_rx
-                              << " rtt=" << std::fixed << std::setprecision(2) << rtt_ms << " ms"
-                              << " ticks_remote=" << ticks_rx << "\n";
+                    PWMH_LOGI("[HB_ACK] seq=%u rtt=%.2f ms ticks_remote=%u",
+                              static_cast<unsigned>(seq_rx), rtt_ms, static_cast<unsigned>(ticks_rx));
                 }
                 else
                 {
-                    std::cout << "[HB_ACK] seq=" << seq_rx << " (no send record)\n";
+                    PWMH_LOGI("[HB_ACK] seq=%u (no send record)", static_cast<unsigned>(seq_rx));
                 }
             }
             else
@@ -208,13 +214,27 @@ int main(int argc, char **argv)
         if (t_now - t_last_report >= Ms(1000))
         {
             t_last_report = t_now;
-            std::cout << "[STAT] sent_pwm=" << stats.sent_pwm
-                      << " sent_hb=" << stats.sent_hb
-                      << " rx_hb_ack=" << stats.rx_hb_ack
-                      << " rtt_avg=" << std::fixed << std::setprecision(2) << stats.rtt_ms_avg << " ms\n";
+            const auto& q = udp.getQueueStats();
+            PWMH_LOGI("[STAT] sent_pwm=%llu sent_hb=%llu rx_hb_ack=%llu rtt_avg=%.2f ms"
+                      " rx_ovfl=%llu rxq=%u/%u txq=%u/%u",
+                      static_cast<unsigned long long>(stats.sent_pwm),
+                      static_cast<unsigned long long>(stats.sent_hb),
+                      static_cast<unsigned long long>(stats.rx_hb_ack), stats.rtt_ms_avg,
+                      static_cast<unsigned long long>(q.rx_overflow),
+                      q.rxq_bytes, q.rxq_peak, q.txq_bytes, q.txq_peak);
         }
     }
 
+    pwmh_log_stop();
+
+    // 按本次运行观测到的队列峰值给出缓冲建议（下次可经 setSocketBuffers 设置）
+    int rcvbuf = 0, sndbuf = 0;
+    udp.recommendSocketBuffers(rcvbuf, sndbuf);
+    if (rcvbuf > 0) {
+        std::cout << "[INFO] socket buffers: rcvbuf=" << udp.getQueueStats().rcvbuf
+                  << " sndbuf=" << udp.getQueueStats().sndbuf
+                  << " -> recommended setSocketBuffers(" << rcvbuf << ", " << sndbuf << ")\n";
+    }
     udp.close();
     std::cout << "[INFO] exit.\n";
     return 0;
@@ -1,5 +1,6 @@
 // protocol_pack.c (host/orangepi lightweight packer)
 #include "protocol_pack.h"
+#include "pwm_cobs.h"
 #include <string.h>
 #include <time.h>
 
@@ -8,6 +9,8 @@
 #define SOF_B1           0x55u
 #define HEADER_FIXED_LEN 12u   // SOF2 + VER1 + MSG1 + SEQ2 + TICKS4 + LEN2
 #define CRC_LEN          2u
+#define SOF_B1_V2        0x5Au
+#define HEADER_V2_LEN    6u    // SOF2 + TL1 + SEQ8 + TICK16
 
 /* 大端读写 */
 static inline void be16_write(uint8_t* p, uint16_t v){ p[0]=(uint8_t)(v>>8); p[1]=(uint8_t)(v&0xFF); }
@@ -74,6 +77,46 @@ bool protocol_pack_pwm(const uint16_t pwm8[8], uint8_t* out_buf, uint16_t out_ca
     return true;
 }
 
+bool protocol_pack_pwm_v2(const uint16_t pwm8[8], int bits,
+                          uint8_t* out_buf, uint16_t out_cap, uint16_t* out_len){
+    if(!pwm8 || !out_buf || !out_len || (bits != 12 && bits != 14)) return false;
+
+    const uint16_t len   = (uint16_t)bits; // 8 路 × bits 位 = bits 字节
+    const uint16_t total = (uint16_t)(HEADER_V2_LEN + len + CRC_LEN);
+    if(out_cap < total) return false;
+
+    uint8_t* p = out_buf;
+    *p++ = SOF_B0; *p++ = SOF_B1_V2;                        // SOF
+    *p++ = (uint8_t)(((bits == 14) ? 1u : 0u) << 5 | len);  // TL：TYPE PWM12=0 / PWM14=1
+    *p++ = (uint8_t)(s_seq++);                              // SEQ 低 8 位
+    be16_write(p, (uint16_t)host_ticks_ms()); p += 2;       // TICK 低 16 位
+
+    // PAYLOAD：MSB 优先位打包；12 位码值 = 值×2/5（0..4000），14 位即原值
+    uint32_t acc = 0; int nacc = 0;
+    for(int i=0;i<8;i++){
+        uint32_t v = pwm8[i];
+        if(v > 10000u) v = 10000u;
+        if(bits == 12) v = (v*2u + 2u) / 5u;
+        acc = (acc << bits) | v; nacc += bits;
+        while(nacc >= 8){ nacc -= 8; *p++ = (uint8_t)(acc >> nacc); }
+    }
+
+    const uint16_t crc = crc16_ccitt(out_buf + 2, (uint16_t)(HEADER_V2_LEN - 2u + len)); // TL..PAYLOAD
+    be16_write(p, crc); p += 2;
+
+    *out_len = (uint16_t)(p - out_buf);
+    return true;
+}
+
+bool protocol_pack_cobs(const uint8_t* frame, uint16_t n,
+                        uint8_t* out_buf, uint16_t out_cap, uint16_t* out_len){
+    if(!frame || !out_buf || !out_len) return false;
+    if(out_cap < PWM_COBS_WIRE_MAX(n)) return false;
+
+    *out_len = pwm_cobs_wrap(frame, n, out_buf);
+    return true;
+}
+
 bool protocol_pack_heartbeat(uint8_t* out_buf, uint16_t out_cap, uint16_t* out_len){
     if(!out_buf || !out_len) return false;
 
@@ -1,8 +1,7 @@
 #include "pwm_control.h"
+#include "pwmh_trace.h"
 #include <string.h>
 #include <math.h>
-#include <time.h>
-#include <errno.h>
 
 #ifndef UNUSED
 #define UNUSED(x) (void)(x)
@@ -20,21 +19,19 @@ static uint64_t          s_step_count  = 0;
 
 static int               s_group_toggle = 0;            /* AB 交替：0->A,1->B */
 
+/* 急停锁存 */
+static pwm_ctrl_estop_mode_t s_estop_mode  = PWM_CTRL_ESTOP_NONE;
+static float                 s_estop_step  = 0.0f;      /* SOFT：每步最大变化量 */
+static uint64_t              s_estop_steps = 0;         /* engage 后的 step 数 */
+
 /* ====================================================================== */
 /*                         内部工具函数                                  */
 /* ====================================================================== */
 
+/* 经由 libpwm_host 的可注入时钟睡眠（虚拟时钟下不真正等待） */
 static void sleep_ms(double ms)
 {
-    if (ms <= 0) return;
-    struct timespec req, rem;
-    req.tv_sec  = (time_t)(ms / 1000.0);
-    req.tv_nsec = (long)((ms - (double)req.tv_sec * 1000.0) * 1e6);
-    if (req.tv_nsec < 0) req.tv_nsec = 0;
-
-    while (nanosleep(&req, &rem) != 0 && errno == EINTR) {
-        req = rem;
-    }
+    pwm_host_sleep_ms(ms);
 }
 
 /* 推荐周期 ms（用于阻塞函数 sleep） */
@@ -92,6 +89,17 @@ static float clamp_pct(float pct)
     return pct;
 }
 
+/* 当前输出距中位的最大偏差（%） */
+static float max_dev_from_mid(void)
+{
+    float max_dev = 0.0f;
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+        float dev = fabsf(s_current_pct[i] - s_cfg.mid_pct);
+        if (dev > max_dev) max_dev = dev;
+    }
+    return max_dev;
+}
+
 /* 初始化内部状态：全部设为中位 */
 static void init_state_to_mid(void)
 {
@@ -103,6 +111,9 @@ static void init_state_to_mid(void)
     }
     s_step_count   = 0;
     s_group_toggle = 0;
+    s_estop_mode   = PWM_CTRL_ESTOP_NONE;
+    s_estop_step   = 0.0f;
+    s_estop_steps  = 0;
 }
 
 /* ====================================================================== */
@@ -196,11 +207,13 @@ int pwm_ctrl_set_target_pct(int ch, float pct)
 {
     if (!s_inited) return PWM_CTRL_ERR_NOT_INIT;
     if (ch < 1 || ch > PWM_HOST_CH_NUM) return PWM_CTRL_ERR_INVALID_ARG;
+    if (s_estop_mode != PWM_CTRL_ESTOP_NONE) return PWM_CTRL_ERR_ESTOP;
 
     if (pct < 0.0f) pct = s_cfg.mid_pct;   /* 负值视为中位 */
     pct = clamp_pct(pct);
 
     s_target_pct[ch - 1] = pct;
+    PWMH_TRACE2(target_set, ch, (int)(pct * 100.0f));
     return PWM_CTRL_OK;
 }
 
@@ -209,6 +222,7 @@ int pwm_ctrl_set_targets_mask(pwm_channel_mask_t mask,
 {
     if (!s_inited) return PWM_CTRL_ERR_NOT_INIT;
     if (!pct)      return PWM_CTRL_ERR_INVALID_ARG;
+    if (s_estop_mode != PWM_CTRL_ESTOP_NONE) return PWM_CTRL_ERR_ESTOP;
 
     for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
         int ch = i + 1;
@@ -218,6 +232,7 @@ int pwm_ctrl_set_targets_mask(pwm_channel_mask_t mask,
         if (p < 0.0f) p = s_cfg.mid_pct;
         s_target_pct[i] = clamp_pct(p);
     }
+    PWMH_TRACE2(target_set, 0, mask);
     return PWM_CTRL_OK;
 }
 
@@ -227,6 +242,7 @@ int pwm_ctrl_set_all_target_mid(void)
     for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
         s_target_pct[i] = s_cfg.mid_pct;
     }
+    PWMH_TRACE2(target_set, 0, PWM_CH_MASK_ALL);
     return PWM_CTRL_OK;
 }
 
@@ -239,15 +255,27 @@ int pwm_ctrl_step(void)
     if (!s_inited) return PWM_CTRL_ERR_NOT_INIT;
 
     pwm_channel_mask_t mask     = active_mask_for_this_step();
-    const float        max_step = max_step_pct_effective();
+    float              max_step = max_step_pct_effective();
     const float        mid      = s_cfg.mid_pct;
 
+    /* 软急停：全部通道同时归中，步长由 engage 时按归中时间算出 */
+    if (s_estop_mode == PWM_CTRL_ESTOP_SOFT) {
+        mask     = PWM_CH_MASK_ALL;
+        max_step = s_estop_step;
+    }
+
     float next_pct[PWM_HOST_CH_NUM];
 
     for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
         int   ch   = i + 1;
         float cur  = s_current_pct[i];
-        float tgt  = s_target_pct [i];
+        float tgt  = (s_estop_mode != PWM_CTRL_ESTOP_NONE) ? mid : s_target_pct[i];
+
+        /* 硬急停：每步直接重复中位帧 */
+        if (s_estop_mode == PWM_CTRL_ESTOP_HARD) {
+            next_pct[i] = mid;
+            continue;
+        }
 
         /* 默认：本次以逻辑目标值为目标 */
         float eff_target = tgt;
@@ -283,6 +311,8 @@ int pwm_ctrl_step(void)
         next_pct[i] = clamp_pct(np);
     }
 
+    PWMH_TRACE2(step_computed, s_step_count, mask);
+
     /* 下发完整 8 通道一帧 */
     pwmh_result_t rc = pwm_host_set_all_pct(next_pct);
     if (rc != PWMH_OK) {
@@ -294,6 +324,7 @@ int pwm_ctrl_step(void)
         s_current_pct[i] = next_pct[i];
     }
     ++s_step_count;
+    if (s_estop_mode != PWM_CTRL_ESTOP_NONE) ++s_estop_steps;
 
     return PWM_CTRL_OK;
 }
@@ -332,20 +363,13 @@ int pwm_ctrl_emergency_stop(float seconds)
 {
     if (!s_inited) return PWM_CTRL_ERR_NOT_INIT;
 
-    int rc = pwm_ctrl_set_all_target_mid();
-    if (rc < 0) return rc;
-
     float hz = (s_cfg.ctrl_hz > 0.0f) ? s_cfg.ctrl_hz : 50.0f;
     double period = ctrl_period_ms();
 
     /* 估算需要的步数：  
      * - 若 seconds > 0：按 seconds * hz  
      * - 若 seconds <= 0：按 “最大偏差 / 单步步长” 估算上界 */
-    float max_dev = 0.0f;
-    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
-        float dev = fabsf(s_current_pct[i] - s_cfg.mid_pct);
-        if (dev > max_dev) max_dev = dev;
-    }
+    float max_dev = max_dev_from_mid();
 
     float step = max_step_pct_effective();
     int steps_by_dev = (step > 0.0f) ? (int)(max_dev / step + 1.0f) : 1;
@@ -360,6 +384,10 @@ int pwm_ctrl_emergency_stop(float seconds)
         steps = steps_by_dev;
     }
 
+    /* 以软急停推进（HARD 已锁存时不会降级） */
+    int rc = pwm_ctrl_estop_engage(PWM_CTRL_ESTOP_SOFT, seconds);
+    if (rc < 0) return rc;
+
     for (int i = 0; i < steps; ++i) {
         int rc_step = pwm_ctrl_step();
         if (rc_step < 0) return rc_step;
@@ -368,6 +396,83 @@ int pwm_ctrl_emergency_stop(float seconds)
         if (period > 0.0) sleep_ms(period);
     }
 
+    /* 阻塞接口保持原语义：成功返回时急停已解除、目标为中位；
+     * 未能归中（如发送失败）时锁存保持，错误码交给调用方 */
+    return pwm_ctrl_estop_release();
+}
+
+/* ====================================================================== */
+/*                         非阻塞急停（锁存）                             */
+/* ====================================================================== */
+
+int pwm_ctrl_estop_engage(pwm_ctrl_estop_mode_t mode, float seconds)
+{
+    if (!s_inited) return PWM_CTRL_ERR_NOT_INIT;
+    if (mode != PWM_CTRL_ESTOP_SOFT && mode != PWM_CTRL_ESTOP_HARD) {
+        return PWM_CTRL_ERR_INVALID_ARG;
+    }
+
+    /* 已是硬急停：不降级 */
+    if (s_estop_mode == PWM_CTRL_ESTOP_HARD) return PWM_CTRL_OK;
+
+    if (s_estop_mode == PWM_CTRL_ESTOP_NONE) s_estop_steps = 0;
+    s_estop_mode = mode;
+    PWMH_TRACE2(estop_engage, (int)mode, (int)(seconds * 1000.0f));
+
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+        s_target_pct[i] = s_cfg.mid_pct;
+    }
+
+    if (mode == PWM_CTRL_ESTOP_SOFT) {
+        /* 步长：保证 seconds 内到位，且不慢于常规限斜率 */
+        float step = max_step_pct_effective();
+        if (seconds > 0.0f) {
+            float hz    = (s_cfg.ctrl_hz > 0.0f) ? s_cfg.ctrl_hz : 50.0f;
+            float steps = seconds * hz;
+            if (steps < 1.0f) steps = 1.0f;
+            float need = max_dev_from_mid() / steps;
+            if (need > step) step = need;
+        }
+        s_estop_step = step;
+        return PWM_CTRL_OK;
+    }
+
+    /* HARD：立即下发一帧全中位（单次 sendto，不阻塞调用方） */
+    float mid_arr[PWM_HOST_CH_NUM];
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) mid_arr[i] = s_cfg.mid_pct;
+
+    /* 速率控制可能暂缓本帧，急停须立即发出 */
+    pwmh_result_t rc = pwm_host_set_all_pct(mid_arr);
+    if (rc == PWMH_OK) rc = pwm_host_flush();
+    if (rc != PWMH_OK) {
+        return PWM_CTRL_ERR_INTERNAL;   /* 锁存保持，后续 step 继续重发 */
+    }
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) s_current_pct[i] = s_cfg.mid_pct;
     return PWM_CTRL_OK;
 }
 
+int pwm_ctrl_estop_release(void)
+{
+    if (!s_inited) return PWM_CTRL_ERR_NOT_INIT;
+    if (s_estop_mode == PWM_CTRL_ESTOP_NONE) return PWM_CTRL_OK;
+    if (max_dev_from_mid() > 1e-4f) return PWM_CTRL_ERR_ESTOP;
+
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+        s_target_pct[i] = s_cfg.mid_pct;
+    }
+    s_estop_mode = PWM_CTRL_ESTOP_NONE;
+    PWMH_TRACE2(estop_engage, (int)PWM_CTRL_ESTOP_NONE, 0);
+    return PWM_CTRL_OK;
+}
+
+int pwm_ctrl_estop_get_status(pwm_ctrl_estop_status_t* out)
+{
+    if (!out) return PWM_CTRL_ERR_INVALID_ARG;
+    if (!s_inited) return PWM_CTRL_ERR_NOT_INIT;
+
+    out->mode               = s_estop_mode;
+    out->max_dev_pct        = max_dev_from_mid();
+    out->complete           = (out->max_dev_pct <= 1e-4f) ? 1 : 0;
+    out->steps_since_engage = s_estop_steps;
+    return PWM_CTRL_OK;
+}
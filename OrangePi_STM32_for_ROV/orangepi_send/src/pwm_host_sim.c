@@ -0,0 +1,413 @@
+#include "pwm_host_sim.h"
+#include "pwm_cobs.h"
+
+#include <string.h>
+
+#ifndef UNUSED
+#define UNUSED(x) (void)(x)
+#endif
+
+/* ============================ 内部常量 ============================ */
+
+#define SIM_HDR_LEN    12   /* SOF(2)+VER+MSG+SEQ(2)+TICKS(4)+LEN(2) */
+#define SIM_CRC_LEN    2
+#define SIM_V2_HDR_LEN 6    /* SOF(2)+TL+SEQ8+TICK16(2) */
+#define SIM_V2_SOF_B1  0x5A
+#define SIM_ACK_PLEN   16   /* rx_unique / rx_dup / seq_gaps + phase_lag / status，与固件 CFG_HB_ACK_STATS_ENABLE 一致 */
+#define SIM_PWM_PERIOD_US 20000u /* 设备 PWM 周期（TIM1/TIM4） */
+#define SIM_ACK_LEN    (SIM_HDR_LEN + SIM_ACK_PLEN + SIM_CRC_LEN)
+#define SIM_SEQ_WINDOW 64   /* 与固件 CFG_SEQ_REORDER_WINDOW 一致 */
+#define SIM_ACK_QUEUE  16   /* 在途 HB_ACK 上限（超出则丢弃最旧） */
+#define RX_FRAME_MAX   64   /* 解码后单帧上限（主机最长帧 34 字节） */
+
+/* ============================ 内部状态 ============================ */
+
+typedef struct {
+    uint64_t due_ns;               /* 投递给主机的时刻 */
+    uint8_t  frame[SIM_ACK_LEN];
+} sim_ack_t;
+
+static pwm_host_sim_config_t s_cfg;
+static pwm_host_sim_state_t  s_st;
+static sim_ack_t             s_ackq[SIM_ACK_QUEUE];
+static unsigned              s_ack_head  = 0;
+static unsigned              s_ack_count = 0;
+static uint64_t              s_last_valid_ns = 0;  /* 0 = 尚未收到合法帧 */
+static uint64_t              s_tx_count      = 0;  /* 主机已发帧数（含被丢弃的） */
+static int                   s_seq_valid     = 0;  /* SEQ 去重基准已建立 */
+static uint64_t              s_rx_unique     = 0;  /* 去重后的新 PWM 帧（HB_ACK 上报，心跳不计） */
+static int                   s_hb_seq_valid  = 0;  /* 心跳独立 SEQ 空间：最近一个心跳 SEQ 有效 */
+static uint16_t              s_hb_seq_last   = 0;
+static int                   s_cobs          = 0;  /* 主机最近一帧使用 COBS 分帧 */
+static uint64_t              s_down_until_ns = 0;  /* 模拟中断结束时刻（0 = 无中断） */
+static uint64_t              s_boot_ns       = 0;  /* 设备 tick 零点（复位后为中断结束时刻） */
+
+/* ============================ 工具函数 ============================ */
+
+static uint16_t rd16(const uint8_t* p) { return (uint16_t)((p[0] << 8) | p[1]); }
+
+static void wr16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v & 0xFF);
+}
+
+static void wr32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)(v & 0xFF);
+}
+
+/* CRC16-CCITT(False)，与固件 / libpwm_host 一致 */
+static uint16_t crc16(const uint8_t* d, uint16_t n)
+{
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < n; ++i) {
+        crc ^= (uint16_t)((uint16_t)d[i] << 8);
+        for (int j = 0; j < 8; ++j) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void outputs_to_mid(void)
+{
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) s_st.duty[i] = PWM_HOST_VAL_MID;
+}
+
+/* 按当前虚拟时间评估失联保护（与固件 protocol_poll 等价） */
+static void eval_failsafe(uint64_t now_ns)
+{
+    if (s_last_valid_ns == 0 || s_st.failsafe_active) return;
+    if (now_ns - s_last_valid_ns > (uint64_t)s_cfg.failsafe_ms * 1000000ull) {
+        s_st.failsafe_active = 1;
+        ++s_st.failsafe_trips;
+        outputs_to_mid();
+        s_seq_valid    = 0;
+        s_hb_seq_valid = 0;
+    }
+}
+
+static void queue_hb_ack(uint16_t seq, uint64_t now_ns)
+{
+    if (s_ack_count == SIM_ACK_QUEUE) {
+        s_ack_head = (s_ack_head + 1u) % SIM_ACK_QUEUE;
+        --s_ack_count;
+    }
+    sim_ack_t* a = &s_ackq[(s_ack_head + s_ack_count) % SIM_ACK_QUEUE];
+    ++s_ack_count;
+
+    /* 设备在 now+latency 收到 HB，再经 latency 回到主机 */
+    a->due_ns = now_ns + 2ull * (uint64_t)s_cfg.latency_ms * 1000000ull;
+
+    uint8_t* p = a->frame;
+    p[0] = (uint8_t)(PWM_HOST_SOF_BE >> 8);
+    p[1] = (uint8_t)(PWM_HOST_SOF_BE & 0xFF);
+    p[2] = (uint8_t)PWM_HOST_PROTO_VER;
+    p[3] = (uint8_t)PWM_HOST_MSG_HB_ACK;
+    wr16(p + 4, seq);
+    wr32(p + 6, (uint32_t)(((now_ns - s_boot_ns) / 1000000ull) + s_cfg.latency_ms));
+    wr16(p + 10, SIM_ACK_PLEN);
+    wr32(p + 12, (uint32_t)s_rx_unique);
+    wr32(p + 16, (uint32_t)s_st.rx_dup);
+    wr32(p + 20, (uint32_t)s_st.seq_gaps);
+    wr16(p + 24, s_st.rx_pwm ? (uint16_t)s_st.phase_lag_us : 0xFFFFu);
+    wr16(p + 26, s_cfg.v1_only ? 0 : (uint16_t)PWM_HOST_DEV_STATUS_PROTO_V2);
+    wr16(p + 28, crc16(p + 2, SIM_HDR_LEN - 2 + SIM_ACK_PLEN));
+}
+
+/* SEQ 去重（与固件 seq_check 相同，只用于 PWM）：返回 1=新帧，0=同 SEQ 副本，-1=乱序旧帧 */
+static int seq_accept(uint16_t seq)
+{
+    if (s_seq_valid) {
+        const int16_t d = (int16_t)(uint16_t)(seq - s_st.last_seq);
+        if (d == 0) {
+            ++s_st.rx_dup;
+            return 0;
+        }
+        if (d < 0 && d > -SIM_SEQ_WINDOW) {
+            ++s_st.rx_stale;
+            return -1;
+        }
+        if (d > 0) s_st.seq_gaps += (uint64_t)(d - 1);
+    }
+    s_seq_valid   = 1;
+    s_st.last_seq = seq;
+    ++s_rx_unique;
+    return 1;
+}
+
+/* 心跳去重（与固件 hb_seq_is_dup 相同）：只丢同 SEQ 副本，不碰 PWM 的去重基准 */
+static int hb_seq_is_dup(uint16_t seq)
+{
+    if (s_hb_seq_valid && seq == s_hb_seq_last) return 1;
+    s_hb_seq_valid = 1;
+    s_hb_seq_last  = seq;
+    return 0;
+}
+
+/* 合法帧到达：记录间隔，解除失联保护 */
+static void on_valid_frame(uint64_t now)
+{
+    if (s_last_valid_ns != 0) {
+        const uint64_t gap_ms = (now - s_last_valid_ns) / 1000000ull;
+        if (gap_ms > s_st.max_gap_ms) s_st.max_gap_ms = (uint32_t)gap_ms;
+    }
+    s_last_valid_ns      = now;
+    s_st.failsafe_active = 0;
+    ++s_st.rx_frames;
+}
+
+/* 应用 8 路协议值 */
+static void apply_pwm(const uint16_t v[PWM_HOST_CH_NUM], uint64_t now)
+{
+    /* 比较寄存器预装载：新值等到下一个 PWM 周期边界才输出（虚拟时钟零点对齐周期） */
+    const uint32_t lag = SIM_PWM_PERIOD_US - (uint32_t)((now / 1000ull) % SIM_PWM_PERIOD_US);
+    s_st.phase_lag_us = s_st.rx_pwm ? s_st.phase_lag_us - s_st.phase_lag_us / 16u + lag / 16u : lag;
+    ++s_st.rx_pwm;
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+        s_st.duty[i] = (v[i] > PWM_HOST_VAL_MAX) ? (uint16_t)PWM_HOST_VAL_MAX : v[i];
+    }
+}
+
+/* 紧凑帧 v2：TL / SEQ8 / 位打包负载（与固件 try_parse_v2_frame 一致），DUE16 同样忽略 */
+static void sim_rx_v2(const uint8_t* buf, uint16_t len, uint64_t now)
+{
+    const unsigned type = buf[2] >> 5;
+    const unsigned plen = buf[2] & 0x1Fu;
+    const int      at   = (type == 2u || type == 3u);
+    const unsigned bits = (type == 1u || type == 3u) ? 14u : 12u;
+    if (type > 3u || len != SIM_V2_HDR_LEN + plen + SIM_CRC_LEN || plen != (at ? 2u : 0u) + bits ||
+        crc16(buf + 2, (uint16_t)(SIM_V2_HDR_LEN - 2 + plen)) != rd16(buf + SIM_V2_HDR_LEN + plen)) {
+        ++s_st.bad_frames;
+        return;
+    }
+    on_valid_frame(now);
+    ++s_st.rx_v2;
+
+    /* SEQ8 以最近的合法 SEQ 为基准就近展开 */
+    uint16_t seq = buf[3];
+    if (s_seq_valid) {
+        const int8_t d = (int8_t)(uint8_t)(buf[3] - (uint8_t)s_st.last_seq);
+        seq = (uint16_t)(s_st.last_seq + (uint16_t)d);
+    }
+    if (seq_accept(seq) <= 0) return;
+
+    const uint8_t* p    = buf + SIM_V2_HDR_LEN + (at ? 2 : 0);
+    const uint32_t full = (bits == 12u) ? 4000u : PWM_HOST_VAL_MAX;
+    uint16_t v[PWM_HOST_CH_NUM];
+    uint32_t acc  = 0;
+    unsigned nacc = 0;
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) {
+        while (nacc < bits) {
+            acc   = (acc << 8) | *p++;
+            nacc += 8u;
+        }
+        nacc -= bits;
+        uint32_t q = (acc >> nacc) & ((1u << bits) - 1u);
+        if (q > full) q = full;
+        /* 12 位码值 × 5/2 还原协议值（奇数码值落在半步，向下取整） */
+        v[i] = (uint16_t)((bits == 12u) ? q * 5u / 2u : q);
+    }
+    apply_pwm(v, now);
+}
+
+/* ============================ 注入传输回调 ============================ */
+
+/* 处理一帧原始帧（v1 / v2） */
+static void sim_rx_frame(const uint8_t* buf, uint16_t len, uint64_t now)
+{
+    if (!s_cfg.v1_only && len >= SIM_V2_HDR_LEN + SIM_CRC_LEN &&
+        buf[0] == (uint8_t)(PWM_HOST_SOF_BE >> 8) && buf[1] == SIM_V2_SOF_B1) {
+        sim_rx_v2(buf, len, now);
+        return;
+    }
+
+    /* 解析：SOF / VER / LEN / CRC */
+    if (len < SIM_HDR_LEN + SIM_CRC_LEN ||
+        buf[0] != (uint8_t)(PWM_HOST_SOF_BE >> 8) ||
+        buf[1] != (uint8_t)(PWM_HOST_SOF_BE & 0xFF) ||
+        buf[2] != (uint8_t)PWM_HOST_PROTO_VER) {
+        ++s_st.bad_frames;
+        return;
+    }
+    const uint16_t plen = rd16(buf + 10);
+    if ((uint32_t)SIM_HDR_LEN + plen + SIM_CRC_LEN != len ||
+        crc16(buf + 2, (uint16_t)(SIM_HDR_LEN - 2 + plen)) != rd16(buf + SIM_HDR_LEN + plen)) {
+        ++s_st.bad_frames;
+        return;
+    }
+
+    const uint8_t  msg = buf[3];
+    const uint16_t seq = rd16(buf + 4);
+
+    on_valid_frame(now);
+
+    /* 心跳独立 SEQ 空间：乱序照常应答，只有同 SEQ 副本不重复应答（与固件一致） */
+    if (msg == PWM_HOST_MSG_HB) {
+        if (hb_seq_is_dup(seq)) return;
+        ++s_st.rx_hb;
+        queue_hb_ack(seq, now);
+        return;
+    }
+
+    const int verdict = seq_accept(seq);
+    if (verdict == 0) return;
+
+    /* 乱序旧帧丢弃；PWM_AT 跳过 DUE 后到达即应用 */
+    const int is_pwm    = (msg == PWM_HOST_MSG_PWM    && plen == 2u * PWM_HOST_CH_NUM);
+    const int is_pwm_at = (msg == PWM_HOST_MSG_PWM_AT && plen == 4u + 2u * PWM_HOST_CH_NUM);
+    if ((is_pwm || is_pwm_at) && verdict > 0) {
+        const uint8_t* pl = buf + SIM_HDR_LEN + (is_pwm_at ? 4 : 0);
+        uint16_t v[PWM_HOST_CH_NUM];
+        for (int i = 0; i < PWM_HOST_CH_NUM; ++i) v[i] = rd16(pl + 2 * i);
+        apply_pwm(v, now);
+    }
+}
+
+static int sim_send(void* user, const uint8_t* buf, uint16_t len)
+{
+    UNUSED(user);
+    const uint64_t now = pwm_host_now_ns();
+    eval_failsafe(now);
+
+    ++s_tx_count;
+    if (now < s_down_until_ns) {
+        ++s_st.outage_drops;
+        return (int)len;
+    }
+    if (s_cfg.drop_every_n && (s_tx_count % s_cfg.drop_every_n) == 0) {
+        ++s_st.dropped;
+        return (int)len;  /* 对主机而言发送成功，只是链路上丢了 */
+    }
+
+    /* COBS 分帧（首字节为分隔符 0x00）：逐段解码，HB_ACK 以相同分帧回复 */
+    s_cobs = (len > 0 && buf[0] == 0);
+    if (!s_cobs) {
+        sim_rx_frame(buf, len, now);
+        return (int)len;
+    }
+    uint8_t  frame[RX_FRAME_MAX];
+    uint16_t start = 0;
+    for (uint16_t i = 0; i <= len; ++i) {
+        if (i < len && buf[i] != 0) continue;
+        const uint16_t n = (uint16_t)(i - start);
+        if (n > 0) {
+            const uint16_t m = (n <= sizeof(frame)) ? pwm_cobs_decode(buf + start, n, frame) : 0;
+            if (m == 0) ++s_st.bad_frames;
+            else        sim_rx_frame(frame, m, now);
+        }
+        start = (uint16_t)(i + 1u);
+    }
+    return (int)len;
+}
+
+static int sim_recv(void* user, uint8_t* buf, uint16_t cap, int timeout_ms)
+{
+    UNUSED(user);
+    uint64_t now = pwm_host_now_ns();
+
+    if (s_ack_count > 0) {
+        sim_ack_t* a = &s_ackq[s_ack_head];
+        /* 队首未到期：在超时范围内则把虚拟时间推进到到期时刻 */
+        if (a->due_ns > now && timeout_ms != 0) {
+            const uint64_t limit = (timeout_ms < 0) ? a->due_ns
+                                 : now + (uint64_t)(unsigned)timeout_ms * 1000000u;
+            if (a->due_ns <= limit) {
+                pwm_host_vclock_advance_ns(a->due_ns - now);
+                now = a->due_ns;
+            }
+        }
+        if (a->due_ns <= now) {
+            eval_failsafe(now);
+            if (cap < PWM_COBS_WIRE_MAX(SIM_ACK_LEN)) return -1;
+            const int n = s_cobs ? pwm_cobs_wrap(a->frame, SIM_ACK_LEN, buf) : SIM_ACK_LEN;
+            if (!s_cobs) memcpy(buf, a->frame, SIM_ACK_LEN);
+            s_ack_head = (s_ack_head + 1u) % SIM_ACK_QUEUE;
+            --s_ack_count;
+            ++s_st.tx_hb_ack;
+            return n;
+        }
+    }
+
+    /* 无可投递数据：虚拟时间走完整个超时 */
+    if (timeout_ms > 0) pwm_host_vclock_advance_ns((uint64_t)(unsigned)timeout_ms * 1000000u);
+    eval_failsafe(pwm_host_now_ns());
+    return 0;
+}
+
+/* ============================ 对外接口 ============================ */
+
+PWMH_API void pwm_host_sim_default_config(pwm_host_sim_config_t* cfg)
+{
+    if (!cfg) return;
+    cfg->latency_ms   = 2;
+    cfg->failsafe_ms  = 300;
+    cfg->drop_every_n = 0;
+    cfg->v1_only      = 0;
+    cfg->start_ns     = 0;
+}
+
+PWMH_API pwmh_result_t pwm_host_sim_open(const pwm_host_sim_config_t* cfg,
+                                         const pwm_host_config_t* host_cfg)
+{
+    pwm_host_sim_default_config(&s_cfg);
+    if (cfg) s_cfg = *cfg;
+    if (s_cfg.failsafe_ms == 0) s_cfg.failsafe_ms = 300;
+
+    memset(&s_st, 0, sizeof(s_st));
+    outputs_to_mid();
+    s_ack_head      = 0;
+    s_ack_count     = 0;
+    s_last_valid_ns = 0;
+    s_tx_count      = 0;
+    s_seq_valid     = 0;
+    s_rx_unique     = 0;
+    s_hb_seq_valid  = 0;
+    s_cobs          = 0;
+    s_down_until_ns = 0;
+    s_boot_ns       = 0;
+
+    pwm_host_use_virtual_clock(s_cfg.start_ns ? s_cfg.start_ns : 1000000000ull);
+
+    pwm_host_transport_t tp;
+    tp.send = sim_send;
+    tp.recv = sim_recv;
+    tp.user = NULL;
+    pwmh_result_t rc = pwm_host_init_transport(host_cfg, &tp);
+    if (rc != PWMH_OK) pwm_host_set_clock(NULL);
+    return rc;
+}
+
+PWMH_API void pwm_host_sim_close(void)
+{
+    pwm_host_close();
+    pwm_host_set_clock(NULL);
+}
+
+PWMH_API void pwm_host_sim_outage(uint32_t down_ms, int reset)
+{
+    const uint64_t now = pwm_host_now_ns();
+    s_down_until_ns = now + (uint64_t)down_ms * 1000000ull;
+    s_ack_head      = 0;
+    s_ack_count     = 0;
+    if (reset) {
+        /* 上电后尚未收到合法帧：不触发失联保护，输出保持中位 */
+        ++s_st.resets;
+        outputs_to_mid();
+        s_seq_valid     = 0;
+        s_hb_seq_valid  = 0;
+        s_last_valid_ns = 0;
+        s_boot_ns       = s_down_until_ns;
+    }
+}
+
+PWMH_API void pwm_host_sim_get_state(pwm_host_sim_state_t* out)
+{
+    if (!out) return;
+    eval_failsafe(pwm_host_now_ns());
+    *out = s_st;
+}
@@ -0,0 +1,388 @@
+#include "pwm_player.h"
+#include "pwm_control.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ============================ 内部常量 ============================ */
+
+#define PREFETCH_BYTES  (256u * 1024u)   /* 游标前方预读窗口（posix_madvise WILLNEED） */
+#define ABORT_GRACE_S   1.0              /* run 中止后等待归中的额外时间 */
+
+_Static_assert(sizeof(pwm_player_file_hdr_t) == 32, "file header layout");
+_Static_assert(sizeof(pwm_player_rec_t) == 48, "record layout");
+
+/* ============================ 数据结构 ============================ */
+
+struct pwm_player {
+    uint8_t*                map;
+    size_t                  map_len;
+    const pwm_player_rec_t* rec;
+    uint64_t                count;
+    pwm_player_kind_t       kind;
+    uint64_t                duration_ns;
+    pwm_player_config_t     cfg;
+
+    pwm_player_status_t     status;
+    uint64_t                t0_ns;
+    uint64_t                t_ns;
+    uint64_t                idx;
+    uint64_t                entered;         /* 已检查 ABORT 标志的记录上界（不含） */
+    uint64_t                prefetch_end;    /* 已预读到的字节偏移 */
+
+    int                     blending;
+    uint64_t                blend_t0_ns;
+    uint64_t                blend_ns;
+    float                   blend_from[PWM_HOST_CH_NUM];
+
+    uint64_t                ticks;
+    uint64_t                late_ticks;
+    uint64_t                saturated;
+    const char*             abort_reason;
+};
+
+/* ============================ 工具函数 ============================ */
+
+static void advise_ahead(pwm_player_t* p)
+{
+    const size_t hdr  = sizeof(pwm_player_file_hdr_t);
+    const size_t cur  = hdr + (size_t)p->idx * sizeof(pwm_player_rec_t);
+    if (cur + PREFETCH_BYTES / 2u < p->prefetch_end || p->prefetch_end >= p->map_len) return;
+
+    const size_t pg    = (size_t)sysconf(_SC_PAGESIZE);
+    size_t       start = (cur > p->prefetch_end ? cur : p->prefetch_end) & ~(pg - 1u);
+    size_t       end   = start + PREFETCH_BYTES;
+    if (end > p->map_len) end = p->map_len;
+    (void)posix_madvise(p->map + start, end - start, POSIX_MADV_WILLNEED);
+    p->prefetch_end = end;
+}
+
+static float lerpf(float a, float b, float alpha)
+{
+    return a + (b - a) * alpha;
+}
+
+/* 一条记录 → 8 路占空比（负值 / 未用通道已换算为中位） */
+static void rec_to_pct(pwm_player_t* p, const float v[PWM_HOST_CH_NUM], float out[PWM_HOST_CH_NUM])
+{
+    const pwm_player_config_t* c = &p->cfg;
+    if (p->kind == PWM_PLAYER_KIND_PCT8) {
+        for (int ch = 0; ch < PWM_HOST_CH_NUM; ++ch)
+            out[ch] = (v[ch] < 0.0f || isnan(v[ch])) ? c->mid_pct : v[ch];
+        return;
+    }
+
+    /* WRENCH6：u = alloc · w，饱和时整体等比缩放 */
+    float u[PWM_HOST_CH_NUM];
+    float umax = 0.0f;
+    for (int ch = 0; ch < PWM_HOST_CH_NUM; ++ch) {
+        float s = 0.0f;
+        for (int k = 0; k < 6; ++k) s += c->alloc[ch][k] * v[k];
+        u[ch] = s;
+        if (fabsf(s) > umax) umax = fabsf(s);
+    }
+    const float scale = (umax > 1.0f) ? 1.0f / umax : 1.0f;
+    if (umax > 1.0f) p->saturated++;
+    for (int ch = 0; ch < PWM_HOST_CH_NUM; ++ch) {
+        const float uu = u[ch] * scale;
+        out[ch] = (uu >= 0.0f) ? c->mid_pct + uu * (c->max_pct - c->mid_pct)
+                               : c->mid_pct + uu * (c->mid_pct - c->min_pct);
+    }
+}
+
+/* 当前输出（pwm_control 影子值），作为过渡起点 */
+static void begin_blend(pwm_player_t* p, uint64_t now, float seconds)
+{
+    if (seconds <= 0.0f) {
+        p->blending = 0;
+        return;
+    }
+    pwm_ctrl_state_t st;
+    pwm_ctrl_get_state(&st);
+    memcpy(p->blend_from, st.current_pct, sizeof(p->blend_from));
+    p->blend_t0_ns = now;
+    p->blend_ns    = (uint64_t)((double)seconds * 1e9);
+    p->blending    = 1;
+}
+
+/* ============================ 对外接口 ============================ */
+
+void pwm_player_default_config(pwm_player_config_t* cfg)
+{
+    if (!cfg) return;
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->ctrl_hz = 50.0;
+    cfg->mask    = 0xFFu;
+    cfg->abort_s = 1.0f;
+    cfg->min_pct = PWM_HOST_PCT_MIN;
+    cfg->mid_pct = PWM_HOST_PCT_MID;
+    cfg->max_pct = PWM_HOST_PCT_MAX;
+}
+
+pwmh_result_t pwm_player_open(const char* path, const pwm_player_config_t* cfg, pwm_player_t** out)
+{
+    if (!path || !out) return PWMH_EINVAL;
+    *out = NULL;
+
+    pwm_player_config_t c;
+    if (cfg) c = *cfg;
+    else     pwm_player_default_config(&c);
+    if (c.ctrl_hz <= 0.0) c.ctrl_hz = 50.0;
+    if (c.mask == 0) c.mask = 0xFFu;
+    if (c.abort_s <= 0.0f) c.abort_s = 1.0f;
+    if (!(c.min_pct > 0.0f && c.min_pct < c.mid_pct && c.mid_pct < c.max_pct)) {
+        c.min_pct = PWM_HOST_PCT_MIN;
+        c.mid_pct = PWM_HOST_PCT_MID;
+        c.max_pct = PWM_HOST_PCT_MAX;
+    }
+
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return PWMH_ESYS;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return PWMH_ESYS;
+    }
+    const size_t len = (size_t)st.st_size;
+    if (len < sizeof(pwm_player_file_hdr_t)) {
+        close(fd);
+        return PWMH_EINVAL;
+    }
+    void* m = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) return PWMH_ESYS;
+
+    /* 只校验文件头与长度：记录在回放时按需换入 */
+    const pwm_player_file_hdr_t* h = (const pwm_player_file_hdr_t*)m;
+    const size_t avail = (len - sizeof(*h)) / sizeof(pwm_player_rec_t);
+    int ok = h->magic == PWM_PLAYER_MAGIC && h->version == PWM_PLAYER_VERSION &&
+             h->rec_size == sizeof(pwm_player_rec_t) && h->count >= 1 && h->count <= avail &&
+             (h->kind == PWM_PLAYER_KIND_PCT8 || h->kind == PWM_PLAYER_KIND_WRENCH6);
+    if (ok && h->kind == PWM_PLAYER_KIND_WRENCH6) {
+        ok = 0;
+        for (int ch = 0; ch < PWM_HOST_CH_NUM; ++ch)
+            for (int k = 0; k < 6; ++k) ok |= (c.alloc[ch][k] != 0.0f);
+    }
+    pwm_player_t* p = ok ? (pwm_player_t*)calloc(1, sizeof(*p)) : NULL;
+    if (!p) {
+        munmap(m, len);
+        return ok ? PWMH_ESYS : PWMH_EINVAL;
+    }
+    (void)posix_madvise(m, len, POSIX_MADV_SEQUENTIAL);
+
+    p->map         = (uint8_t*)m;
+    p->map_len     = len;
+    p->rec         = (const pwm_player_rec_t*)(p->map + sizeof(*h));
+    p->count       = h->count;
+    p->kind        = (pwm_player_kind_t)h->kind;
+    p->duration_ns = h->duration_ns;
+    p->cfg         = c;
+    p->status      = PWM_PLAYER_IDLE;
+    *out = p;
+    return PWMH_OK;
+}
+
+void pwm_player_close(pwm_player_t* p)
+{
+    if (!p) return;
+    munmap(p->map, p->map_len);
+    free(p);
+}
+
+pwmh_result_t pwm_player_start(pwm_player_t* p, uint64_t t0_ns)
+{
+    if (!p) return PWMH_EINVAL;
+    pwm_ctrl_estop_status_t es;
+    pwm_ctrl_estop_get_status(&es);
+    if (es.mode != PWM_CTRL_ESTOP_NONE) return PWMH_EBUSY;
+
+    const uint64_t now = pwm_host_now_ns();
+    p->t0_ns        = t0_ns ? t0_ns : now;
+    p->t_ns         = 0;
+    p->idx          = 0;
+    p->entered      = 0;
+    p->prefetch_end = 0;
+    p->ticks        = 0;
+    p->late_ticks   = 0;
+    p->saturated    = 0;
+    p->abort_reason = NULL;
+    p->status       = PWM_PLAYER_RUNNING;
+    begin_blend(p, now, p->cfg.blend_in_s);
+    advise_ahead(p);
+    return PWMH_OK;
+}
+
+void pwm_player_abort(pwm_player_t* p, const char* reason)
+{
+    if (!p || p->status == PWM_PLAYER_ABORTED) return;
+    pwm_ctrl_estop_status_t es;
+    pwm_ctrl_estop_get_status(&es);
+    if (es.mode == PWM_CTRL_ESTOP_NONE)
+        (void)pwm_ctrl_estop_engage(p->cfg.abort_hard ? PWM_CTRL_ESTOP_HARD : PWM_CTRL_ESTOP_SOFT,
+                                    p->cfg.abort_s);
+    p->abort_reason = reason ? reason : "aborted";
+    p->status       = PWM_PLAYER_ABORTED;
+}
+
+pwm_player_status_t pwm_player_tick(pwm_player_t* p)
+{
+    if (!p) return PWM_PLAYER_ABORTED;
+    if (p->status != PWM_PLAYER_RUNNING) return p->status;
+
+    /* t0 可能早于时钟零点（跳转到靠后的标签），按模 2^64 相减后取有符号值 */
+    const uint64_t now = pwm_host_now_ns();
+    const int64_t  dt  = (int64_t)(now - p->t0_ns);
+    const uint64_t t   = (dt > 0) ? (uint64_t)dt : 0;
+    p->t_ns = t;
+    p->ticks++;
+
+    /* 顺序推进游标（只触及当前附近的页面） */
+    while (p->idx + 1 < p->count && p->rec[p->idx + 1].t_ns <= t) p->idx++;
+    for (; p->entered <= p->idx; ++p->entered) {
+        if (p->rec[p->entered].t_ns > t) break;
+        if (p->rec[p->entered].flags & PWM_PLAYER_REC_ABORT) {
+            pwm_player_abort(p, "abort record");
+            return p->status;
+        }
+    }
+    advise_ahead(p);
+
+    const pwm_player_rec_t* r = &p->rec[p->idx];
+    float pct[PWM_HOST_CH_NUM];
+    rec_to_pct(p, r->v, pct);
+    if ((r->flags & PWM_PLAYER_REC_LERP) && p->idx + 1 < p->count && t > r->t_ns) {
+        const pwm_player_rec_t* n = &p->rec[p->idx + 1];
+        if (n->t_ns > r->t_ns) {
+            float nx[PWM_HOST_CH_NUM];
+            rec_to_pct(p, n->v, nx);
+            const float a = (float)((double)(t - r->t_ns) / (double)(n->t_ns - r->t_ns));
+            for (int ch = 0; ch < PWM_HOST_CH_NUM; ++ch) pct[ch] = lerpf(pct[ch], nx[ch], a);
+        }
+    }
+
+    if (p->blending) {
+        const uint64_t bt = now - p->blend_t0_ns;
+        if (bt >= p->blend_ns) {
+            p->blending = 0;
+        } else {
+            const float a = (float)((double)bt / (double)p->blend_ns);
+            for (int ch = 0; ch < PWM_HOST_CH_NUM; ++ch) pct[ch] = lerpf(p->blend_from[ch], pct[ch], a);
+        }
+    }
+
+    if (pwm_ctrl_set_targets_mask(p->cfg.mask, pct) == PWM_CTRL_ERR_ESTOP) {
+        pwm_player_abort(p, "e-stop latched");
+        return p->status;
+    }
+    if (p->idx + 1 == p->count && t >= r->t_ns) p->status = PWM_PLAYER_DONE;
+    return p->status;
+}
+
+pwm_player_status_t pwm_player_run(pwm_player_t* p, int hb_ms, volatile int* stop)
+{
+    if (!p) return PWM_PLAYER_ABORTED;
+    if (p->status == PWM_PLAYER_IDLE && pwm_player_start(p, 0) != PWMH_OK) {
+        p->abort_reason = "e-stop latched";
+        p->status       = PWM_PLAYER_ABORTED;
+        return p->status;
+    }
+    if (hb_ms <= 0) hb_ms = 100;
+
+    const uint64_t period  = (uint64_t)(1e9 / p->cfg.ctrl_hz);
+    const uint64_t hb_ns   = (uint64_t)hb_ms * 1000000u;
+    uint64_t       next    = pwm_host_now_ns();
+    uint64_t       next_hb = next;
+    uint64_t       acks    = 0;
+    uint64_t       ack_ns  = next;
+    uint64_t       abort_deadline = 0;
+
+    for (;;) {
+        const uint64_t now = pwm_host_now_ns();
+        if (stop && *stop) pwm_player_abort(p, "stopped");
+
+        if (p->cfg.abort_on_ack_ms && p->status == PWM_PLAYER_RUNNING) {
+            pwm_host_stats_t hs;
+            pwm_host_get_stats(&hs);
+            if (hs.rx_hb_ack != acks) {
+                acks   = hs.rx_hb_ack;
+                ack_ns = now;
+            } else if (now - ack_ns > (uint64_t)p->cfg.abort_on_ack_ms * 1000000u) {
+                pwm_player_abort(p, "hb ack timeout");
+            }
+        }
+
+        const pwm_player_status_t s = pwm_player_tick(p);
+        (void)pwm_ctrl_step();
+        if (now >= next_hb) {
+            (void)pwm_host_send_heartbeat();
+            next_hb = now + hb_ns;
+        }
+        (void)pwm_host_poll(0);
+
+        if (s == PWM_PLAYER_DONE) break;
+        if (s == PWM_PLAYER_ABORTED) {
+            /* 继续 step 直到归中完成（SOFT），避免中止后输出停在半途 */
+            if (!abort_deadline) abort_deadline = now + (uint64_t)(((double)p->cfg.abort_s + ABORT_GRACE_S) * 1e9);
+            pwm_ctrl_estop_status_t es;
+            pwm_ctrl_estop_get_status(&es);
+            if (es.complete || now >= abort_deadline) break;
+        }
+
+        /* 绝对截止时间：超期则从当前时刻重新对齐，不补发追赶帧 */
+        next += period;
+        const uint64_t after = pwm_host_now_ns();
+        if (next > after) {
+            pwm_host_sleep_ms((double)(next - after) / 1e6);
+        } else {
+            if (after - next >= period) p->late_ticks++;
+            next = after;
+        }
+    }
+    return p->status;
+}
+
+pwmh_result_t pwm_player_seek_tag(pwm_player_t* p, uint16_t tag, float blend_s)
+{
+    if (!p || tag == 0) return PWMH_EINVAL;
+    if (p->status != PWM_PLAYER_RUNNING) return PWMH_ENOTINIT;
+
+    /* 向后查找，再从头查找（只在跳转时扫描，页面按需换入） */
+    uint64_t k = p->count;
+    for (uint64_t i = p->idx + 1; i < p->count; ++i)
+        if (p->rec[i].tag == tag) { k = i; break; }
+    if (k == p->count)
+        for (uint64_t i = 0; i <= p->idx; ++i)
+            if (p->rec[i].tag == tag) { k = i; break; }
+    if (k == p->count) return PWMH_EINVAL;
+
+    const uint64_t now = pwm_host_now_ns();
+    p->t0_ns        = now - p->rec[k].t_ns;
+    p->idx          = k;
+    p->entered      = k;
+    p->prefetch_end = 0;
+    begin_blend(p, now, blend_s);
+    advise_ahead(p);
+    return PWMH_OK;
+}
+
+void pwm_player_get_info(const pwm_player_t* p, pwm_player_info_t* out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!p) return;
+    out->kind         = p->kind;
+    out->count        = p->count;
+    out->duration_ns  = p->duration_ns;
+    out->status       = p->status;
+    out->t_ns         = p->t_ns;
+    out->index        = p->idx;
+    out->ticks        = p->ticks;
+    out->late_ticks   = p->late_ticks;
+    out->saturated    = p->saturated;
+    out->abort_reason = p->abort_reason;
+}
@@ -0,0 +1,239 @@
+#include "pwmd_shm.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+struct pwmd_client {
+    int          fd;          /* 控制连接（保持打开：断开即注销） */
+    int          slot;
+    pwmd_shm_t*  shm;
+    size_t       shm_len;
+    pwmd_ring_t* ring;
+    uint32_t     seq;
+    uint64_t     dropped;
+};
+
+/* ====================================================================== */
+/*                         内部工具函数                                  */
+/* ====================================================================== */
+
+static uint64_t mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* 发送一行请求并读取一行应答（控制通道，仅在注册 / 调整时使用） */
+static int request(int fd, const char* line, char* reply, size_t cap)
+{
+    const size_t n = strlen(line);
+    if (send(fd, line, n, MSG_NOSIGNAL) != (ssize_t)n) return -1;
+
+    size_t got = 0;
+    while (got + 1 < cap) {
+        const ssize_t r = recv(fd, reply + got, 1, 0);
+        if (r <= 0) {
+            if (r < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        if (reply[got] == '\n') break;
+        ++got;
+    }
+    reply[got] = '\0';
+    return 0;
+}
+
+static int map_shm(pwmd_client_t* c, const char* name)
+{
+    const int sfd = shm_open(name, O_RDWR, 0);
+    if (sfd < 0) return -1;
+    struct stat st;
+    if (fstat(sfd, &st) != 0 || (size_t)st.st_size < sizeof(pwmd_shm_t)) {
+        close(sfd);
+        return -1;
+    }
+    void* p = mmap(NULL, sizeof(pwmd_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, sfd, 0);
+    close(sfd);
+    if (p == MAP_FAILED) return -1;
+
+    pwmd_shm_t* shm = (pwmd_shm_t*)p;
+    if (shm->magic != PWMD_SHM_MAGIC || shm->version != PWMD_SHM_VERSION ||
+        shm->size != sizeof(pwmd_shm_t) || shm->max_clients != PWMD_MAX_CLIENTS) {
+        munmap(p, sizeof(pwmd_shm_t));
+        return -1;
+    }
+    c->shm     = shm;
+    c->shm_len = sizeof(pwmd_shm_t);
+    return 0;
+}
+
+static pwmh_result_t push(pwmd_client_t* c, pwmd_cmd_t* cmd)
+{
+    if (!c) return PWMH_EINVAL;
+    pwmd_ring_t*   r    = c->ring;
+    const uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    const uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (head - tail >= PWMD_RING_SIZE) {
+        c->dropped++;
+        return PWMH_EBUSY;
+    }
+    cmd->seq  = c->seq++;
+    cmd->t_ns = mono_ns();
+    r->cmd[head & (PWMD_RING_SIZE - 1u)] = *cmd;
+    atomic_store_explicit(&r->head, head + 1u, memory_order_release);
+    return PWMH_OK;
+}
+
+/* ====================================================================== */
+/*                         对外接口                                      */
+/* ====================================================================== */
+
+pwmh_result_t pwmd_connect(const char* sock_path, const char* name, int priority,
+                           pwmd_client_t** out)
+{
+    if (!out || priority < PWMD_PRIO_MIN || priority > PWMD_PRIO_MAX) return PWMH_EINVAL;
+    *out = NULL;
+    if (!sock_path) sock_path = PWMD_DEFAULT_SOCK;
+
+    struct sockaddr_un sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    if (strlen(sock_path) >= sizeof(sa.sun_path)) return PWMH_EINVAL;
+    strcpy(sa.sun_path, sock_path);
+
+    pwmd_client_t* c = (pwmd_client_t*)calloc(1, sizeof(*c));
+    if (!c) return PWMH_ESYS;
+    c->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (c->fd < 0) {
+        free(c);
+        return PWMH_ESYS;
+    }
+    const struct timeval tv = { 2, 0 };
+    setsockopt(c->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (connect(c->fd, (const struct sockaddr*)&sa, sizeof(sa)) != 0) {
+        close(c->fd);
+        free(c);
+        return PWMH_ESYS;
+    }
+
+    /* 名称去掉空白，保证一行一个字段 */
+    char nm[PWMD_NAME_MAX];
+    snprintf(nm, sizeof(nm), "%s", (name && *name) ? name : "client");
+    for (char* p = nm; *p; ++p)
+        if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') *p = '_';
+
+    char line[96], reply[128];
+    snprintf(line, sizeof(line), "HELLO %d %ld %s\n", priority, (long)getpid(), nm);
+    if (request(c->fd, line, reply, sizeof(reply)) != 0) {
+        close(c->fd);
+        free(c);
+        return PWMH_ESYS;
+    }
+
+    int  slot = -1;
+    char shm_name[64];
+    if (sscanf(reply, "OK %d %63s", &slot, shm_name) != 2 || slot < 0 || slot >= PWMD_MAX_CLIENTS) {
+        close(c->fd);
+        free(c);
+        return (strncmp(reply, "ERR full", 8) == 0) ? PWMH_EBUSY : PWMH_EINTERNAL;
+    }
+    if (map_shm(c, shm_name) != 0) {
+        close(c->fd);
+        free(c);
+        return PWMH_ESYS;
+    }
+    c->slot = slot;
+    c->ring = &c->shm->ring[slot];
+    *out = c;
+    return PWMH_OK;
+}
+
+void pwmd_disconnect(pwmd_client_t* c)
+{
+    if (!c) return;
+    if (c->shm) munmap(c->shm, c->shm_len);
+    if (c->fd >= 0) close(c->fd);
+    free(c);
+}
+
+int pwmd_slot(const pwmd_client_t* c)
+{
+    return c ? c->slot : -1;
+}
+
+pwmh_result_t pwmd_set_priority(pwmd_client_t* c, int priority)
+{
+    if (!c || priority < PWMD_PRIO_MIN || priority > PWMD_PRIO_MAX) return PWMH_EINVAL;
+    char line[32], reply[64];
+    snprintf(line, sizeof(line), "PRIO %d\n", priority);
+    if (request(c->fd, line, reply, sizeof(reply)) != 0) return PWMH_ESYS;
+    return (strncmp(reply, "OK", 2) == 0) ? PWMH_OK : PWMH_EINVAL;
+}
+
+pwmh_result_t pwmd_set_targets_pct(pwmd_client_t* c, uint8_t mask, const float pct[PWM_HOST_CH_NUM])
+{
+    if (!pct) return PWMH_EINVAL;
+    pwmd_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.kind = PWMD_CMD_TARGET;
+    cmd.mask = mask;
+    memcpy(cmd.pct, pct, sizeof(cmd.pct));
+    return push(c, &cmd);
+}
+
+pwmh_result_t pwmd_keepalive(pwmd_client_t* c)
+{
+    pwmd_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.kind = PWMD_CMD_KEEPALIVE;
+    return push(c, &cmd);
+}
+
+pwmh_result_t pwmd_estop(pwmd_client_t* c, int hard, float seconds)
+{
+    pwmd_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.kind       = PWMD_CMD_ESTOP;
+    cmd.estop_hard = hard ? 1u : 0u;
+    cmd.seconds    = seconds;
+    return push(c, &cmd);
+}
+
+pwmh_result_t pwmd_estop_release(pwmd_client_t* c)
+{
+    pwmd_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.kind = PWMD_CMD_RELEASE;
+    return push(c, &cmd);
+}
+
+pwmh_result_t pwmd_get_state(const pwmd_client_t* c, pwmd_state_t* out)
+{
+    if (!c || !out) return PWMH_EINVAL;
+    const pwmd_shm_t* shm = c->shm;
+    for (int tries = 0; tries < 1000; ++tries) {
+        const uint32_t s1 = atomic_load_explicit(&shm->state_seq, memory_order_acquire);
+        if (s1 & 1u) continue;
+        memcpy(out, (const void*)&shm->state, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        const uint32_t s2 = atomic_load_explicit(&shm->state_seq, memory_order_relaxed);
+        if (s1 == s2) return PWMH_OK;
+    }
+    return PWMH_EBUSY;
+}
+
+uint64_t pwmd_dropped(const pwmd_client_t* c)
+{
+    return c ? c->dropped : 0;
+}
@@ -0,0 +1,57 @@
+#ifndef PWMD_SHM_H
+#define PWMD_SHM_H
+
+/**
+ * @file    pwmd_shm.h
+ * @brief   pwm-daemon 共享内存布局（守护进程与 pwmd_client.c 私有，不对外安装）
+ *
+ *  - 每个客户端槽位一条 SPSC 环：客户端写 head，守护进程写 tail，两者分处不同缓存行；
+ *  - 状态快照用 seqlock：写者先把 state_seq 加到奇数、写数据、再加到偶数；
+ *    读者两次读到相同的偶数序号才算一致；
+ *  - 版本号随布局变化递增，客户端映射时校验 magic / version / 大小。
+ */
+
+#include "pwmd_client.h"
+
+#include <stdatomic.h>
+
+#define PWMD_SHM_MAGIC    0x444D5750u   /* "PWMD" */
+#define PWMD_SHM_VERSION  1u
+#define PWMD_RING_SIZE    64u           /* 2 的幂 */
+#define PWMD_CACHELINE    64
+
+typedef enum {
+    PWMD_CMD_TARGET    = 1,   /* mask + pct[8] */
+    PWMD_CMD_KEEPALIVE = 2,   /* 仅续租 */
+    PWMD_CMD_ESTOP     = 3,   /* estop_hard + seconds */
+    PWMD_CMD_RELEASE   = 4
+} pwmd_cmd_kind_t;
+
+typedef struct {
+    uint32_t kind;
+    uint32_t seq;                        /* 客户端本地递增，仅用于排查 */
+    uint64_t t_ns;                       /* 提交时刻（CLOCK_MONOTONIC） */
+    uint8_t  mask;
+    uint8_t  estop_hard;
+    uint16_t reserved;
+    float    seconds;
+    float    pct[PWM_HOST_CH_NUM];
+} pwmd_cmd_t;
+
+typedef struct {
+    _Alignas(PWMD_CACHELINE) _Atomic uint32_t head;   /* 客户端写 */
+    _Alignas(PWMD_CACHELINE) _Atomic uint32_t tail;   /* 守护进程写 */
+    _Alignas(PWMD_CACHELINE) pwmd_cmd_t cmd[PWMD_RING_SIZE];
+} pwmd_ring_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                                     /* sizeof(pwmd_shm_t) */
+    uint32_t max_clients;
+    _Alignas(PWMD_CACHELINE) _Atomic uint32_t state_seq;
+    pwmd_state_t state;
+    pwmd_ring_t  ring[PWMD_MAX_CLIENTS];
+} pwmd_shm_t;
+
+#endif /* PWMD_SHM_H */
@@ -0,0 +1,546 @@
+#include "pwmh_log.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ============================ 内部常量 ============================ */
+
+#define LOG_RING_MIN   16u
+#define LOG_RING_MAX   (1u << 20)
+#define LOG_LINE_MAX   512    /* 单条格式化结果上限（超出截断） */
+#define LOG_BATCH_MAX  8192   /* 后台线程一次 write 的批量大小 */
+
+static const char* const k_level_name[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+/* ============================ 记录与环 ============================ */
+
+typedef union {
+    int64_t  i;
+    uint64_t u;              /* 无符号整数 / 指针 / %s 在 str 中的偏移 */
+    double   f;
+} log_arg_t;
+
+/* 环槽（Vyukov 有界队列）：seq == pos 表示空闲可写，seq == pos+1 表示已写好可读 */
+typedef struct {
+    _Atomic size_t seq;
+    uint64_t       ts_ns;
+    const char*    fmt;      /* 格式 ID（字面量指针） */
+    uint8_t        level;
+    uint8_t        nargs;
+    uint8_t        truncated;
+    log_arg_t      args[PWMH_LOG_MAX_ARGS];
+    char           str[PWMH_LOG_STR_CAP];
+} log_cell_t;
+
+/* 一个转换说明（与 printf 子集对应），生产者取参与消费者格式化共用同一解析 */
+typedef struct {
+    const char* lit;         /* 本转换之前的字面文本 */
+    size_t      lit_len;
+    char        head[24];    /* '%' + flags / 宽度 / 精度（不含长度修饰与转换字符） */
+    char        lenmod[3];
+    char        conv;        /* 0 = 格式串结束；'%' = 字面百分号 */
+} log_spec_t;
+
+/* ============================ 内部状态 ============================ */
+
+static log_cell_t*      s_ring     = NULL;
+static size_t           s_ring_cap = 0;
+static _Atomic size_t   s_enq_pos;
+static size_t           s_deq_pos  = 0;      /* 仅后台线程访问 */
+
+static pwmh_log_config_t s_cfg;
+static _Atomic int      s_running  = 0;
+static _Atomic int      s_stop     = 0;
+static _Atomic int      s_min_level = PWMH_LOG_INFO;
+static pthread_t        s_thread;
+static uint64_t         s_t0_ns    = 0;
+
+static _Atomic uint64_t s_written;
+static _Atomic uint64_t s_dropped;
+static _Atomic uint64_t s_truncated;
+
+/* ============================ 格式串解析 ============================ */
+
+/* 从 *p 起解析下一个转换；返回 1=得到转换，0=格式串结束（lit 为剩余文本），-1=不支持 */
+static int next_spec(const char** p, log_spec_t* s)
+{
+    const char* q = *p;
+    s->lit = q;
+    while (*q && *q != '%') ++q;
+    s->lit_len   = (size_t)(q - s->lit);
+    s->conv      = 0;
+    s->lenmod[0] = '\0';
+    s->head[0]   = '\0';
+    if (!*q) {
+        *p = q;
+        return 0;
+    }
+
+    const char* start = q++;
+    if (*q == '%') {
+        s->conv = '%';
+        *p = q + 1;
+        return 1;
+    }
+    while (*q && strchr("-+ #0'", *q)) ++q;
+    if (*q == '*') return -1;
+    while (*q >= '0' && *q <= '9') ++q;
+    if (*q == '.') {
+        ++q;
+        if (*q == '*') return -1;
+        while (*q >= '0' && *q <= '9') ++q;
+    }
+    const size_t hl = (size_t)(q - start);
+    if (hl >= sizeof(s->head)) return -1;
+    memcpy(s->head, start, hl);
+    s->head[hl] = '\0';
+
+    if ((q[0] == 'h' && q[1] == 'h') || (q[0] == 'l' && q[1] == 'l')) {
+        s->lenmod[0] = q[0];
+        s->lenmod[1] = q[1];
+        s->lenmod[2] = '\0';
+        q += 2;
+    } else if (*q && strchr("hljztL", *q)) {
+        s->lenmod[0] = *q++;
+        s->lenmod[1] = '\0';
+    }
+
+    if (!*q || !strchr("diouxXcfFeEgGaAsp", *q)) return -1;
+    s->conv = *q;
+    *p = q + 1;
+    return 1;
+}
+
+static int conv_is_signed(char c) { return c == 'd' || c == 'i'; }
+static int conv_is_unsigned(char c) { return c == 'o' || c == 'u' || c == 'x' || c == 'X'; }
+static int conv_is_float(char c) { return c && strchr("fFeEgGaA", c) != NULL; }
+
+/* ============================ 生产者（热路径） ============================ */
+
+/* 按转换说明从 va_list 取参写入记录 */
+static void capture_args(log_cell_t* c, const char* fmt, va_list ap)
+{
+    const char* p        = fmt;
+    size_t      str_used = 0;
+    log_spec_t  s;
+    int         r;
+
+    c->nargs     = 0;
+    c->truncated = 0;
+    c->str[PWMH_LOG_STR_CAP - 1] = '\0';
+
+    while ((r = next_spec(&p, &s)) > 0) {
+        if (s.conv == '%') continue;
+        if (c->nargs == PWMH_LOG_MAX_ARGS) {
+            c->truncated = 1;
+            return;
+        }
+        log_arg_t* a = &c->args[c->nargs++];
+        const char l0 = s.lenmod[0];
+        const char l1 = s.lenmod[1];
+
+        if (conv_is_signed(s.conv)) {
+            if      (l0 == 'l' && l1 == 'l') a->i = (int64_t)va_arg(ap, long long);
+            else if (l0 == 'l')              a->i = (int64_t)va_arg(ap, long);
+            else if (l0 == 'j')              a->i = (int64_t)va_arg(ap, intmax_t);
+            else if (l0 == 'z')              a->i = (int64_t)va_arg(ap, ssize_t);
+            else if (l0 == 't')              a->i = (int64_t)va_arg(ap, ptrdiff_t);
+            else                             a->i = (int64_t)va_arg(ap, int);
+        } else if (conv_is_unsigned(s.conv)) {
+            if      (l0 == 'l' && l1 == 'l') a->u = (uint64_t)va_arg(ap, unsigned long long);
+            else if (l0 == 'l')              a->u = (uint64_t)va_arg(ap, unsigned long);
+            else if (l0 == 'j')              a->u = (uint64_t)va_arg(ap, uintmax_t);
+            else if (l0 == 'z')              a->u = (uint64_t)va_arg(ap, size_t);
+            else if (l0 == 't')              a->u = (uint64_t)va_arg(ap, ptrdiff_t);
+            else                             a->u = (uint64_t)va_arg(ap, unsigned);
+        } else if (conv_is_float(s.conv)) {
+            a->f = (l0 == 'L') ? (double)va_arg(ap, long double) : va_arg(ap, double);
+        } else if (s.conv == 'c') {
+            a->i = va_arg(ap, int);
+        } else if (s.conv == 'p') {
+            a->u = (uint64_t)(uintptr_t)va_arg(ap, void*);
+        } else { /* 's'：复制进记录，空间不足时截断 */
+            const char* str = va_arg(ap, const char*);
+            if (!str) str = "(null)";
+            const size_t avail = PWMH_LOG_STR_CAP - 1 - str_used;
+            size_t n = strlen(str);
+            if (n > avail) {
+                n = avail;
+                c->truncated = 1;
+            }
+            memcpy(c->str + str_used, str, n);
+            c->str[str_used + n] = '\0';
+            a->u = str_used;
+            str_used += (str_used + n < PWMH_LOG_STR_CAP - 1) ? n + 1 : n;
+        }
+    }
+    if (r < 0) c->truncated = 1;
+}
+
+PWMH_API void pwmh_log_emitv(pwmh_log_level_t level, const char* fmt, va_list ap)
+{
+    if (!fmt || (int)level < atomic_load_explicit(&s_min_level, memory_order_relaxed)) return;
+
+    /* 未启动：同步写 stderr */
+    if (!atomic_load_explicit(&s_running, memory_order_acquire)) {
+        fprintf(stderr, "[%s] ", k_level_name[(unsigned)level & 3u]);
+        vfprintf(stderr, fmt, ap);
+        fputc('\n', stderr);
+        return;
+    }
+
+    /* 抢占一个空闲槽；环满则丢弃 */
+    const size_t mask = s_ring_cap - 1;
+    size_t       pos  = atomic_load_explicit(&s_enq_pos, memory_order_relaxed);
+    log_cell_t*  c;
+    for (;;) {
+        c = &s_ring[pos & mask];
+        const size_t   seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        const intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&s_enq_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&s_enq_pos, memory_order_relaxed);
+        }
+    }
+
+    c->ts_ns = pwm_host_now_ns();
+    c->fmt   = fmt;
+    c->level = (uint8_t)level;
+    capture_args(c, fmt, ap);
+    atomic_store_explicit(&c->seq, pos + 1, memory_order_release);
+}
+
+PWMH_API void pwmh_log_emit(pwmh_log_level_t level, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    pwmh_log_emitv(level, fmt, ap);
+    va_end(ap);
+}
+
+/* ============================ 消费者（后台线程） ============================ */
+
+typedef struct {
+    char*  buf;
+    size_t cap;
+    size_t len;
+} log_out_t;
+
+static void out_putn(log_out_t* o, const char* s, size_t n)
+{
+    if (o->len + n >= o->cap) n = (o->cap > o->len + 1) ? o->cap - o->len - 1 : 0;
+    memcpy(o->buf + o->len, s, n);
+    o->len += n;
+    o->buf[o->len] = '\0';
+}
+
+static void out_puts(log_out_t* o, const char* s) { out_putn(o, s, strlen(s)); }
+
+/* JSON 字符串转义 */
+static void out_json_str(log_out_t* o, const char* s)
+{
+    out_putn(o, "\"", 1);
+    for (; *s; ++s) {
+        const unsigned char ch = (unsigned char)*s;
+        if (ch == '"' || ch == '\\') {
+            const char esc[2] = { '\\', (char)ch };
+            out_putn(o, esc, 2);
+        } else if (ch < 0x20) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", ch);
+            out_puts(o, esc);
+        } else {
+            out_putn(o, s, 1);
+        }
+    }
+    out_putn(o, "\"", 1);
+}
+
+/* 转换说明由格式串在运行时拼出，参数类型已按 next_spec 归一（整数统一走 ll） */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+static void format_arg(log_out_t* o, const log_cell_t* c, const log_spec_t* s, const log_arg_t* a)
+{
+    char spec[32];
+    char tmp[LOG_LINE_MAX];
+    tmp[0] = '\0';
+    if (conv_is_signed(s->conv)) {
+        snprintf(spec, sizeof(spec), "%sll%c", s->head, s->conv);
+        snprintf(tmp, sizeof(tmp), spec, (long long)a->i);
+    } else if (conv_is_unsigned(s->conv)) {
+        snprintf(spec, sizeof(spec), "%sll%c", s->head, s->conv);
+        snprintf(tmp, sizeof(tmp), spec, (unsigned long long)a->u);
+    } else if (conv_is_float(s->conv)) {
+        snprintf(spec, sizeof(spec), "%s%c", s->head, s->conv);
+        snprintf(tmp, sizeof(tmp), spec, a->f);
+    } else if (s->conv == 'c') {
+        snprintf(spec, sizeof(spec), "%sc", s->head);
+        snprintf(tmp, sizeof(tmp), spec, (int)a->i);
+    } else if (s->conv == 'p') {
+        snprintf(spec, sizeof(spec), "%sp", s->head);
+        snprintf(tmp, sizeof(tmp), spec, (void*)(uintptr_t)a->u);
+    } else {
+        snprintf(spec, sizeof(spec), "%ss", s->head);
+        snprintf(tmp, sizeof(tmp), spec, c->str + (a->u < PWMH_LOG_STR_CAP ? a->u : PWMH_LOG_STR_CAP - 1));
+    }
+    out_puts(o, tmp);
+}
+#pragma GCC diagnostic pop
+
+/* 展开一条记录的消息正文 */
+static void format_msg(log_out_t* o, const log_cell_t* c)
+{
+    const char* p = c->fmt;
+    unsigned    k = 0;
+    log_spec_t  s;
+    int         r;
+    while ((r = next_spec(&p, &s)) > 0) {
+        out_putn(o, s.lit, s.lit_len);
+        if (s.conv == '%') {
+            out_putn(o, "%", 1);
+        } else if (k < c->nargs) {
+            format_arg(o, c, &s, &c->args[k++]);
+        } else {
+            out_puts(o, "...");   /* 超出 PWMH_LOG_MAX_ARGS */
+            return;
+        }
+    }
+    /* 结束：剩余字面文本；不支持的转换：原样输出其后的格式串 */
+    out_puts(o, s.lit);
+}
+
+static void format_json_args(log_out_t* o, const log_cell_t* c)
+{
+    const char* p = c->fmt;
+    unsigned    k = 0;
+    log_spec_t  s;
+    out_putn(o, "[", 1);
+    while (k < c->nargs && next_spec(&p, &s) > 0) {
+        if (s.conv == '%') continue;
+        const log_arg_t* a = &c->args[k];
+        char tmp[64];
+        if (k++ > 0) out_putn(o, ",", 1);
+        if (conv_is_signed(s.conv) || s.conv == 'c') {
+            snprintf(tmp, sizeof(tmp), "%lld", (long long)a->i);
+            out_puts(o, tmp);
+        } else if (conv_is_unsigned(s.conv) || s.conv == 'p') {
+            snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long)a->u);
+            out_puts(o, tmp);
+        } else if (conv_is_float(s.conv)) {
+            if (a->f != a->f || a->f > 1e308 || a->f < -1e308) {
+                out_puts(o, "null");   /* JSON 无 NaN / Inf */
+            } else {
+                snprintf(tmp, sizeof(tmp), "%.9g", a->f);
+                out_puts(o, tmp);
+            }
+        } else {
+            out_json_str(o, c->str + (a->u < PWMH_LOG_STR_CAP ? a->u : PWMH_LOG_STR_CAP - 1));
+        }
+    }
+    out_putn(o, "]", 1);
+}
+
+/* 一条记录 → 一行文本（含换行） */
+static size_t format_line(const log_cell_t* c, char* line, size_t cap)
+{
+    char      msg[LOG_LINE_MAX];
+    log_out_t m = { msg, sizeof(msg), 0 };
+    msg[0] = '\0';
+    format_msg(&m, c);
+
+    const double t   = (c->ts_ns >= s_t0_ns) ? (double)(c->ts_ns - s_t0_ns) / 1e9 : 0.0;
+    const char*  lvl = k_level_name[c->level & 3u];
+    log_out_t    o   = { line, cap, 0 };
+    line[0] = '\0';
+
+    if (s_cfg.json) {
+        char head[64];
+        snprintf(head, sizeof(head), "{\"t\":%.6f,\"lvl\":\"%s\",\"fmt\":", t, lvl);
+        out_puts(&o, head);
+        out_json_str(&o, c->fmt);
+        out_puts(&o, ",\"msg\":");
+        out_json_str(&o, msg);
+        out_puts(&o, ",\"args\":");
+        format_json_args(&o, c);
+        out_puts(&o, c->truncated ? ",\"truncated\":true}\n" : "}\n");
+    } else {
+        char head[48];
+        snprintf(head, sizeof(head), "[%12.6f][%-5s] ", t, lvl);
+        out_puts(&o, head);
+        out_puts(&o, msg);
+        out_putn(&o, "\n", 1);
+    }
+    return o.len;
+}
+
+static void write_all(int fd, const char* buf, size_t n)
+{
+    while (n > 0) {
+        const ssize_t w = write(fd, buf, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return;   /* 输出端失效：丢弃本批，不影响控制环 */
+        }
+        buf += w;
+        n   -= (size_t)w;
+    }
+}
+
+/* 取出一条记录；环空返回 0 */
+static int dequeue(log_cell_t* out)
+{
+    log_cell_t* c = &s_ring[s_deq_pos & (s_ring_cap - 1)];
+    if (atomic_load_explicit(&c->seq, memory_order_acquire) != s_deq_pos + 1) return 0;
+
+    out->ts_ns     = c->ts_ns;
+    out->fmt       = c->fmt;
+    out->level     = c->level;
+    out->nargs     = c->nargs;
+    out->truncated = c->truncated;
+    memcpy(out->args, c->args, sizeof(out->args));
+    memcpy(out->str, c->str, sizeof(out->str));
+
+    atomic_store_explicit(&c->seq, s_deq_pos + s_ring_cap, memory_order_release);
+    ++s_deq_pos;
+    return 1;
+}
+
+static void* log_thread(void* arg)
+{
+    (void)arg;
+    static char batch[LOG_BATCH_MAX];
+    uint64_t    dropped_reported = 0;
+
+    /* 输出端是已关闭的管道时让 write 返回 EPIPE，而不是以 SIGPIPE 终止整个控制进程 */
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    for (;;) {
+        const int stopping = atomic_load_explicit(&s_stop, memory_order_acquire);
+        size_t    n        = 0;
+        int       got      = 0;
+        log_cell_t rec;
+        char       line[LOG_LINE_MAX + 128];
+
+        while (dequeue(&rec)) {
+            got = 1;
+            const size_t len = format_line(&rec, line, sizeof(line));
+            if (n + len > sizeof(batch)) {
+                write_all(s_cfg.fd, batch, n);
+                n = 0;
+            }
+            memcpy(batch + n, line, len);
+            n += len;
+            atomic_fetch_add_explicit(&s_written, 1, memory_order_relaxed);
+            if (rec.truncated) atomic_fetch_add_explicit(&s_truncated, 1, memory_order_relaxed);
+        }
+
+        /* 丢弃提示（由后台线程输出，热路径只计数） */
+        const uint64_t dropped = atomic_load_explicit(&s_dropped, memory_order_relaxed);
+        if (dropped != dropped_reported) {
+            const int len = snprintf(line, sizeof(line), "[log] dropped %llu records (ring full)\n",
+                                     (unsigned long long)(dropped - dropped_reported));
+            if (n + (size_t)len > sizeof(batch)) {
+                write_all(s_cfg.fd, batch, n);
+                n = 0;
+            }
+            memcpy(batch + n, line, (size_t)len);
+            n += (size_t)len;
+            dropped_reported = dropped;
+        }
+        if (n > 0) write_all(s_cfg.fd, batch, n);
+
+        if (stopping && !got) break;
+        if (!got) {
+            struct timespec ts;
+            ts.tv_sec  = s_cfg.flush_ms / 1000;
+            ts.tv_nsec = (long)(s_cfg.flush_ms % 1000) * 1000000L;
+            nanosleep(&ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+/* ============================ 对外接口 ============================ */
+
+PWMH_API void pwmh_log_default_config(pwmh_log_config_t* cfg)
+{
+    if (!cfg) return;
+    cfg->ring_records = 1024u;
+    cfg->fd           = 2;
+    cfg->min_level    = PWMH_LOG_INFO;
+    cfg->flush_ms     = 5;
+    cfg->json         = 0;
+}
+
+PWMH_API pwmh_result_t pwmh_log_start(const pwmh_log_config_t* cfg)
+{
+    if (atomic_load(&s_running)) return PWMH_EBUSY;
+
+    pwmh_log_config_t c;
+    pwmh_log_default_config(&c);
+    if (cfg) c = *cfg;
+    if (c.ring_records == 0) c.ring_records = 1024u;
+    if (c.flush_ms <= 0)     c.flush_ms = 5;
+    if (c.fd < 0 || c.ring_records > LOG_RING_MAX ||
+        c.min_level < PWMH_LOG_DEBUG || c.min_level > PWMH_LOG_ERROR) {
+        return PWMH_EINVAL;
+    }
+
+    size_t cap = LOG_RING_MIN;
+    while (cap < c.ring_records) cap <<= 1;
+    if (cap != s_ring_cap) {
+        free(s_ring);
+        s_ring     = (log_cell_t*)calloc(cap, sizeof(*s_ring));
+        s_ring_cap = s_ring ? cap : 0;
+        if (!s_ring) return PWMH_ESYS;
+    }
+    for (size_t i = 0; i < cap; ++i) atomic_init(&s_ring[i].seq, i);
+    atomic_store(&s_enq_pos, 0);
+    s_deq_pos = 0;
+
+    s_cfg   = c;
+    s_t0_ns = pwm_host_now_ns();
+    atomic_store(&s_min_level, c.min_level);
+    atomic_store(&s_written, 0);
+    atomic_store(&s_dropped, 0);
+    atomic_store(&s_truncated, 0);
+    atomic_store(&s_stop, 0);
+
+    if (pthread_create(&s_thread, NULL, log_thread, NULL) != 0) return PWMH_ESYS;
+    atomic_store_explicit(&s_running, 1, memory_order_release);
+    return PWMH_OK;
+}
+
+PWMH_API void pwmh_log_stop(void)
+{
+    if (!atomic_load(&s_running)) return;
+    atomic_store_explicit(&s_running, 0, memory_order_release);
+    atomic_store_explicit(&s_stop, 1, memory_order_release);
+    pthread_join(s_thread, NULL);
+}
+
+PWMH_API void pwmh_log_get_stats(pwmh_log_stats_t* out)
+{
+    if (!out) return;
+    out->written   = atomic_load(&s_written);
+    out->dropped   = atomic_load(&s_dropped);
+    out->truncated = atomic_load(&s_truncated);
+}
@@ -0,0 +1,156 @@
+#ifndef PWMH_SOCKQ_H
+#define PWMH_SOCKQ_H
+
+/**
+ * @file    pwmh_sockq.h
+ * @brief   内核 socket 队列遥测（libpwm_host 与 UdpSender 共用，仅内部使用）
+ *
+ *  - SO_RXQ_OVFL：接收缓冲满时内核丢弃的数据报累计数，由溢出之后收到的数据报以 cmsg 带回
+ *    （溢出后一直没有新数据报到达时暂不可见）；
+ *    缺失的 HB_ACK 是丢在线路上还是丢在本机接收缓冲，由它区分；
+ *  - 接收队列深度：SO_MEMINFO 的 rmem_alloc（内核记账字节，含 skb 开销，可与 SO_RCVBUF 直接比较）；
+ *    UDP 的 SIOCINQ 只返回队首一个数据报的长度，仅在无 SO_MEMINFO 时退化使用；
+ *  - 发送队列深度：SIOCOUTQ（UDP 下即 wmem_alloc，同样含 skb 开销，可与 SO_SNDBUF 比较）；
+ *  - IP_RECVERR：未 connect 的 UDP socket 默认收不到 ICMP 不可达，开启后由 recv / sendto 报错，
+ *    错误同时进入错误队列，须用 pwmh_sockq_drain_errors() 取走（否则 select 持续报告可读）。
+ *
+ * 队列深度是主机侧时延堆积最早的信号：持续非零说明收包 / 发包跟不上控制周期。
+ * 非 Linux 平台上各函数退化为空操作（深度 0，无溢出计数）。
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+
+#ifdef __linux__
+#include <asm/socket.h>      /* SO_RXQ_OVFL / SO_MEMINFO（_POSIX_C_SOURCE 下 <sys/socket.h> 不导出） */
+#include <linux/sockios.h>
+#include <linux/sock_diag.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** recvmsg 控制缓冲（容纳一条 SO_RXQ_OVFL cmsg） */
+typedef union {
+    char           buf[CMSG_SPACE(sizeof(uint32_t))];
+    struct cmsghdr align;
+} pwmh_sockq_cmsg_t;
+
+/** 开启 SO_RXQ_OVFL（失败忽略：旧内核上溢出计数恒为 0） */
+static inline void pwmh_sockq_enable(int sock)
+{
+#ifdef SO_RXQ_OVFL
+    int on = 1;
+    (void)setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+#else
+    (void)sock;
+#endif
+}
+
+/**
+ * @brief 从 recvmsg 结果取 SO_RXQ_OVFL 累计值，返回自上次以来新增的丢弃数
+ * @param last [入/出] 该 socket 上次读到的累计值（初值 0）
+ */
+static inline uint32_t pwmh_sockq_take_drops(const struct msghdr* msg, uint32_t* last)
+{
+#ifdef SO_RXQ_OVFL
+    for (struct cmsghdr* c = CMSG_FIRSTHDR((struct msghdr*)msg); c != NULL;
+         c = CMSG_NXTHDR((struct msghdr*)msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL) {
+            uint32_t total;
+            memcpy(&total, CMSG_DATA(c), sizeof(total));
+            const uint32_t delta = total - *last;   /* 计数器回绕时差值仍正确 */
+            *last = total;
+            return delta;
+        }
+    }
+#else
+    (void)msg; (void)last;
+#endif
+    return 0;
+}
+
+/** 开启 IP_RECVERR（ICMP 不可达经 recv / sendto 报告）；失败忽略 */
+static inline void pwmh_sockq_enable_recverr(int sock)
+{
+#ifdef IP_RECVERR
+    int on = 1;
+    (void)setsockopt(sock, IPPROTO_IP, IP_RECVERR, &on, sizeof(on));
+#else
+    (void)sock;
+#endif
+}
+
+/** errno 是否表示对端 / 路径不可达（ICMP 端口 / 主机不可达、本机无路由、网卡未就绪） */
+static inline int pwmh_sockq_is_unreach(int err)
+{
+    return err == ECONNREFUSED || err == EHOSTUNREACH || err == ENETUNREACH ||
+           err == EHOSTDOWN    || err == ENETDOWN;
+}
+
+/** 取尽错误队列（MSG_ERRQUEUE），返回取出的错误数 */
+static inline unsigned pwmh_sockq_drain_errors(int sock)
+{
+    unsigned n = 0;
+#ifdef MSG_ERRQUEUE
+    for (;;) {
+        uint8_t       data[64];
+        char          ctl[256];
+        struct iovec  iov = { data, sizeof(data) };
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = ctl;
+        msg.msg_controllen = sizeof(ctl);
+        if (recvmsg(sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+        ++n;
+    }
+#else
+    (void)sock;
+#endif
+    return n;
+}
+
+/** 接收队列占用字节（内核记账）；失败返回 0 */
+static inline uint32_t pwmh_sockq_rx_bytes(int sock)
+{
+#if defined(SO_MEMINFO) && defined(__linux__)
+    uint32_t mi[SK_MEMINFO_VARS];
+    socklen_t len = sizeof(mi);
+    if (getsockopt(sock, SOL_SOCKET, SO_MEMINFO, mi, &len) == 0 &&
+        len > SK_MEMINFO_RMEM_ALLOC * sizeof(uint32_t)) {
+        return mi[SK_MEMINFO_RMEM_ALLOC];
+    }
+#endif
+#ifdef SIOCINQ
+    int n = 0;
+    if (ioctl(sock, SIOCINQ, &n) == 0 && n > 0) return (uint32_t)n;
+#else
+    (void)sock;
+#endif
+    return 0;
+}
+
+/** 发送队列占用字节（SIOCOUTQ）；失败返回 0 */
+static inline uint32_t pwmh_sockq_tx_bytes(int sock)
+{
+#ifdef SIOCOUTQ
+    int n = 0;
+    if (ioctl(sock, SIOCOUTQ, &n) == 0 && n > 0) return (uint32_t)n;
+#else
+    (void)sock;
+#endif
+    return 0;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PWMH_SOCKQ_H */
@@ -0,0 +1,1205 @@
+/**
+ * @file    fleet_sim.c
+ * @brief   大规模虚拟 STM32 端点 + 多板主机控制扩展性基准
+ *
+ * 一个进程内承载数千个仿真端点，每个端点绑定一个回环端口（base_port + i），行为与固件 protocol_v1 一致：
+ *   - 解析 v1 帧（SOF / VER / LEN / CRC），按 SEQ 去重（窗口 64，与 CFG_SEQ_REORDER_WINDOW 一致）；
+ *   - PWM / PWM_AT 更新 8 路输出（PWM_AT 到达即应用），ESTOP 回中位；
+ *   - HB 回 HB_ACK（16 字节链路统计负载，与 CFG_HB_ACK_STATS_ENABLE 一致，不声明 v2，主机保持 v1）；
+ *   - 可选按 status_ms 周期发 STATUS（0x40，负载 8 × u16 当前输出），发往该端点最近的来包地址；
+ *   - 每端点独立的单向延迟与丢包：来包按 loss 丢弃，应答按 loss 独立丢弃，
+ *     HB_ACK 在收到 HB 后 2 × delay 发出（与 pwm_host_sim 相同），STATUS 延迟 1 × delay。
+ * 单线程：一个 epoll 循环（端点 socket + timerfd），recvmmsg 批量收、sendmmsg 批量发，
+ *   延迟应答放入最小堆，由 timerfd 按绝对时刻唤醒。
+ *
+ * 用法：
+ *   pwm_fleet_sim serve -n N [端点参数] [-T seconds] [-i stat_s]
+ *       只运行端点，供外部主机程序连接（第 i 块板 = IP:base_port+i）；-i 周期打印统计。
+ *   pwm_fleet_sim bench [-n LIST] [-r LIST] [-t seconds] [-b HB_MS] [-g] [-k] [-o out.csv] [端点参数]
+ *       对每个频率、按板数递增运行：每块板一个子进程，各自用 libpwm_host 连接一个端点
+ *       （libpwm_host 为单链路库，多板主机即每板一个实例），按绝对截止时间发 PWM、每 HB_MS 发心跳。
+ *       -n 板数列表（默认 1,2,4,...,1024），-r 频率列表（默认 50,100,200），-t 每轮时长（默认 3 秒），
+ *       -g 各板相位均匀错开（默认同一时刻发出，即最坏的同步突发），-k 不可维持后继续增加板数。
+ *
+ *   端点参数：
+ *     -a IP          绑定地址（默认 127.0.0.1）
+ *     -p PORT        起始端口（默认 20000）
+ *     -d MS[:MS]     单向延迟；给出区间时每端点按 seed 在区间内均匀取值（默认 0）
+ *     -l P[:P]       丢包概率（0..1），区间同上（默认 0）
+ *     -c FILE        逐端点覆盖，每行 "FIRST[-LAST] delay=MS loss=P"，'#' 起注释
+ *     -s STATUS_MS   STATUS 周期（默认 0 = 不发）
+ *     -S seed        随机种子（默认 1）
+ *
+ * 基准输出（stdout，每轮一行；-o 另存 CSV）：
+ *   host_cpu%/board   子进程 CPU（user+sys）÷ 板数 ÷ 时长，即每块板的主机 CPU 占用
+ *   sim_cpu%          仿真端点进程本身的 CPU（单核机器上与主机争用，判读时需扣除）
+ *   late p50/p99/max  截止时刻 → PWM sendto 返回（微秒），主机调度与发送路径的尾时延
+ *   rtt p50/p99       HB 发出 → HB_ACK 被 pwm_host_poll 处理（微秒，含端点延迟）
+ *   deliv%            端点收到的数据报 ÷ 主机发出的帧（丢包参数之前计数）
+ *   gap p99/max       端点侧相邻 PWM 帧到达间隔（毫秒）
+ *   ok                可维持判据：跳过的节拍 ≤ 1%、deliv% ≥ 99%、late p99 ≤ 半个周期
+ *   每个频率结束时打印 "[RESULT] HZ: sustained up to N boards"。
+ *
+ * 文件描述符：启动时把 RLIMIT_NOFILE 软限制提到硬限制；端点数受其约束。
+ */
+
+#define _GNU_SOURCE /* recvmmsg / sendmmsg */
+
+#include "libpwm_host.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ============================ 内部常量 ============================ */
+
+#define HDR_LEN       12     /* SOF(2)+VER+MSG+SEQ(2)+TICKS(4)+LEN(2) */
+#define CRC_LEN       2
+#define ACK_PLEN      16     /* rx_unique / rx_dup / seq_gaps + phase_lag / status */
+#define STATUS_PLEN   (2 * PWM_HOST_CH_NUM)
+#define FRAME_MAX     32     /* 端点发出的最长帧（HB_ACK / STATUS 均为 30 字节） */
+#define SEQ_WINDOW    64
+#define MSG_ESTOP     0x20
+#define MSG_STATUS    0x40
+
+#define RX_BATCH      64     /* 单次 recvmmsg 条数 */
+#define RX_BUF        256
+#define OUT_BATCH     64     /* 待发暂存（按 fd 分组 sendmmsg） */
+#define HEAP_MAX      (1u << 20)
+#define EV_BATCH      256
+#define TIMER_TAG     UINT32_MAX
+
+#define HIST_BINS     160    /* 对数直方图：每倍程 4 档，覆盖到 2^41 */
+#define LIST_MAX      32
+#define MAX_BOARDS    30000
+
+/* ============================ 数据结构 ============================ */
+
+/** 对数直方图（值单位由使用方决定：此处均为微秒） */
+typedef struct {
+    uint32_t n[HIST_BINS];
+    uint64_t count;
+    uint64_t max;
+} hist_t;
+
+typedef struct {
+    uint64_t rx_dgram;     /* 到达的数据报（丢包判定之前） */
+    uint64_t lost_up;      /* 按 loss 丢弃的来包 */
+    uint64_t rx_frames;
+    uint64_t rx_pwm;
+    uint64_t rx_hb;
+    uint64_t bad;
+    uint64_t unique;       /* 去重后的新 PWM 帧（HB_ACK 上报，心跳不计） */
+    uint64_t dup;
+    uint64_t stale;
+    uint64_t gaps;
+    uint64_t tx_ack;
+    uint64_t tx_status;
+    uint64_t lost_down;    /* 按 loss 丢弃的应答 */
+    uint64_t max_gap_us;
+} ep_stats_t;
+
+typedef struct {
+    int                fd;
+    uint16_t           port;
+    uint16_t           last_seq;
+    int                seq_valid;
+    uint16_t           last_hb_seq;  /* 心跳独立 SEQ 空间，只用于同 SEQ 副本不重复应答 */
+    int                hb_seq_valid;
+    int                have_peer;
+    uint64_t           delay_ns;
+    double             loss;
+    uint64_t           rng;
+    uint64_t           last_pwm_ns;
+    struct sockaddr_in peer;     /* 最近来包地址（应答 / STATUS 目的地） */
+    uint16_t           duty[PWM_HOST_CH_NUM];
+    ep_stats_t         st;
+} endpoint_t;
+
+typedef struct {
+    uint64_t           due_ns;
+    uint32_t           ep;
+    uint16_t           len;
+    struct sockaddr_in to;
+    uint8_t            frame[FRAME_MAX];
+} tx_item_t;
+
+/** 端点参数 */
+typedef struct {
+    const char* ip;
+    uint16_t    base_port;
+    double      delay_ms[2];
+    double      loss[2];
+    const char* cfg_path;
+    uint32_t    status_ms;
+    uint64_t    seed;
+} ep_config_t;
+
+/** 基准：每块板的结果（父子进程共享内存） */
+typedef struct {
+    int      rc;           /* 0 = 正常，1 = pwm_host_init 失败 */
+    uint64_t ticks;        /* 截止时刻数（含跳过的） */
+    uint64_t sent;
+    uint64_t skipped;      /* 超过一个周期未能发出而跳过的节拍 */
+    uint64_t hb_sent;
+    uint64_t cpu_ns;
+    hist_t   late;         /* 截止时刻 → sendto 返回（us） */
+    hist_t   rtt;          /* HB → HB_ACK（us） */
+} board_result_t;
+
+typedef struct {
+    volatile uint64_t t0_ns;      /* 0 = 尚未开始（子进程等待） */
+    board_result_t    board[];
+} bench_shared_t;
+
+/* ============================ 内部状态 ============================ */
+
+static volatile sig_atomic_t g_stop = 0;
+
+static uint16_t    s_crc_tab[256];
+static endpoint_t* s_ep    = NULL;
+static uint32_t    s_ep_n  = 0;
+static int         s_epfd  = -1;
+static int         s_tfd   = -1;
+static ep_config_t s_ecfg;
+
+static tx_item_t*  s_heap     = NULL;
+static uint32_t    s_heap_n   = 0;
+static uint32_t    s_heap_cap = 0;
+static uint64_t    s_qdrop    = 0;   /* 延迟队列满而丢弃的应答 */
+
+static tx_item_t   s_out[OUT_BATCH];
+static uint32_t    s_out_n = 0;
+
+static hist_t      s_gap_hist;       /* 端点侧 PWM 到达间隔（us） */
+static uint64_t    s_status_next_ns = 0;
+static uint32_t    s_status_cursor  = 0;
+
+/* ============================ 工具函数 ============================ */
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_stop = 1;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t t)
+{
+    struct timespec ts;
+    ts.tv_sec  = (time_t)(t / 1000000000ull);
+    ts.tv_nsec = (long)(t % 1000000000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+}
+
+static uint64_t cpu_ns(int who)
+{
+    struct rusage ru;
+    getrusage(who, &ru);
+    return ((uint64_t)ru.ru_utime.tv_sec + (uint64_t)ru.ru_stime.tv_sec) * 1000000000ull +
+           ((uint64_t)ru.ru_utime.tv_usec + (uint64_t)ru.ru_stime.tv_usec) * 1000ull;
+}
+
+/* splitmix64：由 seed 派生各端点的随机流 */
+static uint64_t splitmix64(uint64_t* x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* xorshift64*，返回 [0,1) */
+static double rnd01(uint64_t* s)
+{
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return (double)((*s * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static uint16_t rd16(const uint8_t* p) { return (uint16_t)((p[0] << 8) | p[1]); }
+
+static void wr16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v & 0xFF);
+}
+
+static void wr32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)(v & 0xFF);
+}
+
+/* CRC16-CCITT(False)，查表（与固件 / libpwm_host 逐位算法结果一致） */
+static void crc_init(void)
+{
+    for (unsigned i = 0; i < 256u; ++i) {
+        uint16_t c = (uint16_t)(i << 8);
+        for (int j = 0; j < 8; ++j) c = (c & 0x8000) ? (uint16_t)((c << 1) ^ 0x1021) : (uint16_t)(c << 1);
+        s_crc_tab[i] = c;
+    }
+}
+
+static uint16_t crc16(const uint8_t* d, uint16_t n)
+{
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < n; ++i) crc = (uint16_t)((crc << 8) ^ s_crc_tab[((crc >> 8) ^ d[i]) & 0xFFu]);
+    return crc;
+}
+
+/* ---------- 对数直方图 ---------- */
+
+static unsigned hist_bin(uint64_t v)
+{
+    if (v < 8u) return (unsigned)v;
+    const unsigned e = 63u - (unsigned)__builtin_clzll(v);
+    const unsigned b = 8u + (e - 3u) * 4u + (unsigned)((v >> (e - 2u)) & 3u);
+    return (b < HIST_BINS) ? b : HIST_BINS - 1u;
+}
+
+/* 桶上沿（含） */
+static uint64_t hist_upper(unsigned b)
+{
+    if (b < 8u) return b;
+    const unsigned e   = (b - 8u) / 4u + 3u;
+    const unsigned sub = (b - 8u) % 4u;
+    return ((uint64_t)(5u + sub) << (e - 2u)) - 1u;
+}
+
+static void hist_add(hist_t* h, uint64_t v)
+{
+    ++h->n[hist_bin(v)];
+    ++h->count;
+    if (v > h->max) h->max = v;
+}
+
+static void hist_merge(hist_t* dst, const hist_t* src)
+{
+    for (unsigned b = 0; b < HIST_BINS; ++b) dst->n[b] += src->n[b];
+    dst->count += src->count;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+/* 分位数（桶上沿估计，不超过最大值）；无样本返回 0 */
+static uint64_t hist_pct(const hist_t* h, double q)
+{
+    if (h->count == 0) return 0;
+    const uint64_t want = (uint64_t)(q * (double)h->count + 0.999999);
+    uint64_t acc = 0;
+    for (unsigned b = 0; b < HIST_BINS; ++b) {
+        acc += h->n[b];
+        if (acc >= want) return (hist_upper(b) < h->max) ? hist_upper(b) : h->max;
+    }
+    return h->max;
+}
+
+/* "a" 或 "a:b" */
+static int parse_range(const char* s, double out[2])
+{
+    char* end = NULL;
+    out[0] = strtod(s, &end);
+    if (end == s || out[0] < 0.0) return -1;
+    out[1] = out[0];
+    if (*end == ':') {
+        const char* b = end + 1;
+        out[1] = strtod(b, &end);
+        if (end == b || out[1] < out[0]) return -1;
+    }
+    return (*end == '\0') ? 0 : -1;
+}
+
+/* 逗号分隔的正整数列表；返回个数，失败返回 -1 */
+static int parse_list(const char* s, uint32_t* out, int cap)
+{
+    int n = 0;
+    while (*s) {
+        char* end = NULL;
+        const unsigned long v = strtoul(s, &end, 10);
+        if (end == s || v == 0 || n == cap) return -1;
+        out[n++] = (uint32_t)v;
+        if (*end == ',') ++end;
+        else if (*end != '\0') return -1;
+        s = end;
+    }
+    return n;
+}
+
+/* ============================ 端点：配置与绑定 ============================ */
+
+static void ep_config_default(ep_config_t* c)
+{
+    memset(c, 0, sizeof(*c));
+    c->ip        = "127.0.0.1";
+    c->base_port = 20000;
+    c->seed      = 1;
+}
+
+/* 逐端点覆盖文件："FIRST[-LAST] delay=MS loss=P" */
+static int load_ep_file(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "[ERR] open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    char line[256];
+    int  ln = 0;
+    while (fgets(line, sizeof(line), f)) {
+        ++ln;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char* save = NULL;
+        char* tok  = strtok_r(line, " \t\r\n", &save);
+        if (!tok) continue;
+
+        unsigned long first = 0, last = 0;
+        char* end = NULL;
+        first = strtoul(tok, &end, 10);
+        last  = first;
+        if (*end == '-') last = strtoul(end + 1, &end, 10);
+        if (*end != '\0' || last < first) {
+            fprintf(stderr, "[ERR] %s:%d: bad range\n", path, ln);
+            fclose(f);
+            return -1;
+        }
+        double delay = -1.0, loss = -1.0;
+        while ((tok = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+            if      (strncmp(tok, "delay=", 6) == 0) delay = atof(tok + 6);
+            else if (strncmp(tok, "loss=", 5) == 0)  loss  = atof(tok + 5);
+            else {
+                fprintf(stderr, "[ERR] %s:%d: bad parameter: %s\n", path, ln, tok);
+                fclose(f);
+                return -1;
+            }
+        }
+        for (unsigned long i = first; i <= last && i < s_ep_n; ++i) {
+            if (delay >= 0.0) s_ep[i].delay_ns = (uint64_t)(delay * 1e6);
+            if (loss >= 0.0)  s_ep[i].loss     = loss;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static void raise_nofile(void)
+{
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        (void)setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+/* 创建 n 个端点并加入 epoll；返回 0 成功 */
+static int endpoints_open(uint32_t n)
+{
+    struct in_addr addr;
+    if (inet_pton(AF_INET, s_ecfg.ip, &addr) != 1) {
+        fprintf(stderr, "[ERR] bad address: %s\n", s_ecfg.ip);
+        return -1;
+    }
+    if ((uint32_t)s_ecfg.base_port + n > 65536u) {
+        fprintf(stderr, "[ERR] port range %u+%u exceeds 65535\n", (unsigned)s_ecfg.base_port, n);
+        return -1;
+    }
+    s_ep = calloc(n, sizeof(*s_ep));
+    if (!s_ep) return -1;
+    s_ep_n = n;
+
+    s_epfd = epoll_create1(EPOLL_CLOEXEC);
+    s_tfd  = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (s_epfd < 0 || s_tfd < 0) {
+        perror("epoll/timerfd");
+        return -1;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN;
+    ev.data.u32 = TIMER_TAG;
+    epoll_ctl(s_epfd, EPOLL_CTL_ADD, s_tfd, &ev);
+
+    uint64_t sm = s_ecfg.seed;
+    for (uint32_t i = 0; i < n; ++i) {
+        endpoint_t* e = &s_ep[i];
+        e->port = (uint16_t)(s_ecfg.base_port + i);
+        e->rng  = splitmix64(&sm);
+        if (e->rng == 0) e->rng = 1;
+        const double d = s_ecfg.delay_ms[0] + (s_ecfg.delay_ms[1] - s_ecfg.delay_ms[0]) * rnd01(&e->rng);
+        e->delay_ns    = (uint64_t)(d * 1e6);
+        e->loss        = s_ecfg.loss[0] + (s_ecfg.loss[1] - s_ecfg.loss[0]) * rnd01(&e->rng);
+        for (int c = 0; c < PWM_HOST_CH_NUM; ++c) e->duty[c] = PWM_HOST_VAL_MID;
+
+        e->fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (e->fd < 0) {
+            fprintf(stderr, "[ERR] socket #%u: %s (raise ulimit -n)\n", i, strerror(errno));
+            return -1;
+        }
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_addr   = addr;
+        sa.sin_port   = htons(e->port);
+        if (bind(e->fd, (const struct sockaddr*)&sa, sizeof(sa)) < 0) {
+            fprintf(stderr, "[ERR] bind %s:%u: %s\n", s_ecfg.ip, (unsigned)e->port, strerror(errno));
+            return -1;
+        }
+        ev.data.u32 = i;
+        if (epoll_ctl(s_epfd, EPOLL_CTL_ADD, e->fd, &ev) < 0) {
+            perror("epoll_ctl");
+            return -1;
+        }
+    }
+    return s_ecfg.cfg_path ? load_ep_file(s_ecfg.cfg_path) : 0;
+}
+
+/* 清空端点状态与统计（基准每轮之前） */
+static void endpoints_reset(void)
+{
+    for (uint32_t i = 0; i < s_ep_n; ++i) {
+        endpoint_t* e = &s_ep[i];
+        e->seq_valid    = 0;
+        e->hb_seq_valid = 0;
+        e->have_peer    = 0;
+        e->last_pwm_ns  = 0;
+        memset(&e->st, 0, sizeof(e->st));
+        for (int c = 0; c < PWM_HOST_CH_NUM; ++c) e->duty[c] = PWM_HOST_VAL_MID;
+    }
+    memset(&s_gap_hist, 0, sizeof(s_gap_hist));
+    s_heap_n = 0;
+    s_out_n  = 0;
+    s_qdrop  = 0;
+}
+
+/* ============================ 端点：发送路径 ============================ */
+
+/* 暂存区按 fd 分组，每组一次 sendmmsg */
+static void out_flush(void)
+{
+    struct mmsghdr msgs[OUT_BATCH];
+    struct iovec   iov[OUT_BATCH];
+    uint32_t i = 0;
+    while (i < s_out_n) {
+        const int fd = s_ep[s_out[i].ep].fd;
+        unsigned  k  = 0;
+        while (i + k < s_out_n && s_ep[s_out[i + k].ep].fd == fd) {
+            tx_item_t* t = &s_out[i + k];
+            iov[k].iov_base = t->frame;
+            iov[k].iov_len  = t->len;
+            memset(&msgs[k], 0, sizeof(msgs[k]));
+            msgs[k].msg_hdr.msg_name    = &t->to;
+            msgs[k].msg_hdr.msg_namelen = sizeof(t->to);
+            msgs[k].msg_hdr.msg_iov     = &iov[k];
+            msgs[k].msg_hdr.msg_iovlen  = 1;
+            ++k;
+        }
+        /* 发送失败（对端已退出 / 缓冲满）直接丢弃：与设备侧 UDP 行为一致 */
+        unsigned done = 0;
+        while (done < k) {
+            const int r = sendmmsg(fd, msgs + done, k - done, MSG_DONTWAIT);
+            if (r <= 0) break;
+            done += (unsigned)r;
+        }
+        i += k;
+    }
+    s_out_n = 0;
+}
+
+static void heap_push(const tx_item_t* t)
+{
+    if (s_heap_n == s_heap_cap) {
+        if (s_heap_cap == HEAP_MAX) {
+            ++s_qdrop;
+            return;
+        }
+        const uint32_t cap = s_heap_cap ? s_heap_cap * 2u : 1024u;
+        tx_item_t* h = realloc(s_heap, (size_t)cap * sizeof(*h));
+        if (!h) {
+            ++s_qdrop;
+            return;
+        }
+        s_heap     = h;
+        s_heap_cap = cap;
+    }
+    uint32_t i = s_heap_n++;
+    while (i > 0) {
+        const uint32_t p = (i - 1u) / 2u;
+        if (s_heap[p].due_ns <= t->due_ns) break;
+        s_heap[i] = s_heap[p];
+        i = p;
+    }
+    s_heap[i] = *t;
+}
+
+static void heap_pop(tx_item_t* out)
+{
+    *out = s_heap[0];
+    const tx_item_t last = s_heap[--s_heap_n];
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t c = 2u * i + 1u;
+        if (c >= s_heap_n) break;
+        if (c + 1u < s_heap_n && s_heap[c + 1u].due_ns < s_heap[c].due_ns) ++c;
+        if (last.due_ns <= s_heap[c].due_ns) break;
+        s_heap[i] = s_heap[c];
+        i = c;
+    }
+    if (s_heap_n > 0) s_heap[i] = last;
+}
+
+/* 端点发出一帧：按 loss 丢弃，未到期入堆，否则进暂存区 */
+static void ep_tx(uint32_t idx, const uint8_t* frame, uint16_t len, uint64_t due, uint64_t now)
+{
+    endpoint_t* e = &s_ep[idx];
+    if (e->loss > 0.0 && rnd01(&e->rng) < e->loss) {
+        ++e->st.lost_down;
+        return;
+    }
+    tx_item_t* t;
+    tx_item_t  tmp;
+    if (due > now) {
+        t = &tmp;
+    } else {
+        if (s_out_n == OUT_BATCH) out_flush();
+        t = &s_out[s_out_n++];
+    }
+    t->due_ns = due;
+    t->ep     = idx;
+    t->len    = len;
+    t->to     = e->peer;
+    memcpy(t->frame, frame, len);
+    if (t == &tmp) heap_push(t);
+}
+
+/* 到期的延迟应答 */
+static void flush_due(uint64_t now)
+{
+    while (s_heap_n > 0 && s_heap[0].due_ns <= now) {
+        if (s_out_n == OUT_BATCH) out_flush();
+        heap_pop(&s_out[s_out_n++]);
+    }
+    out_flush();
+}
+
+static uint16_t build_hdr(uint8_t* p, uint8_t msg, uint16_t seq, uint32_t ticks, uint16_t plen)
+{
+    p[0] = (uint8_t)(PWM_HOST_SOF_BE >> 8);
+    p[1] = (uint8_t)(PWM_HOST_SOF_BE & 0xFF);
+    p[2] = (uint8_t)PWM_HOST_PROTO_VER;
+    p[3] = msg;
+    wr16(p + 4, seq);
+    wr32(p + 6, ticks);
+    wr16(p + 10, plen);
+    return (uint16_t)(HDR_LEN + plen + CRC_LEN);
+}
+
+static void ep_send_hb_ack(uint32_t idx, uint16_t seq, uint64_t now)
+{
+    const endpoint_t* e = &s_ep[idx];
+    uint8_t f[FRAME_MAX];
+    const uint16_t n = build_hdr(f, (uint8_t)PWM_HOST_MSG_HB_ACK, seq,
+                                 (uint32_t)((now + e->delay_ns) / 1000000ull), ACK_PLEN);
+    wr32(f + 12, (uint32_t)e->st.unique);
+    wr32(f + 16, (uint32_t)e->st.dup);
+    wr32(f + 20, (uint32_t)e->st.gaps);
+    wr16(f + 24, 0xFFFFu);   /* 不模拟 PWM 相位 */
+    wr16(f + 26, 0);         /* 不声明 PROTO_V2 */
+    wr16(f + 28, crc16(f + 2, HDR_LEN - 2 + ACK_PLEN));
+    ++s_ep[idx].st.tx_ack;
+    ep_tx(idx, f, n, now + 2u * e->delay_ns, now);
+}
+
+static void ep_send_status(uint32_t idx, uint64_t now)
+{
+    const endpoint_t* e = &s_ep[idx];
+    uint8_t f[FRAME_MAX];
+    const uint16_t n = build_hdr(f, MSG_STATUS, e->last_seq, (uint32_t)(now / 1000000ull), STATUS_PLEN);
+    for (int c = 0; c < PWM_HOST_CH_NUM; ++c) wr16(f + HDR_LEN + 2 * c, e->duty[c]);
+    wr16(f + HDR_LEN + STATUS_PLEN, crc16(f + 2, HDR_LEN - 2 + STATUS_PLEN));
+    ++s_ep[idx].st.tx_status;
+    ep_tx(idx, f, n, now + e->delay_ns, now);
+}
+
+/* STATUS：所有端点同一周期，相位按序号均匀错开，游标推进（与端点数无关的 O(1) 摊销） */
+static void service_status(uint64_t now)
+{
+    if (s_ecfg.status_ms == 0 || s_ep_n == 0) return;
+    const uint64_t period = (uint64_t)s_ecfg.status_ms * 1000000ull;
+    const uint64_t step   = period / s_ep_n ? period / s_ep_n : 1u;
+    if (s_status_next_ns == 0) s_status_next_ns = now;
+    while (s_status_next_ns <= now) {
+        if (s_ep[s_status_cursor].have_peer) ep_send_status(s_status_cursor, now);
+        if (++s_status_cursor == s_ep_n) s_status_cursor = 0;
+        s_status_next_ns += step;
+    }
+}
+
+/* ============================ 端点：接收路径 ============================ */
+
+/* SEQ 去重（与固件 seq_check 相同，只用于 PWM）：返回 1=新帧，0=同 SEQ 副本，-1=乱序旧帧 */
+static int seq_accept(endpoint_t* e, uint16_t seq)
+{
+    if (e->seq_valid) {
+        const int16_t d = (int16_t)(uint16_t)(seq - e->last_seq);
+        if (d == 0) {
+            ++e->st.dup;
+            return 0;
+        }
+        if (d < 0 && d > -SEQ_WINDOW) {
+            ++e->st.stale;
+            return -1;
+        }
+        if (d > 0) e->st.gaps += (uint64_t)(d - 1);
+    }
+    e->seq_valid = 1;
+    e->last_seq  = seq;
+    ++e->st.unique;
+    return 1;
+}
+
+static void ep_rx(uint32_t idx, const uint8_t* buf, uint32_t len, const struct sockaddr_in* from, uint64_t now)
+{
+    endpoint_t* e = &s_ep[idx];
+    ++e->st.rx_dgram;
+    if (e->loss > 0.0 && rnd01(&e->rng) < e->loss) {
+        ++e->st.lost_up;
+        return;
+    }
+    e->peer      = *from;
+    e->have_peer = 1;
+
+    /* 解析：SOF / VER / LEN / CRC */
+    if (len < HDR_LEN + CRC_LEN || buf[0] != (uint8_t)(PWM_HOST_SOF_BE >> 8) ||
+        buf[1] != (uint8_t)(PWM_HOST_SOF_BE & 0xFF) || buf[2] != (uint8_t)PWM_HOST_PROTO_VER) {
+        ++e->st.bad;
+        return;
+    }
+    const uint16_t plen = rd16(buf + 10);
+    if ((uint32_t)HDR_LEN + plen + CRC_LEN != len ||
+        crc16(buf + 2, (uint16_t)(HDR_LEN - 2 + plen)) != rd16(buf + HDR_LEN + plen)) {
+        ++e->st.bad;
+        return;
+    }
+    ++e->st.rx_frames;
+
+    const uint8_t  msg = buf[3];
+    const uint16_t seq = rd16(buf + 4);
+
+    /* 心跳独立 SEQ 空间：乱序照常应答，只有同 SEQ 副本不重复应答（与固件一致） */
+    if (msg == PWM_HOST_MSG_HB) {
+        if (e->hb_seq_valid && seq == e->last_hb_seq) return;
+        e->hb_seq_valid = 1;
+        e->last_hb_seq  = seq;
+        ++e->st.rx_hb;
+        ep_send_hb_ack(idx, seq, now);
+        return;
+    }
+
+    const int verdict = seq_accept(e, seq);
+    if (verdict == 0) return;
+
+    /* 乱序旧帧丢弃；PWM_AT 跳过 DUE 后到达即应用 */
+    const int is_pwm    = (msg == PWM_HOST_MSG_PWM    && plen == 2u * PWM_HOST_CH_NUM);
+    const int is_pwm_at = (msg == PWM_HOST_MSG_PWM_AT && plen == 4u + 2u * PWM_HOST_CH_NUM);
+    if ((is_pwm || is_pwm_at) && verdict > 0) {
+        ++e->st.rx_pwm;
+        if (e->last_pwm_ns != 0) {
+            const uint64_t gap_us = (now - e->last_pwm_ns) / 1000u;
+            hist_add(&s_gap_hist, gap_us);
+            if (gap_us > e->st.max_gap_us) e->st.max_gap_us = gap_us;
+        }
+        e->last_pwm_ns = now;
+        const uint8_t* pl = buf + HDR_LEN + (is_pwm_at ? 4 : 0);
+        for (int c = 0; c < PWM_HOST_CH_NUM; ++c) {
+            const uint16_t v = rd16(pl + 2 * c);
+            e->duty[c] = (v > PWM_HOST_VAL_MAX) ? (uint16_t)PWM_HOST_VAL_MAX : v;
+        }
+    } else if (msg == MSG_ESTOP && verdict > 0) {
+        for (int c = 0; c < PWM_HOST_CH_NUM; ++c) e->duty[c] = PWM_HOST_VAL_MID;
+    }
+}
+
+/* 取尽一个端点的接收缓冲（recvmmsg 批量） */
+static void ep_drain(uint32_t idx)
+{
+    static uint8_t            bufs[RX_BATCH][RX_BUF];
+    static struct sockaddr_in names[RX_BATCH];
+    struct mmsghdr            msgs[RX_BATCH];
+    struct iovec              iov[RX_BATCH];
+
+    for (;;) {
+        for (unsigned k = 0; k < RX_BATCH; ++k) {
+            iov[k].iov_base = bufs[k];
+            iov[k].iov_len  = RX_BUF;
+            memset(&msgs[k], 0, sizeof(msgs[k]));
+            msgs[k].msg_hdr.msg_name    = &names[k];
+            msgs[k].msg_hdr.msg_namelen = sizeof(names[k]);
+            msgs[k].msg_hdr.msg_iov     = &iov[k];
+            msgs[k].msg_hdr.msg_iovlen  = 1;
+        }
+        const int n = recvmmsg(s_ep[idx].fd, msgs, RX_BATCH, MSG_DONTWAIT, NULL);
+        if (n <= 0) return;
+        const uint64_t now = now_ns();
+        for (int k = 0; k < n; ++k) ep_rx(idx, bufs[k], msgs[k].msg_len, &names[k], now);
+        if (s_out_n > 0) out_flush();
+        if (n < RX_BATCH) return;
+    }
+}
+
+/* ============================ 端点：事件循环 ============================ */
+
+static void arm_timer(uint64_t wake_ns)
+{
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (wake_ns != UINT64_MAX) {
+        if (wake_ns == 0) wake_ns = 1;   /* 0 表示解除，已过期的时刻取最小正值（立即触发） */
+        its.it_value.tv_sec  = (time_t)(wake_ns / 1000000000ull);
+        its.it_value.tv_nsec = (long)(wake_ns % 1000000000ull);
+    }
+    timerfd_settime(s_tfd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+/* 运行端点直到 end_ns / g_stop；tick 非空时每 tick_ns 回调一次（统计打印） */
+static void serve_loop(uint64_t end_ns, uint64_t tick_ns, void (*tick)(void))
+{
+    struct epoll_event evs[EV_BATCH];
+    uint64_t next_tick = tick ? now_ns() + tick_ns : UINT64_MAX;
+    uint64_t armed     = 0;
+
+    while (!g_stop) {
+        uint64_t now = now_ns();
+        if (now >= end_ns) break;
+        flush_due(now);
+        service_status(now);
+        if (s_out_n > 0) out_flush();
+        if (now >= next_tick) {
+            tick();
+            next_tick += tick_ns;
+        }
+
+        uint64_t wake = end_ns;
+        if (s_heap_n > 0 && s_heap[0].due_ns < wake) wake = s_heap[0].due_ns;
+        if (s_ecfg.status_ms && s_status_next_ns < wake) wake = s_status_next_ns;
+        if (next_tick < wake) wake = next_tick;
+        if (wake != armed) {
+            arm_timer(wake);
+            armed = wake;
+        }
+
+        const int n = epoll_wait(s_epfd, evs, EV_BATCH, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int k = 0; k < n; ++k) {
+            if (evs[k].data.u32 == TIMER_TAG) {
+                uint64_t exp;
+                if (read(s_tfd, &exp, sizeof(exp)) < 0) {}
+                armed = 0;
+            } else {
+                ep_drain(evs[k].data.u32);
+            }
+        }
+    }
+}
+
+static void sum_stats(uint32_t n, ep_stats_t* out)
+{
+    memset(out, 0, sizeof(*out));
+    for (uint32_t i = 0; i < n; ++i) {
+        const ep_stats_t* s = &s_ep[i].st;
+        out->rx_dgram  += s->rx_dgram;
+        out->lost_up   += s->lost_up;
+        out->rx_frames += s->rx_frames;
+        out->rx_pwm    += s->rx_pwm;
+        out->rx_hb     += s->rx_hb;
+        out->bad       += s->bad;
+        out->dup       += s->dup;
+        out->stale     += s->stale;
+        out->gaps      += s->gaps;
+        out->tx_ack    += s->tx_ack;
+        out->tx_status += s->tx_status;
+        out->lost_down += s->lost_down;
+        if (s->max_gap_us > out->max_gap_us) out->max_gap_us = s->max_gap_us;
+    }
+}
+
+static void print_serve_stats(void)
+{
+    ep_stats_t t;
+    sum_stats(s_ep_n, &t);
+    uint32_t active = 0;
+    for (uint32_t i = 0; i < s_ep_n; ++i) active += (uint32_t)s_ep[i].have_peer;
+    fprintf(stderr,
+            "[STAT] endpoints=%u active=%u rx=%llu lost_up=%llu pwm=%llu hb=%llu bad=%llu dup=%llu stale=%llu "
+            "gaps=%llu ack=%llu status=%llu lost_down=%llu qdrop=%llu gap_p50=%.1fms gap_p99=%.1fms gap_max=%.1fms\n",
+            s_ep_n, active, (unsigned long long)t.rx_dgram, (unsigned long long)t.lost_up,
+            (unsigned long long)t.rx_pwm, (unsigned long long)t.rx_hb, (unsigned long long)t.bad,
+            (unsigned long long)t.dup, (unsigned long long)t.stale, (unsigned long long)t.gaps,
+            (unsigned long long)t.tx_ack, (unsigned long long)t.tx_status, (unsigned long long)t.lost_down,
+            (unsigned long long)s_qdrop, (double)hist_pct(&s_gap_hist, 0.50) / 1e3,
+            (double)hist_pct(&s_gap_hist, 0.99) / 1e3, (double)s_gap_hist.max / 1e3);
+}
+
+/* ============================ 基准：每板工作进程 ============================ */
+
+typedef struct {
+    uint32_t hz;
+    uint32_t boards;
+    uint32_t hb_ms;
+    int      stagger;
+    double   run_s;
+} bench_run_t;
+
+/* 子进程：一块板的主机控制环（libpwm_host），结果写入共享内存 */
+static void board_main(const bench_run_t* br, uint32_t idx, bench_shared_t* sh)
+{
+    board_result_t* r = &sh->board[idx];
+
+    pwm_host_config_t hc;
+    pwm_host_default_config(&hc);
+    hc.stm32_ip   = s_ecfg.ip;
+    hc.stm32_port = (uint16_t)(s_ecfg.base_port + idx);
+    hc.send_hz    = (int)br->hz;
+    if (pwm_host_init(&hc) != PWMH_OK) {
+        r->rc = 1;
+        return;
+    }
+
+    while (sh->t0_ns == 0) usleep(1000);
+    const uint64_t period = 1000000000ull / br->hz;
+    const uint64_t hb_ns  = (uint64_t)br->hb_ms * 1000000ull;
+    const uint64_t t_end  = sh->t0_ns + (uint64_t)(br->run_s * 1e9);
+    uint64_t deadline = sh->t0_ns + (br->stagger ? period * idx / br->boards : 0);
+    uint64_t next_hb  = deadline;
+    uint64_t hb_at    = 0;   /* 待应答心跳的发出时刻 */
+    uint64_t acks     = 0;
+    uint16_t v[PWM_HOST_CH_NUM];
+
+    while (deadline < t_end && !g_stop) {
+        /* 等到截止时刻：pwm_host_poll 在 HB_ACK 到达时即返回（RTT 时间戳精确），不足 1ms 的余量 nanosleep */
+        for (;;) {
+            const uint64_t now = now_ns();
+            if (now >= deadline) break;
+            const uint64_t rem = deadline - now;
+            if (rem < 1000000ull) {
+                sleep_until_ns(deadline);
+                continue;
+            }
+            if (pwm_host_poll((int)(rem / 1000000ull)) > 0) {
+                pwm_host_stats_t st;
+                pwm_host_get_stats(&st);
+                if (st.rx_hb_ack != acks) {
+                    acks = st.rx_hb_ack;
+                    if (hb_at) hist_add(&r->rtt, (now_ns() - hb_at) / 1000u);
+                    hb_at = 0;
+                }
+            }
+        }
+
+        for (int c = 0; c < PWM_HOST_CH_NUM; ++c) {
+            v[c] = (uint16_t)(PWM_HOST_VAL_MID + (r->ticks * 7u + (uint64_t)c * 311u) % 2000u);
+        }
+        pwm_host_set_all_u16(v);
+        hist_add(&r->late, (now_ns() - deadline) / 1000u);
+        ++r->ticks;
+        ++r->sent;
+
+        if (deadline >= next_hb) {
+            hb_at = now_ns();
+            pwm_host_send_heartbeat();
+            ++r->hb_sent;
+            next_hb += hb_ns;
+        }
+
+        /* 超过一整个周期的节拍不补发（与控制环“超期不追赶”一致），计为跳过 */
+        deadline += period;
+        const uint64_t now = now_ns();
+        while (deadline + period <= now && deadline < t_end) {
+            deadline += period;
+            ++r->ticks;
+            ++r->skipped;
+        }
+    }
+    (void)pwm_host_poll(0);
+    pwm_host_close();
+    r->cpu_ns = cpu_ns(RUSAGE_SELF);
+}
+
+/* ============================ 基准：主流程 ============================ */
+
+typedef struct {
+    double   host_cpu_pct_board;
+    double   sim_cpu_pct;
+    uint64_t late_p50, late_p99, late_max;
+    uint64_t rtt_p50, rtt_p99;
+    double   deliv_pct;
+    double   skip_pct;
+    uint64_t gap_p99, gap_max;
+    int      ok;
+    uint32_t failed_boards;
+} bench_row_t;
+
+static int run_one(const bench_run_t* br, bench_shared_t* sh, bench_row_t* row)
+{
+    endpoints_reset();
+    memset(sh->board, 0, sizeof(board_result_t) * br->boards);
+    sh->t0_ns = 0;
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t* pids = calloc(br->boards, sizeof(pid_t));
+    if (!pids) return -1;
+    for (uint32_t i = 0; i < br->boards; ++i) {
+        const pid_t p = fork();
+        if (p == 0) {
+            board_main(br, i, sh);
+            _exit(0);
+        }
+        if (p < 0) {
+            perror("fork");
+            g_stop = 1;
+            break;
+        }
+        pids[i] = p;
+    }
+
+    /* 全部子进程就位后统一起跑；子进程初始化期间端点照常服务 */
+    serve_loop(now_ns() + 100000000ull, 0, NULL);
+    const uint64_t sim0 = cpu_ns(RUSAGE_SELF);
+    const uint64_t t0   = now_ns() + 50000000ull;
+    sh->t0_ns = t0;
+
+    uint64_t max_delay = 0;
+    for (uint32_t i = 0; i < br->boards; ++i) {
+        if (s_ep[i].delay_ns > max_delay) max_delay = s_ep[i].delay_ns;
+    }
+    const uint64_t t_end = t0 + (uint64_t)(br->run_s * 1e9);
+    serve_loop(t_end + 2u * max_delay + 100000000ull, 0, NULL);
+    const uint64_t sim_cpu = cpu_ns(RUSAGE_SELF) - sim0;
+
+    for (uint32_t i = 0; i < br->boards; ++i) {
+        if (pids[i] > 0) waitpid(pids[i], NULL, 0);
+    }
+    free(pids);
+
+    /* 汇总 */
+    hist_t   late, rtt;
+    uint64_t ticks = 0, sent = 0, skipped = 0, hb = 0, host_cpu = 0;
+    memset(&late, 0, sizeof(late));
+    memset(&rtt, 0, sizeof(rtt));
+    memset(row, 0, sizeof(*row));
+    for (uint32_t i = 0; i < br->boards; ++i) {
+        const board_result_t* b = &sh->board[i];
+        if (b->rc != 0) ++row->failed_boards;
+        hist_merge(&late, &b->late);
+        hist_merge(&rtt, &b->rtt);
+        ticks    += b->ticks;
+        sent     += b->sent;
+        skipped  += b->skipped;
+        hb       += b->hb_sent;
+        host_cpu += b->cpu_ns;
+    }
+    ep_stats_t es;
+    sum_stats(br->boards, &es);
+
+    const double period_us  = 1e6 / br->hz;
+    row->host_cpu_pct_board = 100.0 * (double)host_cpu / ((double)br->boards * br->run_s * 1e9);
+    row->sim_cpu_pct        = 100.0 * (double)sim_cpu / (br->run_s * 1e9);
+    row->late_p50           = hist_pct(&late, 0.50);
+    row->late_p99           = hist_pct(&late, 0.99);
+    row->late_max           = late.max;
+    row->rtt_p50            = hist_pct(&rtt, 0.50);
+    row->rtt_p99            = hist_pct(&rtt, 0.99);
+    row->deliv_pct          = (sent + hb) ? 100.0 * (double)es.rx_dgram / (double)(sent + hb) : 0.0;
+    row->skip_pct           = ticks ? 100.0 * (double)skipped / (double)ticks : 100.0;
+    row->gap_p99            = hist_pct(&s_gap_hist, 0.99);
+    row->gap_max            = s_gap_hist.max;
+    row->ok = row->failed_boards == 0 && row->skip_pct <= 1.0 && row->deliv_pct >= 99.0 &&
+              (double)row->late_p99 <= period_us / 2.0;
+    return 0;
+}
+
+static int bench_main(const uint32_t* boards, int nb, const uint32_t* rates, int nr,
+                      double run_s, uint32_t hb_ms, int stagger, int keep_going, const char* csv_path)
+{
+    uint32_t max_n = 0;
+    for (int i = 0; i < nb; ++i) {
+        if (boards[i] > max_n) max_n = boards[i];
+    }
+    if (max_n > MAX_BOARDS) {
+        fprintf(stderr, "[ERR] at most %u boards\n", MAX_BOARDS);
+        return 2;
+    }
+    if (endpoints_open(max_n) != 0) return 1;
+
+    const size_t shm_len = sizeof(bench_shared_t) + sizeof(board_result_t) * max_n;
+    bench_shared_t* sh = mmap(NULL, shm_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sh == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    FILE* csv = NULL;
+    if (csv_path) {
+        csv = fopen(csv_path, "w");
+        if (!csv) {
+            fprintf(stderr, "[ERR] open %s: %s\n", csv_path, strerror(errno));
+            return 1;
+        }
+        fprintf(csv, "hz,boards,host_cpu_pct_per_board,sim_cpu_pct,late_p50_us,late_p99_us,late_max_us,"
+                     "rtt_p50_us,rtt_p99_us,deliv_pct,skip_pct,gap_p99_ms,gap_max_ms,ok\n");
+    }
+
+    printf("%5s %6s %10s %8s %8s %8s %9s %8s %8s %7s %6s %8s %8s %3s\n", "hz", "boards", "cpu%/brd",
+           "sim_cpu%", "late_p50", "late_p99", "late_max", "rtt_p50", "rtt_p99", "deliv%", "skip%",
+           "gap_p99", "gap_max", "ok");
+    for (int ri = 0; ri < nr && !g_stop; ++ri) {
+        uint32_t best = 0;
+        int      failed = 0;
+        for (int bi = 0; bi < nb && !g_stop; ++bi) {
+            const bench_run_t br = { rates[ri], boards[bi], hb_ms, stagger, run_s };
+            bench_row_t row;
+            if (run_one(&br, sh, &row) != 0) break;
+            printf("%5u %6u %10.3f %8.1f %8llu %8llu %9llu %8llu %8llu %7.2f %6.2f %8.2f %8.2f %3s\n",
+                   br.hz, br.boards, row.host_cpu_pct_board, row.sim_cpu_pct,
+                   (unsigned long long)row.late_p50, (unsigned long long)row.late_p99,
+                   (unsigned long long)row.late_max, (unsigned long long)row.rtt_p50,
+                   (unsigned long long)row.rtt_p99, row.deliv_pct, row.skip_pct,
+                   (double)row.gap_p99 / 1e3, (double)row.gap_max / 1e3, row.ok ? "yes" : "NO");
+            fflush(stdout);
+            if (csv) {
+                fprintf(csv, "%u,%u,%.4f,%.2f,%llu,%llu,%llu,%llu,%llu,%.3f,%.3f,%.3f,%.3f,%d\n",
+                        br.hz, br.boards, row.host_cpu_pct_board, row.sim_cpu_pct,
+                        (unsigned long long)row.late_p50, (unsigned long long)row.late_p99,
+                        (unsigned long long)row.late_max, (unsigned long long)row.rtt_p50,
+                        (unsigned long long)row.rtt_p99, row.deliv_pct, row.skip_pct,
+                        (double)row.gap_p99 / 1e3, (double)row.gap_max / 1e3, row.ok);
+                fflush(csv);
+            }
+            if (row.failed_boards) {
+                fprintf(stderr, "[WARN] %u boards failed pwm_host_init\n", row.failed_boards);
+            }
+            if (row.ok && !failed) best = br.boards;
+            if (!row.ok) {
+                failed = 1;
+                if (!keep_going) break;
+            }
+        }
+        printf("[RESULT] %u Hz: sustained up to %u boards%s\n", rates[ri], best,
+               failed ? "" : " (not reached the limit; extend -n)");
+    }
+
+    if (csv) fclose(csv);
+    munmap(sh, shm_len);
+    return 0;
+}
+
+/* ============================ 主程序 ============================ */
+
+static void usage(const char* argv0)
+{
+    fprintf(stderr,
+            "usage: %s serve -n N [-T seconds] [-i stat_s] [endpoint options]\n"
+            "       %s bench [-n LIST] [-r LIST] [-t seconds] [-b HB_MS] [-g] [-k] [-o out.csv] [endpoint options]\n"
+            "  endpoint options: -a IP  -p BASE_PORT  -d MS[:MS]  -l P[:P]  -c FILE  -s STATUS_MS  -S seed\n",
+            argv0, argv0);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || (strcmp(argv[1], "serve") != 0 && strcmp(argv[1], "bench") != 0)) {
+        usage(argv[0]);
+        return 2;
+    }
+    const int bench = (strcmp(argv[1], "bench") == 0);
+
+    ep_config_default(&s_ecfg);
+    uint32_t boards[LIST_MAX] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024 };
+    uint32_t rates[LIST_MAX]  = { 50, 100, 200 };
+    int      nb = 11, nr = 3;
+    double   run_s  = bench ? 3.0 : 0.0;
+    double   stat_s = 0.0;
+    uint32_t hb_ms  = 100;
+    int      stagger = 0, keep_going = 0;
+    const char* csv = NULL;
+
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "n:r:t:T:i:b:gko:a:p:d:l:c:s:S:h")) != -1) {
+        switch (opt) {
+        case 'n': nb = parse_list(optarg, boards, LIST_MAX); break;
+        case 'r': nr = parse_list(optarg, rates, LIST_MAX); break;
+        case 't':
+        case 'T': run_s  = atof(optarg); break;
+        case 'i': stat_s = atof(optarg); break;
+        case 'b': hb_ms  = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'g': stagger    = 1; break;
+        case 'k': keep_going = 1; break;
+        case 'o': csv = optarg; break;
+        case 'a': s_ecfg.ip = optarg; break;
+        case 'p': s_ecfg.base_port = (uint16_t)strtoul(optarg, NULL, 10); break;
+        case 'd': if (parse_range(optarg, s_ecfg.delay_ms) != 0) { usage(argv[0]); return 2; } break;
+        case 'l': if (parse_range(optarg, s_ecfg.loss) != 0 || s_ecfg.loss[1] > 1.0) { usage(argv[0]); return 2; } break;
+        case 'c': s_ecfg.cfg_path = optarg; break;
+        case 's': s_ecfg.status_ms = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'S': s_ecfg.seed = strtoull(optarg, NULL, 0); break;
+        default:  usage(argv[0]); return 2;
+        }
+    }
+    if (nb <= 0 || nr <= 0 || hb_ms == 0 || (bench && run_s <= 0.0)) {
+        usage(argv[0]);
+        return 2;
+    }
+    for (int i = 0; i < nr; ++i) {
+        if (rates[i] > 1000u) {
+            fprintf(stderr, "[ERR] rate %u Hz too high\n", rates[i]);
+            return 2;
+        }
+    }
+
+    crc_init();
+    raise_nofile();
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (bench) return bench_main(boards, nb, rates, nr, run_s, hb_ms, stagger, keep_going, csv);
+
+    /* serve：-n 取列表第一个值 */
+    if (endpoints_open(boards[0]) != 0) return 1;
+    fprintf(stderr, "[INFO] %u endpoints on %s:%u-%u\n", s_ep_n, s_ecfg.ip, (unsigned)s_ecfg.base_port,
+            (unsigned)(s_ecfg.base_port + s_ep_n - 1u));
+    const uint64_t end_ns = (run_s > 0.0) ? now_ns() + (uint64_t)(run_s * 1e9) : UINT64_MAX;
+    serve_loop(end_ns, (stat_s > 0.0) ? (uint64_t)(stat_s * 1e9) : 0,
+               (stat_s > 0.0) ? print_serve_stats : NULL);
+    print_serve_stats();
+    return 0;
+}
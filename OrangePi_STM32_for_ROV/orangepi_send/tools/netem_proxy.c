@@ -0,0 +1,669 @@
+/**
+ * @file    netem_proxy.c
+ * @brief   UDP 链路损伤代理（用户态 netem，无需 root）
+ *
+ * 位于主机（UdpSender / libpwm_host）与目标（实机桥 / 仿真端）之间，按方向注入
+ * 延迟、抖动、丢包（Bernoulli / Gilbert-Elliott 突发）、重复、乱序与限速。
+ *
+ * 用法：
+ *   pwm_netem_proxy -l 127.0.0.1:9000 -t 192.168.2.16:8000 [-S seed] [-f profile]
+ *                   [-T seconds] [-i stat_s] [-o log.csv] [-u k=v]... [-d k=v]... [-b k=v]...
+ *
+ *   主机改连 -l 地址；代理把第一个来包的源地址记为客户端，下行（目标 → 主机）回给它。
+ *   -u / -d / -b 分别设置上行（主机 → 目标）/ 下行 / 双向的初始参数；
+ *   -T 运行指定秒数后退出（CI）；-i 周期打印统计；-o 逐包记录判决（CSV）。
+ *
+ * 参数（命令行与剧本同一语法）：
+ *   delay=MS  jitter=MS  loss=P  dup=P  reorder=P  reorder_ms=MS  rate=KBIT  queue=N
+ *   ge=P_GB,P_BG[,LOSS_GOOD,LOSS_BAD]   Gilbert-Elliott（默认 LOSS_GOOD=0，LOSS_BAD=1）
+ *   reset                               恢复无损伤
+ *
+ *   - jitter 为 ±jitter 的均匀分布（结果不小于 0），本身即可造成乱序，与 netem 相同；
+ *   - reorder 命中的包额外滞留 reorder_ms（默认 10），让后续包超过它；
+ *   - rate>0 时按包长串行化排队（先限速后延迟），在途超过 queue 个（默认 1000）则尾丢。
+ *
+ * 剧本（-f）：每行 "T DIR k=v ..."，DIR 为 up / down / both，'#' 起注释，按行顺序执行：
+ *   - T 为相对代理启动的毫秒数；
+ *   - T 写作 @N 时表示“已转发 N 个上行包之后”，不受主机调度抖动影响，逐包可重放。
+ *   例：
+ *
+ *      0      both  delay=5 jitter=2
+ *      @500   up    ge=0.02,0.25
+ *      20000  both  reset rate=64
+ *
+ * 可重放：每个方向一条由 seed 派生的独立随机流，每个包固定消耗 6 个随机数，
+ *   同一 seed 下同一方向第 N 个包抽到的随机数恒定；参数不变或按 @N 切换时判决逐包一致
+ *   （-o 记录每包判决，便于两次运行逐包对比）。
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ============================ 内部常量 ============================ */
+
+#define PKT_MAX     2048   /* 单个数据报上限 */
+#define POOL_SIZE   1024   /* 在途（已收未发）包上限，两方向共用 */
+#define PROFILE_MAX 256    /* 剧本行数上限 */
+#define RND_PER_PKT 6      /* 每包消耗的随机数个数（固定，保证可重放） */
+
+enum { DIR_UP = 0, DIR_DOWN = 1, DIR_NUM = 2 };
+
+static const char* const k_dir_name[DIR_NUM] = { "up", "down" };
+
+/* ============================ 数据结构 ============================ */
+
+typedef struct {
+    double   delay_ms;
+    double   jitter_ms;
+    double   loss;
+    double   dup;
+    double   reorder;
+    double   reorder_ms;
+    double   rate_kbit;      /* 0 = 不限速 */
+    unsigned queue_max;
+    int      ge_on;
+    double   ge_p_gb;        /* good → bad 转移概率 */
+    double   ge_p_bg;        /* bad → good 转移概率 */
+    double   ge_loss_good;
+    double   ge_loss_bad;
+} imp_t;
+
+typedef struct {
+    uint64_t rx;
+    uint64_t tx;
+    uint64_t lost;
+    uint64_t dup;
+    uint64_t reordered;
+    uint64_t qdrop;          /* 限速队列满 / 在途池满 */
+    uint64_t bytes_tx;
+} dir_stats_t;
+
+typedef struct {
+    imp_t       imp;
+    uint64_t    rng;
+    int         ge_bad;
+    uint64_t    link_free_ns; /* 限速：串行化链路空闲时刻 */
+    unsigned    inflight;
+    uint64_t    pkt_no;
+    dir_stats_t st;
+} dir_t;
+
+typedef struct {
+    uint64_t due_ns;
+    uint64_t order;          /* 同一到期时刻按入队顺序发出 */
+    int      dir;
+    uint16_t len;
+    uint8_t  data[PKT_MAX];
+} pkt_t;
+
+typedef struct {
+    uint64_t at;             /* 毫秒（相对启动）或上行包数（by_pkt） */
+    int      by_pkt;
+    int      dir_mask;       /* bit0=up bit1=down */
+    char     kv[256];
+} profile_line_t;
+
+/* ============================ 内部状态 ============================ */
+
+static volatile sig_atomic_t g_stop = 0;
+
+static dir_t              s_dir[DIR_NUM];
+static pkt_t              s_pool[POOL_SIZE];
+static int                s_free[POOL_SIZE];
+static int                s_free_n = 0;
+static int                s_heap[POOL_SIZE];
+static int                s_heap_n = 0;
+static uint64_t           s_order  = 0;
+
+static profile_line_t     s_prof[PROFILE_MAX];
+static int                s_prof_n   = 0;
+static int                s_prof_pos = 0;
+
+static int                s_lsock = -1;    /* 面向主机 */
+static int                s_usock = -1;    /* 面向目标 */
+static struct sockaddr_in s_target;
+static struct sockaddr_in s_client;
+static int                s_have_client = 0;
+static FILE*              s_log = NULL;
+static uint64_t           s_t0_ns = 0;
+
+/* ============================ 工具函数 ============================ */
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_stop = 1;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* splitmix64：由 seed 派生各方向的初始状态 */
+static uint64_t splitmix64(uint64_t* x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* xorshift64*，返回 [0,1) */
+static double rnd01(uint64_t* s)
+{
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return (double)((*s * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int parse_addr(const char* s, struct sockaddr_in* out)
+{
+    char host[64];
+    const char* colon = strrchr(s, ':');
+    if (!colon || (size_t)(colon - s) >= sizeof(host)) return -1;
+    memcpy(host, s, (size_t)(colon - s));
+    host[colon - s] = '\0';
+
+    char* end = NULL;
+    long port = strtol(colon + 1, &end, 10);
+    if (*end != '\0' || port <= 0 || port > 65535) return -1;
+
+    memset(out, 0, sizeof(*out));
+    out->sin_family = AF_INET;
+    out->sin_port   = htons((uint16_t)port);
+    return (inet_pton(AF_INET, host, &out->sin_addr) == 1) ? 0 : -1;
+}
+
+static void imp_default(imp_t* m)
+{
+    memset(m, 0, sizeof(*m));
+    m->reorder_ms = 10.0;
+    m->queue_max  = 1000u;
+}
+
+/* 解析单个 k=v；返回 0 成功 */
+static int imp_apply_kv(imp_t* m, const char* tok)
+{
+    if (strcmp(tok, "reset") == 0) {
+        imp_default(m);
+        return 0;
+    }
+    const char* eq = strchr(tok, '=');
+    if (!eq) return -1;
+    const size_t klen = (size_t)(eq - tok);
+    const char*  v    = eq + 1;
+
+#define KEY_IS(k) (klen == sizeof(k) - 1 && strncmp(tok, k, klen) == 0)
+    if (KEY_IS("ge")) {
+        double a = 0, b = 0, lg = 0.0, lb = 1.0;
+        const int n = sscanf(v, "%lf,%lf,%lf,%lf", &a, &b, &lg, &lb);
+        if (n != 2 && n != 4) return -1;
+        m->ge_on        = (a > 0.0);
+        m->ge_p_gb      = a;
+        m->ge_p_bg      = b;
+        m->ge_loss_good = lg;
+        m->ge_loss_bad  = lb;
+        return 0;
+    }
+
+    char* end = NULL;
+    const double x = strtod(v, &end);
+    if (end == v || *end != '\0' || x < 0.0) return -1;
+
+    if      (KEY_IS("delay"))      m->delay_ms   = x;
+    else if (KEY_IS("jitter"))     m->jitter_ms  = x;
+    else if (KEY_IS("loss"))       m->loss       = x;
+    else if (KEY_IS("dup"))        m->dup        = x;
+    else if (KEY_IS("reorder"))    m->reorder    = x;
+    else if (KEY_IS("reorder_ms")) m->reorder_ms = x;
+    else if (KEY_IS("rate"))       m->rate_kbit  = x;
+    else if (KEY_IS("queue"))      m->queue_max  = (unsigned)x;
+    else return -1;
+#undef KEY_IS
+    return 0;
+}
+
+/* 把空白分隔的一串 k=v 应用到 mask 指定的方向 */
+static int apply_kv_line(int dir_mask, const char* line)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", line);
+    for (char* save = NULL, *tok = strtok_r(buf, " \t\r\n", &save); tok;
+         tok = strtok_r(NULL, " \t\r\n", &save)) {
+        for (int d = 0; d < DIR_NUM; ++d) {
+            if ((dir_mask & (1 << d)) && imp_apply_kv(&s_dir[d].imp, tok) != 0) {
+                fprintf(stderr, "[ERR] bad parameter: %s\n", tok);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int load_profile(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "[ERR] open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    char     line[320];
+    int      lineno = 0;
+    uint64_t last_t = 0, last_pkt = 0;
+    while (fgets(line, sizeof(line), f)) {
+        ++lineno;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        unsigned long long t = 0;
+        char dir[16];
+        int  used = 0;
+        const char* s = line + strspn(line, " \t");
+        const int by_pkt = (*s == '@');
+        if (sscanf(s + by_pkt, "%llu %15s %n", &t, dir, &used) < 2) continue;  /* 空行 / 注释 */
+        uint64_t* last = by_pkt ? &last_pkt : &last_t;
+
+        int mask = 0;
+        if      (strcmp(dir, "up") == 0)   mask = 1;
+        else if (strcmp(dir, "down") == 0) mask = 2;
+        else if (strcmp(dir, "both") == 0) mask = 3;
+        if (!mask || s_prof_n == PROFILE_MAX || (uint64_t)t < *last) {
+            fprintf(stderr, "[ERR] %s:%d: bad direction, non-monotonic trigger or too many lines\n", path, lineno);
+            fclose(f);
+            return -1;
+        }
+        profile_line_t* p = &s_prof[s_prof_n++];
+        p->at       = (uint64_t)t;
+        p->by_pkt   = by_pkt;
+        p->dir_mask = mask;
+        snprintf(p->kv, sizeof(p->kv), "%s", s + by_pkt + used);
+        for (size_t n = strlen(p->kv); n > 0 && strchr(" \t\r\n", p->kv[n - 1]); --n) p->kv[n - 1] = '\0';
+        *last = p->at;
+
+        /* 先在副本上校验语法，避免运行到一半才报错 */
+        imp_t probe;
+        imp_default(&probe);
+        char chk[256];
+        snprintf(chk, sizeof(chk), "%s", p->kv);
+        for (char* save = NULL, *tok = strtok_r(chk, " \t\r\n", &save); tok;
+             tok = strtok_r(NULL, " \t\r\n", &save)) {
+            if (imp_apply_kv(&probe, tok) != 0) {
+                fprintf(stderr, "[ERR] %s:%d: bad parameter: %s\n", path, lineno, tok);
+                fclose(f);
+                return -1;
+            }
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+/* 剧本按行顺序执行：当前行条件未满足时后续行一律等待 */
+static int profile_due(const profile_line_t* p, uint64_t now)
+{
+    return p->by_pkt ? (s_dir[DIR_UP].pkt_no >= p->at) : (now - s_t0_ns >= p->at * 1000000ull);
+}
+
+static void service_profile(uint64_t now)
+{
+    while (s_prof_pos < s_prof_n && profile_due(&s_prof[s_prof_pos], now)) {
+        const profile_line_t* p = &s_prof[s_prof_pos++];
+        (void)apply_kv_line(p->dir_mask, p->kv);
+        fprintf(stderr, "[INFO] %s%llu%s %s: %s\n", p->by_pkt ? "pkt=" : "t=", (unsigned long long)p->at,
+                p->by_pkt ? "" : "ms", p->dir_mask == 3 ? "both" : k_dir_name[p->dir_mask - 1], p->kv);
+    }
+}
+
+static uint64_t next_profile_ns(void)
+{
+    if (s_prof_pos >= s_prof_n || s_prof[s_prof_pos].by_pkt) return UINT64_MAX;
+    return s_t0_ns + s_prof[s_prof_pos].at * 1000000ull;
+}
+
+/* ============================ 在途队列（最小堆） ============================ */
+
+static int pkt_before(int a, int b)
+{
+    const pkt_t* pa = &s_pool[a];
+    const pkt_t* pb = &s_pool[b];
+    return (pa->due_ns != pb->due_ns) ? (pa->due_ns < pb->due_ns) : (pa->order < pb->order);
+}
+
+static void heap_push(int idx)
+{
+    int i = s_heap_n++;
+    s_heap[i] = idx;
+    while (i > 0) {
+        const int parent = (i - 1) / 2;
+        if (!pkt_before(s_heap[i], s_heap[parent])) break;
+        const int tmp = s_heap[i];
+        s_heap[i]      = s_heap[parent];
+        s_heap[parent] = tmp;
+        i = parent;
+    }
+}
+
+static int heap_pop(void)
+{
+    const int top = s_heap[0];
+    s_heap[0] = s_heap[--s_heap_n];
+    int i = 0;
+    for (;;) {
+        const int l = 2 * i + 1;
+        const int r = l + 1;
+        int m = i;
+        if (l < s_heap_n && pkt_before(s_heap[l], s_heap[m])) m = l;
+        if (r < s_heap_n && pkt_before(s_heap[r], s_heap[m])) m = r;
+        if (m == i) break;
+        const int tmp = s_heap[i];
+        s_heap[i] = s_heap[m];
+        s_heap[m] = tmp;
+        i = m;
+    }
+    return top;
+}
+
+static void log_pkt(int dir, uint64_t no, uint16_t len, const char* verdict, double delay_ms)
+{
+    if (!s_log) return;
+    fprintf(s_log, "%.3f,%s,%llu,%u,%s,%.3f\n", (double)(now_ns() - s_t0_ns) / 1e6,
+            k_dir_name[dir], (unsigned long long)no, (unsigned)len, verdict, delay_ms);
+}
+
+static int enqueue(int dir, const uint8_t* data, uint16_t len, uint64_t due_ns)
+{
+    dir_t* d = &s_dir[dir];
+    if (s_free_n == 0 || d->inflight >= d->imp.queue_max) {
+        ++d->st.qdrop;
+        return -1;
+    }
+    const int idx = s_free[--s_free_n];
+    pkt_t* p  = &s_pool[idx];
+    p->due_ns = due_ns;
+    p->order  = s_order++;
+    p->dir    = dir;
+    p->len    = len;
+    memcpy(p->data, data, len);
+    heap_push(idx);
+    ++d->inflight;
+    return 0;
+}
+
+/* ============================ 损伤判决 ============================ */
+
+/* 对一个收到的包做判决并入队（随机数消耗固定为 RND_PER_PKT 个） */
+static void impair(int dir, const uint8_t* data, uint16_t len, uint64_t now)
+{
+    if (dir == DIR_UP) service_profile(now);   /* 按包数触发的剧本行恰好在第 N+1 个上行包之前生效 */
+
+    dir_t*       d = &s_dir[dir];
+    const imp_t* m = &d->imp;
+    const uint64_t no = ++d->pkt_no;
+    ++d->st.rx;
+
+    double u[RND_PER_PKT];
+    for (int i = 0; i < RND_PER_PKT; ++i) u[i] = rnd01(&d->rng);
+
+    /* 丢包：Gilbert-Elliott 先转移状态，再按状态丢包率判决；Bernoulli 叠加 */
+    double p_loss = m->loss;
+    if (m->ge_on) {
+        if (d->ge_bad) { if (u[0] < m->ge_p_bg) d->ge_bad = 0; }
+        else           { if (u[0] < m->ge_p_gb) d->ge_bad = 1; }
+        const double ge = d->ge_bad ? m->ge_loss_bad : m->ge_loss_good;
+        p_loss = 1.0 - (1.0 - p_loss) * (1.0 - ge);
+    }
+    if (u[1] < p_loss) {
+        ++d->st.lost;
+        log_pkt(dir, no, len, "loss", 0.0);
+        return;
+    }
+
+    /* 限速：按包长串行化（先限速后延迟） */
+    uint64_t start = now;
+    if (m->rate_kbit > 0.0) {
+        const uint64_t ser = (uint64_t)((double)len * 8.0 / (m->rate_kbit * 1000.0) * 1e9);
+        if (d->link_free_ns > start) start = d->link_free_ns;
+        d->link_free_ns = start + ser;
+        start = d->link_free_ns;
+    }
+
+    double delay = m->delay_ms + (2.0 * u[2] - 1.0) * m->jitter_ms;
+    const char* verdict = "pass";
+    if (u[4] < m->reorder) {
+        delay  += m->reorder_ms;
+        verdict = "reorder";
+        ++d->st.reordered;
+    }
+    if (delay < 0.0) delay = 0.0;
+    const uint64_t due = start + (uint64_t)(delay * 1e6);
+    if (enqueue(dir, data, len, due) != 0) {
+        log_pkt(dir, no, len, "qdrop", 0.0);
+        return;
+    }
+    log_pkt(dir, no, len, verdict, (double)(due - now) / 1e6);
+
+    /* 重复：副本独立抖动 */
+    if (u[3] < m->dup) {
+        double dd = m->delay_ms + (2.0 * u[5] - 1.0) * m->jitter_ms;
+        if (dd < 0.0) dd = 0.0;
+        const uint64_t due2 = start + (uint64_t)(dd * 1e6);
+        if (enqueue(dir, data, len, due2) == 0) {
+            ++d->st.dup;
+            log_pkt(dir, no, len, "dup", (double)(due2 - now) / 1e6);
+        }
+    }
+}
+
+/* 发出所有到期的包 */
+static void flush_due(uint64_t now)
+{
+    while (s_heap_n > 0 && s_pool[s_heap[0]].due_ns <= now) {
+        const int idx = heap_pop();
+        pkt_t*    p   = &s_pool[idx];
+        dir_t*    d   = &s_dir[p->dir];
+        --d->inflight;
+        s_free[s_free_n++] = idx;
+
+        ssize_t n = -1;
+        if (p->dir == DIR_UP) {
+            n = sendto(s_usock, p->data, p->len, 0, (const struct sockaddr*)&s_target, sizeof(s_target));
+        } else if (s_have_client) {
+            n = sendto(s_lsock, p->data, p->len, 0, (const struct sockaddr*)&s_client, sizeof(s_client));
+        }
+        if (n == (ssize_t)p->len) {
+            ++d->st.tx;
+            d->st.bytes_tx += p->len;
+        } else {
+            ++d->st.qdrop;   /* 本地发送失败（缓冲满等）计入尾丢 */
+        }
+    }
+}
+
+/* 把 sock 上的数据报取尽；下行只接受目标地址来包，上行来包刷新客户端地址 */
+static void drain(int sock, int dir, uint64_t now)
+{
+    uint8_t buf[PKT_MAX];
+    for (;;) {
+        struct sockaddr_in from;
+        socklen_t fl = sizeof(from);
+        const ssize_t n = recvfrom(sock, buf, sizeof(buf), MSG_DONTWAIT, (struct sockaddr*)&from, &fl);
+        if (n < 0) return;   /* EAGAIN 或错误：本轮结束 */
+
+        if (dir == DIR_UP) {
+            if (!s_have_client || from.sin_addr.s_addr != s_client.sin_addr.s_addr ||
+                from.sin_port != s_client.sin_port) {
+                char ip[INET_ADDRSTRLEN];
+                inet_ntop(AF_INET, &from.sin_addr, ip, sizeof(ip));
+                fprintf(stderr, "[INFO] client %s:%u\n", ip, (unsigned)ntohs(from.sin_port));
+                s_client      = from;
+                s_have_client = 1;
+            }
+        } else if (from.sin_addr.s_addr != s_target.sin_addr.s_addr || from.sin_port != s_target.sin_port) {
+            continue;   /* 非目标来包 */
+        }
+        impair(dir, buf, (uint16_t)n, now);
+    }
+}
+
+static void print_stats(FILE* out)
+{
+    for (int d = 0; d < DIR_NUM; ++d) {
+        const dir_stats_t* s = &s_dir[d].st;
+        fprintf(out, "[STAT][%-4s] rx=%llu tx=%llu lost=%llu dup=%llu reordered=%llu qdrop=%llu bytes=%llu inflight=%u\n",
+                k_dir_name[d], (unsigned long long)s->rx, (unsigned long long)s->tx,
+                (unsigned long long)s->lost, (unsigned long long)s->dup,
+                (unsigned long long)s->reordered, (unsigned long long)s->qdrop,
+                (unsigned long long)s->bytes_tx, s_dir[d].inflight);
+    }
+    fflush(out);
+}
+
+static void usage(const char* argv0)
+{
+    fprintf(stderr,
+            "usage: %s -l IP:PORT -t IP:PORT [-S seed] [-f profile] [-T seconds] [-i stat_s]\n"
+            "          [-o log.csv] [-u k=v]... [-d k=v]... [-b k=v]...\n"
+            "  k=v: delay=MS jitter=MS loss=P dup=P reorder=P reorder_ms=MS rate=KBIT queue=N\n"
+            "       ge=P_GB,P_BG[,LOSS_GOOD,LOSS_BAD] reset\n",
+            argv0);
+}
+
+/* ============================ 主程序 ============================ */
+
+int main(int argc, char** argv)
+{
+    struct sockaddr_in listen_addr;
+    int      have_listen = 0, have_target = 0;
+    uint64_t seed        = 1;
+    double   run_s       = 0.0;
+    double   stat_s      = 0.0;
+    const char* profile  = NULL;
+    const char* log_path = NULL;
+
+    for (int d = 0; d < DIR_NUM; ++d) imp_default(&s_dir[d].imp);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "l:t:S:f:T:i:o:u:d:b:h")) != -1) {
+        switch (opt) {
+        case 'l': have_listen = (parse_addr(optarg, &listen_addr) == 0); break;
+        case 't': have_target = (parse_addr(optarg, &s_target) == 0); break;
+        case 'S': seed    = strtoull(optarg, NULL, 0); break;
+        case 'f': profile = optarg; break;
+        case 'T': run_s   = atof(optarg); break;
+        case 'i': stat_s  = atof(optarg); break;
+        case 'o': log_path = optarg; break;
+        case 'u': if (apply_kv_line(1, optarg) != 0) return 2; break;
+        case 'd': if (apply_kv_line(2, optarg) != 0) return 2; break;
+        case 'b': if (apply_kv_line(3, optarg) != 0) return 2; break;
+        default:  usage(argv[0]); return 2;
+        }
+    }
+    if (!have_listen || !have_target) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (profile && load_profile(profile) != 0) return 2;
+
+    /* 各方向独立随机流 */
+    uint64_t sm = seed;
+    for (int d = 0; d < DIR_NUM; ++d) {
+        s_dir[d].rng = splitmix64(&sm);
+        if (s_dir[d].rng == 0) s_dir[d].rng = 1;
+    }
+    for (int i = 0; i < POOL_SIZE; ++i) s_free[i] = POOL_SIZE - 1 - i;
+    s_free_n = POOL_SIZE;
+
+    if (log_path) {
+        s_log = fopen(log_path, "w");
+        if (!s_log) {
+            fprintf(stderr, "[ERR] open %s: %s\n", log_path, strerror(errno));
+            return 1;
+        }
+        fprintf(s_log, "t_ms,dir,pkt,len,verdict,delay_ms\n");
+    }
+
+    s_lsock = socket(AF_INET, SOCK_DGRAM, 0);
+    s_usock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s_lsock < 0 || s_usock < 0) {
+        perror("socket");
+        return 1;
+    }
+    const int one = 1;
+    setsockopt(s_lsock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(s_lsock, (const struct sockaddr*)&listen_addr, sizeof(listen_addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    s_t0_ns = now_ns();
+    const uint64_t end_ns    = (run_s > 0.0) ? s_t0_ns + (uint64_t)(run_s * 1e9) : UINT64_MAX;
+    const uint64_t stat_step = (stat_s > 0.0) ? (uint64_t)(stat_s * 1e9) : 0;
+    uint64_t       next_stat = stat_step ? s_t0_ns + stat_step : UINT64_MAX;
+
+    fprintf(stderr, "[INFO] netem proxy up, seed=%llu%s%s\n", (unsigned long long)seed,
+            profile ? " profile=" : "", profile ? profile : "");
+
+    while (!g_stop) {
+        uint64_t now = now_ns();
+        if (now >= end_ns) break;
+        service_profile(now);
+        flush_due(now);
+        if (now >= next_stat) {
+            print_stats(stderr);
+            next_stat += stat_step;
+        }
+
+        /* 等到下一个事件：到期包 / 剧本行 / 统计 / 结束 */
+        uint64_t wake = end_ns;
+        if (s_heap_n > 0 && s_pool[s_heap[0]].due_ns < wake) wake = s_pool[s_heap[0]].due_ns;
+        if (next_profile_ns() < wake) wake = next_profile_ns();
+        if (next_stat < wake) wake = next_stat;
+        uint64_t wait_us = (wake > now) ? (wake - now + 999u) / 1000u : 0;
+        if (wait_us > 1000000u) wait_us = 1000000u;
+
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        FD_SET(s_lsock, &rfds);
+        FD_SET(s_usock, &rfds);
+        struct timeval tv;
+        tv.tv_sec  = (time_t)(wait_us / 1000000u);
+        tv.tv_usec = (suseconds_t)(wait_us % 1000000u);
+        const int maxfd = (s_lsock > s_usock) ? s_lsock : s_usock;
+        const int r = select(maxfd + 1, &rfds, NULL, NULL, &tv);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            perror("select");
+            break;
+        }
+        now = now_ns();
+        if (r > 0 && FD_ISSET(s_lsock, &rfds)) drain(s_lsock, DIR_UP, now);
+        if (r > 0 && FD_ISSET(s_usock, &rfds)) drain(s_usock, DIR_DOWN, now);
+    }
+
+    print_stats(stdout);
+    if (s_log) fclose(s_log);
+    close(s_lsock);
+    close(s_usock);
+    return 0;
+}
@@ -0,0 +1,645 @@
+/**
+ * @file    pwm_daemon.c
+ * @brief   pwm-daemon：链路的唯一持有者，多进程客户端经共享内存提交目标
+ *
+ * 守护进程持有 libpwm_host（socket / SEQ / 心跳）与 pwm_control（限斜率 step / 急停），
+ * 以绝对截止时间按 ctrl_hz 运行控制周期：
+ *   1) 取尽每个客户端的共享内存环（目标 / 保活 / 急停 / 解除），按序处理；
+ *   2) 仲裁：租约内优先级最高的客户端持有控制权（同级保持现持有者），无人持有时目标回中位；
+ *   3) pwm_ctrl_step() 下发，按 hb_ms 发心跳，pwm_host_poll(0) 收 ACK；
+ *   4) 发布 seqlock 状态快照。
+ * Unix socket 只处理注册（HELLO）/ 调整优先级（PRIO）/ 查询（STATUS），连接断开即回收槽位。
+ *
+ * 用法：
+ *   pwm_daemon [-i IP] [-p PORT] [-r HZ] [-b HB_MS] [-l LEASE_MS] [-S MAX_STEP_PCT]
+ *              [-s SOCK] [-m SHM] [-n] [-x] [-T seconds]
+ *
+ *   -n  非阻塞发送（发送邮箱，见 libpwm_host.h nonblock_send）
+ *   -x  不连设备：使用进程内 STM32 仿真端点（虚拟时钟随实时推进），便于联调客户端
+ *   -T  运行指定秒数后退出（CI）
+ *
+ * 控制协议（每行一条，应答一行）：
+ *   HELLO <prio> <pid> <name>  → OK <slot> <shm_name> | ERR full | ERR bad
+ *   PRIO <prio>                → OK | ERR bad | ERR denied（只能调低，不能高于 HELLO 时的值）
+ *   STATUS                     → OK owner=<slot> clients=<n> estop=<mode> rtt_ms=<x>
+ *
+ * 退出（SIGINT / SIGTERM / -T）：软急停回中位（最多 2 秒）后关闭链路，删除 socket 与共享内存。
+ */
+
+#include "pwm_control.h"
+#include "pwm_host_sim.h"
+#include "pwmd_shm.h"
+#include "pwmh_log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ============================ 内部常量 ============================ */
+
+#define LINE_MAX_      128
+#define STOP_TIMEOUT_S 2.0
+#define LAT_WINDOW_NS  1000000000ull
+
+/* ============================ 数据结构 ============================ */
+
+typedef struct {
+    int      in_use;
+    int      fd;                        /* 控制连接 */
+    char     rbuf[LINE_MAX_];
+    size_t   rlen;
+    int      priority;
+    uint32_t pid;
+    char     name[PWMD_NAME_MAX];
+    int      has_target;                /* 解除急停后清零，需重新提交 */
+    float    target[PWM_HOST_CH_NUM];
+    uint64_t last_cmd_ns;               /* 0 = 尚未提交 */
+    uint64_t cmds;
+} slot_t;
+
+typedef struct {
+    const char* ip;
+    uint16_t    port;
+    double      ctrl_hz;
+    int         hb_ms;
+    int         lease_ms;
+    float       max_step;
+    const char* sock_path;
+    const char* shm_name;
+    int         nonblock;
+    int         sim;
+    double      run_s;
+} opts_t;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static opts_t      s_opt;
+static pwmd_shm_t* s_shm        = NULL;
+static int         s_lfd        = -1;
+static slot_t      s_slot[PWMD_MAX_CLIENTS];
+static int         s_owner      = -1;
+static int         s_estop_slot = -1;   /* 锁存急停的槽位；该客户端断开后为 -1，但 s_estop_prio 保留 */
+static int         s_estop_prio = -1;   /* 解除所需的最低优先级，-1 = 无客户端锁存的急停 */
+static uint64_t    s_update     = 0;
+static uint64_t    s_lat_max_ns = 0;
+static uint64_t    s_lat_win_ns = 0;
+static uint64_t    s_acks       = 0;
+static uint64_t    s_ack_ns     = 0;   /* 最近一次观察到 rx_hb_ack 增长的时刻 */
+
+/* ============================ 工具函数 ============================ */
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_stop = 1;
+}
+
+static uint64_t mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int set_nonblock(int fd)
+{
+    const int fl = fcntl(fd, F_GETFL, 0);
+    return (fl < 0) ? -1 : fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+}
+
+/* ============================ 共享内存 ============================ */
+
+static int shm_create(const char* name)
+{
+    shm_unlink(name); /* 上次异常退出残留 */
+    const int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0660);
+    if (fd < 0) {
+        PWMH_LOGE("shm_open %s: %s", name, strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)sizeof(pwmd_shm_t)) != 0) {
+        PWMH_LOGE("ftruncate: %s", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    void* p = mmap(NULL, sizeof(pwmd_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        PWMH_LOGE("mmap: %s", strerror(errno));
+        return -1;
+    }
+    s_shm = (pwmd_shm_t*)p;
+    memset(s_shm, 0, sizeof(*s_shm));
+    s_shm->magic       = PWMD_SHM_MAGIC;
+    s_shm->version     = PWMD_SHM_VERSION;
+    s_shm->size        = (uint32_t)sizeof(pwmd_shm_t);
+    s_shm->max_clients = PWMD_MAX_CLIENTS;
+    atomic_init(&s_shm->state_seq, 0);
+    for (int i = 0; i < PWMD_MAX_CLIENTS; ++i) {
+        atomic_init(&s_shm->ring[i].head, 0);
+        atomic_init(&s_shm->ring[i].tail, 0);
+    }
+    return 0;
+}
+
+/* ============================ 槽位与控制连接 ============================ */
+
+static void slot_free(int i)
+{
+    slot_t* s = &s_slot[i];
+    if (!s->in_use) return;
+    PWMH_LOGI("[CLIENT] slot %d '%s' (pid %u) detached", i, s->name, (unsigned)s->pid);
+    close(s->fd);
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+    if (s_owner == i) s_owner = -1;
+    /* 锁存者断开：急停保持，解除门槛（s_estop_prio）不变，交给同级或更高优先级的客户端 */
+    if (s_estop_slot == i) s_estop_slot = -1;
+}
+
+static void reply(int fd, const char* msg)
+{
+    (void)send(fd, msg, strlen(msg), MSG_NOSIGNAL);
+}
+
+/* 处理一行控制命令；返回 -1 表示关闭连接 */
+static int handle_line(int i, char* line)
+{
+    slot_t* s = &s_slot[i];
+    char    out[LINE_MAX_];
+
+    if (strncmp(line, "HELLO ", 6) == 0) {
+        int  prio = -1;
+        long pid  = 0;
+        char name[PWMD_NAME_MAX] = "";
+        if (s->pid != 0 || sscanf(line + 6, "%d %ld %23s", &prio, &pid, name) != 3 ||
+            prio < PWMD_PRIO_MIN || prio > PWMD_PRIO_MAX) {
+            reply(s->fd, "ERR bad\n");
+            return -1;
+        }
+        s->priority = prio;
+        s->pid      = (uint32_t)pid;
+        snprintf(s->name, sizeof(s->name), "%s", name);
+        /* 环清零后再交给客户端（上一个持有者已断开） */
+        atomic_store(&s_shm->ring[i].tail, 0);
+        atomic_store(&s_shm->ring[i].head, 0);
+        snprintf(out, sizeof(out), "OK %d %s\n", i, s_opt.shm_name);
+        reply(s->fd, out);
+        PWMH_LOGI("[CLIENT] slot %d '%s' (pid %ld) attached, prio %d", i, s->name, pid, prio);
+        return 0;
+    }
+    if (strncmp(line, "PRIO ", 5) == 0) {
+        const int prio = atoi(line + 5);
+        if (s->pid == 0 || prio < PWMD_PRIO_MIN || prio > PWMD_PRIO_MAX) {
+            reply(s->fd, "ERR bad\n");
+            return 0;
+        }
+        /* 只允许调低：否则任意客户端都能抢占仲裁、越过急停解除门槛 */
+        if (prio > s->priority) {
+            PWMH_LOGW("[CLIENT] slot %d '%s' prio raise %d -> %d denied", i, s->name, s->priority, prio);
+            reply(s->fd, "ERR denied\n");
+            return 0;
+        }
+        PWMH_LOGI("[CLIENT] slot %d '%s' prio %d -> %d", i, s->name, s->priority, prio);
+        s->priority = prio;
+        reply(s->fd, "OK\n");
+        return 0;
+    }
+    if (strcmp(line, "STATUS") == 0) {
+        int n = 0;
+        for (int k = 0; k < PWMD_MAX_CLIENTS; ++k) n += (s_slot[k].pid != 0);
+        pwm_ctrl_estop_status_t es;
+        pwm_ctrl_estop_get_status(&es);
+        snprintf(out, sizeof(out), "OK owner=%d clients=%d estop=%d rtt_ms=%.2f\n", s_owner, n,
+                 (int)es.mode, pwm_host_last_rtt_ms());
+        reply(s->fd, out);
+        return 0;
+    }
+    reply(s->fd, "ERR bad\n");
+    return 0;
+}
+
+static void accept_clients(void)
+{
+    for (;;) {
+        const int fd = accept(s_lfd, NULL, NULL);
+        if (fd < 0) return;
+        int i = 0;
+        while (i < PWMD_MAX_CLIENTS && s_slot[i].in_use) ++i;
+        if (i == PWMD_MAX_CLIENTS) {
+            reply(fd, "ERR full\n");
+            close(fd);
+            PWMH_LOGW("[CLIENT] rejected: all %d slots in use", PWMD_MAX_CLIENTS);
+            continue;
+        }
+        set_nonblock(fd);
+        memset(&s_slot[i], 0, sizeof(s_slot[i]));
+        s_slot[i].in_use = 1;
+        s_slot[i].fd     = fd;
+    }
+}
+
+static void service_conn(int i)
+{
+    slot_t* s = &s_slot[i];
+    for (;;) {
+        const ssize_t r = recv(s->fd, s->rbuf + s->rlen, sizeof(s->rbuf) - 1 - s->rlen, 0);
+        if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            slot_free(i);
+            return;
+        }
+        if (r < 0) return;
+        s->rlen += (size_t)r;
+        char* nl;
+        while ((nl = memchr(s->rbuf, '\n', s->rlen)) != NULL) {
+            *nl = '\0';
+            if (nl > s->rbuf && nl[-1] == '\r') nl[-1] = '\0';
+            if (handle_line(i, s->rbuf) != 0) {
+                slot_free(i);
+                return;
+            }
+            const size_t used = (size_t)(nl + 1 - s->rbuf);
+            memmove(s->rbuf, nl + 1, s->rlen - used);
+            s->rlen -= used;
+        }
+        if (s->rlen >= sizeof(s->rbuf) - 1) { /* 超长行 */
+            slot_free(i);
+            return;
+        }
+    }
+}
+
+/* ============================ 控制周期 ============================ */
+
+static void apply_cmd(int i, const pwmd_cmd_t* c, uint64_t now)
+{
+    slot_t* s = &s_slot[i];
+    s->cmds++;
+    s->last_cmd_ns = now;
+    if (c->t_ns && now > c->t_ns && now - c->t_ns > s_lat_max_ns) s_lat_max_ns = now - c->t_ns;
+
+    switch (c->kind) {
+    case PWMD_CMD_TARGET:
+        for (int ch = 0; ch < PWM_HOST_CH_NUM; ++ch) {
+            if (!(c->mask & (1u << ch))) continue;
+            s->target[ch] = c->pct[ch];
+        }
+        if (!s->has_target) {
+            /* 首次提交：未选中的通道为中位 */
+            for (int ch = 0; ch < PWM_HOST_CH_NUM; ++ch)
+                if (!(c->mask & (1u << ch))) s->target[ch] = -1.0f;
+            s->has_target = 1;
+        }
+        break;
+    case PWMD_CMD_KEEPALIVE:
+        break;
+    case PWMD_CMD_ESTOP:
+        if (pwm_ctrl_estop_engage(c->estop_hard ? PWM_CTRL_ESTOP_HARD : PWM_CTRL_ESTOP_SOFT,
+                                  c->seconds) == PWM_CTRL_OK) {
+            /* 再次锁存只能抬高解除门槛：锁存者断开后，低优先级客户端不能借重新急停降低门槛再解除 */
+            if (s_estop_prio < 0 || s->priority > s_estop_prio) {
+                s_estop_slot = i;
+                s_estop_prio = s->priority;
+            }
+            PWMH_LOGW("[ESTOP] %s engaged by slot %d '%s'", c->estop_hard ? "HARD" : "SOFT", i, s->name);
+        }
+        break;
+    case PWMD_CMD_RELEASE:
+        if (s_estop_prio < 0) break;
+        if (s->priority < s_estop_prio) {
+            PWMH_LOGW("[ESTOP] release by slot %d '%s' refused (prio %d < %d)", i, s->name, s->priority,
+                      s_estop_prio);
+            break;
+        }
+        if (pwm_ctrl_estop_release() == PWM_CTRL_OK) {
+            PWMH_LOGI("[ESTOP] released by slot %d '%s'; clients must resubmit targets", i, s->name);
+            s_estop_slot = -1;
+            s_estop_prio = -1;
+            for (int k = 0; k < PWMD_MAX_CLIENTS; ++k) s_slot[k].has_target = 0;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void drain_rings(uint64_t now)
+{
+    for (int i = 0; i < PWMD_MAX_CLIENTS; ++i) {
+        if (!s_slot[i].in_use || s_slot[i].pid == 0) continue;
+        pwmd_ring_t*   r    = &s_shm->ring[i];
+        uint32_t       tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        const uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (head - tail > PWMD_RING_SIZE) { /* 客户端写坏了索引 */
+            PWMH_LOGE("[CLIENT] slot %d ring corrupt, detaching", i);
+            slot_free(i);
+            continue;
+        }
+        while (tail != head) {
+            const pwmd_cmd_t c = r->cmd[tail & (PWMD_RING_SIZE - 1u)];
+            ++tail;
+            apply_cmd(i, &c, now);
+        }
+        atomic_store_explicit(&r->tail, tail, memory_order_release);
+    }
+}
+
+static int slot_live(int i, uint64_t now)
+{
+    const slot_t* s = &s_slot[i];
+    return s->in_use && s->pid != 0 && s->has_target && s->last_cmd_ns != 0 &&
+           now - s->last_cmd_ns <= (uint64_t)s_opt.lease_ms * 1000000u;
+}
+
+static void arbitrate(uint64_t now)
+{
+    int best = -1;
+    for (int i = 0; i < PWMD_MAX_CLIENTS; ++i) {
+        if (!slot_live(i, now)) continue;
+        if (best < 0 || s_slot[i].priority > s_slot[best].priority) best = i;
+    }
+    /* 同级保持现持有者，避免来回抢 */
+    if (best >= 0 && s_owner >= 0 && s_owner != best && slot_live(s_owner, now) &&
+        s_slot[s_owner].priority == s_slot[best].priority)
+        best = s_owner;
+
+    if (best != s_owner) {
+        if (best >= 0)
+            PWMH_LOGI("[ARB] control -> slot %d '%s' (prio %d)", best, s_slot[best].name, s_slot[best].priority);
+        else
+            PWMH_LOGW("[ARB] no live client, targets to mid");
+        s_owner = best;
+    }
+
+    pwm_ctrl_estop_status_t es;
+    pwm_ctrl_estop_get_status(&es);
+    if (es.mode != PWM_CTRL_ESTOP_NONE) return; /* 急停期间目标被拒绝 */
+    if (s_owner >= 0)
+        pwm_ctrl_set_targets_mask(PWM_CH_MASK_ALL, s_slot[s_owner].target);
+    else
+        pwm_ctrl_set_all_target_mid();
+}
+
+static void publish(uint64_t now)
+{
+    pwmd_state_t st;
+    memset(&st, 0, sizeof(st));
+    st.update  = ++s_update;
+    st.t_ns    = now;
+    st.ctrl_hz = s_opt.ctrl_hz;
+
+    pwm_ctrl_state_t cs;
+    pwm_ctrl_get_state(&cs);
+    memcpy(st.current_pct, cs.current_pct, sizeof(st.current_pct));
+    memcpy(st.target_pct, cs.target_pct, sizeof(st.target_pct));
+
+    pwm_ctrl_estop_status_t es;
+    pwm_ctrl_estop_get_status(&es);
+    st.owner          = s_owner;
+    st.estop_mode     = (int)es.mode;
+    st.estop_complete = es.complete;
+    st.estop_slot     = s_estop_slot;
+
+    pwm_host_stats_t hs;
+    pwm_host_get_stats(&hs);
+    st.rtt_ms           = pwm_host_last_rtt_ms();
+    st.dev_status       = hs.dev_status;
+    st.dev_phase_lag_us = hs.dev_phase_lag_us;
+    st.tx_pwm           = hs.tx_pwm;
+    st.tx_hb            = hs.tx_hb;
+    st.rx_hb_ack        = hs.rx_hb_ack;
+    st.tx_err           = hs.tx_err;
+    if (hs.rx_hb_ack != s_acks) {
+        s_acks   = hs.rx_hb_ack;
+        s_ack_ns = now;
+    }
+    st.hb_ack_age_ms = s_ack_ns ? (uint32_t)((now - s_ack_ns) / 1000000ull) : UINT32_MAX;
+    st.cmd_latency_us_max = (uint32_t)(s_lat_max_ns / 1000u);
+
+    for (int i = 0; i < PWMD_MAX_CLIENTS; ++i) {
+        const slot_t* s = &s_slot[i];
+        if (!s->in_use || s->pid == 0) continue;
+        pwmd_client_info_t* ci = &st.clients[i];
+        ci->in_use   = 1;
+        ci->priority = s->priority;
+        ci->live     = slot_live(i, now);
+        ci->pid      = s->pid;
+        ci->cmds     = s->cmds;
+        memcpy(ci->name, s->name, sizeof(ci->name));
+    }
+
+    /* seqlock 写：奇数 → 写 → 偶数 */
+    const uint32_t seq = atomic_load_explicit(&s_shm->state_seq, memory_order_relaxed);
+    atomic_store_explicit(&s_shm->state_seq, seq + 1u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy((void*)&s_shm->state, &st, sizeof(st));
+    atomic_store_explicit(&s_shm->state_seq, seq + 2u, memory_order_release);
+}
+
+/* 每个周期：取指令 → 仲裁 → step → 心跳 / 收包 → 发布 */
+static void control_tick(uint64_t now, uint64_t* next_hb)
+{
+    drain_rings(now);
+    arbitrate(now);
+    pwm_ctrl_step();
+    if (now >= *next_hb) {
+        pwm_host_send_heartbeat();
+        *next_hb = now + (uint64_t)s_opt.hb_ms * 1000000u;
+    }
+    pwm_host_poll(0);
+
+    if (now - s_lat_win_ns >= LAT_WINDOW_NS) {
+        s_lat_win_ns = now;
+        s_lat_max_ns = 0;
+    }
+    publish(now);
+}
+
+/* ============================ 主程序 ============================ */
+
+static void usage(const char* argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-i IP] [-p PORT] [-r HZ] [-b HB_MS] [-l LEASE_MS] [-S MAX_STEP_PCT]\n"
+            "          [-s SOCK] [-m SHM] [-n] [-x] [-T seconds]\n",
+            argv0);
+}
+
+static int open_listen(const char* path)
+{
+    struct sockaddr_un sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(sa.sun_path)) return -1;
+    strcpy(sa.sun_path, path);
+    unlink(path);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (const struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(fd, PWMD_MAX_CLIENTS) != 0) {
+        close(fd);
+        return -1;
+    }
+    chmod(path, 0660);
+    set_nonblock(fd);
+    return fd;
+}
+
+int main(int argc, char** argv)
+{
+    s_opt.ip        = NULL;
+    s_opt.port      = 0;
+    s_opt.ctrl_hz   = 50.0;
+    s_opt.hb_ms     = 100;
+    s_opt.lease_ms  = 200;
+    s_opt.max_step  = 0.2f;
+    s_opt.sock_path = PWMD_DEFAULT_SOCK;
+    s_opt.shm_name  = PWMD_DEFAULT_SHM;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:p:r:b:l:S:s:m:nxT:h")) != -1) {
+        switch (opt) {
+        case 'i': s_opt.ip        = optarg; break;
+        case 'p': s_opt.port      = (uint16_t)atoi(optarg); break;
+        case 'r': s_opt.ctrl_hz   = atof(optarg); break;
+        case 'b': s_opt.hb_ms     = atoi(optarg); break;
+        case 'l': s_opt.lease_ms  = atoi(optarg); break;
+        case 'S': s_opt.max_step  = (float)atof(optarg); break;
+        case 's': s_opt.sock_path = optarg; break;
+        case 'm': s_opt.shm_name  = optarg; break;
+        case 'n': s_opt.nonblock  = 1; break;
+        case 'x': s_opt.sim       = 1; break;
+        case 'T': s_opt.run_s     = atof(optarg); break;
+        default:  usage(argv[0]); return 2;
+        }
+    }
+    if (s_opt.ctrl_hz <= 0.0 || s_opt.ctrl_hz > 1000.0 || s_opt.hb_ms <= 0 || s_opt.lease_ms <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    for (int i = 0; i < PWMD_MAX_CLIENTS; ++i) s_slot[i].fd = -1;
+
+    pwm_host_config_t hc;
+    pwm_host_default_config(&hc);
+    if (s_opt.ip) hc.stm32_ip = s_opt.ip;
+    if (s_opt.port) hc.stm32_port = s_opt.port;
+    hc.send_hz       = (int)s_opt.ctrl_hz;
+    hc.nonblock_send = s_opt.nonblock;
+    const pwmh_result_t rc = s_opt.sim ? pwm_host_sim_open(NULL, &hc) : pwm_host_init(&hc);
+    if (rc != PWMH_OK) {
+        PWMH_LOGE("link init: %s", pwm_host_strerror(rc));
+        return 1;
+    }
+    pwmh_log_start(NULL); /* 链路（及仿真虚拟时钟）就绪后再启动，日志时间戳与控制周期同一时基 */
+
+    pwm_ctrl_config_t cc;
+    memset(&cc, 0, sizeof(cc));
+    cc.ctrl_hz      = (float)s_opt.ctrl_hz;
+    cc.max_step_pct = s_opt.max_step;
+    cc.enable_reverse_protection = 1;
+    if (pwm_ctrl_init(&cc) != PWM_CTRL_OK || shm_create(s_opt.shm_name) != 0) {
+        PWMH_LOGE("control / shm init failed");
+        s_opt.sim ? pwm_host_sim_close() : pwm_host_close();
+        pwmh_log_stop();
+        return 1;
+    }
+    s_lfd = open_listen(s_opt.sock_path);
+    if (s_lfd < 0) {
+        PWMH_LOGE("listen %s: %s", s_opt.sock_path, strerror(errno));
+        shm_unlink(s_opt.shm_name);
+        s_opt.sim ? pwm_host_sim_close() : pwm_host_close();
+        pwmh_log_stop();
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    PWMH_LOGI("pwm_daemon up: %s, %.0f Hz, lease %d ms, sock %s, shm %s",
+              s_opt.sim ? "sim endpoint" : (hc.stm32_ip ? hc.stm32_ip : "default"), s_opt.ctrl_hz,
+              s_opt.lease_ms, s_opt.sock_path, s_opt.shm_name);
+
+    const uint64_t period  = (uint64_t)(1e9 / s_opt.ctrl_hz);
+    const uint64_t t0      = mono_ns();
+    const uint64_t end_ns  = (s_opt.run_s > 0.0) ? t0 + (uint64_t)(s_opt.run_s * 1e9) : UINT64_MAX;
+    uint64_t       next    = t0;
+    uint64_t       next_hb = t0;
+    uint64_t       last    = t0;
+    uint64_t       stop_deadline = 0;
+
+    for (;;) {
+        uint64_t now = mono_ns();
+        if (!stop_deadline && (g_stop || now >= end_ns)) {
+            /* 退出前软急停回中位 */
+            PWMH_LOGI("stopping: soft e-stop to mid");
+            pwm_ctrl_estop_engage(PWM_CTRL_ESTOP_SOFT, 1.0f);
+            stop_deadline = now + (uint64_t)(STOP_TIMEOUT_S * 1e9);
+        }
+        if (now >= next) {
+            if (s_opt.sim) pwm_host_vclock_advance_ns(now - last); /* 仿真端虚拟时钟随实时推进 */
+            last = now;
+            control_tick(now, &next_hb);
+            next += period;
+            if (next <= now) next = now + period; /* 严重超期：放弃追赶，避免突发 */
+            if (stop_deadline) {
+                pwm_ctrl_estop_status_t es;
+                pwm_ctrl_estop_get_status(&es);
+                if (es.complete || now >= stop_deadline) break;
+            }
+        }
+
+        /* 等到下一个周期或控制连接有数据 */
+        struct pollfd pfd[1 + PWMD_MAX_CLIENTS];
+        int           idx[1 + PWMD_MAX_CLIENTS];
+        nfds_t        n = 0;
+        pfd[n].fd = s_lfd;
+        pfd[n].events = POLLIN;
+        idx[n++] = -1;
+        for (int i = 0; i < PWMD_MAX_CLIENTS; ++i) {
+            if (!s_slot[i].in_use) continue;
+            pfd[n].fd = s_slot[i].fd;
+            pfd[n].events = POLLIN;
+            idx[n++] = i;
+        }
+        now = mono_ns();
+        const int wait_ms = (next > now) ? (int)((next - now + 999999u) / 1000000u) : 0;
+        const int r = poll(pfd, n, wait_ms);
+        if (r <= 0) continue;
+        for (nfds_t k = 0; k < n; ++k) {
+            if (!pfd[k].revents) continue;
+            if (idx[k] < 0) accept_clients();
+            else if (s_slot[idx[k]].in_use && s_slot[idx[k]].fd == pfd[k].fd) service_conn(idx[k]);
+        }
+    }
+
+    for (int i = 0; i < PWMD_MAX_CLIENTS; ++i) slot_free(i);
+    close(s_lfd);
+    unlink(s_opt.sock_path);
+    munmap(s_shm, sizeof(*s_shm));
+    shm_unlink(s_opt.shm_name);
+
+    pwm_host_stats_t hs;
+    pwm_host_get_stats(&hs);
+    PWMH_LOGI("ticks=%llu tx_pwm=%llu tx_hb=%llu rx_hb_ack=%llu tx_err=%llu"
+              " rx_ovfl=%llu rxq_peak=%u txq_peak=%u",
+              (unsigned long long)s_update, (unsigned long long)hs.tx_pwm, (unsigned long long)hs.tx_hb,
+              (unsigned long long)hs.rx_hb_ack, (unsigned long long)hs.tx_err,
+              (unsigned long long)hs.rx_overflow, hs.rxq_peak, hs.txq_peak);
+    pwm_ctrl_deinit();
+    s_opt.sim ? pwm_host_sim_close() : pwm_host_close();
+    pwmh_log_stop();
+    return 0;
+}
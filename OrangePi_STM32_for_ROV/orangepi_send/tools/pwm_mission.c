@@ -0,0 +1,311 @@
+/**
+ * @file    pwm_mission.c
+ * @brief   轨迹 / 任务文件工具：文本脚本 → 二进制设定值文件，查看与回放（pwm_player.h）
+ *
+ * 用法：
+ *   pwm_mission compile SCRIPT OUT.pwmt
+ *   pwm_mission info    FILE.pwmt
+ *   pwm_mission play    FILE.pwmt [-i IP] [-p PORT] [-x] [-r HZ] [-S MAX_STEP_PCT]
+ *                       [-B BLEND_IN_S] [-A ALLOC] [-H] [-k ACK_MS]
+ *
+ *   -x  不连设备：进程内 STM32 仿真端点 + 虚拟时钟（整段任务毫秒级跑完）
+ *   -A  WRENCH6 文件的推力分配矩阵：8 行 × 6 列（CH1..CH8 × Fx Fy Fz Mx My Mz）
+ *   -H  中止时硬急停（默认软急停 1 秒归中）
+ *   -k  超过 ACK_MS 未收到 HB_ACK 即中止
+ *   Ctrl-C 中止回放并急停归中。
+ *
+ * 脚本（每行一条记录，'#' 起注释）：
+ *
+ *      kind pct8                       # 或 kind wrench6（须在第一条记录之前）
+ *      # t_s   CH1 .. CH8 (%)          [lerp] [tag=N] [abort]
+ *      0.0     -   -   -   -   -   -   -   -          # '-' 或负值 = 中位
+ *      4.0     9.5 -   -   -   -   -   -   -   tag=1
+ *      6.0     -   -   -   -   -   -   -   -   lerp   # 6s→下一条之间线性插值
+ *
+ *   wrench6 每行 6 个值（Fx Fy Fz Mx My Mz）。时间须单调不减。
+ */
+
+#include "pwm_control.h"
+#include "pwm_host_sim.h"
+#include "pwm_player.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ============================ 内部常量 ============================ */
+
+#define LINE_MAX_ 512
+
+static volatile int g_stop = 0;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_stop = 1;
+}
+
+/* ============================ compile ============================ */
+
+static int parse_record(char* line, int nvals, pwm_player_rec_t* r)
+{
+    memset(r, 0, sizeof(*r));
+    char* save = NULL;
+    char* tok  = strtok_r(line, " \t\r\n", &save);
+    if (!tok) return 0;
+    char*        end;
+    const double t = strtod(tok, &end);
+    if (*end || t < 0.0) return -1;
+    r->t_ns = (uint64_t)(t * 1e9 + 0.5);
+
+    for (int i = 0; i < PWM_HOST_CH_NUM; ++i) r->v[i] = (nvals == PWM_HOST_CH_NUM) ? -1.0f : 0.0f;
+    for (int i = 0; i < nvals; ++i) {
+        tok = strtok_r(NULL, " \t\r\n", &save);
+        if (!tok) return -1;
+        if (strcmp(tok, "-") == 0) continue;
+        r->v[i] = strtof(tok, &end);
+        if (*end) return -1;
+    }
+    while ((tok = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+        if (strcmp(tok, "lerp") == 0)            r->flags |= PWM_PLAYER_REC_LERP;
+        else if (strcmp(tok, "abort") == 0)      r->flags |= PWM_PLAYER_REC_ABORT;
+        else if (strncmp(tok, "tag=", 4) == 0)   r->tag = (uint16_t)atoi(tok + 4);
+        else return -1;
+    }
+    return 1;
+}
+
+static int cmd_compile(const char* in_path, const char* out_path)
+{
+    FILE* in = fopen(in_path, "r");
+    if (!in) {
+        fprintf(stderr, "[ERR] %s: %s\n", in_path, strerror(errno));
+        return 1;
+    }
+    FILE* out = fopen(out_path, "wb");
+    if (!out) {
+        fprintf(stderr, "[ERR] %s: %s\n", out_path, strerror(errno));
+        fclose(in);
+        return 1;
+    }
+
+    pwm_player_file_hdr_t h;
+    memset(&h, 0, sizeof(h));
+    h.magic    = PWM_PLAYER_MAGIC;
+    h.version  = PWM_PLAYER_VERSION;
+    h.kind     = PWM_PLAYER_KIND_PCT8;
+    h.rec_size = (uint32_t)sizeof(pwm_player_rec_t);
+    fwrite(&h, sizeof(h), 1, out); /* 占位，结束后回填 count / duration */
+
+    char     line[LINE_MAX_];
+    int      lineno = 0;
+    int      rc     = 0;
+    uint64_t last_t = 0;
+    while (fgets(line, sizeof(line), in)) {
+        ++lineno;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char kind[16];
+        if (sscanf(line, " kind %15s", kind) == 1) {
+            if (h.count) {
+                fprintf(stderr, "[ERR] %s:%d: 'kind' must precede records\n", in_path, lineno);
+                rc = 1;
+                break;
+            }
+            if (strcmp(kind, "pct8") == 0)         h.kind = PWM_PLAYER_KIND_PCT8;
+            else if (strcmp(kind, "wrench6") == 0) h.kind = PWM_PLAYER_KIND_WRENCH6;
+            else {
+                fprintf(stderr, "[ERR] %s:%d: unknown kind '%s'\n", in_path, lineno, kind);
+                rc = 1;
+                break;
+            }
+            continue;
+        }
+        pwm_player_rec_t r;
+        const int        pr = parse_record(line, h.kind == PWM_PLAYER_KIND_PCT8 ? PWM_HOST_CH_NUM : 6, &r);
+        if (pr == 0) continue;
+        if (pr < 0 || r.t_ns < last_t) {
+            fprintf(stderr, "[ERR] %s:%d: %s\n", in_path, lineno,
+                    pr < 0 ? "bad record" : "time goes backwards");
+            rc = 1;
+            break;
+        }
+        fwrite(&r, sizeof(r), 1, out);
+        last_t = r.t_ns;
+        h.count++;
+    }
+    if (rc == 0 && h.count == 0) {
+        fprintf(stderr, "[ERR] %s: no records\n", in_path);
+        rc = 1;
+    }
+    h.duration_ns = last_t;
+    if (rc == 0 && (fseek(out, 0, SEEK_SET) != 0 || fwrite(&h, sizeof(h), 1, out) != 1)) rc = 1;
+    fclose(in);
+    if (fclose(out) != 0) rc = 1;
+    if (rc != 0) {
+        remove(out_path);
+        return 1;
+    }
+    printf("[INFO] %s: %llu records, %.3f s, kind %s\n", out_path, (unsigned long long)h.count,
+           (double)h.duration_ns / 1e9, h.kind == PWM_PLAYER_KIND_PCT8 ? "pct8" : "wrench6");
+    return 0;
+}
+
+/* ============================ info / play ============================ */
+
+static int load_alloc(const char* path, pwm_player_config_t* cfg)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "[ERR] %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    for (int ch = 0; ch < PWM_HOST_CH_NUM; ++ch)
+        for (int k = 0; k < 6; ++k)
+            if (fscanf(f, "%f", &cfg->alloc[ch][k]) != 1) {
+                fprintf(stderr, "[ERR] %s: need 8 x 6 numbers\n", path);
+                fclose(f);
+                return -1;
+            }
+    fclose(f);
+    return 0;
+}
+
+static void print_info(const pwm_player_info_t* in)
+{
+    printf("[INFO] kind=%s records=%llu duration=%.3f s\n", in->kind == PWM_PLAYER_KIND_PCT8 ? "pct8" : "wrench6",
+           (unsigned long long)in->count, (double)in->duration_ns / 1e9);
+}
+
+static int cmd_info(const char* path)
+{
+    pwm_player_config_t cfg;
+    pwm_player_default_config(&cfg);
+    cfg.alloc[0][0] = 1.0f; /* 只看文件头：WRENCH6 也允许打开 */
+    pwm_player_t*       p;
+    const pwmh_result_t rc = pwm_player_open(path, &cfg, &p);
+    if (rc != PWMH_OK) {
+        fprintf(stderr, "[ERR] %s: %s\n", path, pwm_host_strerror(rc));
+        return 1;
+    }
+    pwm_player_info_t in;
+    pwm_player_get_info(p, &in);
+    print_info(&in);
+    pwm_player_close(p);
+    return 0;
+}
+
+static void usage(const char* argv0)
+{
+    fprintf(stderr,
+            "usage: %s compile SCRIPT OUT.pwmt\n"
+            "       %s info FILE.pwmt\n"
+            "       %s play FILE.pwmt [-i IP] [-p PORT] [-x] [-r HZ] [-S MAX_STEP_PCT]\n"
+            "                          [-B BLEND_IN_S] [-A ALLOC] [-H] [-k ACK_MS]\n",
+            argv0, argv0, argv0);
+}
+
+static int cmd_play(int argc, char** argv, const char* argv0)
+{
+    const char* path     = argv[1];
+    const char* ip       = NULL;
+    const char* alloc    = NULL;
+    int         port     = 0;
+    int         sim      = 0;
+    float       max_step = 0.2f;
+
+    pwm_player_config_t cfg;
+    pwm_player_default_config(&cfg);
+
+    optind = 2;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:p:xr:S:B:A:Hk:h")) != -1) {
+        switch (opt) {
+        case 'i': ip  = optarg; break;
+        case 'p': port = atoi(optarg); break;
+        case 'x': sim = 1; break;
+        case 'r': cfg.ctrl_hz = atof(optarg); break;
+        case 'S': max_step = (float)atof(optarg); break;
+        case 'B': cfg.blend_in_s = (float)atof(optarg); break;
+        case 'A': alloc = optarg; break;
+        case 'H': cfg.abort_hard = 1; break;
+        case 'k': cfg.abort_on_ack_ms = (uint32_t)atoi(optarg); break;
+        default:  usage(argv0); return 2;
+        }
+    }
+    if (cfg.ctrl_hz <= 0.0 || cfg.ctrl_hz > 1000.0) {
+        usage(argv0);
+        return 2;
+    }
+    if (alloc && load_alloc(alloc, &cfg) != 0) return 1;
+
+    /* 打开任务文件在先：格式错误时不触碰链路 */
+    pwm_player_t* p;
+    pwmh_result_t rc = pwm_player_open(path, &cfg, &p);
+    if (rc != PWMH_OK) {
+        fprintf(stderr, "[ERR] %s: %s%s\n", path, pwm_host_strerror(rc),
+                rc == PWMH_EINVAL ? " (bad file, or wrench6 without -A)" : "");
+        return 1;
+    }
+    pwm_player_info_t in;
+    pwm_player_get_info(p, &in);
+    print_info(&in);
+
+    pwm_host_config_t hc;
+    pwm_host_default_config(&hc);
+    if (ip) hc.stm32_ip = ip;
+    if (port) hc.stm32_port = (uint16_t)port;
+    hc.send_hz = (int)cfg.ctrl_hz;
+    rc = sim ? pwm_host_sim_open(NULL, &hc) : pwm_host_init(&hc);
+    if (rc != PWMH_OK) {
+        fprintf(stderr, "[ERR] link init: %s\n", pwm_host_strerror(rc));
+        pwm_player_close(p);
+        return 1;
+    }
+    pwm_ctrl_config_t cc;
+    memset(&cc, 0, sizeof(cc));
+    cc.ctrl_hz      = (float)cfg.ctrl_hz;
+    cc.max_step_pct = max_step;
+    cc.enable_reverse_protection = 1;
+    pwm_ctrl_init(&cc);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    const pwm_player_status_t st = pwm_player_run(p, 100, &g_stop);
+    pwm_player_get_info(p, &in);
+
+    pwm_ctrl_state_t cs;
+    pwm_ctrl_get_state(&cs);
+    pwm_host_stats_t hs;
+    pwm_host_get_stats(&hs);
+    printf("[%s] t=%.3f s record=%llu/%llu ticks=%llu late=%llu saturated=%llu%s%s\n",
+           st == PWM_PLAYER_DONE ? "DONE" : "ABORTED", (double)in.t_ns / 1e9,
+           (unsigned long long)in.index + 1, (unsigned long long)in.count, (unsigned long long)in.ticks,
+           (unsigned long long)in.late_ticks, (unsigned long long)in.saturated,
+           in.abort_reason ? " reason=" : "", in.abort_reason ? in.abort_reason : "");
+    printf("[STAT] tx_pwm=%llu tx_hb=%llu rx_hb_ack=%llu tx_err=%llu ch1=%.2f%%\n",
+           (unsigned long long)hs.tx_pwm, (unsigned long long)hs.tx_hb, (unsigned long long)hs.rx_hb_ack,
+           (unsigned long long)hs.tx_err, (double)cs.current_pct[0]);
+
+    pwm_player_close(p);
+    pwm_ctrl_deinit();
+    if (sim) pwm_host_sim_close();
+    else     pwm_host_close();
+    return st == PWM_PLAYER_DONE ? 0 : 3;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 4 && strcmp(argv[1], "compile") == 0) return cmd_compile(argv[2], argv[3]);
+    if (argc >= 3 && strcmp(argv[1], "info") == 0) return cmd_info(argv[2]);
+    if (argc >= 3 && strcmp(argv[1], "play") == 0) return cmd_play(argc - 1, argv + 1, argv[0]);
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,587 @@
+/**
+ * @file    tlog_decode.c
+ * @brief   STM32 令牌化日志（Tlog）主机端解码器
+ *
+ * 固件 TLOG_x 只发送“格式串地址 + 原始参数字节”，格式串留在 .axf 里。本工具：
+ *   1) 构建后从 .axf / .elf 抽取格式串表（ID = 地址）；
+ *   2) 读取调试串口字节流（或抓包文件），按表格式化输出。
+ *
+ * 用法：
+ *   pwm_tlog_decode -x receive_pwm_stm32.axf [-o fw.tlog]      抽取格式串表（构建后执行一次）
+ *   pwm_tlog_decode -t fw.tlog -d /dev/ttyUSB0 [-b 115200]      解码串口
+ *   pwm_tlog_decode -e receive_pwm_stm32.axf -i capture.bin     直接用 .axf 解码文件（- 为 stdin）
+ *
+ * 抽取规则：名为 .tlog_fmt 的段（GCC 保留段名）中的全部字符串，以及符号表中
+ *   以 tlog_fmt_ 开头的数据符号（armlink 合并段后仍保留局部符号）。
+ *
+ * 记录格式（小端，与 Source/Src/Tlog.c 一致）：
+ *   A5 | LEN | LVL(bit1..0)+SEQ(bit7..2) | ID u32 | TS_ms u32 | 参数 LEN 字节 | CRC-8(0x07，覆盖 LEN..参数)
+ *   同一串口上的 VOFA+ JustFloat 帧与 printf 文本按“同步失败”跳过；
+ *   已加载格式串表时，ID 不在表中的候选记录也视为噪声。
+ *
+ * 输出：每条记录一行 "秒 级别 消息"；SEQ 不连续时提示固件端丢弃条数；退出时统计到 stderr。
+ */
+
+#define _DEFAULT_SOURCE /* cfmakeraw */
+
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* ============================ 内部常量 ============================ */
+
+#define REC_SYNC      0xA5u
+#define REC_HDR       11u     /* SYNC LEN LVL|SEQ ID TS */
+#define REC_ARG_MAX   48u     /* 与固件 TLOG_MAX_ARG_BYTES 一致 */
+#define REC_MAX       (REC_HDR + REC_ARG_MAX + 1u)
+#define TABLE_MAX     4096
+#define FMT_MAX       256
+
+static const char k_lvl_char[4] = { 'E', 'W', 'I', 'D' };
+
+/* ============================ 数据结构 ============================ */
+
+typedef struct {
+    uint32_t id;
+    char     fmt[FMT_MAX];
+} fmt_entry_t;
+
+typedef struct {
+    unsigned long long records;
+    unsigned long long crc_err;
+    unsigned long long noise;    /* 非记录字节（VOFA+ 帧 / 文本 / 噪声） */
+    unsigned long long lost;     /* 按 SEQ 推算的固件端丢弃条数 */
+    unsigned long long unknown;  /* 未加载表时无法解析的 ID */
+} dec_stats_t;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static fmt_entry_t s_table[TABLE_MAX];
+static int         s_table_n = 0;
+static dec_stats_t s_st;
+static int         s_last_seq = -1;
+
+/* ============================ 工具函数 ============================ */
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_stop = 1;
+}
+
+static uint32_t le32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint8_t crc8(const uint8_t* p, size_t n)
+{
+    uint8_t c = 0;
+    while (n--) {
+        c ^= *p++;
+        for (int i = 0; i < 8; ++i) c = (uint8_t)((c & 0x80u) ? ((unsigned)(c << 1) ^ 0x07u) : (unsigned)(c << 1));
+    }
+    return c;
+}
+
+static const fmt_entry_t* table_find(uint32_t id)
+{
+    for (int i = 0; i < s_table_n; ++i)
+        if (s_table[i].id == id) return &s_table[i];
+    return NULL;
+}
+
+static void table_add(uint32_t id, const char* fmt, size_t len)
+{
+    if (len == 0 || table_find(id) || s_table_n >= TABLE_MAX) return;
+    fmt_entry_t* e = &s_table[s_table_n++];
+    e->id = id;
+    if (len >= FMT_MAX) len = FMT_MAX - 1;
+    memcpy(e->fmt, fmt, len);
+    e->fmt[len] = '\0';
+}
+
+/* ============================ ELF 抽取 ============================ */
+
+typedef struct {
+    uint64_t addr, off, size;
+    uint32_t type;
+    const char* name;
+} sec_t;
+
+/* 读取整个文件 */
+static uint8_t* read_file(const char* path, size_t* out_len)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "[ERR] open %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    const long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* buf = (n > 0) ? (uint8_t*)malloc((size_t)n) : NULL;
+    if (!buf || fread(buf, 1, (size_t)n, f) != (size_t)n) {
+        fprintf(stderr, "[ERR] read %s\n", path);
+        free(buf);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+    *out_len = (size_t)n;
+    return buf;
+}
+
+/* 地址 → 文件内字符串（所在 PROGBITS 段内，最长到段尾） */
+static const char* addr_to_str(const sec_t* secs, int nsec, const uint8_t* img, size_t img_len,
+                               uint64_t addr, size_t* len)
+{
+    for (int i = 0; i < nsec; ++i) {
+        const sec_t* s = &secs[i];
+        if (s->type != SHT_PROGBITS || addr < s->addr || addr >= s->addr + s->size) continue;
+        const uint64_t off = s->off + (addr - s->addr);
+        const uint64_t end = s->off + s->size;
+        if (end > img_len) return NULL;
+        const char* p = (const char*)img + off;
+        const void* z = memchr(p, 0, (size_t)(end - off));
+        if (!z) return NULL;
+        *len = (size_t)((const char*)z - p);
+        return p;
+    }
+    return NULL;
+}
+
+/* 解析 ELF32 / ELF64（小端），把格式串加入表；返回新增条数，失败 -1 */
+static int load_elf(const char* path)
+{
+    size_t len = 0;
+    uint8_t* img = read_file(path, &len);
+    if (!img) return -1;
+    if (len < EI_NIDENT || memcmp(img, ELFMAG, SELFMAG) != 0 || img[EI_DATA] != ELFDATA2LSB) {
+        fprintf(stderr, "[ERR] %s: not a little-endian ELF\n", path);
+        free(img);
+        return -1;
+    }
+    const int is64 = (img[EI_CLASS] == ELFCLASS64);
+
+    uint64_t shoff;
+    unsigned shnum, shentsize, shstrndx;
+    if (is64) {
+        const Elf64_Ehdr* eh = (const Elf64_Ehdr*)img;
+        shoff = eh->e_shoff; shnum = eh->e_shnum; shentsize = eh->e_shentsize; shstrndx = eh->e_shstrndx;
+    } else {
+        const Elf32_Ehdr* eh = (const Elf32_Ehdr*)img;
+        shoff = eh->e_shoff; shnum = eh->e_shnum; shentsize = eh->e_shentsize; shstrndx = eh->e_shstrndx;
+    }
+    if (shnum == 0 || shoff + (uint64_t)shnum * shentsize > len || shstrndx >= shnum) {
+        fprintf(stderr, "[ERR] %s: bad section table\n", path);
+        free(img);
+        return -1;
+    }
+
+    sec_t* secs = (sec_t*)calloc(shnum, sizeof(sec_t));
+    uint32_t* links = (uint32_t*)calloc(shnum, sizeof(uint32_t));
+    uint64_t* entsz = (uint64_t*)calloc(shnum, sizeof(uint64_t));
+    uint32_t* names = (uint32_t*)calloc(shnum, sizeof(uint32_t));
+    for (unsigned i = 0; i < shnum; ++i) {
+        const uint8_t* sh = img + shoff + (uint64_t)i * shentsize;
+        if (is64) {
+            const Elf64_Shdr* s = (const Elf64_Shdr*)sh;
+            secs[i] = (sec_t){ s->sh_addr, s->sh_offset, s->sh_size, s->sh_type, NULL };
+            links[i] = s->sh_link; entsz[i] = s->sh_entsize; names[i] = s->sh_name;
+        } else {
+            const Elf32_Shdr* s = (const Elf32_Shdr*)sh;
+            secs[i] = (sec_t){ s->sh_addr, s->sh_offset, s->sh_size, s->sh_type, NULL };
+            links[i] = s->sh_link; entsz[i] = s->sh_entsize; names[i] = s->sh_name;
+        }
+    }
+    const sec_t* strsec = &secs[shstrndx];
+    for (unsigned i = 0; i < shnum; ++i)
+        secs[i].name = (strsec->off + names[i] < len) ? (const char*)img + strsec->off + names[i] : "";
+
+    const int before = s_table_n;
+
+    /* 1) .tlog_fmt 段：逐个字符串（跳过对齐填充） */
+    for (unsigned i = 0; i < shnum; ++i) {
+        if (strcmp(secs[i].name, ".tlog_fmt") != 0 || secs[i].type != SHT_PROGBITS) continue;
+        if (secs[i].off + secs[i].size > len) continue;
+        for (uint64_t o = 0; o < secs[i].size;) {
+            const char* p = (const char*)img + secs[i].off + o;
+            const size_t n = strnlen(p, (size_t)(secs[i].size - o));
+            if (n > 0) table_add((uint32_t)(secs[i].addr + o), p, n);
+            o += n + 1;
+        }
+    }
+
+    /* 2) 符号表：tlog_fmt_* 数据符号 */
+    for (unsigned i = 0; i < shnum; ++i) {
+        if (secs[i].type != SHT_SYMTAB || links[i] >= shnum || entsz[i] == 0) continue;
+        const sec_t* strtab = &secs[links[i]];
+        const uint64_t nsym = secs[i].size / entsz[i];
+        for (uint64_t k = 0; k < nsym; ++k) {
+            const uint8_t* se = img + secs[i].off + k * entsz[i];
+            if ((size_t)(se - img) + entsz[i] > len) break;
+            uint32_t nm;
+            uint64_t val;
+            if (is64) {
+                const Elf64_Sym* s = (const Elf64_Sym*)se;
+                nm = s->st_name; val = s->st_value;
+            } else {
+                const Elf32_Sym* s = (const Elf32_Sym*)se;
+                nm = s->st_name; val = s->st_value;
+            }
+            if (strtab->off + nm >= len) continue;
+            const char* name = (const char*)img + strtab->off + nm;
+            if (strncmp(name, "tlog_fmt_", 9) != 0) continue;
+            size_t n = 0;
+            const char* p = addr_to_str(secs, (int)shnum, img, len, val, &n);
+            if (p) table_add((uint32_t)val, p, n);
+        }
+    }
+
+    free(names);
+    free(entsz);
+    free(links);
+    free(secs);
+    free(img);
+    return s_table_n - before;
+}
+
+/* ============================ 表文件 ============================ */
+
+/* 每行 "0xID<TAB>C 转义格式串" */
+static void write_table(FILE* out)
+{
+    for (int i = 0; i < s_table_n; ++i) {
+        fprintf(out, "0x%08x\t", s_table[i].id);
+        for (const char* p = s_table[i].fmt; *p; ++p) {
+            switch (*p) {
+            case '\\': fputs("\\\\", out); break;
+            case '\n': fputs("\\n", out); break;
+            case '\r': fputs("\\r", out); break;
+            case '\t': fputs("\\t", out); break;
+            default:   fputc(*p, out); break;
+            }
+        }
+        fputc('\n', out);
+    }
+}
+
+static int load_table(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "[ERR] open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    char line[FMT_MAX * 2 + 32];
+    while (fgets(line, sizeof(line), f)) {
+        char* tab = strchr(line, '\t');
+        if (line[0] == '#' || !tab) continue;
+        const uint32_t id = (uint32_t)strtoul(line, NULL, 0);
+        char fmt[FMT_MAX];
+        size_t n = 0;
+        for (const char* p = tab + 1; *p && *p != '\n' && n + 1 < sizeof(fmt); ++p) {
+            if (*p == '\\' && p[1]) {
+                ++p;
+                fmt[n++] = (*p == 'n') ? '\n' : (*p == 'r') ? '\r' : (*p == 't') ? '\t' : *p;
+            } else {
+                fmt[n++] = *p;
+            }
+        }
+        table_add(id, fmt, n);
+    }
+    fclose(f);
+    return 0;
+}
+
+/* ============================ 记录格式化 ============================ */
+
+/* 按格式串消费参数字节，输出到 out；参数不足时以 <?> 结尾 */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+static void render(const char* fmt, const uint8_t* a, size_t na, char* out, size_t cap)
+{
+    size_t o = 0, ai = 0;
+#define PUT(...)                                                        \
+    do {                                                                \
+        int w_ = snprintf(out + o, cap - o, __VA_ARGS__);               \
+        if (w_ > 0) o = ((size_t)w_ < cap - o) ? o + (size_t)w_ : cap - 1; \
+    } while (0)
+
+    for (const char* p = fmt; *p && o + 1 < cap; ++p) {
+        if (*p != '%') {
+            out[o++] = *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[o++] = '%';
+            ++p;
+            continue;
+        }
+        /* 复制标志 / 宽度 / 精度，去掉长度修饰（线上宽度由转换符与 ll 决定） */
+        char spec[32] = "%";
+        size_t sn = 1;
+        ++p;
+        while (*p && strchr("-+ #0123456789.", *p) && sn < sizeof(spec) - 4) spec[sn++] = *p++;
+        int ll = 0;
+        while (*p && strchr("hlLqjzt", *p)) {
+            if (p[0] == 'l' && p[1] == 'l') { ll = 1; ++p; }
+            ++p;
+        }
+        if (!*p) break;
+        const char conv = *p;
+
+        if (strchr("diuxXoc", conv)) {
+            const size_t w = ll ? 8 : 4;
+            if (ai + w > na) { PUT("<?>"); break; }
+            if (ll) {
+                spec[sn++] = 'l'; spec[sn++] = 'l'; spec[sn++] = conv; spec[sn] = '\0';
+                const uint64_t v = (uint64_t)le32(a + ai) | ((uint64_t)le32(a + ai + 4) << 32);
+                if (conv == 'd' || conv == 'i') PUT(spec, (long long)v);
+                else                            PUT(spec, (unsigned long long)v);
+            } else {
+                spec[sn++] = conv; spec[sn] = '\0';
+                const uint32_t v = le32(a + ai);
+                if (conv == 'd' || conv == 'i') PUT(spec, (int)(int32_t)v);
+                else                            PUT(spec, (unsigned)v);
+            }
+            ai += w;
+        } else if (conv == 'p') {
+            if (ai + 4 > na) { PUT("<?>"); break; }
+            PUT("0x%08x", (unsigned)le32(a + ai));
+            ai += 4;
+        } else if (strchr("fFeEgGaA", conv)) {
+            if (ai + 4 > na) { PUT("<?>"); break; }
+            spec[sn++] = conv; spec[sn] = '\0';
+            float f;
+            memcpy(&f, a + ai, 4);
+            PUT(spec, (double)f);
+            ai += 4;
+        } else if (conv == 's') {
+            if (ai + 1 > na || ai + 1 + a[ai] > na) { PUT("<?>"); break; }
+            char s[REC_ARG_MAX + 1];
+            const size_t sl = a[ai];
+            memcpy(s, a + ai + 1, sl);
+            s[sl] = '\0';
+            spec[sn++] = 's'; spec[sn] = '\0';
+            PUT(spec, s);
+            ai += 1 + sl;
+        } else {
+            PUT("<%%%c?>", conv);
+            break;
+        }
+    }
+#undef PUT
+    out[o < cap ? o : cap - 1] = '\0';
+}
+#pragma GCC diagnostic pop
+
+static void emit_record(const uint8_t* r)
+{
+    const uint8_t  n   = r[1];
+    const uint8_t  lvl = r[2] & 0x03u;
+    const int      seq = r[2] >> 2;
+    const uint32_t id  = le32(r + 3);
+    const uint32_t ts  = le32(r + 7);
+
+    if (s_last_seq >= 0) {
+        const int gap = (seq - s_last_seq - 1) & 0x3F;
+        if (gap) {
+            s_st.lost += (unsigned long long)gap;
+            printf("%10s   # %d record(s) dropped on target\n", "", gap);
+        }
+    }
+    s_last_seq = seq;
+    s_st.records++;
+
+    char msg[512];
+    const fmt_entry_t* e = table_find(id);
+    if (e) {
+        render(e->fmt, r + REC_HDR, n, msg, sizeof(msg));
+    } else {
+        size_t o = (size_t)snprintf(msg, sizeof(msg), "<id 0x%08x>", id);
+        for (uint8_t i = 0; i < n && o + 4 < sizeof(msg); ++i)
+            o += (size_t)snprintf(msg + o, sizeof(msg) - o, " %02x", r[REC_HDR + i]);
+        s_st.unknown++;
+    }
+    printf("%10.3f %c %s\n", ts / 1000.0, k_lvl_char[lvl], msg);
+}
+
+/* 在缓冲中搜记录；返回已消费字节数（剩余不足一条的留待下次） */
+static size_t scan(const uint8_t* buf, size_t n)
+{
+    size_t i = 0;
+    while (i < n) {
+        if (buf[i] != REC_SYNC) {
+            s_st.noise++;
+            ++i;
+            continue;
+        }
+        if (n - i < 2) break;
+        const size_t len = buf[i + 1];
+        if (len > REC_ARG_MAX) {
+            s_st.noise++;
+            ++i;
+            continue;
+        }
+        const size_t total = REC_HDR + len + 1;
+        if (n - i < total) break;
+        const uint8_t* r = buf + i;
+        if (crc8(r + 1, REC_HDR - 1 + len) != r[total - 1]) {
+            s_st.crc_err++;
+            s_st.noise++;
+            ++i;
+            continue;
+        }
+        if (s_table_n > 0 && !table_find(le32(r + 3))) {
+            /* CRC 碰巧通过的 JustFloat 数据 */
+            s_st.noise++;
+            ++i;
+            continue;
+        }
+        emit_record(r);
+        i += total;
+    }
+    return i;
+}
+
+/* ============================ 输入 ============================ */
+
+static speed_t baud_const(long b)
+{
+    switch (b) {
+    case 9600:    return B9600;
+    case 57600:   return B57600;
+    case 115200:  return B115200;
+    case 230400:  return B230400;
+    case 460800:  return B460800;
+    case 921600:  return B921600;
+    case 1000000: return B1000000;
+    case 2000000: return B2000000;
+    default:      return 0;
+    }
+}
+
+static int open_serial(const char* dev, long baud)
+{
+    const int fd = open(dev, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "[ERR] open %s: %s\n", dev, strerror(errno));
+        return -1;
+    }
+    struct termios tio;
+    const speed_t sp = baud_const(baud);
+    if (tcgetattr(fd, &tio) != 0 || sp == 0) {
+        fprintf(stderr, "[ERR] %s: unsupported tty or baud %ld\n", dev, baud);
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, sp);
+    cfsetospeed(&tio, sp);
+    tio.c_cc[VMIN]  = 1;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        fprintf(stderr, "[ERR] tcsetattr %s: %s\n", dev, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void usage(const char* argv0)
+{
+    fprintf(stderr,
+            "usage: %s -x FW.axf [-o TABLE]                 extract format table\n"
+            "       %s (-t TABLE | -e FW.axf) (-d TTY [-b BAUD] | -i FILE|-)\n",
+            argv0, argv0);
+}
+
+/* ============================ 主程序 ============================ */
+
+int main(int argc, char** argv)
+{
+    const char* extract  = NULL;
+    const char* out_path = NULL;
+    const char* dev      = NULL;
+    const char* in_path  = NULL;
+    long        baud     = 115200;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "x:o:t:e:d:b:i:h")) != -1) {
+        switch (opt) {
+        case 'x': extract  = optarg; break;
+        case 'o': out_path = optarg; break;
+        case 't': if (load_table(optarg) != 0) return 1; break;
+        case 'e': if (load_elf(optarg) < 0) return 1; break;
+        case 'd': dev      = optarg; break;
+        case 'b': baud     = atol(optarg); break;
+        case 'i': in_path  = optarg; break;
+        default:  usage(argv[0]); return 2;
+        }
+    }
+
+    if (extract) {
+        if (load_elf(extract) < 0) return 1;
+        FILE* out = out_path ? fopen(out_path, "w") : stdout;
+        if (!out) {
+            fprintf(stderr, "[ERR] open %s: %s\n", out_path, strerror(errno));
+            return 1;
+        }
+        write_table(out);
+        if (out != stdout) fclose(out);
+        fprintf(stderr, "[INFO] %d format string(s)\n", s_table_n);
+        return s_table_n > 0 ? 0 : 1;
+    }
+
+    if (!dev && !in_path) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (s_table_n == 0) fprintf(stderr, "[WARN] no format table, records print as raw ids\n");
+
+    int fd;
+    if (dev)                          fd = open_serial(dev, baud);
+    else if (strcmp(in_path, "-") == 0) fd = STDIN_FILENO;
+    else                              fd = open(in_path, O_RDONLY);
+    if (fd < 0) {
+        if (!dev) fprintf(stderr, "[ERR] open %s: %s\n", in_path, strerror(errno));
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    uint8_t buf[4096 + REC_MAX];
+    size_t  have = 0;
+    while (!g_stop) {
+        const ssize_t r = read(fd, buf + have, sizeof(buf) - have);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            perror("read");
+            break;
+        }
+        if (r == 0) break;
+        have += (size_t)r;
+        const size_t used = scan(buf, have);
+        memmove(buf, buf + used, have - used);
+        have -= used;
+        fflush(stdout);
+    }
+
+    fprintf(stderr, "[STAT] records=%llu lost=%llu crc_err=%llu noise_bytes=%llu unknown_id=%llu\n",
+            s_st.records, s_st.lost, s_st.crc_err, s_st.noise, s_st.unknown);
+    if (fd != STDIN_FILENO) close(fd);
+    return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file FreeRTOSConfig.h
+ * @brief FreeRTOS 内核配置（仅 config.h 中 CFG_USE_RTOS=1 时使用，任务划分见 Source/Inc/App_rtos.h）
+ *
+ * - 1kHz 节拍，与 HAL_GetTick 同为 SysTick（stm32f4xx_it.c 中 SysTick_Handler 同时驱动两者）；
+ * - 任务优先级、栈大小在 config.h（CFG_RTOS_*）；
+ * - 调用 FromISR API 的中断（UART5 / TIM5 定时应用）优先级须 >= configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY（数值），
+ *   更高优先级的中断（DMA）不受内核临界区屏蔽，但不得调用内核 API。
+ */
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__) || defined(__ARMCC_VERSION)
+#include <stdint.h>
+extern uint32_t SystemCoreClock;
+#endif
+
+#include "config.h"
+
+#define configUSE_PREEMPTION                     1
+#define configSUPPORT_STATIC_ALLOCATION          0
+#define configSUPPORT_DYNAMIC_ALLOCATION         1
+#define configUSE_IDLE_HOOK                      0
+#define configUSE_TICK_HOOK                      0
+#define configCPU_CLOCK_HZ                       (SystemCoreClock)
+#define configTICK_RATE_HZ                       ((TickType_t)1000)
+#define configMAX_PRIORITIES                     (6)
+#define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
+#define configTOTAL_HEAP_SIZE                    ((size_t)(16 * 1024))
+#define configMAX_TASK_NAME_LEN                  (16)
+#define configUSE_16_BIT_TICKS                   0
+#define configUSE_MUTEXES                        1
+#define configQUEUE_REGISTRY_SIZE                8
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION  1
+#define configCHECK_FOR_STACK_OVERFLOW           2
+#define configUSE_MALLOC_FAILED_HOOK             1
+#define configUSE_TRACE_FACILITY                 0
+
+/* 软件定时器：失联保护。服务任务优先级高于协议任务，解析繁忙时失联判定也不被推迟 */
+#define configUSE_TIMERS                         1
+#define configTIMER_TASK_PRIORITY                (CFG_RTOS_PRIO_TIMER)
+#define configTIMER_QUEUE_LENGTH                 10
+#define configTIMER_TASK_STACK_DEPTH             256
+
+/* 可选 API */
+#define INCLUDE_vTaskPrioritySet                 0
+#define INCLUDE_uxTaskPriorityGet                0
+#define INCLUDE_vTaskDelete                      1
+#define INCLUDE_vTaskSuspend                     1
+#define INCLUDE_vTaskDelayUntil                  1
+#define INCLUDE_vTaskDelay                       1
+#define INCLUDE_xTaskGetSchedulerState           1
+
+/* Cortex-M4 中断优先级：STM32F4 使用 4 位（HAL_Init 设为 NVIC_PRIORITYGROUP_4） */
+#ifdef __NVIC_PRIO_BITS
+#define configPRIO_BITS                          __NVIC_PRIO_BITS
+#else
+#define configPRIO_BITS                          4
+#endif
+
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY       15
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY  5
+
+#define configKERNEL_INTERRUPT_PRIORITY      (configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+
+#define configASSERT(x)                      \
+    if ((x) == 0)                            \
+    {                                        \
+        taskDISABLE_INTERRUPTS();            \
+        for (;;)                             \
+            ;                                \
+    }
+
+/* 内核接管 SVC / PendSV（stm32f4xx_it.c 中对应的空处理函数在 CFG_USE_RTOS 时不编译）；
+ * SysTick 不在此映射：SysTick_Handler 先 HAL_IncTick 再调 xPortSysTickHandler */
+#define vPortSVCHandler    SVC_Handler
+#define xPortPendSVHandler PendSV_Handler
+
+#if (CFG_RTOS_PRIO_ACTUATE >= configMAX_PRIORITIES)
+#error "CFG_RTOS_PRIO_ACTUATE 须小于 configMAX_PRIORITIES"
+#endif
+
+#endif /* FREERTOS_CONFIG_H */
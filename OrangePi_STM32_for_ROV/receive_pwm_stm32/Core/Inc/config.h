@@ -20,6 +20,27 @@ extern "C" {
 #define FW_VERSION_PATCH        0
 #define FW_VERSION_U16          ((FW_VERSION_MAJOR << 8) | (FW_VERSION_MINOR))  /* 0x0100 */
 
+/* ========================= 运行模式（裸机 / FreeRTOS） ========================= */
+/* 0=裸机超级循环（默认）；1=FreeRTOS 任务化（需在工程中加入 FreeRTOS 内核源码，见 App_rtos.h）。
+ * 可在 Keil 另建一个 Target，在 C/C++ Define 中写 CFG_USE_RTOS=1 切换，无需改本文件 */
+#ifndef CFG_USE_RTOS
+#define CFG_USE_RTOS                    0
+#endif
+
+/* 任务优先级（数值越大越高，须 < configMAX_PRIORITIES）：执行 > 失联定时器 > 协议/ACK > 状态上报 */
+#define CFG_RTOS_PRIO_ACTUATE           5u
+#define CFG_RTOS_PRIO_TIMER             4u
+#define CFG_RTOS_PRIO_PROTO             3u
+#define CFG_RTOS_PRIO_STATUS            1u
+
+/* 任务栈（字，4 字节/字） */
+#define CFG_RTOS_STACK_ACTUATE          256u
+#define CFG_RTOS_STACK_PROTO            512u
+#define CFG_RTOS_STACK_STATUS           384u
+
+/* 串口中断 → 协议任务的字节流缓冲（字节，应覆盖协议任务最长一次被抢占期间到达的数据） */
+#define CFG_RTOS_RX_STREAM_SIZE         1024u
+
 /* ========================= 协议/心跳/失联保护 ========================= */
 /* 心跳 ACK 功能开关（STM32 收到 HB 后是否回 ACK） */
 #define CFG_HB_ACK_ENABLE               1
@@ -27,15 +48,68 @@ extern "C" {
 /* 失联保护：超过该时间未收到“合法帧”（PWM/HB/HB_ACK）→ 全部回中位（ms） */
 #define CFG_FAILSAFE_TIMEOUT_MS         300u
 
+/* SEQ 去重：主机冗余发送（同一帧多份）时只应用最先到达的一份，乱序的旧帧丢弃 */
+#define CFG_SEQ_DEDUP_ENABLE            1
+
+/* 乱序容忍窗口：SEQ 回退超过该值视为主机重启，直接以新 SEQ 重新同步 */
+#define CFG_SEQ_REORDER_WINDOW          64
+
+/* HB_ACK 携带链路统计负载（rx_unique / rx_dup / seq_gaps，各 u32），0=保持 LEN=0 */
+#define CFG_HB_ACK_STATS_ENABLE         1
+
+/* 紧凑帧 v2（SOF 0xAA 0x5A，8 路 12/14 位打包，20~24 字节）：解析并在 HB_ACK 状态位声明支持，
+ * 主机据此把 PWM 帧切换为 v2；0=只认 v1（主机自动回退） */
+#define CFG_PROTO_V2_ENABLE             1
+
+/* COBS 分帧（两端须一致，主机 pwm_host_set_framing）：每帧 COBS 编码后首尾各加 0x00，
+ * 接收按 0x00 切分、每段解码后恰好一帧，重同步代价与负载内容无关；0=原始字节流（按 SOF 搜索）。
+ * 可在编译命令中覆盖（test/ 的主机测试即以 CFG_PROTO_COBS_ENABLE=1 编译 protocol_v1.c） */
+#ifndef CFG_PROTO_COBS_ENABLE
+#define CFG_PROTO_COBS_ENABLE           0
+#endif
+
 /* 软急停：收到 ESTOP 命令后，中位并锁定该时长禁止输出（ms） */
 #define CFG_ESTOP_LOCK_MS               500u
 
-/* 上电暖机：上电/复位后固定中位输出的时长（ms），用于电调自检与安全等待 */
+/* 上电暖机：上电/复位后固定中位输出的时长（ms），用于电调自检与安全等待。
+ * 非阻塞：暖机期间照常收包、应答心跳（HB_ACK status 带 warming 位），PWM 指令不应用，到时自动开始接受 */
 #define CFG_STARTUP_WARMUP_MS           3000u
 
 /* 状态上报频率（Hz）：建议 1~5Hz；0 表示不主动上报（仅应答型） */
 #define CFG_STATUS_FEEDBACK_HZ          2u
 
+/* ========================= 定时应用（抖动缓冲） ========================= */
+/* MSG_PWM_AT：主机标注设备 tick 目标时刻，TIM5 1ms 中断到点应用；0=收到即应用（忽略目标时刻） */
+#define CFG_SCHED_APPLY_ENABLE          1
+
+/* 排队指令上限：应覆盖“抖动缓冲深度 / 发送周期”，如 60ms / 20ms = 3，留余量 */
+#define CFG_SCHED_QUEUE_LEN             8u
+
+/* 迟到策略：迟到不超过该值立即应用，超过则丢弃（ms，建议约一个发送周期） */
+#define CFG_SCHED_LATE_DROP_MS          20u
+
+/* 目标时刻比当前超前超过该值 → 视为时钟未对齐，退化为立即应用（ms） */
+#define CFG_SCHED_MAX_LEAD_MS           500u
+
+/* ========================= PWM 周期相位对齐 ========================= */
+/* 指令到达时刻相对 TIM1/TIM4 更新事件的相位始终测量（HB_ACK 上报平均相位滞后）；
+ * 1=锁相：逐帧微调 ARR，使 PWM 周期跟随指令周期、更新事件落在典型到达时刻之后，平均省去约半个周期的等待 */
+#define CFG_PHASE_ALIGN_ENABLE          0
+
+/* 目标：更新事件落在到达时刻之后 margin + 2σ（μs），吸收到达抖动 */
+#define CFG_PHASE_MARGIN_US             500u
+
+/* PWM 周期可偏离 20ms 的上限（μs）：1000 → 19~21ms（47.6~52.6Hz），电调均可接受；
+ * 指令周期超出该范围时无法锁定，只测量不改善 */
+#define CFG_PHASE_MAX_STEP_US           1000u
+
+/* 锁相环增益（右移位数）：比例 1/2^KP，积分 1/2^KI；越大越慢越平滑 */
+#define CFG_PHASE_KP_SHIFT              2u
+#define CFG_PHASE_KI_SHIFT              5u
+
+/* 平均误差小于该值视为已锁定（μs） */
+#define CFG_PHASE_DEADBAND_US           300u
+
 /* ========================= PWM 输出保护与整形 ========================= */
 /* 斜率限幅（μs/秒）：限制输出变化速度，保护电调/推进器。典型 1000~3000 */
 #define CFG_PWM_SLEW_US_PER_S           1500u
@@ -50,12 +124,23 @@ extern "C" {
 /* UART5 DMA 接收环形缓冲大小（应 ≥ 最大一帧长度 + 抖动余量） */
 #define CFG_UART5_RX_DMA_BUF_SIZE       512u
 
+/* ========================= 调试串口遥测（VOFA+ JustFloat） ========================= */
+/* 双缓冲每半区字节数：一半由 DMA 发送，另一半供 Telem_Push 追加；半区写满即计 overrun 丢帧 */
+#define CFG_TELEM_BUF_SIZE              1024u
+
+/* 调试串口波特率：0=保持 CubeMX 配置（115200，约 11KB/s）；1kHz 多通道遥测建议 921600 或更高 */
+#define CFG_TELEM_UART_BAUD             0u
+
 /* ========================= 看门狗与调试开关 ========================= */
 /* 独立看门狗使能（由 main.c 或系统初始化处拉起并喂狗） */
 #define CFG_IWDG_ENABLE                 0
 
-/* 打印/调试开关（0=关闭，1=最小日志，2=详细日志） */
-#define CFG_LOG_VERBOSITY               1
+/* 令牌化日志（Tlog）编译期级别：0=关闭，1=ERROR，2=+WARN，3=+INFO，4=+DEBUG
+ * 高于该级别的 TLOG_x 调用连同格式串一起不进入固件；记录与遥测帧共用调试串口，
+ * 主机端用 pwm_tlog_decode 解码（与 VOFA+ 同时使用时日志记录会让 VOFA+ 偶尔错一帧） */
+#ifndef CFG_LOG_VERBOSITY
+#define CFG_LOG_VERBOSITY               2
+#endif
 
 /* ========================= 编译期健壮性检查 ========================= */
 #if (CFG_STATUS_FEEDBACK_HZ > 10u)
@@ -66,6 +151,14 @@ extern "C" {
 #  error "CFG_FAILSAFE_TIMEOUT_MS 太小，建议 >= 100ms"
 #endif
 
+#if (CFG_SCHED_MAX_LEAD_MS >= CFG_FAILSAFE_TIMEOUT_MS * 2u)
+#  error "CFG_SCHED_MAX_LEAD_MS 过大：排队指令可能在失联保护之后才生效"
+#endif
+
+#if (CFG_PHASE_MAX_STEP_US > 2000u)
+#  error "CFG_PHASE_MAX_STEP_US 过大：调整帧周期偏离 20ms 超过 10%"
+#endif
+
 #if (CFG_PWM_SLEW_US_PER_S > 10000u)
 #  error "CFG_PWM_SLEW_US_PER_S 过大，建议 <= 10000 us/s"
 #endif
@@ -62,6 +62,7 @@ void UART5_IRQHandler(void);
 void DMA2_Stream2_IRQHandler(void);
 void DMA2_Stream7_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void TIM5_IRQHandler(void);
 
 /* USER CODE END EFP */
 
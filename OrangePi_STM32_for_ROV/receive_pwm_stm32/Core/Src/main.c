@@ -29,6 +29,10 @@
 #include "Driver_pwm.h"
 #include "Uart_service.h"
 #include "protocol_v1.h"
+#include "Sched_pwm.h"
+#include "Phase_pwm.h"
+#include "App_rtos.h"
+#include "config.h"
 
 /* USER CODE END Includes */
 
@@ -102,9 +106,16 @@ int main(void)
   MX_UART5_Init();
   MX_USART1_UART_Init();
   /* USER CODE BEGIN 2 */
-  Driver_PWM_Init();  //初始化PWM通道
+  Telem_Init();       //调试串口遥测双缓冲（VOFA+ JustFloat）
+  Driver_PWM_Init();  //初始化PWM通道（中位，不阻塞；暖机由协议层计时）
   protocol_force_failsafe(); //进入保护状态，所有通道回中位
-  protocol_process_init(); //协议处理初始化
+  Phase_pwm_Init();        //PWM 周期相位测量 / 对齐
+#if (CFG_USE_RTOS)
+  App_rtos_Start();        //FreeRTOS：协议/定时应用初始化、创建任务并启动调度器，不返回
+#else
+  protocol_process_init(); //协议处理初始化（开始暖机计时，期间照常应答心跳）
+  Sched_pwm_Init();        //定时应用：TIM5 1ms 中断
+#endif
 
   /* USER CODE END 2 */
 
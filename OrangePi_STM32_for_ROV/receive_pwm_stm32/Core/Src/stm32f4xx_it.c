@@ -24,6 +24,13 @@
 /* USER CODE BEGIN Includes */
 #include "Parse_pwm.h"
 #include "protocol_v1.h"
+#include "Sched_pwm.h"
+#include "config.h"
+#if (CFG_USE_RTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+extern void xPortSysTickHandler(void);
+#endif
 
 /* USER CODE END Includes */
 
@@ -149,6 +156,7 @@ void UsageFault_Handler(void)
 /**
   * @brief This function handles System service call via SWI instruction.
   */
+#if !(CFG_USE_RTOS) /* RTOS：由内核 vPortSVCHandler 提供（FreeRTOSConfig.h 映射） */
 void SVC_Handler(void)
 {
   /* USER CODE BEGIN SVCall_IRQn 0 */
@@ -158,6 +166,7 @@ void SVC_Handler(void)
 
   /* USER CODE END SVCall_IRQn 1 */
 }
+#endif
 
 /**
   * @brief This function handles Debug monitor.
@@ -175,6 +184,7 @@ void DebugMon_Handler(void)
 /**
   * @brief This function handles Pendable request for system service.
   */
+#if !(CFG_USE_RTOS) /* RTOS：由内核 xPortPendSVHandler 提供 */
 void PendSV_Handler(void)
 {
   /* USER CODE BEGIN PendSV_IRQn 0 */
@@ -184,6 +194,7 @@ void PendSV_Handler(void)
 
   /* USER CODE END PendSV_IRQn 1 */
 }
+#endif
 
 /**
   * @brief This function handles System tick timer.
@@ -195,6 +206,13 @@ void SysTick_Handler(void)
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
+#if (CFG_USE_RTOS)
+  /* HAL 与内核共用 SysTick：调度器启动前只走 HAL_IncTick（HAL_Delay 可用） */
+  if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+  {
+    xPortSysTickHandler();
+  }
+#endif
 
   /* USER CODE END SysTick_IRQn 1 */
 }
@@ -292,5 +310,12 @@ void DMA2_Stream7_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles TIM5 global interrupt（定时应用 1ms 节拍）.
+  */
+void TIM5_IRQHandler(void)
+{
+  Sched_pwm_TimerIRQ();
+}
 
 /* USER CODE END 1 */
@@ -0,0 +1,49 @@
+#ifndef App_rtos_H
+#define App_rtos_H
+#include "stm32f4xx_hal.h"
+#include <stdint.h>
+/**
+ * @brief FreeRTOS 任务化运行（config.h 中 CFG_USE_RTOS=1 时启用）
+ *
+ * 裸机超级循环里协议解析、ACK、失联判定串行执行，日志/遥测越多，指令从收到到输出的延迟越大。
+ * RTOS 版本按优先级拆分：
+ *  - 执行任务（最高）：阻塞在长度 1 的指令邮箱上，收到即写 PWM 比较寄存器，只保留最新一条；
+ *    是唯一写输出的任务，定时应用（TIM5 到点 / 迟到立即应用）同样经邮箱投递；
+ *  - 失联保护：软件定时器，每收到合法帧重置，到期通知协议任务回中位（代替 protocol_poll 轮询）；
+ *  - 协议/ACK 任务：UART5 空闲中断把字节写入流缓冲唤醒本任务，解析后把 PWM 交给执行任务、直接回 HB_ACK；
+ *  - 状态任务（最低）：按 CFG_STATUS_FEEDBACK_HZ 在调试串口输出链路统计，可被上面任一任务抢占。
+ *
+ * 工程需加入 FreeRTOS 内核（CubeMX Middlewares/Third_Party/FreeRTOS：Source 下全部 .c、portable/RVDS/ARM_CM4F、
+ * MemMang/heap_4.c），内核配置见 Core/Inc/FreeRTOSConfig.h。CFG_USE_RTOS=0 时本模块为空。
+ */
+
+/* 创建队列/定时器/任务，初始化协议栈与定时应用，启动调度器（不返回） */
+void App_rtos_Start(void);
+
+/* UART5 空闲中断中调用：本次 DMA 收到的字节写入流缓冲并唤醒协议任务 */
+void App_rtos_RxFromISR(const uint8_t *data, uint16_t n);
+
+/* 任务中调用：提交一条立即指令（8 路占空 -1..1），作废排队的定时指令并覆盖尚未执行的旧指令 */
+void App_rtos_PostDuty(const float duty[8]);
+
+/* TIM5 中断中调用：提交一条到点的定时指令（不清定时队列） */
+void App_rtos_PostDutyFromISR(const float duty[8]);
+
+/* 任务中调用：收到合法帧，重置失联保护定时器 */
+void App_rtos_LinkAlive(void);
+
+/* 调整失联保护定时器周期（ms） */
+void App_rtos_SetFailsafeMs(uint32_t ms);
+
+typedef struct
+{
+    uint32_t applied;        /* 执行任务应用的指令数 */
+    uint32_t overwritten;    /* 执行前被新指令覆盖的指令数 */
+    uint32_t failsafe;       /* 失联定时器到期次数 */
+    uint32_t rx_overflow;    /* 流缓冲满丢弃的字节数 */
+    uint32_t max_latency_ms; /* 指令提交 → 输出的最大延迟（ms） */
+} rtos_stats_t;
+
+const rtos_stats_t *App_rtos_Stats(void);
+
+#endif
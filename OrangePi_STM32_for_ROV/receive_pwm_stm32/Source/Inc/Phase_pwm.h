@@ -0,0 +1,34 @@
+#ifndef Phase_pwm_H
+#define Phase_pwm_H
+#include "stm32f4xx_hal.h"
+#include <stdbool.h>
+/**
+ * @brief PWM 周期相位对齐：让 TIM1/TIM4 的更新事件紧跟在指令到达之后
+ *
+ * 比较寄存器带预装载，新占空要等到下一个更新事件才输出；指令异步到达时平均等待半个周期（20ms 周期约 10ms）。
+ * - 每条立即应用的指令记录到达时的计数值（即相对上一次更新事件的相位），平均相位滞后经 HB_ACK 上报；
+ * - CFG_PHASE_ALIGN_ENABLE 时每个定时器运行一个锁相环：相位误差经比例 + 积分得到本帧周期修正量，
+ *   写入带预装载的 ARR（下一周期生效，脉宽不受影响），周期限制在 20ms ± CFG_PHASE_MAX_STEP_US。
+ *   积分项吸收主机发送周期与 20ms 的差（如 51Hz 主机），稳态下 PWM 周期等于指令周期；
+ * - 失联保护触发时恢复名义周期。
+ */
+typedef struct
+{
+    uint32_t samples;     /* 已测量的指令数 */
+    uint16_t mean_lag_us; /* 平均相位滞后（到达 → 下一次更新事件，EMA，两个定时器平均），0xFFFF=无样本 */
+    int16_t  err_us[2];   /* 平均相位误差（TIM1 / TIM4，相对目标相位） */
+    int16_t  adj_us[2];   /* 当前周期修正量（TIM1 / TIM4，相对 20ms） */
+    bool     locked;      /* 两个定时器平均误差均在 CFG_PHASE_DEADBAND_US 内 */
+} phase_stats_t;
+
+void Phase_pwm_Init(void);
+
+/* 立即指令写入比较寄存器时调用（失联回中不调用） */
+void Phase_pwm_OnApply(void);
+
+/* 失联保护时调用：恢复名义周期、清空环路状态 */
+void Phase_pwm_Reset(void);
+
+const phase_stats_t *Phase_pwm_Stats(void);
+
+#endif
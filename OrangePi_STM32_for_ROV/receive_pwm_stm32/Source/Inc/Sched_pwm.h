@@ -0,0 +1,43 @@
+#ifndef Sched_pwm_H
+#define Sched_pwm_H
+
+#include "stm32f4xx_hal.h"
+#include <stdbool.h>
+
+/**
+ * @brief 定时应用（抖动缓冲）：按设备 tick 排队的 PWM 指令，由 TIM5 1ms 中断到点应用
+ *
+ * - 主机用 MSG_PWM_AT 为每条指令标注“设备 tick 目标时刻”（主机按 HB/HB_ACK 估计时钟偏移），
+ *   网络/桥接抖动被吸收在队列里，输出按主机节拍均匀变化；
+ * - 迟到策略见 config.h 的 CFG_SCHED_LATE_DROP_MS / CFG_SCHED_MAX_LEAD_MS；
+ * - CFG_USE_RTOS 时本模块不直接写输出：迟到 / 过远的立即应用与到点应用都投递给执行任务（App_rtos.h）。
+ */
+
+typedef struct
+{
+    uint32_t applied;     /* 到点应用的指令数 */
+    uint32_t late;        /* 迟到但在容忍内、立即应用的指令数 */
+    uint32_t late_drop;   /* 迟到超过容忍、丢弃的指令数 */
+    uint32_t far_future;  /* 目标时刻过远（时钟未对齐），立即应用的指令数 */
+    uint32_t overflow;    /* 队列满、挤掉最早一条的次数 */
+    int32_t  max_late_ms; /* 观测到的最大迟到量（ms，到点应用时为应用延迟） */
+} sched_stats_t;
+
+void Sched_pwm_Init(void);
+
+/**
+ * @brief 入队一条定时指令（主循环调用）
+ * @param due_tick 设备 HAL_GetTick() 目标时刻
+ * @param duty     8 路占空（-1..1，与 Driver_pwm_SetDuty 一致）
+ */
+void Sched_pwm_Push(uint32_t due_tick, const float duty[8]);
+
+/* 清空队列（立即指令 / 失联保护 / 急停时调用，避免旧指令在之后“复活”） */
+void Sched_pwm_Clear(void);
+
+/* 在 TIM5_IRQHandler 中调用 */
+void Sched_pwm_TimerIRQ(void);
+
+const sched_stats_t *Sched_pwm_Stats(void);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef Tlog_H
+#define Tlog_H
+#include "stm32f4xx_hal.h"
+#include "config.h"
+#include <stdbool.h>
+/**
+ * @brief 令牌化延迟日志（defmt 风格）：调用点只发“格式串 ID + 原始参数字节”
+ *
+ * - 格式串放进独立段 .tlog_fmt，ID 即其地址；固件里不做任何格式化，一条记录十几个字节；
+ * - 记录写入调试串口遥测双缓冲（Telem_PushBytes），由 DMA 在后台发送，调用方不阻塞，
+ *   缓冲满则丢弃并计数；可在中断里调用；
+ * - 主机端 pwm_tlog_decode 从 .axf 抽取格式串表（-x），再按表解码串口字节流，
+ *   流中的 VOFA+ JustFloat 帧会被跳过；
+ * - CFG_LOG_VERBOSITY 编译期裁剪：被裁掉的调用不产生代码，格式串也不进固件。
+ *
+ * 参数按格式串取值并按小端写入（与主机解码器约定一致，见 docs/protocol_v1.md）：
+ *   %d %i %u %x %X %o %c %p → 4 字节；%lld 等 ll → 8 字节；%f %e %g → float 4 字节；
+ *   %s → 1 字节长度 + 至多 TLOG_STR_MAX 字节。不支持 '*' 宽度 / 精度。
+ * 格式串必须是字符串字面量：
+ *
+ *    TLOG_W("seq gap %u (seq=%u)", gap, seq);
+ */
+
+#define TLOG_LVL_ERROR 1
+#define TLOG_LVL_WARN  2
+#define TLOG_LVL_INFO  3
+#define TLOG_LVL_DEBUG 4
+
+#define TLOG_SYNC          0xA5u
+#define TLOG_HDR_BYTES     11u /* SYNC LEN LVL|SEQ ID(4) TS(4) */
+#define TLOG_MAX_ARG_BYTES 48u
+#define TLOG_STR_MAX       12u
+
+typedef struct
+{
+    uint32_t emitted;   /* 已写入缓冲的记录数 */
+    uint32_t dropped;   /* 缓冲满丢弃的记录数 */
+    uint32_t truncated; /* 参数超出 TLOG_MAX_ARG_BYTES 被截断的记录数 */
+} tlog_stats_t;
+
+/* 由 TLOG_x 宏调用；fmt 必须位于 .tlog_fmt 段 */
+void Tlog_Emit(uint8_t level, const char *fmt, ...);
+
+const tlog_stats_t *Tlog_Stats(void);
+
+#if defined(__CC_ARM) || defined(__ARMCC_VERSION) || defined(__GNUC__)
+#define TLOG_FMT_ATTR __attribute__((section(".tlog_fmt"), used))
+#else
+#define TLOG_FMT_ATTR
+#endif
+
+/* 第一个参数（格式串）放进 .tlog_fmt；其余参数后补一个 0 占位，避免 C99 下空 __VA_ARGS__ */
+#define TLOG_FIRST_(fmt, ...) fmt
+#define TLOG_REST_(fmt, ...) __VA_ARGS__
+#define TLOG_EMIT_(lvl, ...)                                                        \
+    do                                                                              \
+    {                                                                               \
+        static const char TLOG_FMT_ATTR tlog_fmt_[] = TLOG_FIRST_(__VA_ARGS__, 0); \
+        Tlog_Emit((lvl), tlog_fmt_, TLOG_REST_(__VA_ARGS__, 0));                   \
+    } while (0)
+
+#if (CFG_LOG_VERBOSITY >= TLOG_LVL_ERROR)
+#define TLOG_E(...) TLOG_EMIT_(TLOG_LVL_ERROR, __VA_ARGS__)
+#else
+#define TLOG_E(...) do { } while (0)
+#endif
+#if (CFG_LOG_VERBOSITY >= TLOG_LVL_WARN)
+#define TLOG_W(...) TLOG_EMIT_(TLOG_LVL_WARN, __VA_ARGS__)
+#else
+#define TLOG_W(...) do { } while (0)
+#endif
+#if (CFG_LOG_VERBOSITY >= TLOG_LVL_INFO)
+#define TLOG_I(...) TLOG_EMIT_(TLOG_LVL_INFO, __VA_ARGS__)
+#else
+#define TLOG_I(...) do { } while (0)
+#endif
+#if (CFG_LOG_VERBOSITY >= TLOG_LVL_DEBUG)
+#define TLOG_D(...) TLOG_EMIT_(TLOG_LVL_DEBUG, __VA_ARGS__)
+#else
+#define TLOG_D(...) do { } while (0)
+#endif
+
+#endif
@@ -1,11 +1,45 @@
 #ifndef Uart_service_H
 #define Uart_service_H
-
 #include "stm32f4xx_hal.h"
 #include <stdbool.h>
+/**
+ * @brief 调试串口（huart1）遥测：VOFA+ JustFloat 双缓冲 DMA 发送
+ *
+ * - 帧格式：n×float（小端）+ 帧尾 00 00 80 7F，与 VOFA+ JustFloat 一致；
+ * - 两个半区轮换：DMA 发送一个半区时，Telem_Push 直接把样本写进另一个半区（DMA 从该缓冲取数，无需再拷贝）；
+ *   DMA 完成中断里换区并立即启动下一次发送；
+ * - 非阻塞：任意上下文（主循环 / 中断 / 任务）可调用，写入时短暂关中断；半区写满即丢弃该帧并计 overrun，
+ *   控制路径不会因串口带宽不足而等待。
+ */
+typedef struct
+{
+    uint32_t frames;   /* 已写入缓冲的帧数（含 Telem_PushBytes 记录） */
+    uint32_t overrun;  /* 半区已满、丢弃的帧数（含 Telem_PushBytes 记录） */
+    uint32_t dma_err;  /* 启动 DMA 失败 / 传输错误次数 */
+    uint32_t bytes_tx; /* 已交给 DMA 的字节数 */
+    uint16_t max_fill; /* 换区时半区的最大填充字节数（接近 CFG_TELEM_BUF_SIZE 说明带宽不足） */
+} telem_stats_t;
+
+#define TELEM_MAX_FLOATS 20u
+
+/* 初始化（可选调整波特率，见 CFG_TELEM_UART_BAUD） */
+void Telem_Init(void);
 
+/**
+ * @brief 追加一帧 n 个 float（1..TELEM_MAX_FLOATS），非阻塞
+ * @return true=已入缓冲；false=参数错误或半区已满（计 overrun）
+ */
+bool Telem_Push(const float *v, uint8_t n);
 
+/**
+ * @brief 追加一段原始字节（1..TELEM_MAX_FLOATS*4+4），与遥测帧共用同一 DMA 通道，整段写入或整段丢弃
+ *        供令牌化日志（Tlog）与 printf 重定向使用
+ */
+bool Telem_PushBytes(const void *data, uint16_t n);
+
+const telem_stats_t *Telem_Stats(void);
+
+/* 兼容旧接口：可变参数 float 会被提升为 double，新代码请用 Telem_Push */
 bool UART_SendFloats_DMA(uint8_t count, ...);
 bool UART_SendFloats_Blocking(uint8_t count, ...);
-
 #endif
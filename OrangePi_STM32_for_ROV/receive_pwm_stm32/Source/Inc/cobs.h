@@ -0,0 +1,30 @@
+// cobs.h
+#ifndef COBS_H
+#define COBS_H
+#include <stdint.h>
+
+/**
+ * COBS（Consistent Overhead Byte Stuffing）：编码后不含 0x00，帧间以 0x00 分隔。
+ * 接收端按 0x00 切分即得到帧边界，不再逐字节搜 SOF、试算 CRC；
+ * 开销固定为每 254 字节 1 字节（本协议的帧 < 254 字节，即恰好 +1）。
+ * 不依赖 HAL，可直接在主机上编译测试。
+ */
+
+/* n 字节数据编码后的最大长度（不含分隔符） */
+#define COBS_MAX_ENCODED(n) ((n) + ((n) / 254u) + 1u)
+
+/**
+ * @brief 编码
+ * @param out 容量 >= COBS_MAX_ENCODED(n)，不可与 in 重叠
+ * @return 编码长度（不含分隔符）
+ */
+uint16_t cobs_encode(const uint8_t *in, uint16_t n, uint8_t *out);
+
+/**
+ * @brief 解码（可原地：out == in）
+ * @param in 一段不含 0x00 的编码数据（分隔符已去掉）
+ * @return 解码长度；格式错误（含 0x00、长度码越界）返回 0
+ */
+uint16_t cobs_decode(const uint8_t *in, uint16_t n, uint8_t *out);
+
+#endif
@@ -28,11 +28,44 @@ extern "C"
 #define PROTO_CRC_LEN 2u
 #define PROTO_MIN_FRAME_LEN (PROTO_HDR_LEN + PROTO_CRC_LEN) /* 14 */
 
+/* ========================= 紧凑帧 v2（CFG_PROTO_V2_ENABLE） ========================= */
+/**
+ * 只承载高频 PWM 指令；HB / HB_ACK 仍走 v1（完整 SEQ16 / TICKS32 / 链路统计），
+ * 设备在 HB_ACK status 中置 PROTO_STATUS_PROTO_V2，主机收到后才切换，否则继续发 v1。
+ *   SOF(2)    = 0xAA 0x5A（第二字节区分格式，旧固件按 SOF 不符逐字节丢弃）
+ *   TL(1)     = TYPE(高 3 位) | LEN(低 5 位，payload 字节数)
+ *   SEQ8(1)   = 主机 SEQ 低 8 位（设备以最近的 SEQ16 为基准就近展开）
+ *   TICK16(2) big-endian，主机 ms tick 低 16 位
+ *   PAYLOAD(LEN)
+ *   CRC(2)    big-endian，CRC16-CCITT-FALSE 覆盖 TL..PAYLOAD
+ * 负载：8 路通道 MSB 优先连续位打包，
+ *   12 位：码值 0..4000 = 协议值 × 2/5（步长 2.5，中位 2000 精确）；
+ *   14 位：码值 = 协议值 0..10000（无损）；
+ *   *_AT 类型前置 DUE16（设备 tick 低 16 位，设备以当前 tick 为基准展开）。
+ */
+#define PROTO_SOF_V2_BE 0xAA5Au
+#define PROTO_V2_HDR_LEN 6u /* SOF(2)+TL(1)+SEQ8(1)+TICK16(2) */
+#define PROTO_V2_MIN_FRAME_LEN (PROTO_V2_HDR_LEN + PROTO_CRC_LEN)
+#define PROTO_V2_TL(type, len) ((uint8_t)(((type) << 5) | ((len) & 0x1Fu)))
+
+#define PROTO_V2_PWM12 0u    /* 8×12 位，LEN=12（整帧 20 字节，v1 为 30） */
+#define PROTO_V2_PWM14 1u    /* 8×14 位，LEN=14 */
+#define PROTO_V2_PWM12_AT 2u /* DUE16 + 8×12 位，LEN=14 */
+#define PROTO_V2_PWM14_AT 3u /* DUE16 + 8×14 位，LEN=16 */
+#define PROTO_V2_Q12_MAX 4000u
+
 /* ========================= 消息 ID ========================= */
 /* 已实现 */
 #define MSG_PWM 0x01    /* 主机→设备：8×u16(0..10000)，LEN=16 */
+#define MSG_PWM_AT 0x02 /* 主机→设备：DUE(u32 设备 tick) + 8×u16，LEN=20，到点应用（CFG_SCHED_APPLY_ENABLE） */
 #define MSG_HB 0x10     /* 主机→设备：心跳，LEN=0 */
-#define MSG_HB_ACK 0x11 /* 设备→主机：心跳应答，LEN=0 */
+#define MSG_HB_ACK 0x11 /* 设备→主机：心跳应答，LEN=0 或 16（链路统计 + 相位滞后 + 状态位，见 protocol_v1.md） */
+
+/* HB_ACK 负载 status 位 */
+#define PROTO_STATUS_PHASE_ALIGN 0x0001u  /* 相位对齐已启用（CFG_PHASE_ALIGN_ENABLE） */
+#define PROTO_STATUS_PHASE_LOCKED 0x0002u /* 相位误差已进入死区 */
+#define PROTO_STATUS_WARMING 0x0004u      /* 上电暖机中：输出保持中位，PWM 指令不应用（CFG_STARTUP_WARMUP_MS） */
+#define PROTO_STATUS_PROTO_V2 0x0008u     /* 支持紧凑帧 v2（CFG_PROTO_V2_ENABLE） */
 
 /* 预留扩展（建议后续实现） */
 #define MSG_ESTOP 0x20  /* 主机→设备：软急停，LEN=0 */
@@ -66,6 +99,16 @@ extern "C"
      */
     void protocol_set_failsafe_timeout_ms(uint32_t ms);
 
+    /**
+     * @brief 追加字节并立即解析（CFG_USE_RTOS：协议任务从流缓冲取出数据后调用，不经 protocol_flag）
+     */
+    void protocol_process_bytes(const uint8_t *data, uint16_t n);
+
+    /**
+     * @brief 失联超时到期（CFG_USE_RTOS：失联保护软件定时器到期后由协议任务调用，代替 protocol_poll 的比较）
+     */
+    void protocol_link_timeout(void);
+
     /* ==== 可选的安全/调试辅助（不调用也不影响现有逻辑） ==== */
 
     /**
@@ -74,6 +117,11 @@ extern "C"
      */
     void protocol_force_failsafe(void);
 
+    /**
+     * @brief 是否仍处于上电暖机（protocol_init 起 CFG_STARTUP_WARMUP_MS 内，输出保持中位）
+     */
+    uint8_t protocol_is_warming(void);
+
     /**
      * @brief 清空统计计数器（调试/自检时使用）。未实现可留空。
      */
@@ -89,6 +137,14 @@ extern "C"
         /* 可选扩展字段（实现里可不维护，默认为 0） */
         uint32_t bytes_rx;    /* 接收的原始字节计数 */
         proto_seq_t last_seq; /* 最近一次合法帧的 seq */
+        /* SEQ 去重（CFG_SEQ_DEDUP_ENABLE） */
+        uint32_t rx_unique; /* 去重后的新 PWM 帧数（心跳不计） */
+        uint32_t rx_dup;    /* 重复副本（同 SEQ，已丢弃） */
+        uint32_t rx_stale;  /* 乱序到达的旧帧（已丢弃） */
+        uint32_t seq_gaps;  /* SEQ 缺口：所有副本均丢失的帧数 */
+        uint32_t rx_warmup; /* 暖机期间收到、未应用的 PWM 帧数 */
+        uint32_t rx_v2;     /* 合法的紧凑帧 v2 数（含副本） */
+        uint32_t rx_cobs_err; /* COBS 分帧：解码失败或不是恰好一帧（含 CRC 失败）而丢弃的段数 */
     } proto_stats_t;
 
     /**
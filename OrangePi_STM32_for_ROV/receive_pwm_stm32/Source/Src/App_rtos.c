@@ -0,0 +1,209 @@
+#include "App_rtos.h"
+#include "config.h"
+#include "main.h"
+
+#if (CFG_USE_RTOS)
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "timers.h"
+#include "stream_buffer.h"
+
+#include "Driver_pwm.h"
+#include "Sched_pwm.h"
+#include "Uart_service.h"
+#include "protocol_v1.h"
+#include "usart.h"
+#include <string.h>
+
+typedef struct
+{
+    float duty[8];
+    TickType_t posted; /* 提交时刻，用于统计执行延迟 */
+} act_cmd_t;
+
+static QueueHandle_t s_act_q;         /* 长度 1 的指令邮箱（xQueueOverwrite） */
+static StreamBufferHandle_t s_rx_sb;  /* UART5 中断 → 协议任务 */
+static TimerHandle_t s_fs_timer;      /* 失联保护 */
+static TaskHandle_t s_proto_task;
+static volatile bool s_link_timeout_pending = false; /* 失联定时器到期，待协议任务处理 */
+static rtos_stats_t s_stats = {0};
+
+/* ========================= 执行任务（最高优先级） ========================= */
+/* 唯一写 PWM 输出的地方：立即指令、到点的定时指令、失联回中都经邮箱到这里 */
+static void actuate_task(void *arg)
+{
+    (void)arg;
+    act_cmd_t cmd;
+    for (;;)
+    {
+        if (xQueueReceive(s_act_q, &cmd, portMAX_DELAY) != pdPASS)
+            continue;
+
+        for (uint8_t ch = 1; ch <= 8; ++ch)
+        {
+            Driver_pwm_SetDuty(ch, cmd.duty[ch - 1]);
+        }
+        s_stats.applied++;
+
+        const uint32_t lat = (uint32_t)((xTaskGetTickCount() - cmd.posted) * portTICK_PERIOD_MS);
+        if (lat > s_stats.max_latency_ms)
+            s_stats.max_latency_ms = lat;
+    }
+}
+
+void App_rtos_PostDuty(const float duty[8])
+{
+    act_cmd_t cmd;
+    memcpy(cmd.duty, duty, sizeof(cmd.duty));
+    cmd.posted = xTaskGetTickCount();
+
+    /* 立即指令优先：先作废排队中的定时指令，之后 TIM5 不会再用旧指令覆盖邮箱 */
+    Sched_pwm_Clear();
+
+    /* 邮箱里还有未执行的指令 → 被新值覆盖（执行任务优先级最高，正常不会发生） */
+    if (uxQueueMessagesWaiting(s_act_q) > 0)
+        s_stats.overwritten++;
+    xQueueOverwrite(s_act_q, &cmd);
+}
+
+void App_rtos_PostDutyFromISR(const float duty[8])
+{
+    act_cmd_t cmd;
+    memcpy(cmd.duty, duty, sizeof(cmd.duty));
+    cmd.posted = xTaskGetTickCountFromISR();
+
+    BaseType_t woken = pdFALSE;
+    if (uxQueueMessagesWaitingFromISR(s_act_q) > 0)
+        s_stats.overwritten++;
+    xQueueOverwriteFromISR(s_act_q, &cmd, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/* ========================= 失联保护（软件定时器） ========================= */
+/* 协议状态（SEQ 基准 / 链路状态 / 相位）只由协议任务修改：这里只置位并唤醒它。
+ * 通知用 eNoAction，与流缓冲写入唤醒接收方的方式相同；协议任务未阻塞时通知保持挂起，下次接收立即返回 */
+static void failsafe_cb(TimerHandle_t t)
+{
+    (void)t;
+    s_stats.failsafe++;
+    s_link_timeout_pending = true; /* 自动重载：失联期间每周期重复 */
+    xTaskNotify(s_proto_task, 0, eNoAction);
+}
+
+void App_rtos_LinkAlive(void)
+{
+    xTimerReset(s_fs_timer, 0);
+}
+
+void App_rtos_SetFailsafeMs(uint32_t ms)
+{
+    if (s_fs_timer)
+        xTimerChangePeriod(s_fs_timer, pdMS_TO_TICKS(ms), 0);
+}
+
+/* ========================= 协议 / ACK 任务 ========================= */
+void App_rtos_RxFromISR(const uint8_t *data, uint16_t n)
+{
+    BaseType_t woken = pdFALSE;
+    const size_t sent = xStreamBufferSendFromISR(s_rx_sb, data, n, &woken);
+    if (sent < n)
+        s_stats.rx_overflow += (uint32_t)(n - sent);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void proto_task(void *arg)
+{
+    (void)arg;
+    uint8_t chunk[PROTOCOL_MSG_LEN];
+    for (;;)
+    {
+        /* 触发级别 1：中断写入任意字节即唤醒；失联定时器到期也会唤醒（n 可能为 0） */
+        const size_t n = xStreamBufferReceive(s_rx_sb, chunk, sizeof(chunk), portMAX_DELAY);
+        if (s_link_timeout_pending)
+        {
+            s_link_timeout_pending = false;
+            protocol_link_timeout(); /* 回中位（经执行任务）并重置 SEQ 基准 */
+        }
+        if (n > 0)
+        {
+            protocol_process_bytes(chunk, (uint16_t)n); /* PWM → 执行任务；HB → 本任务直接回 ACK */
+        }
+    }
+}
+
+/* ========================= 状态 / 遥测任务（最低优先级） ========================= */
+static void status_task(void *arg)
+{
+    (void)arg;
+#if (CFG_STATUS_PERIOD_MS > 0u)
+    TickType_t last = xTaskGetTickCount();
+    for (;;)
+    {
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(CFG_STATUS_PERIOD_MS));
+
+        const proto_stats_t *ps = protocol_stats();
+        /* 调试串口 VOFA+ JustFloat：写入双缓冲后立即返回，由 DMA 在后台发送 */
+        const float v[7] = {(float)ps->rx_ok, (float)ps->rx_crc_err, (float)ps->seq_gaps,
+                            (float)s_stats.applied, (float)s_stats.failsafe,
+                            (float)s_stats.max_latency_ms, (float)Telem_Stats()->overrun};
+        (void)Telem_Push(v, 7);
+    }
+#else
+    vTaskDelete(NULL);
+#endif
+}
+
+/* ========================= 启动 ========================= */
+void App_rtos_Start(void)
+{
+    s_act_q = xQueueCreate(1, sizeof(act_cmd_t));
+    s_rx_sb = xStreamBufferCreate(CFG_RTOS_RX_STREAM_SIZE, 1);
+    s_fs_timer = xTimerCreate("failsafe", pdMS_TO_TICKS(CFG_FAILSAFE_TIMEOUT_MS), pdTRUE, NULL, failsafe_cb);
+    if (!s_act_q || !s_rx_sb || !s_fs_timer)
+        Error_Handler();
+
+    /* UART5 中断调用 FromISR API：优先级不得高于 configMAX_SYSCALL_INTERRUPT_PRIORITY */
+    HAL_NVIC_SetPriority(UART5_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0);
+
+    protocol_process_init(); /* 启动 UART5 DMA + 空闲中断；之前到达的数据进入流缓冲 */
+    Sched_pwm_Init();
+    /* TIM5 到点后经 FromISR 投递给执行任务：优先级同样受内核限制，且低于 UART5 */
+    HAL_NVIC_SetPriority(TIM5_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY + 1u, 0);
+
+    if (xTaskCreate(actuate_task, "actuate", CFG_RTOS_STACK_ACTUATE, NULL, CFG_RTOS_PRIO_ACTUATE, NULL) != pdPASS ||
+        xTaskCreate(proto_task, "proto", CFG_RTOS_STACK_PROTO, NULL, CFG_RTOS_PRIO_PROTO, &s_proto_task) != pdPASS ||
+        xTaskCreate(status_task, "status", CFG_RTOS_STACK_STATUS, NULL, CFG_RTOS_PRIO_STATUS, NULL) != pdPASS)
+    {
+        Error_Handler();
+    }
+
+    xTimerStart(s_fs_timer, 0);
+    vTaskStartScheduler();
+
+    /* 堆不足以创建空闲/定时器任务时才会返回 */
+    Error_Handler();
+}
+
+const rtos_stats_t *App_rtos_Stats(void)
+{
+    return &s_stats;
+}
+
+/* ========================= 内核钩子 ========================= */
+void vApplicationStackOverflowHook(TaskHandle_t task, char *name)
+{
+    (void)task;
+    (void)name;
+    protocol_force_failsafe();
+    Error_Handler();
+}
+
+void vApplicationMallocFailedHook(void)
+{
+    protocol_force_failsafe();
+    Error_Handler();
+}
+
+#endif /* CFG_USE_RTOS */
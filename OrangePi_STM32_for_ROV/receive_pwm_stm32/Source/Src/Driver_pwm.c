@@ -56,7 +56,8 @@ void Driver_PWM_Init(void)
     __HAL_TIM_SET_COMPARE(&htim4, TIM_CHANNEL_4, 1500);
     //其他通道均为0占空比
 
-    HAL_Delay(3000); //等待3秒,确保电机初始化
+    //电调上电自检所需的中位保持时间（CFG_STARTUP_WARMUP_MS）由协议层的暖机状态负责，这里不阻塞：
+    //暖机期间串口与协议栈已在运行，可应答心跳，只是不应用 PWM 指令
 }
 //! pwm对应推进器的映射关系转移到上层应用（即香橙派）
 
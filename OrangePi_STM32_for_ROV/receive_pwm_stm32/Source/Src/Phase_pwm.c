@@ -0,0 +1,172 @@
+#include "Phase_pwm.h"
+#include "config.h"
+#include "tim.h"
+#include <string.h>
+
+/* 每个定时器一个锁相环（TIM1 / TIM4 各自启动，初始相位不同） */
+typedef struct
+{
+    TIM_HandleTypeDef *htim;
+    int32_t nominal;  /* 名义周期（μs，Init 时的 ARR+1） */
+    int32_t integ_q8; /* 积分项（μs，Q8） */
+    int32_t mean;     /* 误差 EMA（μs） */
+    int32_t var;      /* 误差方差 EMA（μs²） */
+    int32_t sd;       /* √var */
+} phase_loop_t;
+
+static phase_loop_t s_loop[2];
+static phase_stats_t s_stats;
+static uint32_t s_lag_ema_q4 = 0;
+static uint32_t s_last_apply_ms = 0;
+static uint32_t s_ivl_ema_q4 = 0; /* 指令间隔 EMA（ms，Q4） */
+
+static inline int32_t wrap_half(int32_t d, int32_t p)
+{
+    while (d >= p / 2)
+        d -= p;
+    while (d < -p / 2)
+        d += p;
+    return d;
+}
+
+static inline int32_t clamp_i32(int32_t v, int32_t lim)
+{
+    return (v > lim) ? lim : (v < -lim) ? -lim : v;
+}
+
+void Phase_pwm_Init(void)
+{
+    memset(s_loop, 0, sizeof(s_loop));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_loop[0].htim = &htim1;
+    s_loop[1].htim = &htim4;
+    for (int k = 0; k < 2; ++k)
+    {
+        s_loop[k].nominal = (int32_t)__HAL_TIM_GET_AUTORELOAD(s_loop[k].htim) + 1;
+#if (CFG_PHASE_ALIGN_ENABLE)
+        /* ARR 预装载：修改只在下一个更新事件生效，计数器永远不会越过新 ARR */
+        s_loop[k].htim->Instance->CR1 |= TIM_CR1_ARPE;
+#endif
+    }
+    s_stats.mean_lag_us = 0xFFFFu;
+    s_lag_ema_q4 = 0;
+    s_ivl_ema_q4 = 0;
+}
+
+#if (CFG_PHASE_ALIGN_ENABLE)
+static void loop_reset(phase_loop_t *w)
+{
+    w->integ_q8 = 0;
+    w->mean = 0;
+    w->var = 0;
+    w->sd = 0;
+    __HAL_TIM_SET_AUTORELOAD(w->htim, (uint32_t)(w->nominal - 1));
+}
+
+static int32_t isqrt(int32_t v)
+{
+    int32_t r = 0;
+    for (int32_t b = 1 << 14; b > 0; b >>= 1)
+    {
+        if ((r + b) * (r + b) <= v)
+            r += b;
+    }
+    return r;
+}
+
+/* 一帧的相位样本 → 下一周期的 ARR */
+static void loop_update(phase_loop_t *w, int32_t cnt, int32_t p_cur)
+{
+    int32_t margin = (int32_t)CFG_PHASE_MARGIN_US + 2 * w->sd;
+    if (margin > w->nominal / 2)
+        margin = w->nominal / 2;
+    const int32_t e = wrap_half(cnt - (p_cur - margin), p_cur); /* <0：到达偏早，需缩短周期 */
+
+    /* 误差统计（EMA 1/16）：均值用于锁定判定，σ 用于目标余量 */
+    w->mean += (e - w->mean) / 16;
+    const int32_t d = clamp_i32(e - w->mean, 10000);
+    w->var += (d * d - w->var) / 16;
+    w->sd = isqrt(w->var);
+
+    /* PI：积分项即“指令周期 - 名义周期”的估计，限幅防饱和 */
+    const int32_t lim = (int32_t)CFG_PHASE_MAX_STEP_US;
+    w->integ_q8 = clamp_i32(w->integ_q8 + e * (256 / (1 << CFG_PHASE_KI_SHIFT)), lim * 256);
+    const int32_t u = clamp_i32(e / (1 << CFG_PHASE_KP_SHIFT) + w->integ_q8 / 256, lim);
+
+    __HAL_TIM_SET_AUTORELOAD(w->htim, (uint32_t)(w->nominal + u - 1));
+}
+#endif
+
+#if (CFG_PHASE_ALIGN_ENABLE)
+/* 指令间隔是否在可锁定范围（名义周期 ± CFG_PHASE_MAX_STEP_US，按 1ms 分辨率放宽 1ms） */
+static bool interval_lockable(void)
+{
+    const uint32_t now = HAL_GetTick();
+    const uint32_t ivl = now - s_last_apply_ms;
+    s_last_apply_ms = now;
+    if (s_stats.samples == 0 || ivl > 1000u)
+    {
+        s_ivl_ema_q4 = 0; /* 首帧 / 长时间无指令：重新估计 */
+        return false;
+    }
+    s_ivl_ema_q4 = (s_ivl_ema_q4 == 0) ? (ivl << 4) : s_ivl_ema_q4 - (s_ivl_ema_q4 >> 4) + ivl;
+
+    const int32_t ivl_us = (int32_t)((s_ivl_ema_q4 * 1000u) >> 4);
+    const int32_t tol = (int32_t)CFG_PHASE_MAX_STEP_US + 1000;
+    return (ivl_us - s_loop[0].nominal) <= tol && (s_loop[0].nominal - ivl_us) <= tol;
+}
+#endif
+
+void Phase_pwm_OnApply(void)
+{
+    uint32_t lag_sum = 0;
+    bool locked = true;
+#if (CFG_PHASE_ALIGN_ENABLE)
+    /* 指令周期超出可调范围（如 100Hz 主机）时锁相无意义，保持名义周期 */
+    const bool lockable = interval_lockable();
+#endif
+    for (int k = 0; k < 2; ++k)
+    {
+        phase_loop_t *w = &s_loop[k];
+        const int32_t p = (int32_t)__HAL_TIM_GET_AUTORELOAD(w->htim) + 1;
+        const int32_t cnt = (int32_t)__HAL_TIM_GET_COUNTER(w->htim);
+        lag_sum += (uint32_t)(p - cnt); /* 到达 → 下一次更新事件 */
+
+#if (CFG_PHASE_ALIGN_ENABLE)
+        if (lockable)
+            loop_update(w, cnt, p);
+        else if (w->integ_q8 != 0 || p != w->nominal)
+            loop_reset(w);
+        s_stats.err_us[k] = (int16_t)w->mean;
+        s_stats.adj_us[k] = (int16_t)((int32_t)__HAL_TIM_GET_AUTORELOAD(w->htim) + 1 - w->nominal);
+        if (w->mean > (int32_t)CFG_PHASE_DEADBAND_US || w->mean < -(int32_t)CFG_PHASE_DEADBAND_US)
+            locked = false;
+#else
+        locked = false;
+#endif
+    }
+
+    /* 平均滞后 EMA(1/16)，首样本直接取值 */
+    const uint32_t lag_q4 = (lag_sum / 2u) << 4;
+    s_lag_ema_q4 = (s_stats.samples == 0) ? lag_q4 : s_lag_ema_q4 - (s_lag_ema_q4 >> 4) + (lag_q4 >> 4);
+    s_stats.mean_lag_us = (uint16_t)((s_lag_ema_q4 >> 4) > 0xFFFEu ? 0xFFFEu : (s_lag_ema_q4 >> 4));
+    s_stats.samples++;
+    s_stats.locked = locked && (s_stats.samples >= 16u);
+}
+
+void Phase_pwm_Reset(void)
+{
+#if (CFG_PHASE_ALIGN_ENABLE)
+    for (int k = 0; k < 2; ++k)
+    {
+        loop_reset(&s_loop[k]);
+        s_stats.adj_us[k] = 0;
+    }
+    s_stats.locked = false;
+#endif
+}
+
+const phase_stats_t *Phase_pwm_Stats(void)
+{
+    return &s_stats;
+}
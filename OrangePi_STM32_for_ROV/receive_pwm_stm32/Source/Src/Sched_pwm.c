@@ -0,0 +1,160 @@
+#include "Sched_pwm.h"
+#include "Driver_pwm.h"
+#include "config.h"
+#include "tim.h"
+#include <string.h>
+
+#if (CFG_USE_RTOS)
+#include "App_rtos.h"
+#endif
+
+/* 队列按 due 升序排列；主循环插入、TIM5 中断取出，插入/清空时短暂屏蔽 TIM5 中断 */
+typedef struct
+{
+    uint32_t due;
+    float duty[8];
+} sched_cmd_t;
+
+static sched_cmd_t s_q[CFG_SCHED_QUEUE_LEN];
+static volatile uint8_t s_qlen = 0;
+static sched_stats_t s_stats = {0};
+
+/* 立即应用（主循环 / 协议任务）。RTOS 下输出只由执行任务写，这里只投递 */
+static void apply_duty(const float duty[8])
+{
+#if (CFG_USE_RTOS)
+    App_rtos_PostDuty(duty);
+#else
+    for (uint8_t ch = 1; ch <= 8; ++ch)
+    {
+        Driver_pwm_SetDuty(ch, duty[ch - 1]);
+    }
+#endif
+}
+
+/* 到点应用（TIM5 中断） */
+static void apply_due_duty(const float duty[8])
+{
+#if (CFG_USE_RTOS)
+    App_rtos_PostDutyFromISR(duty);
+#else
+    apply_duty(duty);
+#endif
+}
+
+/* 回绕安全的时刻比较：a 是否早于 b */
+static inline bool tick_before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+void Sched_pwm_Init(void)
+{
+    s_qlen = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+
+#if (CFG_SCHED_APPLY_ENABLE)
+    /* TIM5：APB1 定时器时钟 80MHz / 160 = 500kHz，ARR=500-1 → 1ms 更新中断 */
+    __HAL_TIM_SET_AUTORELOAD(&htim5, 500u - 1u);
+    __HAL_TIM_SET_COUNTER(&htim5, 0u);
+    HAL_NVIC_SetPriority(TIM5_IRQn, 2, 0); /* 低于 UART5/DMA，不影响收包 */
+    HAL_NVIC_EnableIRQ(TIM5_IRQn);
+    HAL_TIM_Base_Start_IT(&htim5);
+#endif
+}
+
+void Sched_pwm_Push(uint32_t due_tick, const float duty[8])
+{
+    const uint32_t now = HAL_GetTick();
+
+    /* 已过期：容忍内立即应用，超出则丢弃（推力指令宁缺勿滞后） */
+    if (!tick_before(now, due_tick))
+    {
+        const uint32_t late_ms = now - due_tick;
+        if (late_ms > CFG_SCHED_LATE_DROP_MS)
+        {
+            s_stats.late_drop++;
+            return;
+        }
+        s_stats.late++;
+        if ((int32_t)late_ms > s_stats.max_late_ms)
+            s_stats.max_late_ms = (int32_t)late_ms;
+        Sched_pwm_Clear(); /* 比它更早的排队指令已无意义 */
+        apply_duty(duty);
+        return;
+    }
+
+    /* 过远：主机时钟偏移尚未收敛或主机重启，退化为立即应用 */
+    if (due_tick - now > CFG_SCHED_MAX_LEAD_MS)
+    {
+        s_stats.far_future++;
+        Sched_pwm_Clear();
+        apply_duty(duty);
+        return;
+    }
+
+    HAL_NVIC_DisableIRQ(TIM5_IRQn);
+
+    /* 队列满：挤掉最早一条（它很快就会被后续指令覆盖） */
+    if (s_qlen >= CFG_SCHED_QUEUE_LEN)
+    {
+        memmove(&s_q[0], &s_q[1], sizeof(s_q[0]) * (CFG_SCHED_QUEUE_LEN - 1u));
+        s_qlen = CFG_SCHED_QUEUE_LEN - 1u;
+        s_stats.overflow++;
+    }
+
+    /* 按 due 升序插入；同一时刻的后到者排在后面（以新值为准） */
+    uint8_t pos = s_qlen;
+    while (pos > 0 && tick_before(due_tick, s_q[pos - 1].due))
+    {
+        s_q[pos] = s_q[pos - 1];
+        --pos;
+    }
+    s_q[pos].due = due_tick;
+    memcpy(s_q[pos].duty, duty, sizeof(s_q[pos].duty));
+    s_qlen++;
+
+    HAL_NVIC_EnableIRQ(TIM5_IRQn);
+}
+
+void Sched_pwm_Clear(void)
+{
+    HAL_NVIC_DisableIRQ(TIM5_IRQn);
+    s_qlen = 0;
+    HAL_NVIC_EnableIRQ(TIM5_IRQn);
+}
+
+/* 1ms 节拍：应用所有已到点的指令（只输出最后一条，中间值被覆盖） */
+void Sched_pwm_TimerIRQ(void)
+{
+    if (__HAL_TIM_GET_FLAG(&htim5, TIM_FLAG_UPDATE) == RESET)
+        return;
+    __HAL_TIM_CLEAR_IT(&htim5, TIM_IT_UPDATE);
+
+    const uint32_t now = HAL_GetTick();
+    uint8_t n = 0;
+    while (n < s_qlen && !tick_before(now, s_q[n].due))
+    {
+        ++n;
+    }
+    if (n == 0)
+        return;
+
+    const int32_t lag = (int32_t)(now - s_q[n - 1].due);
+    if (lag > s_stats.max_late_ms)
+        s_stats.max_late_ms = lag;
+
+    apply_due_duty(s_q[n - 1].duty);
+    s_stats.applied += n;
+
+    s_qlen = (uint8_t)(s_qlen - n);
+    if (s_qlen > 0)
+    {
+        memmove(&s_q[0], &s_q[n], sizeof(s_q[0]) * s_qlen);
+    }
+}
+
+const sched_stats_t *Sched_pwm_Stats(void)
+{
+    return &s_stats;
+}
@@ -0,0 +1,145 @@
+#include "Tlog.h"
+#include "Uart_service.h"
+#include <stdarg.h>
+#include <string.h>
+
+static tlog_stats_t s_stats;
+static volatile uint8_t s_seq = 0; /* 6 位记录序号，主机据此发现丢弃 */
+
+/* CRC-8（多项式 0x07，初值 0），覆盖 LEN..参数末尾 */
+static uint8_t crc8(const uint8_t *p, uint16_t n)
+{
+    uint8_t c = 0;
+    while (n--)
+    {
+        c ^= *p++;
+        for (uint8_t i = 0; i < 8; i++)
+            c = (uint8_t)((c & 0x80u) ? ((unsigned)(c << 1) ^ 0x07u) : (unsigned)(c << 1));
+    }
+    return c;
+}
+
+static inline void le32_write(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v);
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* 按格式串取参数写入 out，返回写入字节数；超出容量置 *trunc */
+static uint16_t pack_args(const char *fmt, va_list ap, uint8_t *out, bool *trunc)
+{
+    uint16_t n = 0;
+    for (const char *p = fmt; *p; p++)
+    {
+        if (*p != '%')
+            continue;
+        p++;
+        if (*p == '%')
+            continue;
+        /* 标志 / 宽度 / 精度 */
+        while (*p && strchr("-+ #0123456789.", *p))
+            p++;
+        uint8_t ll = 0;
+        while (*p && strchr("hlLqjzt", *p))
+        {
+            if (*p == 'l' && p[1] == 'l')
+            {
+                ll = 1;
+                p++;
+            }
+            p++;
+        }
+        if (!*p)
+            break;
+
+        uint8_t tmp[1 + TLOG_STR_MAX];
+        uint16_t w;
+        switch (*p)
+        {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            if (ll)
+            {
+                const uint64_t v = va_arg(ap, unsigned long long);
+                le32_write(tmp, (uint32_t)v);
+                le32_write(tmp + 4, (uint32_t)(v >> 32));
+                w = 8;
+            }
+            else
+            {
+                /* 32 位目标上 long / size_t 与 int 同宽 */
+                le32_write(tmp, va_arg(ap, unsigned int));
+                w = 4;
+            }
+            break;
+        case 'p':
+            le32_write(tmp, (uint32_t)(uintptr_t)va_arg(ap, void *));
+            w = 4;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        {
+            const float f = (float)va_arg(ap, double);
+            memcpy(tmp, &f, 4);
+            w = 4;
+            break;
+        }
+        case 's':
+        {
+            const char *s = va_arg(ap, const char *);
+            uint8_t len = 0;
+            while (s && s[len] && len < TLOG_STR_MAX)
+                len++;
+            tmp[0] = len;
+            if (len)
+                memcpy(tmp + 1, s, len);
+            w = (uint16_t)(1u + len);
+            break;
+        }
+        default:
+            return n; /* 不支持的转换，其后参数不再发送 */
+        }
+        if (n + w > TLOG_MAX_ARG_BYTES)
+        {
+            *trunc = true;
+            return n;
+        }
+        memcpy(out + n, tmp, w);
+        n = (uint16_t)(n + w);
+    }
+    return n;
+}
+
+void Tlog_Emit(uint8_t level, const char *fmt, ...)
+{
+    uint8_t rec[TLOG_HDR_BYTES + TLOG_MAX_ARG_BYTES + 1u];
+    bool trunc = false;
+
+    va_list ap;
+    va_start(ap, fmt);
+    const uint16_t nargs = pack_args(fmt, ap, rec + TLOG_HDR_BYTES, &trunc);
+    va_end(ap);
+
+    /* 序号在关中断区外自增：并发调用偶尔重号只影响丢弃统计，不影响解码 */
+    const uint8_t seq = s_seq;
+    s_seq = (uint8_t)((seq + 1u) & 0x3Fu);
+
+    rec[0] = TLOG_SYNC;
+    rec[1] = (uint8_t)nargs;
+    rec[2] = (uint8_t)(((level - 1u) & 0x03u) | (seq << 2));
+    le32_write(rec + 3, (uint32_t)(uintptr_t)fmt);
+    le32_write(rec + 7, HAL_GetTick());
+    rec[TLOG_HDR_BYTES + nargs] = crc8(rec + 1, (uint16_t)(TLOG_HDR_BYTES - 1u + nargs));
+
+    if (trunc)
+        s_stats.truncated++;
+    if (Telem_PushBytes(rec, (uint16_t)(TLOG_HDR_BYTES + nargs + 1u)))
+        s_stats.emitted++;
+    else
+        s_stats.dropped++;
+}
+
+const tlog_stats_t *Tlog_Stats(void)
+{
+    return &s_stats;
+}
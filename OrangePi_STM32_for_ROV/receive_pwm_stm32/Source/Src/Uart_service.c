@@ -1,75 +1,175 @@
 #include "Uart_service.h"
 #include "usart.h"
-#include <stdbool.h>
+#include "board.h"
+#include "config.h"
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
+/* VOFA+ JustFloat 帧尾 */
+#define TAIL_BYTES 4u
+static const uint8_t k_tail[TAIL_BYTES] = {0x00, 0x00, 0x80, 0x7F};
 
+#define FRAME_MAX_BYTES (TELEM_MAX_FLOATS * 4u + TAIL_BYTES)
 
-#define MAX_FLOAT_COUNT 20
-#define TX_BUF_SIZE (MAX_FLOAT_COUNT * 4 + 4)
+#if (CFG_TELEM_BUF_SIZE < FRAME_MAX_BYTES)
+#error "CFG_TELEM_BUF_SIZE 至少要容纳一帧（TELEM_MAX_FLOATS 个 float + 帧尾）"
+#endif
 
-static uint8_t _tx_buf[TX_BUF_SIZE];
-static volatile bool _dma_busy = false;
+/* ========================= 双缓冲遥测 ========================= */
+
+static uint8_t s_buf[2][CFG_TELEM_BUF_SIZE];
+static uint16_t s_len[2];           /* 各半区已写入字节数 */
+static uint8_t s_fill = 0;          /* 当前写入的半区 */
+static volatile bool s_dma_busy = false;
+static telem_stats_t s_stats;
+
+/* 把写入半区交给 DMA 并换区；调用方已关中断 */
+static void kick_locked(void)
+{
+    if (s_dma_busy || s_len[s_fill] == 0)
+        return;
+
+    const uint8_t tx = s_fill;
+    const uint16_t n = s_len[tx];
+    s_fill ^= 1u;
+    s_len[s_fill] = 0;
+
+    if (n > s_stats.max_fill)
+        s_stats.max_fill = n;
+
+    if (HAL_UART_Transmit_DMA(&UART_DBG_HANDLE, s_buf[tx], n) == HAL_OK)
+    {
+        s_dma_busy = true;
+        s_stats.bytes_tx += n;
+    }
+    else
+    {
+        s_stats.dma_err++; /* 串口被阻塞发送占用等：本半区丢弃 */
+    }
+}
+
+void Telem_Init(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_len[0] = s_len[1] = 0;
+    s_fill = 0;
+    s_dma_busy = false;
+
+#if (CFG_TELEM_UART_BAUD > 0u)
+    UART_DBG_HANDLE.Init.BaudRate = CFG_TELEM_UART_BAUD;
+    if (HAL_UART_Init(&UART_DBG_HANDLE) != HAL_OK)
+    {
+        s_stats.dma_err++;
+    }
+#endif
+}
+
+/* 两段拼成一帧整体写入（要么全部写入要么整帧丢弃，不会把半帧留给 DMA） */
+static bool push2(const void *a, uint16_t na, const void *b, uint16_t nb)
+{
+    const uint16_t need = (uint16_t)(na + nb);
+    bool ok = false;
+
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint8_t *dst = s_buf[s_fill] + s_len[s_fill];
+    if (s_len[s_fill] + need <= CFG_TELEM_BUF_SIZE)
+    {
+        memcpy(dst, a, na);
+        if (nb)
+            memcpy(dst + na, b, nb);
+        s_len[s_fill] = (uint16_t)(s_len[s_fill] + need);
+        s_stats.frames++;
+        ok = true;
+    }
+    else
+    {
+        s_stats.overrun++;
+    }
+    kick_locked();
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+bool Telem_Push(const float *v, uint8_t n)
+{
+    if (!v || n == 0 || n > TELEM_MAX_FLOATS)
+        return false;
+    /* Cortex-M4 小端，与 JustFloat 一致 */
+    return push2(v, (uint16_t)(n * 4u), k_tail, TAIL_BYTES);
+}
+
+bool Telem_PushBytes(const void *data, uint16_t n)
+{
+    if (!data || n == 0 || n > FRAME_MAX_BYTES)
+        return false;
+    return push2(data, n, NULL, 0);
+}
+
+const telem_stats_t *Telem_Stats(void)
+{
+    return &s_stats;
+}
 
 /**
- * @brief UART DMA 发送完成回调，清除忙标志
+ * @brief UART DMA 发送完成回调：调试串口换区并继续发送
  */
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
-    if (huart->Instance == USART6)
+    if (huart->Instance == UART_DBG_HANDLE.Instance)
     {
-        _dma_busy = false;
+        s_dma_busy = false;
+        kick_locked(); /* 中断上下文，优先级不低于 Telem_Push 的关中断区 */
     }
 }
 
+/**
+ * @brief UART 错误回调：调试串口 DMA 发送中止时释放忙标志，避免遥测永久停摆
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == UART_DBG_HANDLE.Instance && huart->gState == HAL_UART_STATE_READY)
+    {
+        s_stats.dma_err++;
+        s_dma_busy = false;
+    }
+}
+
+/* ========================= 兼容旧接口 ========================= */
+
 bool UART_SendFloats_DMA(uint8_t count, ...)
 {
-    if (_dma_busy || count == 0 || count > MAX_FLOAT_COUNT)
+    if (count == 0 || count > TELEM_MAX_FLOATS)
     {
         return false;
     }
 
+    float v[TELEM_MAX_FLOATS];
     va_list args;
     va_start(args, count);
-
-    uint8_t *p = _tx_buf;
     for (uint8_t i = 0; i < count; i++)
     {
         // float 在可变参数里会被提升为 double
-        double tmp = va_arg(args, double);
-        float v = (float)tmp;
-        memcpy(p, &v, sizeof(v)); // 小端复制
-        p += sizeof(v);
+        v[i] = (float)va_arg(args, double);
     }
     va_end(args);
 
-    // 末尾追加帧尾 0x00,0x00,0x80,0x7F
-    *p++ = 0x00;
-    *p++ = 0x00;
-    *p++ = 0x80;
-    *p++ = 0x7F;
-
-    size_t len = p - _tx_buf;
-    if (HAL_UART_Transmit_DMA(&huart1, _tx_buf, len) != HAL_OK)
-    {
-        return false;
-    }
-    _dma_busy = true;
-    return true;
+    return Telem_Push(v, count);
 }
 
 bool UART_SendFloats_Blocking(uint8_t count, ...)
 {
-    if (count == 0 || count > MAX_FLOAT_COUNT)
+    if (count == 0 || count > TELEM_MAX_FLOATS)
     {
         return false;
     }
 
+    uint8_t buf[FRAME_MAX_BYTES];
     va_list args;
     va_start(args, count);
 
-    uint8_t *p = _tx_buf;
+    uint8_t *p = buf;
     for (uint8_t i = 0; i < count; i++)
     {
         // float 在可变参数里会被提升为 double
@@ -81,13 +181,11 @@ bool UART_SendFloats_Blocking(uint8_t count, ...)
     va_end(args);
 
     // 末尾追加帧尾 0x00,0x00,0x80,0x7F
-    *p++ = 0x00;
-    *p++ = 0x00;
-    *p++ = 0x80;
-    *p++ = 0x7F;
+    memcpy(p, k_tail, sizeof(k_tail));
+    p += sizeof(k_tail);
 
-    size_t len = p - _tx_buf;
-    if (HAL_UART_Transmit(&huart1, _tx_buf, len, HAL_MAX_DELAY) != HAL_OK)
+    size_t len = p - buf;
+    if (HAL_UART_Transmit(&UART_DBG_HANDLE, buf, len, HAL_MAX_DELAY) != HAL_OK)
     {
         return false;
     }
@@ -96,9 +194,11 @@ bool UART_SendFloats_Blocking(uint8_t count, ...)
 
 
 
+/* printf 重定向：字节写入遥测双缓冲由 DMA 发送，不再逐字节阻塞（缓冲满时丢弃） */
 int fputc(int ch, FILE *f)
 {
-  HAL_UART_Transmit(&huart1, (uint8_t *)&ch, 1, 0xffff);
+  const uint8_t c = (uint8_t)ch;
+  (void)Telem_PushBytes(&c, 1);
   return ch;
 }
  
@@ -0,0 +1,48 @@
+// cobs.c
+#include "cobs.h"
+
+uint16_t cobs_encode(const uint8_t *in, uint16_t n, uint8_t *out)
+{
+    uint16_t code_pos = 0; /* 当前块长度码的位置 */
+    uint16_t o = 1;
+    uint8_t code = 1;
+    for (uint16_t i = 0; i < n; ++i)
+    {
+        if (in[i] != 0u)
+        {
+            out[o++] = in[i];
+            ++code;
+        }
+        if (in[i] == 0u || code == 0xFFu)
+        {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    return o;
+}
+
+uint16_t cobs_decode(const uint8_t *in, uint16_t n, uint8_t *out)
+{
+    uint16_t i = 0;
+    uint16_t o = 0;
+    while (i < n)
+    {
+        const uint8_t code = in[i++];
+        if (code == 0u || (uint16_t)(i + code - 1u) > n)
+            return 0;
+        /* 原地解码时 o < i，逐字节前向复制安全 */
+        for (uint8_t k = 1; k < code; ++k)
+        {
+            if (in[i] == 0u)
+                return 0;
+            out[o++] = in[i++];
+        }
+        /* 0xFF 块后没有隐含的 0；最后一块后也没有 */
+        if (code != 0xFFu && i < n)
+            out[o++] = 0u;
+    }
+    return o;
+}
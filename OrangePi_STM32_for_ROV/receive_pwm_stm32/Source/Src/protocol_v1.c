@@ -2,7 +2,14 @@
 #include "config.h"
 #include "board.h"
 #include "Driver_pwm.h"
+#include "Sched_pwm.h"
+#include "Phase_pwm.h"
+#include "Tlog.h"
+#if (CFG_USE_RTOS)
+#include "App_rtos.h"
+#endif
 #include "crc16_ccitt.h" // 需要提供 uint16_t crc16_ccitt(const uint8_t* data, uint16_t len)
+#include "cobs.h"
 #include "protocol_v1.h"
 #include <string.h> // memmove
 #include <stdbool.h>
@@ -13,6 +20,7 @@
 /* 帧头标识 */
 #define SOF_B0 0xAAu
 #define SOF_B1 0x55u
+#define SOF_B1_V2 0x5Au /* 紧凑帧 v2 */
 
 /* 头部固定长度（不含 SOF 的 2 字节） */
 #define HEADER_REST_LEN 10u // VER(1) + MSG(1) + SEQ(2) + TICKS(4) + LEN(2)
@@ -22,6 +30,14 @@
 
 #define MIN_FRAME_LEN (HEADER_TOTAL_LEN + CRC_LEN) // 14
 
+#define V2_HDR_LEN PROTO_V2_HDR_LEN           // SOF(2) + TL(1) + SEQ8(1) + TICK16(2)
+#define V2_MIN_FRAME_LEN PROTO_V2_MIN_FRAME_LEN // 8
+
+/* COBS 分帧：无分隔符的尾段超过该长度即丢弃（最长合法帧 34 字节，编码后 35） */
+#define COBS_CHUNK_MAX 64u
+/* 本端发出的最长帧（HB_ACK 14+16） */
+#define PROTO_TX_MAX 32u
+
 
 /* 大端读写工具 */
 static inline uint16_t be16_read(const uint8_t *p)
@@ -60,13 +76,50 @@ static proto_stats_t s_stats = {0};
 static uint32_t s_last_ok_rx_ms = 0; // 最近一次收到“合法帧”的时刻（ms）
 static uint32_t s_failsafe_timeout_ms = CFG_FAILSAFE_TIMEOUT_MS;
 
+/* SEQ 去重基准：失联/上电后为 false，下一帧直接作为新基准 */
+static bool s_seq_valid = false;
+
+/* 基准来自 v2 的 SEQ8（无基准时展开，高字节未知）：下一个 v1 PWM 帧以完整 SEQ16 重新同步 */
+static bool s_seq_hi_unknown = false;
+
+/* 心跳独立 SEQ 空间：只记最近一个，用于同 SEQ 副本不重复应答 */
+static bool s_hb_seq_valid = false;
+static uint16_t s_hb_seq_last = 0;
+
+/* 链路状态（仅用于日志在上线 / 失联跳变时各记一条） */
+static bool s_link_up = false;
+
+/* 上电暖机：protocol_init 起 CFG_STARTUP_WARMUP_MS 内不应用 PWM（到期后清 s_warming，避免 tick 回绕再次进入） */
+static bool s_warming = false;
+static uint32_t s_warmup_start_ms = 0;
+
+typedef enum
+{
+    SEQ_NEW = 0, /* 新帧：应用 */
+    SEQ_DUP,     /* 同 SEQ 副本：丢弃 */
+    SEQ_STALE    /* 乱序旧帧：丢弃 */
+} seq_verdict_t;
+
 /* ========================= 内部函数声明 ========================= */
 
 static void process_rx_buffer(void);
-static bool try_parse_one_frame(uint16_t *consumed);
+static bool try_parse_one_frame(const uint8_t *buf, uint16_t avail, uint16_t *consumed);
 static void handle_msg_pwm(const uint8_t *payload, uint16_t len);
+static void handle_msg_pwm_at(const uint8_t *payload, uint16_t len);
 static void handle_msg_hb(uint16_t seq, uint32_t ticks);
 static void enter_failsafe_mid_all(void);
+static void output_duty(const float duty[8]);
+static void link_alive(void);
+static seq_verdict_t seq_check(uint16_t seq);
+static bool hb_seq_is_dup(uint16_t seq);
+static void proto_uart_send(const uint8_t *frame, uint16_t n);
+#if (CFG_PROTO_COBS_ENABLE)
+static void process_rx_cobs(void);
+#endif
+#if (CFG_PROTO_V2_ENABLE)
+static bool try_parse_v2_frame(const uint8_t *buf, uint16_t avail, uint16_t *consumed);
+static void handle_msg_pwm_v2(const uint8_t *payload, uint8_t bits, bool at);
+#endif
 
 /* ========================= 对外 API ========================= */
 // 初始化
@@ -76,9 +129,52 @@ void protocol_init(void)
     memset((void *)&s_stats, 0, sizeof(s_stats));
     s_last_ok_rx_ms = HAL_GetTick(); // 单位为ms
     s_failsafe_timeout_ms = CFG_FAILSAFE_TIMEOUT_MS;
+    s_seq_valid = false;
+    s_seq_hi_unknown = false;
+    s_hb_seq_valid = false;
+
+    /* 上电暖机：不阻塞，输出已由 protocol_force_failsafe 置中位，到时由 protocol_is_warming 自动解除 */
+    s_warmup_start_ms = HAL_GetTick();
+    s_warming = (CFG_STARTUP_WARMUP_MS > 0u);
+    s_link_up = false;
+    TLOG_I("proto init: warm-up %u ms, failsafe %u ms", (unsigned)CFG_STARTUP_WARMUP_MS,
+           (unsigned)s_failsafe_timeout_ms);
+}
 
-    /* 上电暖机阶段由 main.c 控制，这里不阻塞 */
+uint8_t protocol_is_warming(void)
+{
+    if (s_warming && (HAL_GetTick() - s_warmup_start_ms) >= CFG_STARTUP_WARMUP_MS)
+    {
+        s_warming = false;
+        TLOG_I("warm-up done");
+    }
+    return s_warming ? 1u : 0u;
 }
+/* 追加到接收滑窗 */
+static void rx_append(const uint8_t *data, uint16_t n)
+{
+    if (!data || n == 0)
+        return;
+
+    /* 如果新数据 + 旧数据会溢出，尽量丢弃老数据保留最新（简单稳妥） */
+    if (n > sizeof(s_rxbuf))
+    {
+        /* 输入太大，直接清空，只保留最后的一段数据 */
+        data += (n - sizeof(s_rxbuf));
+        n = sizeof(s_rxbuf);
+        s_rxlen = 0;
+    }
+    if (s_rxlen + n > sizeof(s_rxbuf))
+    {
+        /* 左移腾位置（简单滑窗） */
+        const uint16_t over = (uint16_t)((s_rxlen + n) - sizeof(s_rxbuf));
+        memmove(s_rxbuf, s_rxbuf + over, s_rxlen - over);
+        s_rxlen = (uint16_t)(s_rxlen - over);
+    }
+    memcpy(s_rxbuf + s_rxlen, data, n);
+    s_rxlen = (uint16_t)(s_rxlen + n);
+}
+
 // 数据传入缓冲区并进行解析数据
 void protocol_feed_bytes(const uint8_t *data, uint16_t n)
 {
@@ -87,38 +183,43 @@ void protocol_feed_bytes(const uint8_t *data, uint16_t n)
         if (!data || n == 0)
             return;
 
-        /* 如果新数据 + 旧数据会溢出，尽量丢弃老数据保留最新（简单稳妥） */
-        if (n > sizeof(s_rxbuf))
-        {
-            /* 输入太大，直接清空，只保留最后的一段数据 */
-            data += (n - sizeof(s_rxbuf));
-            n = sizeof(s_rxbuf);
-            s_rxlen = 0;
-        }
-        if (s_rxlen + n > sizeof(s_rxbuf))
-        {
-            /* 左移腾位置（简单滑窗） */
-            const uint16_t over = (uint16_t)((s_rxlen + n) - sizeof(s_rxbuf));
-            memmove(s_rxbuf, s_rxbuf + over, s_rxlen - over);
-            s_rxlen = (uint16_t)(s_rxlen - over);
-        }
-        memcpy(s_rxbuf + s_rxlen, data, n);
-        s_rxlen = (uint16_t)(s_rxlen + n);
+        rx_append(data, n);
 
         protocol_flag = 1;
         // process_rx_buffer();//解析数据，解析数据转移到protocol_process()中，在主循环进行处理
     }
 }
 
+void protocol_process_bytes(const uint8_t *data, uint16_t n)
+{
+    rx_append(data, n);
+    process_rx_buffer();
+}
+
+void protocol_link_timeout(void)
+{
+    enter_failsafe_mid_all();
+    Phase_pwm_Reset(); /* 恢复名义 PWM 周期 */
+    if (s_link_up)
+    {
+        s_link_up = false;
+        TLOG_W("link lost: no valid frame for %u ms, failsafe", (unsigned)s_failsafe_timeout_ms);
+    }
+    s_last_ok_rx_ms = HAL_GetTick();
+    /* 链路中断后主机可能已重启，SEQ 重新同步 */
+    s_seq_valid = false;
+    s_seq_hi_unknown = false;
+    s_hb_seq_valid = false;
+}
+
 void protocol_poll(void)
 {
     /* 失联保护：超时则回中位 */
     const uint32_t now = HAL_GetTick();
     if ((now - s_last_ok_rx_ms) > s_failsafe_timeout_ms)
     {
-        enter_failsafe_mid_all();
-        /* 防止重复刷 log，可选择这里刷新时戳 */
-        s_last_ok_rx_ms = now;
+        /* 防止重复刷 log，这里刷新时戳 */
+        protocol_link_timeout();
     }
 }
 
@@ -127,6 +228,9 @@ void protocol_set_failsafe_timeout_ms(uint32_t ms)
     if (ms < 50u)
         ms = 50u; /* 安全下限 */
     s_failsafe_timeout_ms = ms;
+#if (CFG_USE_RTOS)
+    App_rtos_SetFailsafeMs(ms);
+#endif
 }
 
 const proto_stats_t *protocol_stats(void)
@@ -136,13 +240,26 @@ const proto_stats_t *protocol_stats(void)
 
 /* ========================= 内部实现 ========================= */
 
+static inline bool is_sof_b1(uint8_t b)
+{
+#if (CFG_PROTO_V2_ENABLE)
+    return (b == SOF_B1) || (b == SOF_B1_V2);
+#else
+    return b == SOF_B1;
+#endif
+}
+
 static void process_rx_buffer(void)
 {
+#if (CFG_PROTO_COBS_ENABLE)
+    process_rx_cobs();
+    return;
+#endif
     /* 尝试从缓冲中解析尽可能多的完整帧 */
     for (;;)
     {
         uint16_t consumed = 0;
-        if (!try_parse_one_frame(&consumed))
+        if (!try_parse_one_frame(s_rxbuf, s_rxlen, &consumed))
         {
             break; /* 需要更多数据或缓冲为空 */
         }
@@ -159,22 +276,63 @@ static void process_rx_buffer(void)
     }
 }
 
+#if (CFG_PROTO_COBS_ENABLE)
+/* 一段 COBS 数据（不含分隔符）：原地解码后应恰好是一帧，否则整段丢弃 */
+static void handle_cobs_chunk(uint8_t *chunk, uint16_t n)
+{
+    uint16_t consumed = 0;
+    const uint16_t m = cobs_decode(chunk, n, chunk);
+    if (m == 0u || !try_parse_one_frame(chunk, m, &consumed) || consumed != m)
+    {
+        s_stats.rx_cobs_err++;
+    }
+}
+
+/* COBS 分帧：一遍扫描按 0x00 切分缓冲，每段最多一次 CRC；不完整的尾段留待下次 */
+static void process_rx_cobs(void)
+{
+    uint16_t start = 0;
+    for (uint16_t i = 0; i < s_rxlen; ++i)
+    {
+        if (s_rxbuf[i] != 0u)
+            continue;
+        if (i > start)
+            handle_cobs_chunk(s_rxbuf + start, (uint16_t)(i - start));
+        start = (uint16_t)(i + 1u);
+    }
+
+    uint16_t remain = (uint16_t)(s_rxlen - start);
+    if (remain > COBS_CHUNK_MAX)
+    {
+        /* 分隔符丢失：整段丢弃，下一个 0x00 后即恢复 */
+        s_stats.rx_cobs_err++;
+        remain = 0;
+    }
+    else if (start > 0u && remain > 0u)
+    {
+        memmove(s_rxbuf, s_rxbuf + start, remain);
+    }
+    s_rxlen = remain;
+}
+#endif
+
 /**
- * @brief 试图从 s_rxbuf 解析出一帧
+ * @brief 试图从 buf（通常为 s_rxbuf）开头解析出一帧
+ * @param buf/avail 待解析数据与有效字节数
  * @param consumed 若成功/失败但移动了指针，返回本次应丢弃的字节数；若无事可做，返回 0
  * @return true=本次成功解析并处理了一帧（调用方应继续尝试）；false=本次无帧可解（等待更多数据）
  */
-static bool try_parse_one_frame(uint16_t *consumed)
+static bool try_parse_one_frame(const uint8_t *buf, uint16_t avail, uint16_t *consumed)
 {
     *consumed = 0;
-    if (s_rxlen < 1)
+    if (avail < 1)
         return false;
 
-    /* 寻找 SOF（简洁做法：线性扫描到第一个 0xAA 0x55） */
+    /* 寻找 SOF（简洁做法：线性扫描到第一个 0xAA 0x55 / 0xAA 0x5A） */
     uint16_t pos = 0;
-    while (pos + 1 < s_rxlen)
+    while (pos + 1 < avail)
     {
-        if (s_rxbuf[pos] == SOF_B0 && s_rxbuf[pos + 1] == SOF_B1)
+        if (buf[pos] == SOF_B0 && is_sof_b1(buf[pos + 1]))
         {
             break;
         }
@@ -188,12 +346,18 @@ static bool try_parse_one_frame(uint16_t *consumed)
     }
 
     /* pos==0：当前缓冲开头就是 SOF */
-    if (s_rxlen < MIN_FRAME_LEN)
+#if (CFG_PROTO_V2_ENABLE)
+    if (avail >= SOF_LEN && buf[1] == SOF_B1_V2)
+    {
+        return try_parse_v2_frame(buf, avail, consumed);
+    }
+#endif
+    if (avail < MIN_FRAME_LEN)
     {
         return false; /* 头都不够，等待更多数据 */
     }
 
-    const uint8_t *p = s_rxbuf;
+    const uint8_t *p = buf;
 
     /* 读取固定头：VER/MSG/SEQ/TICKS/LEN（不含 SOF） */
     const uint8_t ver = p[2];
@@ -220,7 +384,7 @@ static bool try_parse_one_frame(uint16_t *consumed)
         *consumed = 1;
         return true;
     }
-    if (s_rxlen < frame_len)
+    if (avail < frame_len)
     {
         /* 数据不完整，继续等 */
         return false;
@@ -233,6 +397,7 @@ static bool try_parse_one_frame(uint16_t *consumed)
     if (crc_calc != crc_rx)
     {
         s_stats.rx_crc_err++;
+        TLOG_D("crc err: msg=%u len=%u calc=%04x rx=%04x", msg, len, crc_calc, crc_rx);
         /* 丢弃一个字节，继续搜 SOF（更鲁棒） */
         *consumed = 1;
         return true;
@@ -241,18 +406,46 @@ static bool try_parse_one_frame(uint16_t *consumed)
     /* 到这里是一帧完整合法帧 */
     const uint8_t *payload = p + HEADER_TOTAL_LEN;
 
+#if (CFG_PROTO_V2_ENABLE)
+    /* 当前基准由 v2 SEQ8 建立（高字节未知）：以本帧完整 SEQ16 重新同步，不计缺口
+     * （心跳不在 PWM 的 SEQ 空间内，不参与） */
+    if (s_seq_hi_unknown && (msg == MSG_PWM || msg == MSG_PWM_AT))
+    {
+        s_seq_hi_unknown = false;
+        s_seq_valid = false;
+    }
+#endif
+
     switch (msg)
     {
     case MSG_PWM:
-        /* 只有 PWM 与 HB 收到后才更新“链路活跃”时间（防止噪声误刷新） */
-        s_last_ok_rx_ms = HAL_GetTick();
-        handle_msg_pwm(payload, len);
+        /* 只有 PWM 与 HB 收到后才更新“链路活跃”时间（防止噪声误刷新）；
+         * 冗余副本/乱序旧帧同样证明链路存活，但不再应用 */
+        link_alive();
+        if (seq_check(seq) == SEQ_NEW)
+        {
+            handle_msg_pwm(payload, len);
+        }
+        s_stats.rx_ok++;
+        break;
+
+    case MSG_PWM_AT:
+        link_alive();
+        if (seq_check(seq) == SEQ_NEW)
+        {
+            handle_msg_pwm_at(payload, len);
+        }
         s_stats.rx_ok++;
         break;
 
     case MSG_HB:
-        s_last_ok_rx_ms = HAL_GetTick();
-        handle_msg_hb(seq, ticks);
+        /* 心跳只回 ACK 不改输出：使用独立 SEQ 空间，不计入 PWM 去重 / 缺口统计
+         * （双链路探测在备链路上的丢失不应算作控制帧丢失）；乱序照常应答，仅同 SEQ 副本不重复应答 */
+        link_alive();
+        if (!hb_seq_is_dup(seq))
+        {
+            handle_msg_hb(seq, ticks);
+        }
         s_stats.rx_ok++;
         break;
 
@@ -270,18 +463,140 @@ static bool try_parse_one_frame(uint16_t *consumed)
     return true;
 }
 
-/* ========== 业务处理：PWM ==========
- * 期望 LEN=16，内容为 8×uint16（大端），0..10000 对应占空 -1..1（5000->0）。
+#if (CFG_PROTO_V2_ENABLE)
+/* v2 SEQ8 → SEQ16：以最近的合法 SEQ 为基准就近展开（±127 帧） */
+static uint16_t seq_expand8(uint8_t seq8)
+{
+    if (!s_seq_valid)
+    {
+        s_seq_hi_unknown = true;
+        return seq8;
+    }
+    const int8_t d = (int8_t)(uint8_t)(seq8 - (uint8_t)s_stats.last_seq);
+    return (uint16_t)(s_stats.last_seq + (uint16_t)d);
+}
+
+/**
+ * @brief 解析缓冲开头的一帧紧凑帧 v2（SOF 已确认为 0xAA 0x5A），返回值约定同 try_parse_one_frame
  */
-static void handle_msg_pwm(const uint8_t *payload, uint16_t len)
+static bool try_parse_v2_frame(const uint8_t *buf, uint16_t avail, uint16_t *consumed)
 {
-    if (len != 16u)
+    if (avail < V2_MIN_FRAME_LEN)
+        return false;
+
+    const uint8_t *p = buf;
+    const uint8_t type = (uint8_t)(p[2] >> 5);
+    const uint8_t len = (uint8_t)(p[2] & 0x1Fu);
+    const uint16_t frame_len = (uint16_t)(V2_HDR_LEN + len + CRC_LEN);
+    if (avail < frame_len)
+        return false;
+
+    /* CRC 覆盖 TL..PAYLOAD */
+    const uint16_t crc_calc = crc16_ccitt(p + SOF_LEN, (uint16_t)(V2_HDR_LEN - SOF_LEN + len));
+    const uint16_t crc_rx = be16_read(p + V2_HDR_LEN + len);
+    if (crc_calc != crc_rx)
+    {
+        s_stats.rx_crc_err++;
+        TLOG_D("v2 crc err: type=%u len=%u calc=%04x rx=%04x", type, len, crc_calc, crc_rx);
+        *consumed = 1;
+        return true;
+    }
+
+    const bool at = (type == PROTO_V2_PWM12_AT) || (type == PROTO_V2_PWM14_AT);
+    const uint8_t bits = ((type == PROTO_V2_PWM14) || (type == PROTO_V2_PWM14_AT)) ? 14u : 12u;
+    if (type > PROTO_V2_PWM14_AT)
+    {
+        s_stats.rx_unsupported++;
+    }
+    else if (len != (uint8_t)((at ? 2u : 0u) + bits)) /* 8 路 × bits 位 = bits 字节 */
     {
         s_stats.rx_len_err++;
-        return;
+    }
+    else
+    {
+        link_alive();
+        s_stats.rx_v2++;
+        if (seq_check(seq_expand8(p[3])) == SEQ_NEW)
+        {
+            handle_msg_pwm_v2(p + V2_HDR_LEN, bits, at);
+        }
+        s_stats.rx_ok++;
     }
 
-    float duty[8];
+    *consumed = frame_len;
+    return true;
+}
+#endif
+
+/* 合法帧到达：刷新链路活跃时刻；RTOS 下同时重置失联保护软件定时器 */
+static void link_alive(void)
+{
+    s_last_ok_rx_ms = HAL_GetTick();
+#if (CFG_USE_RTOS)
+    App_rtos_LinkAlive();
+#endif
+    if (!s_link_up)
+    {
+        s_link_up = true;
+        TLOG_I("link up");
+    }
+}
+
+/* ========== SEQ 去重 ==========
+ * 主机对 PWM/PWM_AT（含 v2）使用同一个递增 SEQ（回绕），心跳另有独立计数（见 hb_seq_is_dup）。
+ * 冗余发送时同一帧会到达多份：
+ *  - d == 0：重复副本，丢弃；
+ *  - -WINDOW < d < 0：乱序到达的旧帧，丢弃（不能用旧指令覆盖新指令）；
+ *  - d <= -WINDOW：视为主机重启，重新同步；
+ *  - d > 0：新帧，d-1 即中间“所有副本都丢失”的帧数，计入 seq_gaps。
+ */
+static seq_verdict_t seq_check(uint16_t seq)
+{
+#if (CFG_SEQ_DEDUP_ENABLE)
+    if (s_seq_valid)
+    {
+        const int16_t d = (int16_t)(uint16_t)(seq - s_stats.last_seq);
+        if (d == 0)
+        {
+            s_stats.rx_dup++;
+            return SEQ_DUP;
+        }
+        if (d < 0 && d > -(int16_t)CFG_SEQ_REORDER_WINDOW)
+        {
+            s_stats.rx_stale++;
+            return SEQ_STALE;
+        }
+        if (d > 0)
+        {
+            s_stats.seq_gaps += (uint32_t)(d - 1);
+            if (d > 1)
+                TLOG_W("seq gap: %d frame(s) lost before seq=%u", d - 1, seq);
+        }
+    }
+    s_seq_valid = true;
+#endif
+    s_stats.last_seq = seq;
+    s_stats.rx_unique++;
+    return SEQ_NEW;
+}
+
+/* 心跳去重：与上一个心跳 SEQ 相同即为副本（不碰 PWM 的去重基准与统计） */
+static bool hb_seq_is_dup(uint16_t seq)
+{
+#if (CFG_SEQ_DEDUP_ENABLE)
+    if (s_hb_seq_valid && seq == s_hb_seq_last)
+        return true;
+    s_hb_seq_valid = true;
+    s_hb_seq_last = seq;
+#else
+    (void)seq;
+#endif
+    return false;
+}
+
+/* 8×uint16（大端）0..10000 → 占空 -1..1（5000->0） */
+static void decode_duty(const uint8_t *payload, float duty[8])
+{
     for (int i = 0; i < 8; ++i)
     {
         const uint16_t v = be16_read(payload + i * 2);
@@ -296,25 +611,152 @@ static void handle_msg_pwm(const uint8_t *payload, uint16_t len)
         if (duty[i] < -1.0f)
             duty[i] = -1.0f;
     }
+}
 
-    /* 下发到 8 路 PWM 输出（驱动层内部可做斜率限幅/死区/μs↔CCR 等） */
-    Driver_pwm_SetDuty(1, duty[0]);
-    Driver_pwm_SetDuty(2, duty[1]);
-    Driver_pwm_SetDuty(3, duty[2]);
-    Driver_pwm_SetDuty(4, duty[3]);
-    Driver_pwm_SetDuty(5, duty[4]);
-    Driver_pwm_SetDuty(6, duty[5]);
-    Driver_pwm_SetDuty(7, duty[6]);
-    Driver_pwm_SetDuty(8, duty[7]);
+#if (CFG_PROTO_V2_ENABLE)
+/* v2 负载：8 路 MSB 优先位打包（12 位码值 0..4000 / 14 位协议值 0..10000）→ 占空 -1..1（中位 -> 0） */
+static void decode_duty_packed(const uint8_t *payload, uint8_t bits, float duty[8])
+{
+    const uint32_t full = (bits == 12u) ? PROTO_V2_Q12_MAX : 10000u;
+    const uint32_t half = full / 2u;
+    uint32_t acc = 0;
+    uint8_t nacc = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        while (nacc < bits)
+        {
+            acc = (acc << 8) | *payload++;
+            nacc = (uint8_t)(nacc + 8u);
+        }
+        nacc = (uint8_t)(nacc - bits);
+        uint32_t v = (acc >> nacc) & ((1u << bits) - 1u);
+        if (v > full)
+            v = full;
+        duty[i] = ((float)((int32_t)v - (int32_t)half) / (float)half);
+    }
+}
+#endif
+
+/* ========== 业务处理：PWM ==========
+ * 期望 LEN=16，内容为 8×uint16（大端），0..10000 对应占空 -1..1（5000->0）。
+ */
+static void handle_msg_pwm(const uint8_t *payload, uint16_t len)
+{
+    if (len != 16u)
+    {
+        s_stats.rx_len_err++;
+        return;
+    }
+
+    /* 暖机中：链路照常计活（已在调用方刷新），输出保持中位 */
+    if (protocol_is_warming())
+    {
+        s_stats.rx_warmup++;
+        return;
+    }
+
+    float duty[8];
+    decode_duty(payload, duty);
+
+    /* 立即指令优先：排队中的定时指令作废（在 output_duty 内） */
+    output_duty(duty);
+    Phase_pwm_OnApply();
+}
+
+/* ========== 业务处理：PWM_AT（定时应用） ==========
+ * 期望 LEN=20：DUE(u32，设备 HAL_GetTick 目标时刻) + 8×uint16。
+ * 主机按 HB/HB_ACK 估计时钟偏移后填写 DUE；入队后由 TIM5 中断到点应用，迟到策略见 Sched_pwm。
+ */
+static void handle_msg_pwm_at(const uint8_t *payload, uint16_t len)
+{
+    if (len != 20u)
+    {
+        s_stats.rx_len_err++;
+        return;
+    }
+
+    if (protocol_is_warming())
+    {
+        s_stats.rx_warmup++;
+        return;
+    }
+
+    float duty[8];
+    decode_duty(payload + 4, duty);
+
+#if (CFG_SCHED_APPLY_ENABLE)
+    Sched_pwm_Push(be32_read(payload), duty);
+#else
+    output_duty(duty);
+    Phase_pwm_OnApply();
+#endif
 }
 
+#if (CFG_PROTO_V2_ENABLE)
+/* ========== 业务处理：紧凑帧 v2 PWM ==========
+ * 长度已由 try_parse_v2_frame 校验；at=true 时负载前置 DUE16，语义同 MSG_PWM_AT。
+ */
+static void handle_msg_pwm_v2(const uint8_t *payload, uint8_t bits, bool at)
+{
+    if (protocol_is_warming())
+    {
+        s_stats.rx_warmup++;
+        return;
+    }
+
+    float duty[8];
+    decode_duty_packed(payload + (at ? 2u : 0u), bits, duty);
+
+#if (CFG_SCHED_APPLY_ENABLE)
+    if (at)
+    {
+        /* DUE16 以当前 tick 为基准就近展开（缓冲延迟远小于 ±32s） */
+        const uint32_t now = HAL_GetTick();
+        const int16_t ahead = (int16_t)(uint16_t)(be16_read(payload) - (uint16_t)now);
+        Sched_pwm_Push(now + (uint32_t)(int32_t)ahead, duty);
+        return;
+    }
+#endif
+    output_duty(duty);
+    Phase_pwm_OnApply();
+}
+#endif
+
 /* ========== 业务处理：HB（立即回 ACK） ==========
- * 我们回一帧：SOF AA55 / VER 01 / MSG 11 / SEQ=原样 / TICKS=本地HAL_GetTick() / LEN=0000 / CRC(VER..LEN)
+ * 我们回一帧：SOF AA55 / VER 01 / MSG 11 / SEQ=原样 / TICKS=本地HAL_GetTick() / LEN / CRC(VER..LEN)
+ * CFG_HB_ACK_STATS_ENABLE 时 LEN=16，负载为 rx_unique / rx_dup / seq_gaps（各 u32 大端），
+ * 主机据此计算冗余发送后的“残余丢包率”；之后为 phase_lag_us / status（各 u16 大端，见 Phase_pwm.h），
+ * 旧版主机只读前 12 字节或忽略负载即可。
  */
+#if (CFG_HB_ACK_STATS_ENABLE)
+#define HB_ACK_PAYLOAD_LEN 16u
+#else
+#define HB_ACK_PAYLOAD_LEN 0u
+#endif
+
+#if (CFG_HB_ACK_STATS_ENABLE)
+/* HB_ACK 状态位（PROTO_STATUS_*） */
+static uint16_t hb_ack_status(void)
+{
+    uint16_t st = 0;
+    if (protocol_is_warming())
+        st |= PROTO_STATUS_WARMING;
+#if (CFG_PROTO_V2_ENABLE)
+    st |= PROTO_STATUS_PROTO_V2;
+#endif
+#if (CFG_PHASE_ALIGN_ENABLE)
+    st |= PROTO_STATUS_PHASE_ALIGN;
+    if (Phase_pwm_Stats()->locked)
+        st |= PROTO_STATUS_PHASE_LOCKED;
+#endif
+    return st;
+}
+#endif
+
 static void handle_msg_hb(uint16_t seq, uint32_t ticks)
 {
 #if (CFG_HB_ACK_ENABLE)
-    uint8_t buf[MIN_FRAME_LEN]; // 14 bytes
+    uint8_t buf[MIN_FRAME_LEN + HB_ACK_PAYLOAD_LEN]; // 14 (+16) bytes
     uint8_t *p = buf;
 
     /* SOF */
@@ -330,36 +772,78 @@ static void handle_msg_hb(uint16_t seq, uint32_t ticks)
     p += 2;
     be32_write(p, HAL_GetTick());
     p += 4;
-    be16_write(p, 0);
+    be16_write(p, (uint16_t)HB_ACK_PAYLOAD_LEN);
+    p += 2;
+
+#if (CFG_HB_ACK_STATS_ENABLE)
+    be32_write(p, s_stats.rx_unique);
+    p += 4;
+    be32_write(p, s_stats.rx_dup);
+    p += 4;
+    be32_write(p, s_stats.seq_gaps);
+    p += 4;
+    be16_write(p, Phase_pwm_Stats()->mean_lag_us);
+    p += 2;
+    be16_write(p, hb_ack_status());
     p += 2;
+#endif
 
-    /* CRC 覆盖 VER..LEN (10 字节) */
-    const uint16_t crc = crc16_ccitt(buf + 2, 10u);
+    /* CRC 覆盖 VER..LEN(+PAYLOAD) */
+    const uint16_t crc = crc16_ccitt(buf + 2, (uint16_t)(10u + HB_ACK_PAYLOAD_LEN));
     be16_write(p, crc);
     p += 2;
 
-    /* 通过协议串口发送（DMA 或阻塞均可；这里用阻塞更简单稳妥） */
-    HAL_UART_Transmit(&UART_PROTO_HANDLE, buf, (uint16_t)sizeof(buf), 50);
+    proto_uart_send(buf, (uint16_t)sizeof(buf));
 #else
     (void)seq;
 #endif
 }
 
+/* 经协议串口发出一帧（DMA 或阻塞均可；这里用阻塞更简单稳妥）。
+ * CFG_PROTO_COBS_ENABLE 时 COBS 编码并首尾各加 0x00 */
+static void proto_uart_send(const uint8_t *frame, uint16_t n)
+{
+#if (CFG_PROTO_COBS_ENABLE)
+    static uint8_t enc[2u + COBS_MAX_ENCODED(PROTO_TX_MAX)];
+    if (n > PROTO_TX_MAX)
+        return;
+    enc[0] = 0u;
+    const uint16_t e = cobs_encode(frame, n, enc + 1);
+    enc[1u + e] = 0u;
+    HAL_UART_Transmit(&UART_PROTO_HANDLE, enc, (uint16_t)(e + 2u), 50);
+#else
+    HAL_UART_Transmit(&UART_PROTO_HANDLE, frame, n, 50);
+#endif
+}
+
+/* 立即应用 8 路占空并作废排队中的定时指令。
+ * 裸机直接写比较寄存器；RTOS 下交给最高优先级的执行任务（唯一写输出的任务） */
+static void output_duty(const float duty[8])
+{
+#if (CFG_USE_RTOS)
+    App_rtos_PostDuty(duty);
+#else
+    Sched_pwm_Clear();
+
+    /* 下发到 8 路 PWM 输出（驱动层内部可做斜率限幅/死区/μs↔CCR 等） */
+    for (uint8_t ch = 1; ch <= 8; ++ch)
+    {
+        Driver_pwm_SetDuty(ch, duty[ch - 1]);
+    }
+#endif
+}
+
 /* 将所有通道回中位（失联/急停） */
 static void enter_failsafe_mid_all(void)
 {
-    /* 回中，即控制推进器0输出*/
-    Driver_pwm_SetDuty(1, 0.0f);
-    Driver_pwm_SetDuty(2, 0.0f);
-    Driver_pwm_SetDuty(3, 0.0f);
-    Driver_pwm_SetDuty(4, 0.0f);
-    Driver_pwm_SetDuty(5, 0.0f);
-    Driver_pwm_SetDuty(6, 0.0f);
-    Driver_pwm_SetDuty(7, 0.0f);
-    Driver_pwm_SetDuty(8, 0.0f);
+    /* 回中，即控制推进器0输出；排队的定时指令不能在回中之后“复活” */
+    static const float mid[8] = {0.0f};
+    output_duty(mid);
 }
 void protocol_force_failsafe(void)
 {
+    Sched_pwm_Clear();
+
     /* 回中，即控制推进器0输出*/
     Driver_pwm_SetDuty(1, 0.0f);
     Driver_pwm_SetDuty(2, 0.0f);
@@ -413,11 +897,19 @@ void protocol_it_process(void)
         // 关 DMA 取本次收到字节数
         HAL_UART_DMAStop(&huart5);
         uint16_t len = (uint16_t)(PROTOCOL_MSG_LEN - __HAL_DMA_GET_COUNTER(huart5.hdmarx));
+#if (CFG_USE_RTOS)
+        /* 交给协议任务：流缓冲唤醒，不经 protocol_flag（解析期间到达的数据也不会丢） */
+        if (len > 0)
+        {
+            App_rtos_RxFromISR(protocol_buf, len);
+        }
+#else
         if (len > 0 && protocol_flag == 0)
         {
             protocol_feed_bytes(protocol_buf, len);
             protocol_flag = 1; // 通知主循环有一坨新字节
         }
+#endif
         HAL_UART_Receive_DMA(&huart5, protocol_buf, PROTOCOL_MSG_LEN);
     }
 }
@@ -0,0 +1,76 @@
+// hal_stub.c：主机测试用的 HAL / 外设打桩（只提供 protocol_v1.c 链接所需的符号）
+#include "hal_stub.h"
+#include "Driver_pwm.h"
+#include "Phase_pwm.h"
+#include "Sched_pwm.h"
+#include "Tlog.h"
+#include <string.h>
+
+UART_HandleTypeDef huart5;
+
+uint32_t stub_tick = 0;
+uint8_t stub_tx[STUB_TX_CAP];
+uint16_t stub_tx_len = 0;
+float stub_duty[8];
+uint32_t stub_duty_writes = 0;
+
+uint32_t HAL_GetTick(void)
+{
+    return stub_tick;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)huart;
+    (void)Timeout;
+    if ((uint32_t)stub_tx_len + Size <= STUB_TX_CAP)
+    {
+        memcpy(stub_tx + stub_tx_len, pData, Size);
+        stub_tx_len = (uint16_t)(stub_tx_len + Size);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    (void)huart;
+    (void)pData;
+    (void)Size;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef *huart)
+{
+    (void)huart;
+    return HAL_OK;
+}
+
+void Driver_pwm_SetDuty(uint8_t channel, float duty)
+{
+    if (channel >= 1u && channel <= 8u)
+        stub_duty[channel - 1u] = duty;
+    ++stub_duty_writes;
+}
+
+void Phase_pwm_OnApply(void) {}
+void Phase_pwm_Reset(void) {}
+
+const phase_stats_t *Phase_pwm_Stats(void)
+{
+    static const phase_stats_t st = {0};
+    return &st;
+}
+
+void Sched_pwm_Push(uint32_t due_tick, const float duty[8])
+{
+    (void)due_tick;
+    (void)duty;
+}
+
+void Sched_pwm_Clear(void) {}
+
+void Tlog_Emit(uint8_t level, const char *fmt, ...)
+{
+    (void)level;
+    (void)fmt;
+}
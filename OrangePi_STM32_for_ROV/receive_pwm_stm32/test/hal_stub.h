@@ -0,0 +1,14 @@
+// hal_stub.h：打桩状态（测试直接读写）
+#ifndef HAL_STUB_H
+#define HAL_STUB_H
+#include "stm32f4xx_hal.h"
+
+#define STUB_TX_CAP 256u
+
+extern uint32_t stub_tick;           /* HAL_GetTick 返回值 */
+extern uint8_t stub_tx[STUB_TX_CAP]; /* HAL_UART_Transmit 累积的发送字节 */
+extern uint16_t stub_tx_len;
+extern float stub_duty[8];           /* Driver_pwm_SetDuty 最近写入（通道 1..8） */
+extern uint32_t stub_duty_writes;
+
+#endif
@@ -0,0 +1,99 @@
+// test_cobs.c：cobs_encode / cobs_decode 往返与损坏段
+#include "cobs.h"
+#include <stdio.h>
+#include <string.h>
+
+static int s_fail = 0;
+
+#define CHECK(cond)                                                  \
+    do                                                               \
+    {                                                                \
+        if (!(cond))                                                 \
+        {                                                            \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++s_fail;                                                \
+        }                                                            \
+    } while (0)
+
+#define BUF_MAX 600u
+
+/* 编码后不含 0x00、长度不超过 COBS_MAX_ENCODED，异址与原地解码均还原 */
+static void round_trip(const uint8_t *in, uint16_t n)
+{
+    uint8_t enc[COBS_MAX_ENCODED(BUF_MAX)];
+    uint8_t dec[BUF_MAX];
+
+    const uint16_t e = cobs_encode(in, n, enc);
+    CHECK(e >= 1u && e <= COBS_MAX_ENCODED(n));
+    CHECK(memchr(enc, 0, e) == NULL);
+
+    CHECK(cobs_decode(enc, e, dec) == n);
+    CHECK(memcmp(dec, in, n) == 0);
+
+    CHECK(cobs_decode(enc, e, enc) == n);
+    CHECK(memcmp(enc, in, n) == 0);
+}
+
+static void test_round_trip(void)
+{
+    static const uint16_t lens[] = {0, 1, 2, 14, 30, 34, 253, 254, 255, 508, 509, BUF_MAX};
+    uint8_t buf[BUF_MAX];
+
+    for (size_t k = 0; k < sizeof(lens) / sizeof(lens[0]); ++k)
+    {
+        const uint16_t n = lens[k];
+
+        memset(buf, 0x00, n); /* 全 0 */
+        round_trip(buf, n);
+
+        memset(buf, 0x5A, n); /* 无 0：按 254 字节分块 */
+        round_trip(buf, n);
+
+        uint32_t x = 0x12345678u ^ n; /* 伪随机，约 1/8 为 0 */
+        for (uint16_t i = 0; i < n; ++i)
+        {
+            x = x * 1103515245u + 12345u;
+            buf[i] = ((x >> 24) & 7u) ? (uint8_t)(x >> 16) : 0u;
+        }
+        round_trip(buf, n);
+    }
+
+    /* 本协议的帧（< 254 字节）恰好 +1 */
+    memset(buf, 0xAA, 30);
+    uint8_t enc[COBS_MAX_ENCODED(30)];
+    CHECK(cobs_encode(buf, 30, enc) == 31u);
+}
+
+static void test_corrupt(void)
+{
+    uint8_t out[16];
+
+    /* 长度码越界（块声称 5 字节，只有 2 字节） */
+    static const uint8_t overrun[] = {0x05, 0x11, 0x22};
+    CHECK(cobs_decode(overrun, sizeof(overrun), out) == 0u);
+
+    /* 段内含 0x00（分隔符应已被接收端切掉） */
+    static const uint8_t zero_code[] = {0x00, 0x11};
+    CHECK(cobs_decode(zero_code, sizeof(zero_code), out) == 0u);
+    static const uint8_t zero_data[] = {0x03, 0x11, 0x00};
+    CHECK(cobs_decode(zero_data, sizeof(zero_data), out) == 0u);
+
+    /* 合法编码截掉尾部：最后一块长度码越界 */
+    const uint8_t src[] = {0x11, 0x00, 0x22, 0x33, 0x44};
+    uint8_t enc[COBS_MAX_ENCODED(sizeof(src))];
+    const uint16_t e = cobs_encode(src, sizeof(src), enc);
+    CHECK(cobs_decode(enc, (uint16_t)(e - 1u), out) == 0u);
+}
+
+int main(void)
+{
+    test_round_trip();
+    test_corrupt();
+    if (s_fail)
+    {
+        printf("test_cobs: %d check(s) failed\n", s_fail);
+        return 1;
+    }
+    printf("test_cobs: ok\n");
+    return 0;
+}
@@ -0,0 +1,199 @@
+// test_proto_cobs.c：protocol_v1 在 CFG_PROTO_COBS_ENABLE=1 下的接收路径（process_rx_cobs）
+#include "protocol_v1.h"
+#include "cobs.h"
+#include "crc16_ccitt.h"
+#include "config.h"
+#include "hal_stub.h"
+#include <stdio.h>
+#include <string.h>
+
+static int s_fail = 0;
+
+#define CHECK(cond)                                                  \
+    do                                                               \
+    {                                                                \
+        if (!(cond))                                                 \
+        {                                                            \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++s_fail;                                                \
+        }                                                            \
+    } while (0)
+
+#define FRAME_MAX (PROTO_MIN_FRAME_LEN + 20u)
+#define WIRE_MAX (2u + COBS_MAX_ENCODED(FRAME_MAX))
+
+/* v1 帧：SOF AA55 / VER / MSG / SEQ16 / TICKS32 / LEN16 / payload / CRC(VER..payload) */
+static uint16_t v1_frame(uint8_t msg, uint16_t seq, const uint8_t *payload, uint16_t len, uint8_t *out)
+{
+    uint8_t *p = out;
+    *p++ = 0xAAu;
+    *p++ = 0x55u;
+    *p++ = PROTO_VER_1;
+    *p++ = msg;
+    *p++ = (uint8_t)(seq >> 8);
+    *p++ = (uint8_t)seq;
+    *p++ = 0; *p++ = 0; *p++ = 0; *p++ = 0;
+    *p++ = (uint8_t)(len >> 8);
+    *p++ = (uint8_t)len;
+    if (len)
+        memcpy(p, payload, len);
+    p += len;
+    const uint16_t crc = crc16_ccitt(out + 2, (uint16_t)(10u + len));
+    *p++ = (uint8_t)(crc >> 8);
+    *p++ = (uint8_t)crc;
+    return (uint16_t)(p - out);
+}
+
+/* 与主机 pwm_cobs_wrap 相同的线上格式：0x00 + COBS + 0x00 */
+static uint16_t wrap(const uint8_t *frame, uint16_t n, uint8_t *out)
+{
+    out[0] = 0u;
+    const uint16_t e = cobs_encode(frame, n, out + 1);
+    out[1u + e] = 0u;
+    return (uint16_t)(e + 2u);
+}
+
+static uint16_t hb_wire(uint16_t seq, uint8_t *out)
+{
+    uint8_t f[FRAME_MAX];
+    return wrap(f, v1_frame(MSG_HB, seq, NULL, 0, f), out);
+}
+
+/* 取出 stub_tx 中唯一一帧 HB_ACK 的 SEQ；格式不对返回 -1 */
+static int take_hb_ack_seq(void)
+{
+    uint8_t f[STUB_TX_CAP];
+    int seq = -1;
+    if (stub_tx_len >= 3u && stub_tx[0] == 0u && stub_tx[stub_tx_len - 1u] == 0u)
+    {
+        const uint16_t m = cobs_decode(stub_tx + 1, (uint16_t)(stub_tx_len - 2u), f);
+        if (m >= PROTO_MIN_FRAME_LEN && f[0] == 0xAAu && f[1] == 0x55u && f[3] == MSG_HB_ACK &&
+            crc16_ccitt(f + 2, (uint16_t)(m - 4u)) == (uint16_t)((f[m - 2u] << 8) | f[m - 1u]))
+            seq = (f[4] << 8) | f[5];
+    }
+    stub_tx_len = 0;
+    return seq;
+}
+
+static void reset(void)
+{
+    stub_tick = 0;
+    stub_tx_len = 0;
+    protocol_init();
+}
+
+static void test_hb_ack_cobs(void)
+{
+    uint8_t w[WIRE_MAX];
+    reset();
+    protocol_process_bytes(w, hb_wire(7, w));
+    CHECK(take_hb_ack_seq() == 7);
+    CHECK(protocol_stats()->rx_cobs_err == 0u);
+}
+
+static void test_corrupt_chunk(void)
+{
+    uint8_t w[2u * WIRE_MAX];
+    reset();
+
+    /* 损坏的一段（CRC 失败）整段丢弃，紧随其后的合法帧照常处理 */
+    uint16_t n = hb_wire(1, w);
+    w[5] ^= 0x40u;
+    n = (uint16_t)(n + hb_wire(2, w + n));
+    protocol_process_bytes(w, n);
+    CHECK(protocol_stats()->rx_cobs_err == 1u);
+    CHECK(take_hb_ack_seq() == 2);
+
+    /* 长度码越界：解码失败 */
+    uint8_t bad[] = {0x00, 0x20, 0x11, 0x22, 0x00};
+    protocol_process_bytes(bad, sizeof(bad));
+    CHECK(protocol_stats()->rx_cobs_err == 2u);
+    CHECK(stub_tx_len == 0u);
+
+    /* 未编码的原始 v1 帧（含 0x00）：切出的各段都不是恰好一帧 */
+    uint8_t f[FRAME_MAX];
+    const uint32_t before = protocol_stats()->rx_ok;
+    protocol_process_bytes(f, v1_frame(MSG_HB, 3, NULL, 0, f));
+    CHECK(protocol_stats()->rx_ok == before);
+    CHECK(protocol_stats()->rx_cobs_err > 2u);
+    CHECK(stub_tx_len == 0u);
+}
+
+static void test_split_and_back_to_back(void)
+{
+    uint8_t w[2u * WIRE_MAX];
+    reset();
+
+    /* 一帧分两次到达：尾段留在缓冲里等分隔符 */
+    const uint16_t n = hb_wire(10, w);
+    protocol_process_bytes(w, (uint16_t)(n / 2u));
+    CHECK(stub_tx_len == 0u);
+    protocol_process_bytes(w + n / 2u, (uint16_t)(n - n / 2u));
+    CHECK(take_hb_ack_seq() == 10);
+
+    /* 两帧紧贴（0x00 0x00 之间的空段忽略） */
+    uint16_t m = hb_wire(11, w);
+    m = (uint16_t)(m + hb_wire(12, w + m));
+    const uint32_t ok = protocol_stats()->rx_ok;
+    protocol_process_bytes(w, m);
+    CHECK(protocol_stats()->rx_ok == ok + 2u);
+    CHECK(protocol_stats()->rx_cobs_err == 0u);
+    stub_tx_len = 0;
+}
+
+static void test_lost_delimiter(void)
+{
+    uint8_t junk[100];
+    uint8_t w[WIRE_MAX];
+    reset();
+
+    /* 超过 COBS_CHUNK_MAX 仍无分隔符：整段丢弃，下一个 0x00 后恢复 */
+    memset(junk, 0x33, sizeof(junk));
+    protocol_process_bytes(junk, sizeof(junk));
+    CHECK(protocol_stats()->rx_cobs_err == 1u);
+    protocol_process_bytes(w, hb_wire(20, w));
+    CHECK(take_hb_ack_seq() == 20);
+}
+
+static void test_pwm_applied(void)
+{
+    static const uint16_t v[8] = {10000, 0, 5000, 7500, 2500, 5000, 5000, 5000};
+    uint8_t payload[16];
+    uint8_t f[FRAME_MAX];
+    uint8_t w[WIRE_MAX];
+    for (int i = 0; i < 8; ++i)
+    {
+        payload[2 * i] = (uint8_t)(v[i] >> 8);
+        payload[2 * i + 1] = (uint8_t)v[i];
+    }
+
+    reset();
+    stub_tick = CFG_STARTUP_WARMUP_MS + 1u; /* 暖机结束 */
+    stub_duty_writes = 0;
+
+    protocol_process_bytes(w, wrap(f, v1_frame(MSG_PWM, 100, payload, 16, f), w));
+    CHECK(stub_duty_writes == 8u);
+    CHECK(stub_duty[0] == 1.0f);
+    CHECK(stub_duty[1] == -1.0f);
+    CHECK(stub_duty[2] == 0.0f);
+    CHECK(stub_duty[3] == 0.5f);
+    CHECK(stub_duty[4] == -0.5f);
+    CHECK(protocol_stats()->rx_unique == 1u);
+    CHECK(protocol_stats()->rx_cobs_err == 0u);
+}
+
+int main(void)
+{
+    test_hb_ack_cobs();
+    test_corrupt_chunk();
+    test_split_and_back_to_back();
+    test_lost_delimiter();
+    test_pwm_applied();
+    if (s_fail)
+    {
+        printf("test_proto_cobs: %d check(s) failed\n", s_fail);
+        return 1;
+    }
+    printf("test_proto_cobs: ok\n");
+    return 0;
+}
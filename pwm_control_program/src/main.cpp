@@ -1,5 +1,7 @@
 #include "libpwm_host.h"
 #include "pwm_control.h"
+#include "pwm_host_sim.h"
+#include "pwmh_log.h"
 
 #include <atomic>
 #include <chrono>
@@ -7,27 +9,34 @@
 #include <cstdio>
 #include <cstring>
 #include <iostream>
-#include <thread>
 
+// 控制循环的计时统一走 libpwm_host 的可注入时钟：
+// 目标为 "sim" 时切换为虚拟时钟，整套序列在毫秒级内跑完
 using Clock = std::chrono::steady_clock;
-using Ms    = std::chrono::milliseconds;
+
+static uint64_t now_ms() { return pwm_host_now_ns() / 1000000ull; }
 
 static std::atomic<bool> g_running{true};
 static void on_sigint(int){ g_running = false; }
 
-// 简单打印统计信息
+// 简单打印统计信息（控制环内调用：走异步日志，不在终端写入上阻塞）
 static void print_stats(const char* tag)
 {
     pwm_host_stats_t st{};
     pwm_host_get_stats(&st);
     double rtt = pwm_host_last_rtt_ms();
 
-    std::cout << "[STAT][" << tag << "] tx_pwm=" << st.tx_pwm
-              << " tx_hb=" << st.tx_hb
-              << " rx_hb_ack=" << st.rx_hb_ack
-              << " tx_err=" << st.tx_err
-              << " rx_err=" << st.rx_err
-              << " rtt_last=" << (rtt >= 0 ? rtt : -1.0) << " ms\n";
+    PWMH_LOGI("[STAT][%s] tx_pwm=%llu tx_hb=%llu rx_hb_ack=%llu tx_err=%llu rx_err=%llu rtt_last=%g ms",
+              tag, (unsigned long long)st.tx_pwm, (unsigned long long)st.tx_hb,
+              (unsigned long long)st.rx_hb_ack, (unsigned long long)st.tx_err,
+              (unsigned long long)st.rx_err, rtt >= 0 ? rtt : -1.0);
+
+    // 发送节拍：实际帧间隔分布 / 超期 / 追赶
+    pwm_host_txmon_t tm{};
+    pwm_host_txmon_get(&tm);
+    PWMH_LOGI("[TXMON][%s] period=%.3f ms mean=%.3f sd=%.3f p50=%g p99=%g max=%.3f miss=%llu catchup=%llu",
+              tag, tm.period_ms, tm.mean_ms, tm.stddev_ms, tm.p50_ms, tm.p99_ms, tm.max_ms,
+              (unsigned long long)tm.deadline_miss, (unsigned long long)tm.catchup_burst);
 }
 
 // 统一的“控制周期循环”：在 seconds 内按 ctrl_hz 调用 step+poll+心跳
@@ -35,36 +44,35 @@ static int run_for_seconds(float seconds, float ctrl_hz, int hb_hz, const char*
 {
     if (seconds <= 0.0f) return 0;
 
-    std::cout << "\n========== PHASE: " << phase_name
-              << " (" << seconds << " s) ==========\n";
+    PWMH_LOGI("========== PHASE: %s (%g s) ==========", phase_name, static_cast<double>(seconds));
 
     const double period_ms = 1000.0 / (ctrl_hz > 0.0f ? ctrl_hz : 51.0f);
     const double hb_period_ms = 1000.0 / (hb_hz > 0 ? hb_hz : 1);
 
-    auto t_start      = Clock::now();
-    auto t_next_hb    = t_start;
-    auto t_next_stat  = t_start + Ms(1000);
+    const uint64_t t_start     = now_ms();
+    uint64_t       t_next_hb   = t_start;
+    uint64_t       t_next_stat = t_start + 1000;
+    uint64_t       t_next_ns   = pwm_host_now_ns();   // 下一控制步的绝对时刻
+    const uint64_t period_ns   = static_cast<uint64_t>(period_ms * 1e6);
 
     while (g_running.load()) {
-        auto now = Clock::now();
-        double elapsed_s =
-            std::chrono::duration<double>(now - t_start).count();
+        const uint64_t now = now_ms();
+        double elapsed_s = static_cast<double>(now - t_start) / 1000.0;
         if (elapsed_s >= seconds) break;
 
         // 控制步：限斜率 + 分组更新 + 一帧 8CH PWM
         int rc_step = pwm_ctrl_step();
         if (rc_step < 0) {
-            std::cerr << "[ERR] pwm_ctrl_step rc=" << rc_step << "\n";
+            PWMH_LOGE("pwm_ctrl_step rc=%d", rc_step);
             return rc_step;
         }
 
         // 心跳：hb_hz（比如 1Hz）
         if (now >= t_next_hb) {
-            t_next_hb += Ms((int)hb_period_ms);
+            t_next_hb += static_cast<uint64_t>(hb_period_ms);
             pwmh_result_t rc_hb = pwm_host_send_heartbeat();
             if (rc_hb != PWMH_OK) {
-                std::cerr << "[WARN] send_heartbeat: "
-                          << pwm_host_strerror(rc_hb) << "\n";
+                PWMH_LOGW("send_heartbeat: %s", pwm_host_strerror(rc_hb));
             }
         }
 
@@ -73,11 +81,15 @@ static int run_for_seconds(float seconds, float ctrl_hz, int hb_hz, const char*
 
         // 每秒打印统计信息
         if (now >= t_next_stat) {
-            t_next_stat += Ms(1000);
+            t_next_stat += 1000;
             print_stats(phase_name);
         }
 
-        std::this_thread::sleep_for(Ms((int)period_ms));
+        // 按绝对时刻睡眠（扣除本步耗时）；已超期则从当前时刻重新对齐，不补发追赶帧
+        t_next_ns += period_ns;
+        const uint64_t t_after = pwm_host_now_ns();
+        if (t_next_ns > t_after) pwm_host_sleep_ms(static_cast<double>(t_next_ns - t_after) / 1e6);
+        else                     t_next_ns = t_after;
     }
 
     print_stats(phase_name);
@@ -87,8 +99,7 @@ static int run_for_seconds(float seconds, float ctrl_hz, int hb_hz, const char*
 // 辅助：单通道往返渐变（通过设置 target + run_for_seconds 实现）
 static int test_single_channel_ramp(int ch, float ctrl_hz)
 {
-    std::cout << "\n--- Test: 单通道 CH" << ch
-              << " 7.5% -> 9.5% -> 7.5% ---\n";
+    PWMH_LOGI("--- Test: 单通道 CH%d 7.5%% -> 9.5%% -> 7.5%% ---", ch);
 
     // 先把所有目标拉到中位
     int rc = pwm_ctrl_set_all_target_mid();
@@ -121,8 +132,7 @@ static int test_group_forward(const char* name,
                               float fwd_pct,
                               float ctrl_hz)
 {
-    std::cout << "\n--- Test: 分组前推 [" << name << "] to "
-              << fwd_pct << "% ---\n";
+    PWMH_LOGI("--- Test: 分组前推 [%s] to %g%% ---", name, static_cast<double>(fwd_pct));
 
     // 先全中位
     int rc = pwm_ctrl_set_all_target_mid();
@@ -157,7 +167,7 @@ static int test_group_forward(const char* name,
 // 辅助：温和反向测试（先全中，再到 6.5%）
 static int test_soft_reverse(float ctrl_hz)
 {
-    std::cout << "\n--- Test: 温和反向（全通道 7.5% -> 6.5% -> 7.5%）---\n";
+    PWMH_LOGI("--- Test: 温和反向（全通道 7.5%% -> 6.5%% -> 7.5%%）---");
 
     int rc = pwm_ctrl_set_all_target_mid();
     if (rc < 0) return rc;
@@ -185,8 +195,9 @@ int main(int argc, char** argv)
 {
     std::signal(SIGINT, on_sigint);
 
-    // ===== 参数：ip port ctrl_hz hb_hz =====
+    // ===== 参数：ip port ctrl_hz hb_hz（ip="sim" 使用进程内仿真端点 + 虚拟时钟）=====
     const char* ip   = (argc > 1) ? argv[1] : "192.168.2.16";
+    const bool  sim  = (std::strcmp(ip, "sim") == 0);
     const int   port = (argc > 2) ? std::stoi(argv[2]) : 8000;
     const float ctrl_hz = (argc > 3) ? std::stof(argv[3]) : 51.0f;
     const int   hb_hz   = (argc > 4) ? std::stoi(argv[4]) : 1;
@@ -202,12 +213,20 @@ int main(int argc, char** argv)
     host_cfg.socket_sndbuf = 0;
     host_cfg.nonblock_send = 0;
 
-    pwmh_result_t rc_host = pwm_host_init(&host_cfg);
+    const auto wall_start = Clock::now();
+    pwmh_result_t rc_host = sim ? pwm_host_sim_open(nullptr, &host_cfg)
+                                : pwm_host_init(&host_cfg);
     if (rc_host != PWMH_OK) {
         std::cerr << "[ERR] pwm_host_init: " << pwm_host_strerror(rc_host) << "\n";
         return 1;
     }
-    std::cout << "[INFO] libpwm_host version=" << pwm_host_version() << "\n";
+    std::cout << "[INFO] libpwm_host version=" << pwm_host_version() << std::endl;
+
+    // 控制环内的输出走异步日志（写 stdout，与上面的 cout 同一流；时间戳取库时钟，仿真下为虚拟时间）
+    pwmh_log_config_t log_cfg{};
+    pwmh_log_default_config(&log_cfg);
+    log_cfg.fd = 1;
+    if (pwmh_log_start(&log_cfg) != PWMH_OK) std::cerr << "[WARN] async log unavailable, logging synchronously\n";
 
     // ===== 初始化控制层（pwm_control）=====
     pwm_ctrl_config_t ctrl_cfg{};
@@ -219,7 +238,8 @@ int main(int argc, char** argv)
 
     int rc = pwm_ctrl_init(&ctrl_cfg);
     if (rc < 0) {
-        std::cerr << "[ERR] pwm_ctrl_init rc=" << rc << "\n";
+        PWMH_LOGE("pwm_ctrl_init rc=%d", rc);
+        pwmh_log_stop();
         pwm_host_close();
         return 1;
     }
@@ -247,21 +267,35 @@ int main(int argc, char** argv)
     if (rc < 0) goto EXIT;
 
     // ========== Phase 6: 紧急平滑归中位（1秒） ==========
-    std::cout << "\n--- Phase 6: emergency_stop(1.0s) ---\n";
+    PWMH_LOGI("--- Phase 6: emergency_stop(1.0s) ---");
     rc = pwm_ctrl_emergency_stop(1.0f);
     if (rc < 0) goto EXIT;
 
 EXIT:
     if (rc < 0) {
-        std::cerr << "[ERR] test sequence aborted, rc=" << rc << "\n";
+        PWMH_LOGE("test sequence aborted, rc=%d", rc);
     }
 
     // 保险：最后再把目标设为中位并运行 1 秒
     (void)pwm_ctrl_set_all_target_mid();
     (void)run_for_seconds(1.0f, ctrl_hz, hb_hz, "final-mid");
+    pwmh_log_stop();   // 输出剩余日志后再打印结果
+
+    if (sim) {
+        pwm_host_sim_state_t ss{};
+        pwm_host_sim_get_state(&ss);
+        const double wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - wall_start).count();
+        std::cout << "[SIM] rx_pwm=" << ss.rx_pwm << " rx_hb=" << ss.rx_hb
+                  << " bad=" << ss.bad_frames << " failsafe_trips=" << ss.failsafe_trips
+                  << " max_gap=" << ss.max_gap_ms << "ms"
+                  << " phase_lag=" << ss.phase_lag_us << "us"
+                  << " duty_ch1=" << ss.duty[0]
+                  << " wall=" << wall_ms << "ms\n";
+    }
 
     pwm_ctrl_deinit();
-    pwm_host_close();
+    if (sim) pwm_host_sim_close();
+    else     pwm_host_close();
     std::cout << "[INFO] pwm_control_test exit.\n";
     return (rc < 0) ? 1 : 0;
 }
@@ -1,5 +1,6 @@
 #include "libpwm_host.h"
 #include "pwm_control.h"
+#include "pwmh_log.h"
 
 #include <atomic>
 #include <chrono>
@@ -55,12 +56,52 @@ static void print_stats(const char* tag)
     pwm_host_stats_t st{};
     pwm_host_get_stats(&st);
     double rtt = pwm_host_last_rtt_ms();
-    std::cout << "[STAT][" << tag << "] tx_pwm=" << st.tx_pwm
-              << " tx_hb=" << st.tx_hb
-              << " rx_hb_ack=" << st.rx_hb_ack
-              << " tx_err=" << st.tx_err
-              << " rx_err=" << st.rx_err
-              << " rtt=" << (rtt >= 0 ? rtt : -1.0) << " ms\n";
+    int32_t clk_off = 0;
+    const bool has_clk = (pwm_host_clock_offset(&clk_off, nullptr) == PWMH_OK);
+    if (has_clk) {
+        PWMH_LOGI("[STAT][%s] tx_pwm=%llu tx_hb=%llu rx_hb_ack=%llu tx_err=%llu rx_err=%llu rtt=%g ms rate=%g Hz clk_off=%d ms",
+                  tag, (unsigned long long)st.tx_pwm, (unsigned long long)st.tx_hb,
+                  (unsigned long long)st.rx_hb_ack, (unsigned long long)st.tx_err,
+                  (unsigned long long)st.rx_err, rtt >= 0 ? rtt : -1.0, pwm_host_rate_hz(), (int)clk_off);
+    } else {
+        PWMH_LOGI("[STAT][%s] tx_pwm=%llu tx_hb=%llu rx_hb_ack=%llu tx_err=%llu rx_err=%llu rtt=%g ms rate=%g Hz",
+                  tag, (unsigned long long)st.tx_pwm, (unsigned long long)st.tx_hb,
+                  (unsigned long long)st.rx_hb_ack, (unsigned long long)st.tx_err,
+                  (unsigned long long)st.rx_err, rtt >= 0 ? rtt : -1.0, pwm_host_rate_hz());
+    }
+
+    pwm_host_txmon_t tm{};
+    pwm_host_txmon_get(&tm);
+    PWMH_LOGI("[TXMON][%s] p50=%g p99=%g max=%.3f ms miss=%llu catchup=%llu",
+              tag, tm.p50_ms, tm.p99_ms, tm.max_ms,
+              (unsigned long long)tm.deadline_miss, (unsigned long long)tm.catchup_burst);
+
+    // 设备侧：指令到达 → PWM 输出生效的平均等待（固件相位对齐锁定后应远小于半个 PWM 周期）
+    if (st.dev_status & PWM_HOST_DEV_STATUS_WARMING) {
+        PWMH_LOGW("[DEV][%s] warming: outputs held at mid, PWM not applied yet", tag);
+    } else if (st.dev_phase_lag_us >= 0) {
+        PWMH_LOGI("[DEV][%s] phase_lag=%d us%s", tag, (int)st.dev_phase_lag_us,
+                  (st.dev_status & PWM_HOST_DEV_STATUS_PHASE_LOCKED) ? " (locked)"
+                  : (st.dev_status & PWM_HOST_DEV_STATUS_PHASE_ALIGN) ? " (aligning)" : "");
+    }
+
+    // 热备已启用时附带两条链路状态
+    for (int l = 0; l < PWM_HOST_LINK_NUM; ++l) {
+        pwm_host_link_stats_t ls{};
+        if (pwm_host_get_link_stats(l, &ls) != PWMH_OK) break;
+        PWMH_LOGI("[LINK][%s]%s up=%d rtt=%g ms loss=%g switches=%llu",
+                  l == PWM_HOST_LINK_PRIMARY ? "pri" : "sec",
+                  pwm_host_active_link() == l ? "*" : " ",
+                  ls.up, ls.rtt_ms, ls.loss,
+                  (unsigned long long)st.link_switches);
+    }
+}
+
+// 发送节拍告警：持续超期说明控制环被抢占或阻塞（只打印，不改变控制行为）
+static void on_txmon_alert(int active, double miss_rate, void*)
+{
+    if (active) PWMH_LOGW("TX deadline misses %g%%", miss_rate * 100.0);
+    else        PWMH_LOGI("TX cadence recovered, miss rate %g%%", miss_rate * 100.0);
 }
 
 /* ----------- Teleop 状态与映射 ----------- */
@@ -115,7 +156,9 @@ static void print_help()
         "  A / D : yaw 左转 / 右转\n"
         "  R / F : heave 上升 / 下降\n"
         "  M     : 所有通道回中位 (7.5%)\n"
-        "  SPACE : 紧急平滑归中位 (1.0s)\n"
+        "  SPACE : 软急停（1.0s 平滑归中，锁存）\n"
+        "  X     : 硬急停（立即中位，锁存）\n"
+        "  C     : 解除急停（需已归中）\n"
         "  Q     : 退出程序\n"
         "  H     : 显示本帮助\n"
         "当前 cmd 映射: base=7.5%, gain=1.0% * cmd [-1..1]\n"
@@ -135,47 +178,62 @@ static void teleop_handle_key()
     switch (c) {
     case 'w': case 'W':
         g_surge = clamp01(g_surge + step);
-        std::cout << "[KEY] W surge=" << g_surge << "\n";
+        PWMH_LOGI("[KEY] W surge=%.1f", (double)g_surge);
         break;
     case 's': case 'S':
         g_surge = clamp01(g_surge - step);
-        std::cout << "[KEY] S surge=" << g_surge << "\n";
+        PWMH_LOGI("[KEY] S surge=%.1f", (double)g_surge);
         break;
     case 'a': case 'A':
         g_yaw = clamp01(g_yaw + step);
-        std::cout << "[KEY] A yaw=" << g_yaw << "\n";
+        PWMH_LOGI("[KEY] A yaw=%.1f", (double)g_yaw);
         break;
     case 'd': case 'D':
         g_yaw = clamp01(g_yaw - step);
-        std::cout << "[KEY] D yaw=" << g_yaw << "\n";
+        PWMH_LOGI("[KEY] D yaw=%.1f", (double)g_yaw);
         break;
     case 'r': case 'R':
         g_heave = clamp01(g_heave + step);
-        std::cout << "[KEY] R heave=" << g_heave << "\n";
+        PWMH_LOGI("[KEY] R heave=%.1f", (double)g_heave);
         break;
     case 'f': case 'F':
         g_heave = clamp01(g_heave - step);
-        std::cout << "[KEY] F heave=" << g_heave << "\n";
+        PWMH_LOGI("[KEY] F heave=%.1f", (double)g_heave);
         break;
 
     case 'm': case 'M':
         g_surge = g_yaw = g_heave = 0.0f;
-        std::cout << "[KEY] M -> all command reset to 0 (中位)\n";
+        PWMH_LOGI("[KEY] M -> all command reset to 0 (中位)");
         pwm_ctrl_set_all_target_mid();
         break;
 
     case ' ':
-        std::cout << "[KEY] SPACE -> emergency_stop(1.0s)\n";
-        pwm_ctrl_emergency_stop(1.0f);
+        // 非阻塞：急停锁存后照常跑控制循环（心跳 / 键盘 / 统计不中断）
+        PWMH_LOGI("[KEY] SPACE -> estop SOFT (1.0s)");
+        (void)pwm_ctrl_estop_engage(PWM_CTRL_ESTOP_SOFT, 1.0f);
         g_surge = g_yaw = g_heave = 0.0f;
         break;
 
+    case 'x': case 'X':
+        PWMH_LOGI("[KEY] X -> estop HARD");
+        (void)pwm_ctrl_estop_engage(PWM_CTRL_ESTOP_HARD, 0.0f);
+        g_surge = g_yaw = g_heave = 0.0f;
+        break;
+
+    case 'c': case 'C':
+        if (pwm_ctrl_estop_release() == PWM_CTRL_OK) {
+            PWMH_LOGI("[KEY] C -> estop released");
+        } else {
+            PWMH_LOGI("[KEY] C -> estop still ramping, not released");
+        }
+        break;
+
     case 'h': case 'H':
         print_help();
         break;
 
     case 'q': case 'Q':
-        std::cout << "[KEY] Q -> exit\n";
+        PWMH_LOGI("[KEY] Q -> exit");
         g_running = false;
         break;
 
@@ -184,8 +242,13 @@ static void teleop_handle_key()
         break;
     }
 
-    // 有可能更改了命令，刷新目标
-    (void)update_targets_from_command();
+    // 有可能更改了命令，刷新目标；急停锁存期间指令被拒绝，命令清零避免解除后跳变
+    if (update_targets_from_command() == PWM_CTRL_ERR_ESTOP) {
+        if (g_surge != 0.0f || g_yaw != 0.0f || g_heave != 0.0f) {
+            PWMH_LOGI("[ESTOP] latched, command ignored (C to clear)");
+        }
+        g_surge = g_yaw = g_heave = 0.0f;
+    }
 }
 
 /* ----------- 主程序：键盘 teleop 循环 ----------- */
@@ -198,6 +261,9 @@ int main(int argc, char** argv)
     const int   port = (argc > 2) ? std::stoi(argv[2]) : 8000;
     const float ctrl_hz = (argc > 3) ? std::stof(argv[3]) : 51.0f;
     const int   hb_hz   = (argc > 4) ? std::stoi(argv[4]) : 1;
+    const char* ip2     = (argc > 5 && std::strcmp(argv[5], "-") != 0) ? argv[5] : nullptr;  // 可选：备链路 IP（启用热备），"-" 表示不用
+    const bool  adapt   = (argc > 6) && std::stoi(argv[6]) != 0;  // 可选：自适应帧率（上限 = ctrl_hz）
+    const int   sched_ms = (argc > 7) ? std::stoi(argv[7]) : 0;   // 可选：设备侧定时应用缓冲（ms），0=关闭
 
     std::cout << "[INFO] Teleop target=" << ip << ":" << port
               << " ctrl=" << ctrl_hz << "Hz hb=" << hb_hz << "Hz\n";
@@ -208,7 +274,7 @@ int main(int argc, char** argv)
     host_cfg.stm32_port    = static_cast<uint16_t>(port);
     host_cfg.send_hz       = static_cast<int>(ctrl_hz);
     host_cfg.socket_sndbuf = 0;
-    host_cfg.nonblock_send = 0;
+    host_cfg.nonblock_send = 1;   // 缓冲满时进邮箱（只留最新指令），不阻塞控制循环
 
     pwmh_result_t rc_host = pwm_host_init(&host_cfg);
     if (rc_host != PWMH_OK) {
@@ -217,6 +283,49 @@ int main(int argc, char** argv)
     }
     std::cout << "[INFO] libpwm_host version=" << pwm_host_version() << "\n";
 
+    if (ip2) {
+        pwm_host_failover_config_t fo{};
+        pwm_host_failover_default_config(&fo);
+        fo.secondary_ip = ip2;
+        pwmh_result_t rc_fo = pwm_host_enable_failover(&fo);
+        if (rc_fo != PWMH_OK) {
+            std::cerr << "[ERR] pwm_host_enable_failover: " << pwm_host_strerror(rc_fo) << "\n";
+            pwm_host_close();
+            return 1;
+        }
+        std::cout << "[INFO] failover secondary=" << ip2 << ":" << port << "\n";
+    }
+
+    if (adapt) {
+        // 控制循环仍按 ctrl_hz 跑 step，库按链路状况决定实际发帧率（不高于 ctrl_hz）
+        pwm_host_rate_config_t rate{};
+        pwm_host_rate_default_config(&rate);
+        rate.ceil_hz  = ctrl_hz;
+        rate.start_hz = ctrl_hz;
+        pwmh_result_t rc_rate = pwm_host_enable_rate_control(&rate);
+        if (rc_rate != PWMH_OK) {
+            std::cerr << "[ERR] pwm_host_enable_rate_control: " << pwm_host_strerror(rc_rate) << "\n";
+            pwm_host_close();
+            return 1;
+        }
+        std::cout << "[INFO] adaptive rate " << pwm_host_rate_hz() << " Hz (ceil " << ctrl_hz << ")\n";
+    }
+
+    pwm_host_txmon_config_t txmon{};
+    pwm_host_txmon_default_config(&txmon);
+    txmon.on_alert = on_txmon_alert;
+    (void)pwm_host_txmon_configure(&txmon);
+
+    if (sched_ms > 0) {
+        pwmh_result_t rc_sched = pwm_host_set_schedule(sched_ms);
+        if (rc_sched != PWMH_OK) {
+            std::cerr << "[ERR] pwm_host_set_schedule: " << pwm_host_strerror(rc_sched) << "\n";
+            pwm_host_close();
+            return 1;
+        }
+        std::cout << "[INFO] scheduled apply delay=" << sched_ms << " ms\n";
+    }
+
     // 控制层
     pwm_ctrl_config_t ctrl_cfg{};
     ctrl_cfg.ctrl_hz      = ctrl_hz;
@@ -236,6 +345,13 @@ int main(int argc, char** argv)
     (void)pwm_ctrl_set_all_target_mid();
     g_surge = g_yaw = g_heave = 0.0f;
 
+    // 控制环内的输出走异步日志（stdout），慢终端 / SSH 不拉长控制周期
+    std::cout << std::flush;
+    pwmh_log_config_t log_cfg{};
+    pwmh_log_default_config(&log_cfg);
+    log_cfg.fd = 1;
+    (void)pwmh_log_start(&log_cfg);
+
     term_set_raw();
     print_help();
 
@@ -244,6 +360,7 @@ int main(int argc, char** argv)
     auto t_next_pwm  = Clock::now();
     auto t_next_hb   = Clock::now();
     auto t_next_stat = Clock::now() + Ms(1000);
+    bool estop_done_reported = false;
 
     while (g_running.load()) {
         auto now = Clock::now();
@@ -258,7 +375,7 @@ int main(int argc, char** argv)
             int rc_step = pwm_ctrl_step();
             if (rc_step < 0) 
             {
-                std::cerr << "[ERR] pwm_ctrl_step rc=" << rc_step << "\n";
+                PWMH_LOGE("pwm_ctrl_step rc=%d", rc_step);
                 break;
             }
         }
@@ -268,12 +385,21 @@ int main(int argc, char** argv)
             t_next_hb += Ms((int)hb_period_ms);
             pwmh_result_t rc_hb = pwm_host_send_heartbeat();
             if (rc_hb != PWMH_OK) {
-                std::cerr << "[WARN] send_heartbeat: "
-                          << pwm_host_strerror(rc_hb) << "\n";
+                PWMH_LOGW("send_heartbeat: %s", pwm_host_strerror(rc_hb));
             }
         }
         //！ 收 ACK
         (void)pwm_host_poll(1);
+        // 急停完成提示（只在完成的那一刻打印一次）
+        pwm_ctrl_estop_status_t es{};
+        if (pwm_ctrl_estop_get_status(&es) == PWM_CTRL_OK) {
+            const bool done = (es.mode != PWM_CTRL_ESTOP_NONE) && es.complete;
+            if (done && !estop_done_reported) {
+                PWMH_LOGI("[ESTOP] at mid after %llu steps", (unsigned long long)es.steps_since_engage);
+            }
+            estop_done_reported = done;
+        }
+
         // 统计
         if (now >= t_next_stat) {
             t_next_stat += Ms(1000);
@@ -284,6 +410,7 @@ int main(int argc, char** argv)
     term_restore();
     pwm_ctrl_emergency_stop(1.0f);  // 离开前平滑归中
     pwm_ctrl_deinit();
+    pwmh_log_stop();
     pwm_host_close();
     std::cout << "[INFO] pwm_teleop exit.\n";
     return 0;